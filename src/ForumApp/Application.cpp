@@ -144,11 +144,18 @@ int Application::run(int argc, const char* argv[])
     const auto config = Configuration::getGlobalConfig();
 
     {
-        FORUM_LOG_INFO << "Starting to listen under "
-                       << config->service.listenIPAddress << ":" << config->service.listenPort;
+        if (config->service.listenUnixSocketPath.empty())
+        {
+            FORUM_LOG_INFO << "Starting to listen under "
+                           << config->service.listenIPAddress << ":" << config->service.listenPort;
+        }
+        else
+        {
+            FORUM_LOG_INFO << "Starting to listen under " << config->service.listenUnixSocketPath;
+        }
         try
         {
-            tcpListener_->startListening();
+            listener_->startListening();
         }
         catch (std::exception& ex)
         {
@@ -158,11 +165,19 @@ int Application::run(int argc, const char* argv[])
         }
     }
     {
-        FORUM_LOG_INFO << "Starting to listen for auth requests under "
-                       << config->service.authListenIPAddress << ":" << config->service.authListenPort;
+        if (config->service.authListenUnixSocketPath.empty())
+        {
+            FORUM_LOG_INFO << "Starting to listen for auth requests under "
+                           << config->service.authListenIPAddress << ":" << config->service.authListenPort;
+        }
+        else
+        {
+            FORUM_LOG_INFO << "Starting to listen for auth requests under "
+                           << config->service.authListenUnixSocketPath;
+        }
         try
         {
-            tcpListenerAuth_->startListening();
+            listenerAuth_->startListening();
         }
         catch (std::exception& ex)
         {
@@ -175,8 +190,8 @@ int Application::run(int argc, const char* argv[])
     getIOServiceProvider().start();
     getIOServiceProvider().waitForStop();
 
-    tcpListenerAuth_->stopListening();
-    tcpListener_->stopListening();
+    listenerAuth_->stopListening();
+    listener_->stopListening();
 
     FORUM_LOG_INFO << "Stopped listening for HTTP connections";
 
@@ -344,10 +359,19 @@ bool Application::initializeHttp()
         auto connectionManagerWithTimeout = std::make_shared<ConnectionManagerWithTimeout>(ioService,
             httpConnectionManager, forumConfig->service.connectionTimeoutSeconds);
 
-        tcpListener_ = std::make_unique<TcpListener>(ioService,
-            forumConfig->service.listenIPAddress,
-            forumConfig->service.listenPort,
-            connectionManagerWithTimeout);
+        if (forumConfig->service.listenUnixSocketPath.empty())
+        {
+            listener_ = std::make_unique<StreamSocketListener>(ioService,
+                forumConfig->service.listenIPAddress,
+                forumConfig->service.listenPort,
+                connectionManagerWithTimeout);
+        }
+        else
+        {
+            listener_ = std::make_unique<StreamSocketListener>(ioService,
+                forumConfig->service.listenUnixSocketPath,
+                connectionManagerWithTimeout);
+        }
     }
     {
         //auth API listener
@@ -364,10 +388,19 @@ bool Application::initializeHttp()
         auto connectionManagerWithTimeoutAuth = std::make_shared<ConnectionManagerWithTimeout>(ioService,
             httpConnectionManagerAuth, forumConfig->service.connectionTimeoutSeconds);
 
-        tcpListenerAuth_ = std::make_unique<TcpListener>(ioService,
-            forumConfig->service.authListenIPAddress,
-            forumConfig->service.authListenPort,
-            connectionManagerWithTimeoutAuth);
+        if (forumConfig->service.authListenUnixSocketPath.empty())
+        {
+            listenerAuth_ = std::make_unique<StreamSocketListener>(ioService,
+                forumConfig->service.authListenIPAddress,
+                forumConfig->service.authListenPort,
+                connectionManagerWithTimeoutAuth);
+        }
+        else
+        {
+            listenerAuth_ = std::make_unique<StreamSocketListener>(ioService,
+                forumConfig->service.authListenUnixSocketPath,
+                connectionManagerWithTimeoutAuth);
+        }
     }
     return true;
 }
@@ -18,11 +18,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
-#include "TcpListener.h"
 #include "HttpRouter.h"
 #include "CommandHandler.h"
 #include "MemoryRepositoryCommon.h"
 #include "ServiceEndpointManager.h"
+#include "StreamSocketListener.h"
 #include "EventObserver.h"
 #include "Plugin.h"
 
@@ -55,8 +55,8 @@ namespace Forum
 
         std::vector<Extensibility::LoadedPlugin> plugins_;
 
-        std::unique_ptr<Http::TcpListener> tcpListener_;
-        std::unique_ptr<Http::TcpListener> tcpListenerAuth_;
+        std::unique_ptr<Http::StreamSocketListener> listener_;
+        std::unique_ptr<Http::StreamSocketListener> listenerAuth_;
         
         std::unique_ptr<Commands::CommandHandler> commandHandler_;
         std::unique_ptr<Commands::ServiceEndpointManager> endpointManager_;
@@ -29,69 +29,211 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 namespace Json
 {
+    /**
+     * Takes over the content of a StringBuffer that no longer fits in the memory of the buffer
+     */
+    class OutputSink
+    {
+    public:
+        virtual ~OutputSink() = default;
+
+        /**
+         * Receives the content written since the previous call
+         * The content is either in the buffer's own memory or in the memory returned by the previous call
+         * @param blockSize Receives the size of the returned memory
+         * @returns Memory where the buffer continues writing, e.g. the free space at the final destination of the
+         *          content, so that it does not have to be copied again; nullptr to continue in the buffer's memory
+         */
+        virtual char* flush(std::string_view content, size_t& blockSize) = 0;
+    };
+
     class StringBuffer final : boost::noncopyable
     {
     public:
-        explicit StringBuffer(size_t growWith = 1024)
-            : buffer_(new char[growWith]), growWith_(growWith), capacity_(growWith), used_(0)
+        explicit StringBuffer(size_t initialCapacity = 1024)
+            : buffer_(new char[initialCapacity]), initialCapacity_(initialCapacity), bufferCapacity_(initialCapacity),
+              data_(buffer_.get()), capacity_(initialCapacity), used_(0)
         {
-            assert(growWith >= 128);
+            assert(initialCapacity >= 128);
         }
         
         void clear()
         {
+            data_ = buffer_.get();
+            capacity_ = bufferCapacity_;
             used_ = 0;
+            flushed_ = 0;
+        }
+
+        /**
+         * Returns to the initial capacity if an earlier output made the buffer grow beyond the specified limit,
+         * so that one large output does not keep the memory reserved for as long as the buffer lives
+         * Only allowed on an empty buffer, i.e. after clear(), as the content is not kept
+         */
+        void releaseIfLargerThan(const size_t maxCapacityToKeep)
+        {
+            assert(0 == size());
+            if ((bufferCapacity_ <= maxCapacityToKeep) || (bufferCapacity_ <= initialCapacity_))
+            {
+                return;
+            }
+            buffer_.reset(new char[initialCapacity_]);
+            bufferCapacity_ = initialCapacity_;
+            data_ = buffer_.get();
+            capacity_ = bufferCapacity_;
+        }
+
+        /**
+         * When a sink is set, the buffer no longer grows, content that does not fit is passed to the sink instead
+         * Only allowed on an empty buffer
+         */
+        void setSink(OutputSink* sink)
+        {
+            assert(0 == size());
+            sink_ = sink;
+        }
+
+        size_t capacity() const
+        {
+            return bufferCapacity_;
+        }
+
+        /**
+         * Returns the size of everything written since the last clear(), including what was passed to the sink
+         */
+        size_t size() const
+        {
+            return flushed_ + used_;
+        }
+
+        bool anyFlushedToSink() const
+        {
+            return flushed_ > 0;
         }
 
         void write(const char value)
         {
             if (BOOST_UNLIKELY(capacity_ < (used_ + sizeof(char))))
             {
-                resize();
+                makeRoom();
             }
-            *(buffer_.get() + used_) = value;
+            *(data_ + used_) = value;
             used_ += sizeof(char);
         }
 
         template<size_t Size>
         void writeFixed(const char* value)
         {
-            while (BOOST_UNLIKELY(capacity_ < (used_ + Size)))
+            if (BOOST_UNLIKELY(capacity_ < (used_ + Size)))
             {
-                resize();
+                writeWithoutRoom(value, Size);
+                return;
             }
-            std::copy(value, value + Size, buffer_.get() + used_);
+            std::copy(value, value + Size, data_ + used_);
             used_ += Size;
         }
 
         void write(const char* value, const size_t size)
         {
-            while (BOOST_UNLIKELY(capacity_ < (used_ + size)))
+            if (BOOST_UNLIKELY(capacity_ < (used_ + size)))
             {
-                resize();
+                writeWithoutRoom(value, size);
+                return;
             }
-            std::copy(value, value + size, buffer_.get() + used_);
+            std::copy(value, value + size, data_ + used_);
             used_ += size;
         }
 
+        /**
+         * Returns the content written since the last clear() or since the content was last passed to the sink
+         */
         std::string_view view() const
         {
-            return std::string_view(buffer_.get(), used_);
+            return std::string_view(data_, used_);
         }
 
     private:
+        void makeRoom()
+        {
+            if (sink_)
+            {
+                flushToSink();
+            }
+            else
+            {
+                resize();
+            }
+        }
+
+        void writeWithoutRoom(const char* value, size_t size)
+        {
+            if (nullptr == sink_)
+            {
+                while (capacity_ < (used_ + size))
+                {
+                    resize();
+                }
+                std::copy(value, value + size, data_ + used_);
+                used_ += size;
+                return;
+            }
+            //the value can be split between the memory blocks received from the sink
+            while (size > 0)
+            {
+                if (capacity_ == used_)
+                {
+                    flushToSink();
+                }
+                const auto toCopy = std::min(capacity_ - used_, size);
+                std::copy(value, value + toCopy, data_ + used_);
+                used_ += toCopy;
+                value += toCopy;
+                size -= toCopy;
+            }
+        }
+
+        void flushToSink()
+        {
+            size_t blockSize = 0;
+            const auto block = sink_->flush(view(), blockSize);
+
+            flushed_ += used_;
+            used_ = 0;
+            if ((nullptr != block) && (blockSize > 0))
+            {
+                data_ = block;
+                capacity_ = blockSize;
+            }
+            else
+            {
+                data_ = buffer_.get();
+                capacity_ = bufferCapacity_;
+            }
+        }
+
         void resize()
         {
+            assert(data_ == buffer_.get());
+            //grow geometrically so that large outputs are not copied over and over again
+            const auto newCapacity = bufferCapacity_ * 2;
             //on allocation exception, don't corrupt the state of the object
-            auto newBuffer = std::unique_ptr<char[]>(new char[capacity_ + growWith_]);
-            capacity_ += growWith_;
+            auto newBuffer = std::unique_ptr<char[]>(new char[newCapacity]);
             std::memcpy(newBuffer.get(), buffer_.get(), used_);
             std::swap(buffer_, newBuffer);
+            bufferCapacity_ = newCapacity;
+            data_ = buffer_.get();
+            capacity_ = bufferCapacity_;
         }
 
         std::unique_ptr<char[]> buffer_;
-        size_t growWith_;
+        size_t initialCapacity_;
+        size_t bufferCapacity_;
+        //either the buffer's own memory or memory received from the sink
+        char* data_;
         size_t capacity_;
         size_t used_;
+        OutputSink* sink_ = nullptr;
+        //what was already passed to the sink
+        size_t flushed_ = 0;
     };
 }
@@ -43,6 +43,11 @@ namespace Forum::Configuration
          * Do not update last seen more frequently than this amount (in seconds)
          */
         int_fast32_t lastSeenUpdatePrecision = 300;
+        /**
+         * Apply the last seen updates of read requests in batches, on a separate thread, every this amount
+         * (in milliseconds), so that read requests do not need exclusive access; 0 applies them after each request
+         */
+        int_fast32_t lastSeenUpdateBatchMilliseconds = 1000;
         int_fast32_t maxUsersPerPage = 20;
         /**
          * When returning the currently online users, look for users last seen within the specified seconds
@@ -62,10 +67,6 @@ namespace Forum::Configuration
     {
         int_fast16_t minNameLength = 3;
         int_fast16_t maxNameLength = 128;
-        /**
-         * Do not store more than this amount of users in the visited since last collection of a discussion thread
-         */
-        int_fast32_t maxUsersInVisitedSinceLastChange = 1024;
         int_fast32_t maxThreadsPerPage = 25;
     };
 
@@ -93,6 +94,10 @@ namespace Forum::Configuration
         int_fast16_t minNameLength = 2;
         int_fast16_t maxNameLength = 128;
         int_fast16_t maxUiBlobSize = 10000;
+        //thread orderings of a tag are only maintained on each change if they are read often enough
+        int_fast32_t minThreadOrderingAccessesToMaintain = 10;
+        int_fast32_t threadOrderingAccessWindow = 60;
+        int_fast32_t maintainThreadOrderingsWithoutAccessFor = 600;
     };
 
     struct DiscussionCategoryConfig
@@ -119,8 +124,12 @@ namespace Forum::Configuration
         int_fast32_t connectionPoolSize = 100;
         std::string listenIPAddress = "127.0.0.1";
         uint16_t listenPort = 8081;
+        //if not empty, listen on a local socket at this path instead of listenIPAddress:listenPort
+        std::string listenUnixSocketPath = "";
         std::string authListenIPAddress = "127.0.0.1";
         uint16_t authListenPort = 18081;
+        //if not empty, listen on a local socket at this path instead of authListenIPAddress:authListenPort
+        std::string authListenUnixSocketPath = "";
         size_t connectionTimeoutSeconds = 20;
         bool trustIpFromXForwardedFor = false;
         bool disableCommands = false;
@@ -128,6 +137,10 @@ namespace Forum::Configuration
         bool disableThrottling = false;
         std::string responsePrefix = "";
         std::string expectedOriginReferer = "";
+        //responses smaller than this are not compressed, 0 disables compressing responses
+        size_t compressionMinimumSize = 1024;
+        //zlib compression level, from 1 (fastest) to 9 (smallest output)
+        int_fast16_t compressionLevel = 1;
     };
 
     struct LoggingConfig
@@ -324,20 +337,52 @@ namespace Forum::Configuration
         DefaultPrivilegeDurationConfig defaultPrivilegeGrants;
     };
 
-    typedef std::shared_ptr<const Config> ConfigConstRef;
+    typedef const Config* ConfigConstRef;
+
+    struct PublishedConfig;
 
     /**
-     * Returns a thread-safe reference to an immutable configuration structure
+     * Returns a reference to an immutable configuration structure.
+     * Inside a ConfigSnapshot scope the pinned configuration is returned without touching any shared state.
+     * Outside of it, the reference stays valid until the same thread calls getGlobalConfig() again after a newer
+     * configuration has been published.
      */
     ConfigConstRef getGlobalConfig();
 
+    /**
+     * Returns a number that identifies the configuration returned by getGlobalConfig()
+     * Each published configuration receives a greater number than the previous ones.
+     */
+    uint64_t getGlobalConfigVersion();
+
     /**
      * Replaces the current configuration structure in a thread-safe manner.
-     * References to the old configuration should still be valid and point to the old data.
+     * References to the old configuration remain valid as described for getGlobalConfig(), after which it is freed.
      * Newer calls to getGlobalConfig() will receive the new configuration.
      */
     void setGlobalConfig(const Config& value);
 
+    /**
+     * Pins the current configuration for the calling thread until destroyed, 
+     * so that all reads during a request see the same values
+     * A snapshot created while another one is active keeps the configuration pinned by the outer one.
+     */
+    class ConfigSnapshot final
+    {
+    public:
+        ConfigSnapshot();
+        ~ConfigSnapshot();
+
+        ConfigSnapshot(const ConfigSnapshot&) = delete;
+        ConfigSnapshot(ConfigSnapshot&&) = delete;
+
+        ConfigSnapshot& operator=(const ConfigSnapshot&) = delete;
+        ConfigSnapshot& operator=(ConfigSnapshot&&) = delete;
+
+    private:
+        const PublishedConfig* previous_;
+    };
+
     /**
      * Loads the configuration data from a stream and sets it globally.
      * Any exception is thrown up the call stack
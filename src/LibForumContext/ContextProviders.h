@@ -87,6 +87,24 @@ namespace Forum::Context
      */
     void setVisitorCollection(std::shared_ptr<Repository::VisitorCollection> value);
 
+    /**
+     * Returns a value that changes every time the entities are modified
+     * The initial value depends on the start time, so values are not repeated after restarting the application
+     */
+    uint64_t getWriteGeneration();
+
+    /**
+     * Returns a value that changes every time the entities are modified, except for changes that only affect
+     * a single discussion thread and its messages, which change the version of that thread instead
+     */
+    uint64_t getSharedWriteGeneration();
+
+    /**
+     * Signals that the entities have been modified
+     * @param shared Whether the change can affect more than a single discussion thread and its messages
+     */
+    void incrementWriteGeneration(bool shared = true);
+
     /**
      * Returns whether a batch insert is currently in progress for optimization purposes
      */
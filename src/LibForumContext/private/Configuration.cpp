@@ -19,20 +19,82 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Configuration.h"
 #include "ContextProviders.h"
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+
 #include <boost/property_tree/json_parser.hpp>
 
 using namespace Forum::Configuration;
 
-static std::shared_ptr<const Config> currentConfig = std::make_shared<const Config>();
+struct Forum::Configuration::PublishedConfig final
+{
+    Config value;
+    uint64_t version;
+};
+
+static std::mutex publishedConfigsMutex;
+static uint64_t lastPublishedVersion = 0;
+//only accessed through std::atomic_load/std::atomic_store
+static std::shared_ptr<const PublishedConfig> currentConfig =
+        std::make_shared<const PublishedConfig>(PublishedConfig{ Config{}, ++lastPublishedVersion });
+//allows threads to check for a newer configuration without touching the reference count
+static std::atomic<const PublishedConfig*> currentConfigAddress{ currentConfig.get() };
+
+//keeps the configuration last used by the thread alive, older configurations are freed once no thread uses them
+static thread_local std::shared_ptr<const PublishedConfig> threadConfig;
+static thread_local const PublishedConfig* pinnedConfig = nullptr;
+
+static const PublishedConfig* refreshThreadConfig()
+{
+    if (threadConfig.get() != currentConfigAddress.load(std::memory_order_acquire))
+    {
+        threadConfig = std::atomic_load_explicit(&currentConfig, std::memory_order_acquire);
+    }
+    return threadConfig.get();
+}
+
+static const PublishedConfig& getThreadConfig()
+{
+    if (pinnedConfig)
+    {
+        return *pinnedConfig;
+    }
+    return *refreshThreadConfig();
+}
+
+ConfigConstRef Forum::Configuration::getGlobalConfig()
+{
+    return &getThreadConfig().value;
+}
 
-std::shared_ptr<const Config> Forum::Configuration::getGlobalConfig()
+uint64_t Forum::Configuration::getGlobalConfigVersion()
 {
-    return std::atomic_load(&currentConfig);
+    return getThreadConfig().version;
 }
 
 void Forum::Configuration::setGlobalConfig(const Config& value)
 {
-    std::atomic_store(&currentConfig, std::make_shared<const Config>(value));
+    std::lock_guard<std::mutex> lock(publishedConfigsMutex);
+
+    auto newConfig = std::make_shared<const PublishedConfig>(PublishedConfig{ value, ++lastPublishedVersion });
+    const auto newConfigAddress = newConfig.get();
+    std::atomic_store_explicit(&currentConfig, std::move(newConfig), std::memory_order_release);
+    currentConfigAddress.store(newConfigAddress, std::memory_order_release);
+}
+
+ConfigSnapshot::ConfigSnapshot() : previous_(pinnedConfig)
+{
+    //nested snapshots keep the configuration of the outer one, which the thread must not release
+    if ( ! pinnedConfig)
+    {
+        pinnedConfig = refreshThreadConfig();
+    }
+}
+
+ConfigSnapshot::~ConfigSnapshot()
+{
+    pinnedConfig = previous_;
 }
 
 #define CONCAT_MEMBER(structure, member) structure.member
@@ -68,6 +130,7 @@ void Forum::Configuration::loadGlobalConfigFromStream(std::istream& stream)
     LOAD_CONFIG_VALUE(user.minSignatureLength);
     LOAD_CONFIG_VALUE(user.maxSignatureLength);
     LOAD_CONFIG_VALUE(user.lastSeenUpdatePrecision);
+    LOAD_CONFIG_VALUE(user.lastSeenUpdateBatchMilliseconds);
     LOAD_CONFIG_VALUE(user.maxUsersPerPage);
     LOAD_CONFIG_VALUE(user.onlineUsersIntervalSeconds);
     LOAD_CONFIG_VALUE(user.maxLogoBinarySize);
@@ -81,7 +144,6 @@ void Forum::Configuration::loadGlobalConfigFromStream(std::istream& stream)
 
     LOAD_CONFIG_VALUE(discussionThread.minNameLength);
     LOAD_CONFIG_VALUE(discussionThread.maxNameLength);
-    LOAD_CONFIG_VALUE(discussionThread.maxUsersInVisitedSinceLastChange);
     LOAD_CONFIG_VALUE(discussionThread.maxThreadsPerPage);
 
     LOAD_CONFIG_VALUE(discussionThreadMessage.minContentLength);
@@ -100,6 +162,9 @@ void Forum::Configuration::loadGlobalConfigFromStream(std::istream& stream)
     LOAD_CONFIG_VALUE(discussionTag.minNameLength);
     LOAD_CONFIG_VALUE(discussionTag.maxNameLength);
     LOAD_CONFIG_VALUE(discussionTag.maxUiBlobSize);
+    LOAD_CONFIG_VALUE(discussionTag.minThreadOrderingAccessesToMaintain);
+    LOAD_CONFIG_VALUE(discussionTag.threadOrderingAccessWindow);
+    LOAD_CONFIG_VALUE(discussionTag.maintainThreadOrderingsWithoutAccessFor);
 
     LOAD_CONFIG_VALUE(discussionCategory.minNameLength);
     LOAD_CONFIG_VALUE(discussionCategory.maxNameLength);
@@ -116,8 +181,10 @@ void Forum::Configuration::loadGlobalConfigFromStream(std::istream& stream)
     LOAD_CONFIG_VALUE(service.connectionPoolSize);
     LOAD_CONFIG_VALUE(service.listenIPAddress);
     LOAD_CONFIG_VALUE(service.listenPort);
+    LOAD_CONFIG_VALUE(service.listenUnixSocketPath);
     LOAD_CONFIG_VALUE(service.authListenIPAddress);
     LOAD_CONFIG_VALUE(service.authListenPort);
+    LOAD_CONFIG_VALUE(service.authListenUnixSocketPath);
     LOAD_CONFIG_VALUE(service.connectionTimeoutSeconds);
     LOAD_CONFIG_VALUE(service.trustIpFromXForwardedFor);
     LOAD_CONFIG_VALUE(service.disableCommands);
@@ -125,6 +192,8 @@ void Forum::Configuration::loadGlobalConfigFromStream(std::istream& stream)
     LOAD_CONFIG_VALUE(service.disableThrottling);
     LOAD_CONFIG_VALUE(service.responsePrefix);
     LOAD_CONFIG_VALUE(service.expectedOriginReferer);
+    LOAD_CONFIG_VALUE(service.compressionMinimumSize);
+    LOAD_CONFIG_VALUE(service.compressionLevel);
 
     LOAD_CONFIG_VALUE(logging.settingsFile);
 
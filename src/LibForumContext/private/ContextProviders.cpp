@@ -19,6 +19,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "ContextProviders.h"
 #include "ContextProviderMocks.h"
 
+#include <atomic>
 #include <cassert>
 #include <chrono>
 
@@ -112,6 +113,34 @@ void Forum::Context::setVisitorCollection(std::shared_ptr<VisitorCollection> val
     visitorCollection = value;
 }
 
+static uint64_t getInitialWriteGeneration()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+static std::atomic<uint64_t> writeGeneration{ getInitialWriteGeneration() };
+static std::atomic<uint64_t> sharedWriteGeneration{ getInitialWriteGeneration() };
+
+uint64_t Forum::Context::getWriteGeneration()
+{
+    return writeGeneration.load(std::memory_order_acquire);
+}
+
+uint64_t Forum::Context::getSharedWriteGeneration()
+{
+    return sharedWriteGeneration.load(std::memory_order_acquire);
+}
+
+void Forum::Context::incrementWriteGeneration(const bool shared)
+{
+    if (shared)
+    {
+        sharedWriteGeneration.fetch_add(1, std::memory_order_acq_rel);
+    }
+    writeGeneration.fetch_add(1, std::memory_order_acq_rel);
+}
+
 static bool batchInsertInProgress{ false };
 
 bool Forum::Context::isBatchInsertInProgress()
@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "AuthorizationPrivileges.h"
 #include "Entities.h"
 
+#include <bitset>
 #include <cstddef>
 #include <tuple>
 
@@ -56,6 +57,36 @@ namespace Forum::Authorization
         bool allowedToViewComments = false;
     };
 
+    /**
+     * Holds the outcome of all privilege checks needed to serialize a discussion thread as part of a list
+     */
+    struct DiscussionThreadPrivilegeCheck final
+    {
+        DiscussionThreadPrivilegeCheck() = default;
+
+        DiscussionThreadPrivilegeCheck(Entities::UserConstPtr user, const Entities::DiscussionThread& thread)
+            : user(user), thread(&thread) {}
+        ~DiscussionThreadPrivilegeCheck() = default;
+
+        DiscussionThreadPrivilegeCheck(const DiscussionThreadPrivilegeCheck&) = default;
+        DiscussionThreadPrivilegeCheck(DiscussionThreadPrivilegeCheck&&) = default;
+
+        DiscussionThreadPrivilegeCheck& operator=(const DiscussionThreadPrivilegeCheck&) = default;
+        DiscussionThreadPrivilegeCheck& operator=(DiscussionThreadPrivilegeCheck&&) = default;
+
+        bool isAllowed(DiscussionThreadPrivilege privilege) const
+        {
+            return allowed.test(static_cast<size_t>(privilege));
+        }
+
+        Entities::UserConstPtr user;
+        const Entities::DiscussionThread* thread = nullptr;
+        std::bitset<static_cast<size_t>(DiscussionThreadPrivilege::COUNT)> allowed;
+        bool allowedToShowThread = false;
+        bool allowedToShowLatestMessage = false;
+        bool allowedToShowLatestMessageUser = false;
+    };
+
     class GrantedPrivilegeStore final : boost::noncopyable
     {
     public:
@@ -119,6 +150,12 @@ namespace Forum::Authorization
 
         void computeDiscussionThreadMessageVisibilityAllowed(DiscussionThreadMessagePrivilegeCheck* items,
                                                              size_t nrOfItems, Entities::Timestamp now) const;
+        /**
+         * Computes the privileges of a page of threads in one pass,
+         * reusing the values granted via tags and forum wide for all threads
+         */
+        void computeDiscussionThreadPrivileges(DiscussionThreadPrivilegeCheck* items, size_t nrOfItems,
+                                               Entities::Timestamp now) const;
 
         typedef std::function<void(Entities::IdTypeRef, PrivilegeValueIntType,
                                    Entities::Timestamp, Entities::Timestamp)> EnumerationCallback;
@@ -224,10 +261,24 @@ namespace Forum::Authorization
         typedef boost::multi_index_container<PrivilegeEntry, PrivilegeEntryCollectionIndices>
                 PrivilegeEntryCollection;
 
-        void calculatePrivilege(const PrivilegeEntryCollection& collection, Entities::UserConstPtr user,
-                                Entities::IdTypeRef entityId, Entities::Timestamp now,
+        enum class PrivilegeScope : uint8_t
+        {
+            DiscussionThreadMessage,
+            DiscussionThread,
+            DiscussionTag,
+            DiscussionCategory,
+            ForumWide
+        };
+
+        void calculatePrivilege(const PrivilegeEntryCollection& collection, PrivilegeScope scope,
+                                Entities::UserConstPtr user, Entities::IdTypeRef entityId, Entities::Timestamp now,
                                 PrivilegeValueType& positiveValue, PrivilegeValueType& negativeValue) const;
 
+        /**
+        * Invalidates the granted privilege values cached by each thread
+        */
+        static void invalidateCachedPrivileges();
+
         PrivilegeEntryCollection discussionThreadMessageSpecificPrivileges_;
         PrivilegeEntryCollection discussionThreadSpecificPrivileges_;
         PrivilegeEntryCollection discussionTagSpecificPrivileges_;
@@ -22,20 +22,42 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "AuthorizationPrivileges.h"
 #include "ThrottlingCheck.h"
 #include "IdOrIpAddress.h"
+#include "ShardedCounter.h"
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
 #include <unordered_map>
 
 #include <boost/noncopyable.hpp>
 
 namespace Forum::Authorization
 {
+    struct ThrottlingStatistics final
+    {
+        uint64_t entries = 0;
+        uint64_t evictions = 0;
+        uint64_t throttled = 0;
+    };
+
+    /**
+     * Keeps the recent actions of each user or IP address in shards with separate locks
+     * Entries that have been idle for longer than the longest throttling period are evicted by periodically
+     * sweeping each shard, as they no longer influence any check
+     * A sweep is spread over multiple checks: each one advances a clock hand over a few buckets of the shard,
+     * so that no check holds the lock of a shard for a full pass
+     */
     class DefaultThrottling final : boost::noncopyable
     {
     public:
         bool check(UserActionThrottling action, Entities::Timestamp at, const Entities::IdType& id,
                    const Helpers::IpAddress& ip);
 
+        ThrottlingStatistics statistics() const;
+
+        static constexpr Entities::Timestamp SweepInterval = 60;
+        static constexpr size_t BucketsSweptPerCheck = 16;
+
     private:
         struct UserThrottlingChecks
         {
@@ -51,9 +73,24 @@ namespace Forum::Authorization
                 });
             }
             CheckType values[static_cast<EnumIntType>(UserActionThrottling::COUNT)];
+            Entities::Timestamp lastActivity{ 0 };
         };
 
-        std::unordered_map<Entities::IdOrIpAddress, UserThrottlingChecks> entries_;
-        Helpers::SpinLock lock_;
+        struct alignas(Helpers::CacheLineSize) Shard
+        {
+            std::unordered_map<Entities::IdOrIpAddress, UserThrottlingChecks> entries;
+            Entities::Timestamp nextSweepAt{ 0 };
+            //bucket where the current sweep continues, only meaningful while sweeping
+            //if the entries are rehashed in the meantime some of them are only checked during the next sweep
+            size_t sweepBucket{ 0 };
+            bool sweeping{ false };
+            uint64_t evictions{ 0 };
+            uint64_t throttled{ 0 };
+            mutable Helpers::SpinLock lock;
+        };
+
+        static void continueSweep(Shard& shard, Entities::Timestamp at);
+
+        std::array<Shard, Helpers::NrOfShards> shards_;
     };
 }
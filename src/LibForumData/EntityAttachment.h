@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "ConstCollectionAdapter.h"
 #include "EntityCommonTypes.h"
+#include "ShardedCounter.h"
 #include "StringHelpers.h"
 
 #include <boost/noncopyable.hpp>
@@ -115,7 +116,7 @@ namespace Forum::Entities
         NameType name_;
         uint64_t size_;
         bool approved_;
-        mutable std::atomic<uint32_t> nrOfGetRequests_{ 0 };
+        mutable Helpers::ShardedCounter<uint32_t> nrOfGetRequests_;
 
         boost::container::flat_set<DiscussionThreadMessage*> messages_;
     };
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "ConstCollectionAdapter.h"
 #include "EntityAttachment.h"
+#include "ParallelHelpers.h"
 
 #include <boost/noncopyable.hpp>
 
@@ -37,6 +38,7 @@ namespace Forum::Entities
         bool remove(AttachmentPtr attachmentPtr);
 
         void stopBatchInsert();
+        void stopBatchInsert(Helpers::ParallelTaskRunner& tasks);
 
         void prepareUpdateName(AttachmentPtr attachmentPtr);
         void updateName(AttachmentPtr attachmentPtr);
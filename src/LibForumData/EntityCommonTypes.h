@@ -23,8 +23,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "SortedVector.h"
 
 #include <cstdint>
+#include <functional>
 #include <limits>
 #include <utility>
+#include <vector>
 
 #include <boost/preprocessor/cat.hpp>
 
@@ -87,6 +89,11 @@ namespace Forum::Entities
         boost::multi_index::ranked_non_unique<INDEX_CONST_MEM_FUN(Type, Getter)>>>
 #define RANKED_COLLECTION_ITERATOR(Member) decltype(Member)::nth_index<0>::type::iterator
 
+#define RANKED_COLLECTION_GREATER(Type, Getter) \
+    boost::multi_index_container<Type*, boost::multi_index::indexed_by< \
+        boost::multi_index::ranked_non_unique<INDEX_CONST_MEM_FUN(Type, Getter), std::greater<>>>>
+#define RANKED_COLLECTION_GREATER_ITERATOR(Member) decltype(Member)::nth_index<0>::type::iterator
+
 #define RANKED_UNIQUE_COLLECTION(Type, Getter) \
     boost::multi_index_container<Type*, boost::multi_index::indexed_by< \
         boost::multi_index::ranked_unique<INDEX_CONST_MEM_FUN(Type, Getter)>>>
@@ -210,6 +217,29 @@ namespace Forum::Entities
         assert(false); //not found
     }
 
+    /**
+     * Replaces the contents of an ordered/ranked index, sorting the values beforehand so that each one
+     * can be appended at the end instead of searching for its position
+     */
+    template<typename Collection, typename It>
+    void rebuildIndex(Collection& collection, It begin, It end)
+    {
+        std::vector<typename Collection::value_type> values(begin, end);
+        Helpers::parallelSort(values.begin(), values.end(), collection.value_comp());
+
+        collection.clear();
+        for (auto& value : values)
+        {
+            collection.insert(collection.end(), value);
+        }
+    }
+
+    template<typename T, typename Key, typename KeyExtractor, typename Compare, typename It>
+    void rebuildIndex(SortedVectorMultiValue<T, Key, KeyExtractor, Compare>& collection, It begin, It end)
+    {
+        collection.rebuild(begin, end);
+    }
+
     template<typename Collection, typename Entity, typename Value>
     auto findInNonUniqueCollection(Collection& collection, Entity toCompare, const Value& toSearch)
     {
@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "EntityUser.h"
 #include "TypeHelpers.h"
 
+#include <atomic>
 #include <string>
 
 #include <boost/noncopyable.hpp>
@@ -38,6 +39,9 @@ namespace Forum::Entities
     *
     * The discussion category manages the message count and the total thread/message counts
     * when adding/removing threads and/or tags
+    *
+    * Ancestors only hold the total counts. Whether a thread is already counted by an ancestor is derived
+    * from the categories that directly reference the thread, so no per-ancestor thread collections are kept
     */
     class DiscussionCategory final : public Authorization::DiscussionCategoryPrivilegeStore,
                                      boost::noncopyable
@@ -65,8 +69,8 @@ namespace Forum::Entities
 
                auto messageCount()       const { return messageCount_; }
 
-               auto threadTotalCount()   const { return totalThreads_.count(); }
-               auto messageTotalCount()  const { return totalThreads_.messageCount(); }
+               auto threadTotalCount()   const { return threadTotalCount_; }
+               auto messageTotalCount()  const { return messageTotalCount_; }
 
         const DiscussionThreadMessage* latestMessage() const;
 
@@ -142,7 +146,7 @@ namespace Forum::Entities
         void stopBatchInsert()
         {
             threads_.stopBatchInsert();
-            totalThreads_.stopBatchInsert();
+            resetLatestMessage();
         }
 
         auto& parent()             { return parent_; }
@@ -162,7 +166,7 @@ namespace Forum::Entities
 
         bool insertDiscussionThread(DiscussionThreadPtr thread);
         bool insertDiscussionThreads(DiscussionThreadPtr* threads, size_t count);
-        bool deleteDiscussionThread(DiscussionThreadPtr thread, bool deleteMessages, bool onlyThisCategory);
+        bool deleteDiscussionThread(DiscussionThreadPtr thread, bool deleteMessages);
         void deleteDiscussionThreadIfNoOtherTagsReferenceIt(DiscussionThreadPtr thread, bool deleteMessages);
 
         bool addTag(DiscussionTagPtr tag);
@@ -171,12 +175,26 @@ namespace Forum::Entities
 
         void updateMessageCount(DiscussionThreadPtr thread, int_fast32_t delta);
 
+        /**
+        * Removes the threads of the child category and its descendants from the totals of this category and parents
+        * Must be called while the child is still attached to this category
+        */
         void removeTotalsFromChild(const DiscussionCategory& childCategory);
+        /**
+        * Adds the threads of the child category and its descendants to the totals of this category and parents
+        * Must be called after the child has been attached to this category
+        */
         void addTotalsFromChild(const DiscussionCategory& childCategory);
 
     private:
         bool insertDiscussionThreadsOfTag(DiscussionTagPtr tag);
 
+        void addToTotals(DiscussionThreadPtr thread);
+        void removeFromTotals(DiscussionThreadPtr thread, bool deleteMessages);
+        void updateTotalsFromChild(const DiscussionCategory& childCategory, int_fast32_t direction);
+
+        void resetLatestMessage();
+
     private:
         static ChangeNotification changeNotifications_;
 
@@ -195,7 +213,12 @@ namespace Forum::Entities
         UserPtr lastUpdatedBy_{};
 
         DiscussionThreadCollectionWithHashedIdAndPinOrder threads_;
-        DiscussionThreadCollectionWithReferenceCountAndMessageCount totalThreads_;
+        int_fast32_t threadTotalCount_{0};
+        int_fast32_t messageTotalCount_{0};
+
+        //cached latest message of this category and all descendants, reset when the totals of the category change
+        mutable std::atomic<const DiscussionThreadMessage*> latestMessage_{};
+        mutable std::atomic_bool latestMessageValid_{false};
 
         boost::container::flat_set<DiscussionTagPtr> tags_;
         //enable fast search of children, client can sort them on display order
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "ConstCollectionAdapter.h"
 #include "EntityDiscussionCategory.h"
+#include "ParallelHelpers.h"
 
 #include <boost/noncopyable.hpp>
 
@@ -37,7 +38,7 @@ namespace Forum::Entities
         bool add(DiscussionCategoryPtr category);
         bool remove(DiscussionCategoryPtr category);
 
-        void stopBatchInsert();
+        void stopBatchInsert(Helpers::ParallelTaskRunner& tasks);
 
         void prepareUpdateName(DiscussionCategoryPtr category);
         void updateName(DiscussionCategoryPtr category);
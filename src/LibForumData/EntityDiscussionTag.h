@@ -38,6 +38,7 @@ namespace Forum::Entities
     * Repositories are responsible for updating the relationships between this message and other entities
     *
     * The tag manages the message count and also notifies any discussion categories when a thread is added or removed
+    * Thread orderings are only built when requested, see DiscussionThreadCollectionWithLazyOrder
     */
     class DiscussionTag final : public Authorization::DiscussionTagPrivilegeStore,
                                 boost::noncopyable
@@ -140,7 +141,7 @@ namespace Forum::Entities
         NameType name_;
         std::string uiBlob_;
 
-        DiscussionThreadCollectionWithHashedId threads_;
+        DiscussionThreadCollectionWithLazyOrder threads_;
 
         Timestamp lastUpdated_{0};
         VisitDetails lastUpdatedDetails_;
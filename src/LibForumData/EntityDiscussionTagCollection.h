@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "ConstCollectionAdapter.h"
 #include "EntityDiscussionTag.h"
+#include "ParallelHelpers.h"
 
 #include <boost/noncopyable.hpp>
 
@@ -36,7 +37,7 @@ namespace Forum::Entities
         bool add(DiscussionTagPtr tag);
         bool remove(DiscussionTagPtr tag);
 
-        void stopBatchInsert();
+        void stopBatchInsert(Helpers::ParallelTaskRunner& tasks);
 
         void prepareUpdateName(DiscussionTagPtr tag);
         void updateName(DiscussionTagPtr tag);
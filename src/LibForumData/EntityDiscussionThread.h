@@ -19,8 +19,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 
 #include "AuthorizationPrivileges.h"
+#include "CompressedBitmap.h"
 #include "EntityCommonTypes.h"
 #include "EntityDiscussionThreadMessageCollection.h"
+#include "ShardedCounter.h"
+#include "SpinLock.h"
 #include "StringHelpers.h"
 
 #include <atomic>
@@ -82,11 +85,10 @@ namespace Forum::Entities
         }
 
                auto latestVisibleChange()       const { return latestVisibleChange_; }
+               auto version()                   const { return version_; }
 
                auto latestMessageCreated()      const { return latestMessageCreated_; }
 
-               auto nrOfVisitorsSinceLastEdit() const { return visitorsSinceLastEdit_.size(); }
-
                auto tags()                      const { return Helpers::toConst(tags_); }
                auto categories()                const { return Helpers::toConst(categories_); }
 
@@ -186,10 +188,17 @@ namespace Forum::Entities
 
         auto& latestVisibleChange() { return latestVisibleChange_; }
 
+        /**
+         * Records a change of the thread or its messages that leaves the shared write generation unchanged,
+         * so that only cached responses about this thread need to be downloaded again
+         */
+        void incrementVersion() { ++version_; }
+
         /**
         * Thread-safe reference to the number of times the thread was visited.
         * Can be updated even for const values as it is not refenced in any index.
-        * @return An atomic integer of at least 64-bits
+        * Increments are spread across multiple shards once the thread is visited concurrently.
+        * @return A sharded counter of at least 64-bits
         */
         auto& visited()    const { return visited_; }
 
@@ -227,8 +236,12 @@ namespace Forum::Entities
         void insertMessages(DiscussionThreadMessageCollectionLowMemory& collection);
         void deleteDiscussionThreadMessage(DiscussionThreadMessagePtr message);
 
-        void addVisitorSinceLastEdit(IdTypeRef userId);
-        bool hasVisitedSinceLastEdit(IdTypeRef userId) const;
+        /**
+        * Thread-safe, only requires a read lock on the repository
+        */
+        void addVisitorSinceLastEdit(const User& user) const;
+        bool hasVisitedSinceLastEdit(const User& user) const;
+        size_t nrOfVisitorsSinceLastEdit() const;
         void resetVisitorsSinceLastEdit();
 
         bool addTag(DiscussionTag* tag);
@@ -265,9 +278,14 @@ namespace Forum::Entities
         uint16_t aboutToBeDeleted_ : 1;
         uint16_t approved_ : 1;
 
-        mutable std::atomic_int_fast64_t visited_{0};
+        //combined with the shared write generation when checking if cached responses about the thread are current
+        uint32_t version_{0};
+
+        mutable Helpers::ShardedCounter<int_fast64_t> visited_;
 
-        boost::container::flat_set<boost::uuids::uuid> visitorsSinceLastEdit_;
+        //indexed by the ordinal of each user
+        mutable Helpers::CompressedBitmap visitorsSinceLastEdit_;
+        mutable Helpers::SpinLock visitorsSinceLastEditLock_;
 
         boost::container::flat_set<DiscussionTag*> tags_;
         boost::container::flat_set<DiscussionCategory*> categories_;
@@ -22,9 +22,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "ConstCollectionAdapter.h"
 #include "ContextProviders.h"
 #include "EntityDiscussionThread.h"
+#include "ParallelHelpers.h"
 #include "TypeHelpers.h"
 
-#include <unordered_map>
+#include <atomic>
+#include <memory>
+#include <mutex>
 
 #include <boost/noncopyable.hpp>
 
@@ -59,6 +62,10 @@ namespace Forum::Entities
         virtual bool remove(DiscussionThreadPtr thread);
 
         void stopBatchInsert();
+        /**
+         * Schedules the rebuild of each index as a separate task instead of rebuilding them immediately
+         */
+        void stopBatchInsert(Helpers::ParallelTaskRunner& tasks);
 
         bool contains(DiscussionThreadPtr thread) const;
 
@@ -133,7 +140,7 @@ namespace Forum::Entities
         void prepareCountChange();
         void finishCountChange();
 
-        virtual void onStopBatchInsert();
+        virtual void onStopBatchInsert(Helpers::ParallelTaskRunner& tasks);
 
         HASHED_UNIQUE_COLLECTION(DiscussionThread, id) byId_;
 
@@ -163,7 +170,7 @@ namespace Forum::Entities
         bool add(DiscussionThreadPtr* threads, size_t threadCount) override;
         bool remove(DiscussionThreadPtr thread) override;
 
-        void onStopBatchInsert() override;
+        void onStopBatchInsert(Helpers::ParallelTaskRunner& tasks) override;
 
         void prepareUpdatePinDisplayOrder(DiscussionThreadPtr thread) override;
         void updatePinDisplayOrder(DiscussionThreadPtr thread) override;
@@ -175,43 +182,173 @@ namespace Forum::Entities
         SORTED_VECTOR_COLLECTION_ITERATOR(byPinDisplayOrder_) byPinDisplayOrderUpdateIt_;
     };
 
-    class DiscussionThreadCollectionWithReferenceCountAndMessageCount final : boost::noncopyable
+    /**
+    * Only keeps the id index up to date and builds the sorted orderings when they are first requested
+    *
+    * Orderings of collections that are read often (hot) are maintained on each change, while orderings of
+    * the other collections (cold) are discarded on the first change affecting them and rebuilt on demand
+    */
+    class DiscussionThreadCollectionWithLazyOrder final : public IDiscussionThreadCollection,
+                                                          boost::noncopyable
     {
     public:
         bool add(DiscussionThreadPtr thread);
-        void add(const DiscussionThreadCollectionWithReferenceCountAndMessageCount& collection);
+        bool add(DiscussionThreadPtr* threads, size_t threadCount);
+        bool remove(DiscussionThreadPtr thread);
 
-        /**
-        * Reduces the reference count of the thread, removing it once the count drops to 0
-        * Used when a thread is no longer referenced via a tag
-        */
-        void decreaseReferenceCount(DiscussionThreadPtr thread);
-        void decreaseReferenceCount(const DiscussionThreadCollectionWithReferenceCountAndMessageCount& collection);
+        void stopBatchInsert();
 
-        /**
-        * Removes a thread completely, even if the reference count is > 1
-        * Used when a thread is permanently deleted
-        */
-        bool remove(DiscussionThreadPtr thread);
+        bool contains(DiscussionThreadPtr thread) const;
+
+        const DiscussionThread* findById(IdTypeRef id) const;
+            DiscussionThreadPtr findById(IdTypeRef id);
 
-        void clear();
+        template<typename Fn>
+        void iterateThreads(Fn&& callback) const
+        {
+            for (auto& threadPtr : byId_)
+            {
+                callback(static_cast<const DiscussionThread*>(threadPtr));
+            }
+        }
 
-        void stopBatchInsert();
+        template<typename Fn>
+        void iterateThreads(Fn&& callback)
+        {
+            for (auto& threadPtr : byId_)
+            {
+                callback(threadPtr);
+            }
+        }
+
+        void prepareUpdateName(DiscussionThreadPtr thread) override;
+        void updateName(DiscussionThreadPtr thread) override;
+
+        void prepareUpdateLastUpdated(DiscussionThreadPtr thread) override;
+        void updateLastUpdated(DiscussionThreadPtr thread) override;
 
-        auto count()        const { return byId_.size(); }
-        auto messageCount() const { return messageCount_; }
-        auto& byId()              { return byId_; }
-        auto  byId()        const { return Helpers::toConst(byId_); }
+        void prepareUpdateLatestMessageCreated(DiscussionThreadPtr thread) override;
+        void updateLatestMessageCreated(DiscussionThreadPtr thread) override;
 
-        auto& messageCount()           { return messageCount_; }
+        void prepareUpdateMessageCount(DiscussionThreadPtr thread) override;
+        void updateMessageCount(DiscussionThreadPtr thread) override;
+
+        void prepareUpdatePinDisplayOrder(DiscussionThreadPtr /*thread*/) override {} //pin order is not kept
+        void updatePinDisplayOrder(DiscussionThreadPtr /*thread*/) override {}
+
+        auto count()                  const { return byId_.size(); }
+        bool maintainsOrderings()     const { return hot_; }
+
+        auto byName()                 const { return Helpers::toConst(materialize(byName_)); }
+        auto byCreated()              const { return Helpers::toConst(materialize(byCreated_)); }
+        auto byLastUpdated()          const { return Helpers::toConst(materialize(byLastUpdated_)); }
+        auto byLatestMessageCreated() const { return Helpers::toConst(materialize(byLatestMessageCreated_)); }
+        auto byMessageCount()         const { return Helpers::toConst(materialize(byMessageCount_)); }
+
+        /**
+         * Returns the thread with the most recent message without building the full ordering
+         */
+        const DiscussionThread* latestMessageThread() const;
 
     private:
-        bool add(DiscussionThreadPtr thread, int_fast32_t amount);
+        template<typename Collection>
+        struct LazyOrdering final
+        {
+            //kept behind a pointer so that an ordering built outside the lock can be stored without copying it
+            std::unique_ptr<Collection> values;
+            typename Collection::iterator updateIt;
+            std::atomic_bool valid{ false };
+        };
+
+        template<typename Collection>
+        const Collection& materialize(LazyOrdering<Collection>& ordering) const
+        {
+            recordAccess();
+            if ( ! ordering.valid.load(std::memory_order_acquire))
+            {
+                //the ordering is built without holding the lock so that readers of other orderings are not blocked
+                auto values = std::make_unique<Collection>();
+                rebuildIndex(*values, byId_.begin(), byId_.end());
+
+                //multiple readers might request the same ordering at the same time, only the first one stores it
+                std::lock_guard<std::mutex> _(materializeMutex_);
+                if ( ! ordering.valid.load(std::memory_order_relaxed))
+                {
+                    ordering.values = std::move(values);
+                    ordering.valid.store(true, std::memory_order_release);
+                }
+            }
+            return *ordering.values;
+        }
+
+        template<typename Collection>
+        static void discard(LazyOrdering<Collection>& ordering)
+        {
+            ordering.valid.store(false, std::memory_order_release);
+            ordering.values.reset();
+        }
+
+        template<typename Fn>
+        void forEachOrdering(Fn&& fn)
+        {
+            fn(byName_);
+            fn(byCreated_);
+            fn(byLastUpdated_);
+            fn(byLatestMessageCreated_);
+            fn(byMessageCount_);
+        }
+
+        template<typename Collection, typename Value>
+        void prepareUpdate(LazyOrdering<Collection>& ordering, DiscussionThreadPtr thread, const Value& value)
+        {
+            if ( ! ordering.valid.load(std::memory_order_relaxed)) return;
+
+            if (hot_)
+            {
+                ordering.updateIt = findInNonUniqueCollection(*ordering.values, thread, value);
+            }
+            else
+            {
+                discard(ordering);
+            }
+        }
+
+        template<typename Collection>
+        static void update(LazyOrdering<Collection>& ordering, DiscussionThreadPtr thread)
+        {
+            if ( ! ordering.valid.load(std::memory_order_relaxed)) return;
+
+            if (ordering.updateIt != ordering.values->end())
+            {
+                replaceItemInContainer(*ordering.values, ordering.updateIt, thread);
+            }
+        }
+
+        void recordAccess() const;
+        /**
+         * Decides whether the orderings should be maintained based on how often they have been accessed recently
+         * Only called while holding exclusive access to the collection
+         */
+        void updateTemperature();
 
         HASHED_UNIQUE_COLLECTION(DiscussionThread, id) byId_;
 
-        int_fast32_t messageCount_ = 0;
-        std::unordered_map<DiscussionThreadPtr, int_fast32_t> referenceCount_;
+        //ranked indexes keep inserts and updates of hot tags logarithmic in the number of threads
+        mutable LazyOrdering<RANKED_COLLECTION(DiscussionThread, name)> byName_;
+        mutable LazyOrdering<RANKED_COLLECTION(DiscussionThread, created)> byCreated_;
+        mutable LazyOrdering<RANKED_COLLECTION(DiscussionThread, lastUpdated)> byLastUpdated_;
+        mutable LazyOrdering<RANKED_COLLECTION(DiscussionThread, latestMessageCreated)> byLatestMessageCreated_;
+        mutable LazyOrdering<RANKED_COLLECTION_GREATER(DiscussionThread, messageCount)> byMessageCount_;
+        mutable std::mutex materializeMutex_;
+
+        mutable std::atomic<DiscussionThreadPtr> latestMessageThread_{};
+        mutable std::atomic_bool latestMessageThreadValid_{ false };
+        Timestamp latestMessageCreatedBeforeUpdate_{ 0 };
+
+        bool hot_{ false };
+        mutable std::atomic<uint32_t> recentAccesses_{ 0 };
+        mutable std::atomic<Timestamp> lastAccess_{ 0 };
+        Timestamp accessWindowStart_{ 0 };
     };
 
     class DiscussionThreadCollectionLowMemory final : public IDiscussionThreadCollection,
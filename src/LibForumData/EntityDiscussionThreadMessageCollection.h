@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "CallbackWrapper.h"
 #include "ConstCollectionAdapter.h"
 #include "EntityDiscussionThreadMessage.h"
+#include "ParallelHelpers.h"
 
 #include <boost/noncopyable.hpp>
 #include <boost/optional.hpp>
@@ -39,7 +40,7 @@ namespace Forum::Entities
         bool remove(DiscussionThreadMessagePtr message);
         void clear();
 
-        void stopBatchInsert();
+        void stopBatchInsert(Helpers::ParallelTaskRunner& tasks);
 
         auto& onPrepareCountChange() { return onPrepareCountChange_; }
         auto& onCountChange()        { return onCountChange_; }
@@ -20,6 +20,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "AuthorizationGrantedPrivilegeStore.h"
 #include "JsonWriter.h"
+#include "OutputHelpers.h"
+#include "StateHelpers.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
 
 #include <boost/optional.hpp>
 
@@ -52,14 +58,11 @@ namespace Forum::Entities
         bool keepDiscussionCategoryDetails = false;
         boost::optional<int> displayDiscussionCategoryParentRecursionDepth = boost::none;
 
-        boost::optional<bool> allowDisplayDiscussionThreadMessage = boost::none;
-        boost::optional<bool> allowDisplayDiscussionThreadMessageUser = boost::none;
-        boost::optional<bool> allowDisplayDiscussionThreadMessageVotes = boost::none;
-        boost::optional<bool> allowDisplayDiscussionThreadMessageIpAddress = boost::none;
-        boost::optional<bool> allowDisplayDiscussionThreadMessageComments = boost::none;
-
         UserConstPtr currentUser{};
 
+        //privileges computed in advance for showing the latest message of the tag currently being serialized
+        const Authorization::DiscussionThreadPrivilegeCheck* discussionThreadPrivilegeCheck = nullptr;
+
         bool hideLatestMessage = false;
         bool hidePrivileges = false;
         bool onlySendCategoryParentId = false;
@@ -72,6 +75,38 @@ namespace Forum::Entities
 
     extern thread_local SerializationSettings serializationSettings;
 
+    /**
+     * Decides once per view which optional fields are written, instead of for every serialized entity
+     *
+     * The forum-wide privileges and the view settings do not depend on the entity being serialized, so they are
+     * resolved when the plan is created. Pages of users, discussion threads and discussion thread messages are then
+     * written by specialized writers that take the plan instead of reading serializationSettings or changing it
+     * temporarily for each nested entity.
+     * The view settings are copied from serializationSettings, so a plan needs to be created after changing them.
+     */
+    struct SerializationPlan final : private boost::noncopyable
+    {
+        explicit SerializationPlan(const Authorization::SerializationRestriction& restriction);
+
+        const Authorization::SerializationRestriction& restriction;
+        UserConstPtr currentUser;
+        IdType currentUserId;
+
+        bool showUserInfo;
+        bool showUserSubscribedThreadCount;
+        bool showUserAttachments;
+        bool showUserAttachmentQuota;
+        bool showAllMessageAttachments;
+
+        bool showThreadCreatedBy;
+        bool showThreadMessages;
+        bool showLatestMessage;
+        bool showVisitedThreadSinceLastChange;
+        bool showMessageCreatedBy;
+        bool showMessageParentThread;
+        bool showPrivileges;
+    };
+
     Json::JsonWriter& serialize(Json::JsonWriter& writer, const DiscussionThreadMessage& message,
                                 const Authorization::SerializationRestriction& restriction);
 
@@ -99,6 +134,22 @@ namespace Forum::Entities
     Json::JsonWriter& serialize(Json::JsonWriter& writer, const User& user,
                                 const Authorization::SerializationRestriction& restriction);
 
+    Json::JsonWriter& serialize(Json::JsonWriter& writer, const User& user, const SerializationPlan& plan);
+
+    /**
+     * Writes a discussion thread that is part of a page, using privileges computed in advance
+     */
+    Json::JsonWriter& serialize(Json::JsonWriter& writer, const DiscussionThread& thread,
+                                const SerializationPlan& plan,
+                                const Authorization::DiscussionThreadPrivilegeCheck& check, bool visitedSinceLastChange);
+
+    /**
+     * Writes a discussion thread message that is part of a page, using privileges computed in advance
+     */
+    Json::JsonWriter& serialize(Json::JsonWriter& writer, const DiscussionThreadMessage& message,
+                                const SerializationPlan& plan,
+                                const Authorization::DiscussionThreadMessagePrivilegeCheck& check);
+
     template<typename Entity, typename PrivilegeArray, typename PrivilegeStringArray>
     static void writePrivileges(Json::JsonWriter& writer, const Entity& entity,
                                 const PrivilegeArray& privilegeArray,
@@ -116,4 +167,100 @@ namespace Forum::Entities
         }
         writer.endArray();
     }
+
+    template<typename PrivilegeBitset, typename PrivilegeArray, typename PrivilegeStringArray>
+    static void writePrecomputedPrivileges(Json::JsonWriter& writer, const PrivilegeBitset& allowed,
+                                           const PrivilegeArray& privilegeArray,
+                                           const PrivilegeStringArray& privilegeStrings)
+    {
+        writer.newPropertyWithSafeName("privileges");
+        writer.startArray();
+        for (auto& value : privilegeArray)
+        {
+            if (allowed.test(static_cast<size_t>(value)))
+            {
+                writer.writeSafeString(privilegeStrings[static_cast<int>(value)]);
+            }
+        }
+        writer.endArray();
+    }
+
+    /**
+     * Writes a page of discussion threads, checking the privileges of all of them in one pass before serializing
+     * @param visitedSinceLastChange Returns whether the current user visited a thread since it was last changed
+     */
+    template<typename Collection, size_t PropertyNameSize, typename VisitedFn>
+    void writeDiscussionThreadsWithPagination(const Collection& collection, int_fast32_t pageNumber,
+                                              int_fast32_t pageSize, bool ascending,
+                                              const char(&propertyName)[PropertyNameSize], Json::JsonWriter& writer,
+                                              VisitedFn&& visitedSinceLastChange, const SerializationPlan& plan)
+    {
+        static thread_local std::vector<Authorization::DiscussionThreadPrivilegeCheck> privilegeChecks(100);
+
+        privilegeChecks.clear();
+
+        const auto& restriction = plan.restriction;
+
+        Helpers::forEachEntityInPage(collection, pageNumber, pageSize, ascending, [&](const DiscussionThread& thread)
+        {
+            privilegeChecks.emplace_back(restriction.user(), thread);
+        });
+
+        restriction.privilegeStore().computeDiscussionThreadPrivileges(privilegeChecks.data(), privilegeChecks.size(),
+                                                                       restriction.now());
+
+        //the same page is visited again while writing, so the checks are consumed in order
+        size_t nextCheck = 0;
+
+        Helpers::writePageOfEntities(collection, pageNumber, pageSize, ascending, propertyName, writer,
+            [&](const DiscussionThread& thread)
+            {
+                assert(nextCheck < privilegeChecks.size());
+                auto& check = privilegeChecks[nextCheck++];
+                assert(check.thread == &thread);
+
+                serialize(writer, thread, plan, check, visitedSinceLastChange(thread));
+            });
+    }
+
+    /**
+     * Writes discussion tags, checking the privileges needed to show their latest messages in one pass
+     */
+    template<typename It, size_t PropertyNameSize>
+    void writeDiscussionTags(Repository::OutStream& output, const char(&propertyName)[PropertyNameSize],
+                             It begin, It end, const Authorization::SerializationRestriction& restriction)
+    {
+        static thread_local std::vector<Authorization::DiscussionThreadPrivilegeCheck> privilegeChecks(100);
+
+        privilegeChecks.clear();
+
+        for (auto it = begin; it != end; ++it)
+        {
+            const DiscussionTag& tag = **it;
+            //tags without threads keep an empty check so that the checks can be matched to tags by position
+            auto& check = privilegeChecks.emplace_back();
+            check.user = restriction.user();
+            check.thread = tag.threads().latestMessageThread();
+        }
+
+        restriction.privilegeStore().computeDiscussionThreadPrivileges(privilegeChecks.data(), privilegeChecks.size(),
+                                                                       restriction.now());
+
+        Json::JsonWriter writer(output);
+        writer.startObject();
+        writer.newPropertyWithSafeName(propertyName);
+        writer.startArray();
+
+        auto check = privilegeChecks.begin();
+        for (auto it = begin; it != end; ++it, ++check)
+        {
+            Helpers::TemporaryChanger<const Authorization::DiscussionThreadPrivilegeCheck*> _(
+                    serializationSettings.discussionThreadPrivilegeCheck, &*check);
+
+            serialize(writer, **it, restriction);
+        }
+
+        writer.endArray();
+        writer.endObject();
+    }
 }
@@ -47,6 +47,10 @@ namespace Forum::Entities
     {
     public:
         const auto& id()                const { return id_; }
+        /**
+         * Dense number assigned when the user is created, usable as a compact key instead of the id
+         */
+               auto ordinal()           const { return ordinal_; }
 
                auto created()           const { return created_; }
         const auto& creationDetails()   const { return creationDetails_; }
@@ -156,8 +160,9 @@ namespace Forum::Entities
 
         static auto& changeNotifications() { return changeNotifications_; }
 
-        User(const IdType id, NameType&& name, const Timestamp created, VisitDetails creationDetails)
-            : id_(id), created_(created), creationDetails_(creationDetails),
+        User(const IdType id, const uint32_t ordinal, NameType&& name, const Timestamp created,
+             VisitDetails creationDetails)
+            : id_(id), ordinal_(ordinal), created_(created), creationDetails_(creationDetails),
               name_(std::move(name)), info_({}), title_({}), signature_({}), logo_({})
         {
             threads_.onPrepareCountChange()
@@ -321,6 +326,7 @@ namespace Forum::Entities
         static const AttachmentCollection emptyAttachments_;
 
         IdType id_;
+        uint32_t ordinal_{0};
         Timestamp created_{0};
         VisitDetails creationDetails_;
 
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "ConstCollectionAdapter.h"
 #include "EntityUser.h"
+#include "ParallelHelpers.h"
 
 #include <functional>
 
@@ -38,7 +39,7 @@ namespace Forum::Entities
         bool add(UserPtr user);
         bool remove(UserPtr user);
 
-        void stopBatchInsert();
+        void stopBatchInsert(Helpers::ParallelTaskRunner& tasks);
 
         void prepareUpdateAuth(UserPtr user);
         void updateAuth(UserPtr user);
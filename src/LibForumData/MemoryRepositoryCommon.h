@@ -24,26 +24,35 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Repository.h"
 #include "ResourceGuard.h"
 
+#include <memory>
+
 #include <boost/noncopyable.hpp>
 #include <boost/optional.hpp>
 
 namespace Forum::Repository
 {
+    class LastSeenUpdater;
+
     struct MemoryStore final : private boost::noncopyable
     {
-        explicit MemoryStore(Entities::EntityCollectionRef collection) : collection(std::move(collection))
-        {}
+        explicit MemoryStore(Entities::EntityCollectionRef collection);
+        ~MemoryStore();
 
         Helpers::ResourceGuard<Entities::EntityCollection> collection;
         ReadEvents readEvents;
         WriteEvents writeEvents;
+        /**
+         * Applies the last seen updates of read requests in batches on a separate thread
+         * Empty if the updates are applied after each request
+         */
+        std::unique_ptr<LastSeenUpdater> lastSeenUpdater;
     };
     typedef std::shared_ptr<MemoryStore> MemoryStoreRef;
 
     /**
     * Retrieves the user that is performing the current action and also performs an update on the last seen if needed
-    * The update is performed on the spot if a write lock is held or
-    * delayed until the lock is destroyed in the case of a read lock, to avoid deadlocks
+    * The update is performed on the spot if a write lock is held or, in the case of a read lock,
+    * queued for the next batch of updates or delayed until the lock is destroyed, to avoid deadlocks
     * Do not keep references to it outside of MemoryRepository methods
     */
     struct PerformedByWithLastSeenUpdateGuard final : private boost::noncopyable
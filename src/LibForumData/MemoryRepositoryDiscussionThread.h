@@ -40,6 +40,7 @@ namespace Forum::Repository
          * - Stores that the current user has visited the discussion thread
          */
         StatusCode getDiscussionThreadById(Entities::IdTypeRef id, OutStream& output) override;
+        StatusCode getDiscussionThreadVersion(Entities::IdTypeRef id, uint64_t& version) const override;
         StatusCode getMultipleDiscussionThreadsById(StringView ids, OutStream& output) const override;
         StatusCode searchDiscussionThreadsByName(StringView name, OutStream& output) const override;
 
@@ -194,6 +194,11 @@ namespace Forum::Repository
 
         virtual StatusCode getDiscussionThreads(OutStream& output, RetrieveDiscussionThreadsBy by) const = 0;
         virtual StatusCode getDiscussionThreadById(Entities::IdTypeRef id, OutStream& output) = 0;
+        /**
+         * Retrieves a value that changes every time the output of getDiscussionThreadById might change,
+         * without any of the state changes caused by getDiscussionThreadById
+         */
+        virtual StatusCode getDiscussionThreadVersion(Entities::IdTypeRef id, uint64_t& version) const = 0;
         virtual StatusCode getMultipleDiscussionThreadsById(StringView ids, OutStream& output) const = 0;
         virtual StatusCode searchDiscussionThreadsByName(StringView name, OutStream& output) const = 0;
 
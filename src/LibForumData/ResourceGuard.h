@@ -18,6 +18,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include "ContextProviders.h"
+
 #include <boost/core/noncopyable.hpp>
 
 #include <memory>
@@ -40,8 +42,35 @@ namespace Forum::Helpers
             action(constResource);
         }
 
+        /**
+         * Every write is assumed to modify the resource, invalidating what clients may have cached
+         */
         template<typename TAction>
         void write(TAction&& action) const /* lock will be taken anyway so always allow access */
+        {
+            std::unique_lock<decltype(mutex_)> lock(mutex_);
+            action(*resource_);
+            Context::incrementWriteGeneration();
+        }
+
+        /**
+         * For changes that only affect a single discussion thread and its messages; the action needs to increment
+         * the version of the thread, so that cached responses about other threads remain valid
+         */
+        template<typename TAction>
+        void writeSingleDiscussionThread(TAction&& action) const
+        {
+            std::unique_lock<decltype(mutex_)> lock(mutex_);
+            action(*resource_);
+            Context::incrementWriteGeneration(false);
+        }
+
+        /**
+         * For frequent changes that clients may see with a delay (e.g. last seen timestamps), which would otherwise
+         * invalidate cached responses all the time; entity tags expire over time to pick them up eventually
+         */
+        template<typename TAction>
+        void writeKeepingGeneration(TAction&& action) const
         {
             std::unique_lock<decltype(mutex_)> lock(mutex_);
             action(*resource_);
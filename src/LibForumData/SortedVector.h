@@ -18,6 +18,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include "ParallelHelpers.h"
+
 #include <algorithm>
 #include <functional>
 #include <vector>
@@ -217,6 +219,20 @@ namespace Forum::Entities
                 });
         }
 
+        /**
+         * Replaces all values, sorting them on multiple threads if there are many of them
+         */
+        template<typename It>
+        void rebuild(It begin, It end)
+        {
+            this->vector_.assign(begin, end);
+            Helpers::parallelSort(this->vector_.begin(), this->vector_.end(),
+                [](auto&& first, auto&& second)
+                {
+                    return Compare{}(first, second);
+                });
+        }
+
         iterator replace(iterator position, T value)
         {
             return Detail::SortedVectorBase<T, Key, KeyExtractor, Compare>::replaceInternal(position, value);
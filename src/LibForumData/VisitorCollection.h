@@ -19,41 +19,73 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 
 #include "EntityCommonTypes.h"
+#include "ShardedCounter.h"
+#include "SpinLock.h"
 
 #include <boost/noncopyable.hpp>
 
+#include <array>
 #include <atomic>
 #include <cstdint>
-#include <mutex>
 #include <unordered_map>
 
 namespace Forum::Repository
 {
     /**
-    * Thread-safe collection for mappings between auth tokens and auth ids
+    * Thread-safe collection of recent visitors
+    * Visitors are spread across shards with separate locks and each shard is cleaned up independently
+    * A cleanup is spread over multiple additions: each one advances over a few buckets of the shard, so that adding a
+    * visitor never holds the lock of a shard for a full pass
+    * The number of visitors is approximate: expired visitors are only removed by periodic cleanups and
+    * each shard stops counting new visitors once it reaches MaxVisitorsPerShard
     */
     class VisitorCollection : boost::noncopyable
     {
     public:
         using VisitorId = uint64_t;
 
+        /**
+         * Upper limit for the number of visitors tracked by each shard, so that memory usage stays bounded
+         * New visitors are not counted while a shard is full of visitors that have not expired yet, so the reported
+         * number saturates at roughly NrOfShards * MaxVisitorsPerShard, or earlier if visitors are unevenly spread
+         */
+        static constexpr size_t MaxVisitorsPerShard = 1u << 16;
+        static constexpr size_t BucketsCleanedUpPerStep = 16;
+
         explicit VisitorCollection(const Entities::Timestamp visitForSeconds) : visitForSeconds_{visitForSeconds}
         {            
         }
 
-        uint64_t currentNumberOfVisitors() const { return currentNumberOfVisitors_; }
+        /**
+         * Returns an approximate number of recent visitors, which is capped as described for MaxVisitorsPerShard
+         */
+        uint64_t currentNumberOfVisitors() const;
 
         void add(VisitorId visitor);
 
         void cleanup();
 
     private:
-        const Entities::Timestamp visitForSeconds_{};
+        struct alignas(Helpers::CacheLineSize) Shard
+        {
+            std::unordered_map<VisitorId, Entities::Timestamp> collection;
+            Helpers::SpinLock lock;
+            std::atomic<Entities::Timestamp> lastCleanup{};
+            std::atomic<uint64_t> currentNumberOfVisitors{};
+            //bucket where the current cleanup continues, only meaningful while cleaning up
+            //if the visitors are rehashed in the meantime some of them are only checked during the next cleanup
+            size_t cleanupBucket{ 0 };
+            bool cleaningUp{ false };
+        };
 
-        std::unordered_map<VisitorId, Entities::Timestamp> collection_;
-        std::mutex mutex_;
+        /**
+         * Removes the expired visitors from the next few buckets of the shard
+         * @returns true if the cleanup of the shard has been completed
+         */
+        static bool continueCleanup(Shard& shard, Entities::Timestamp now);
+
+        const Entities::Timestamp visitForSeconds_{};
 
-        std::atomic<Entities::Timestamp> lastCleanup_{};
-        std::atomic<uint64_t> currentNumberOfVisitors_{};
+        std::array<Shard, Helpers::NrOfShards> shards_;
     };
 }
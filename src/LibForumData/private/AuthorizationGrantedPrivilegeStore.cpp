@@ -20,14 +20,82 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Configuration.h"
 #include "EntityCollection.h"
 
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
 #include <boost/range/iterator_range.hpp>
 
 using namespace Forum;
 using namespace Forum::Entities;
 using namespace Forum::Authorization;
 
+/**
+ * Caches the privilege values granted to a user via the privilege entries, so that serializing many entities
+ * does not require searching the entries for the same user and entity over and over again
+ *
+ * Each thread keeps values for the user it last checked privileges for. All cached values are discarded when
+ * privileges are granted or revoked (the generation changes) and each value is valid until the earliest expiry
+ * of the entries it was computed from.
+ */
+namespace
+{
+    constexpr size_t MaxCachedGrantedPrivilegesPerThread = 4096;
+
+    struct CachedGrantedPrivilegeKey final
+    {
+        IdType entityId;
+        uint8_t scope;
+
+        bool operator==(const CachedGrantedPrivilegeKey& other) const
+        {
+            return (scope == other.scope) && (entityId == other.entityId);
+        }
+    };
+
+    struct CachedGrantedPrivilegeKeyHasher final
+    {
+        size_t operator()(const CachedGrantedPrivilegeKey& value) const
+        {
+            size_t result = std::hash<IdType>{}(value.entityId);
+            boost::hash_combine(result, value.scope);
+            return result;
+        }
+    };
+
+    struct CachedGrantedPrivilege final
+    {
+        PrivilegeValueType positive;
+        PrivilegeValueType negative;
+        Timestamp computedAt{ 0 };
+        Timestamp validUntil{ 0 }; //0 if none of the entries expire
+        bool computed{ false };
+    };
+
+    struct GrantedPrivilegeCache final
+    {
+        uint64_t generation{ 0 };
+        const GrantedPrivilegeStore* store{};
+        IdType userId;
+        std::unordered_map<CachedGrantedPrivilegeKey, CachedGrantedPrivilege, CachedGrantedPrivilegeKeyHasher> values;
+    };
+
+    std::atomic<uint64_t> grantedPrivilegesGeneration{ 1 };
+    thread_local GrantedPrivilegeCache grantedPrivilegeCache;
+}
+
+void GrantedPrivilegeStore::invalidateCachedPrivileges()
+{
+    grantedPrivilegesGeneration.fetch_add(1, std::memory_order_release);
+}
+
 GrantedPrivilegeStore::GrantedPrivilegeStore()
 {
+    //a new store might reuse the address of a previous one
+    invalidateCachedPrivileges();
+
     defaultPrivilegeValueForLoggedInUser_ = Configuration::getGlobalConfig()->user.defaultPrivilegeValueForLoggedInUser;
     messageCountMultiplierPrivilegeBonus_ = Configuration::getGlobalConfig()->user.messageCountMultiplierPrivilegeBonus;
     maxMessageCountPrivilegeBonus_ = Configuration::getGlobalConfig()->user.maxMessageCountPrivilegeBonus;
@@ -37,6 +105,8 @@ void GrantedPrivilegeStore::grantDiscussionThreadMessagePrivilege(IdTypeRef user
                                                                   PrivilegeValueIntType value, Timestamp now,
                                                                   Timestamp expiresAt)
 {
+    invalidateCachedPrivileges();
+
     if (0 == value)
     {
         const IdTuple toSearch{ userId, entityId };
@@ -50,6 +120,8 @@ void GrantedPrivilegeStore::grantDiscussionThreadPrivilege(IdTypeRef userId, IdT
                                                            PrivilegeValueIntType value, Timestamp now,
                                                            Timestamp expiresAt)
 {
+    invalidateCachedPrivileges();
+
     if (0 == value)
     {
         const IdTuple toSearch{ userId, entityId };
@@ -63,6 +135,8 @@ void GrantedPrivilegeStore::grantDiscussionTagPrivilege(IdTypeRef userId, IdType
                                                         PrivilegeValueIntType value, Timestamp now,
                                                         Timestamp expiresAt)
 {
+    invalidateCachedPrivileges();
+
     if (0 == value)
     {
         const IdTuple toSearch{ userId, entityId };
@@ -76,6 +150,8 @@ void GrantedPrivilegeStore::grantDiscussionCategoryPrivilege(IdTypeRef userId, I
                                                              PrivilegeValueIntType value, Timestamp now,
                                                              Timestamp expiresAt)
 {
+    invalidateCachedPrivileges();
+
     if (0 == value)
     {
         const IdTuple toSearch{ userId, entityId };
@@ -89,6 +165,8 @@ void GrantedPrivilegeStore::grantForumWidePrivilege(IdTypeRef userId, IdTypeRef
                                                     PrivilegeValueIntType value, Timestamp now,
                                                     Timestamp expiresAt)
 {
+    invalidateCachedPrivileges();
+
     if (0 == value)
     {
         const IdTuple toSearch{ userId, entityId };
@@ -324,6 +402,102 @@ void GrantedPrivilegeStore::computeDiscussionThreadMessageVisibilityAllowed(Disc
     }
 }
 
+void GrantedPrivilegeStore::computeDiscussionThreadPrivileges(DiscussionThreadPrivilegeCheck* items, size_t nrOfItems,
+                                                              Timestamp now) const
+{
+    if (nrOfItems < 1)
+    {
+        return;
+    }
+
+    struct TagLevelValues
+    {
+        const DiscussionTag* tag;
+        PrivilegeValueType positive;
+        PrivilegeValueType negative;
+    };
+    static thread_local std::vector<TagLevelValues> tagLevelValues;
+    tagLevelValues.clear();
+
+    auto& user = items[0].user;
+
+    //the values granted forum wide are the same for all threads and most tags are shared between threads
+    PrivilegeValueType forumWidePositive, forumWideNegative;
+    calculateForumWidePrivilege(user, now, forumWidePositive, forumWideNegative);
+
+    for (size_t i = 0; i < nrOfItems; ++i)
+    {
+        auto& item = items[i];
+        if ( ! item.thread)
+        {
+            continue;
+        }
+        auto& thread = *item.thread;
+
+        PrivilegeValueType positive = forumWidePositive;
+        PrivilegeValueType negative = forumWideNegative;
+
+        calculateDiscussionThreadPrivilege(user, thread, now, positive, negative);
+
+        for (auto tag : thread.tags())
+        {
+            assert(tag);
+            auto it = std::find_if(tagLevelValues.begin(), tagLevelValues.end(),
+                                   [tag](const TagLevelValues& value) { return value.tag == tag; });
+            if (it == tagLevelValues.end())
+            {
+                TagLevelValues value{ tag, {}, {} };
+                calculateDiscussionTagPrivilege(user, *tag, now, value.positive, value.negative);
+                tagLevelValues.push_back(value);
+                it = tagLevelValues.end() - 1;
+            }
+            positive = maximumPrivilegeValue(positive, it->positive);
+            negative = minimumPrivilegeValue(negative, it->negative);
+        }
+
+        for (EnumIntType privilege = 0; privilege < static_cast<EnumIntType>(DiscussionThreadPrivilege::COUNT);
+             ++privilege)
+        {
+            item.allowed.set(privilege, static_cast<bool>(::isAllowed(positive, negative,
+                    thread.getDiscussionThreadPrivilege(static_cast<DiscussionThreadPrivilege>(privilege)))));
+        }
+
+        const auto isCreatedByUser = [&user](auto& entity)
+        {
+            return entity.createdBy().id() == (user ? user->id() : IdType{});
+        };
+
+        item.allowedToShowThread = item.isAllowed(DiscussionThreadPrivilege::VIEW)
+                && (thread.approved() || isCreatedByUser(thread)
+                    || item.isAllowed(DiscussionThreadPrivilege::VIEW_UNAPPROVED));
+
+        item.allowedToShowLatestMessage = item.allowedToShowLatestMessageUser = false;
+
+        const auto& messagesIndex = thread.messages().byCreated();
+        if ( ! item.allowedToShowThread || ! messagesIndex.size())
+        {
+            continue;
+        }
+
+        //the values granted at thread level also apply to the messages of the thread
+        const DiscussionThreadMessage& latestMessage = **messagesIndex.rbegin();
+        PrivilegeValueType messagePositive = positive;
+        PrivilegeValueType messageNegative = negative;
+        calculateDiscussionThreadMessagePrivilege(user, latestMessage, now, messagePositive, messageNegative);
+
+        const auto isMessageAllowed = [&](DiscussionThreadMessagePrivilege privilege)
+        {
+            return static_cast<bool>(::isAllowed(messagePositive, messageNegative,
+                                                 latestMessage.getDiscussionThreadMessagePrivilege(privilege)));
+        };
+
+        item.allowedToShowLatestMessage = isMessageAllowed(DiscussionThreadMessagePrivilege::VIEW)
+                && (latestMessage.approved() || isCreatedByUser(latestMessage)
+                    || isMessageAllowed(DiscussionThreadMessagePrivilege::VIEW_UNAPPROVED));
+        item.allowedToShowLatestMessageUser = isMessageAllowed(DiscussionThreadMessagePrivilege::VIEW_CREATOR_USER);
+    }
+}
+
 void GrantedPrivilegeStore::calculateDiscussionThreadMessagePrivilege(UserConstPtr user,
                                                                       const DiscussionThread& thread, Timestamp now,
                                                                       PrivilegeValueType& positiveValue,
@@ -345,8 +519,8 @@ void GrantedPrivilegeStore::calculateDiscussionThreadMessagePrivilege(UserConstP
                                                                       PrivilegeValueType& positiveValue,
                                                                       PrivilegeValueType& negativeValue) const
 {
-    calculatePrivilege(discussionThreadMessageSpecificPrivileges_, user, message.id(), now,
-                       positiveValue, negativeValue);
+    calculatePrivilege(discussionThreadMessageSpecificPrivileges_, PrivilegeScope::DiscussionThreadMessage, user,
+                       message.id(), now, positiveValue, negativeValue);
 }
 
 void GrantedPrivilegeStore::calculateDiscussionThreadPrivilege(UserConstPtr user, const DiscussionThread& thread,
@@ -354,14 +528,16 @@ void GrantedPrivilegeStore::calculateDiscussionThreadPrivilege(UserConstPtr user
                                                                PrivilegeValueType& positiveValue,
                                                                PrivilegeValueType& negativeValue) const
 {
-    calculatePrivilege(discussionThreadSpecificPrivileges_, user, thread.id(), now, positiveValue, negativeValue);
+    calculatePrivilege(discussionThreadSpecificPrivileges_, PrivilegeScope::DiscussionThread, user, thread.id(), now,
+                       positiveValue, negativeValue);
 }
 
 void GrantedPrivilegeStore::calculateDiscussionTagPrivilege(UserConstPtr user, const DiscussionTag& tag, Timestamp now,
                                                             PrivilegeValueType& positiveValue,
                                                             PrivilegeValueType& negativeValue) const
 {
-    calculatePrivilege(discussionTagSpecificPrivileges_, user, tag.id(), now, positiveValue, negativeValue);
+    calculatePrivilege(discussionTagSpecificPrivileges_, PrivilegeScope::DiscussionTag, user, tag.id(), now,
+                       positiveValue, negativeValue);
 }
 
 void GrantedPrivilegeStore::calculateDiscussionCategoryPrivilege(UserConstPtr user, const DiscussionCategory& category,
@@ -369,18 +545,21 @@ void GrantedPrivilegeStore::calculateDiscussionCategoryPrivilege(UserConstPtr us
                                                                  PrivilegeValueType& positiveValue,
                                                                  PrivilegeValueType& negativeValue) const
 {
-    calculatePrivilege(discussionCategorySpecificPrivileges_, user, category.id(), now, positiveValue, negativeValue);
+    calculatePrivilege(discussionCategorySpecificPrivileges_, PrivilegeScope::DiscussionCategory, user, category.id(),
+                       now, positiveValue, negativeValue);
 }
 
 void GrantedPrivilegeStore::calculateForumWidePrivilege(UserConstPtr user, Timestamp now,
                                                         PrivilegeValueType& positiveValue,
                                                         PrivilegeValueType& negativeValue) const
 {
-    calculatePrivilege(forumWideSpecificPrivileges_, user, {}, now, positiveValue, negativeValue);
+    calculatePrivilege(forumWideSpecificPrivileges_, PrivilegeScope::ForumWide, user, {}, now,
+                       positiveValue, negativeValue);
 }
 
-void GrantedPrivilegeStore::calculatePrivilege(const PrivilegeEntryCollection& collection, UserConstPtr user,
-                                               IdTypeRef entityId, Timestamp now, PrivilegeValueType& positiveValue,
+void GrantedPrivilegeStore::calculatePrivilege(const PrivilegeEntryCollection& collection, const PrivilegeScope scope,
+                                               UserConstPtr user, IdTypeRef entityId, Timestamp now,
+                                               PrivilegeValueType& positiveValue,
                                                PrivilegeValueType& negativeValue) const
 {
     if (isAnonymousUser(user))
@@ -394,23 +573,54 @@ void GrantedPrivilegeStore::calculatePrivilege(const PrivilegeEntryCollection& c
                      static_cast<PrivilegeValueIntType>(messageCountMultiplierPrivilegeBonus_ * user->messageCount()));
 
     positiveValue = maximumPrivilegeValue(positiveValue, defaultPositiveValue);
-    
-    auto range = collection.get<PrivilegeEntryCollectionByUserIdEntityId>().equal_range(IdTuple{ user->id(), entityId });
-    for (auto& entry : boost::make_iterator_range(range))
+
+    auto& cache = grantedPrivilegeCache;
+    const auto currentGeneration = grantedPrivilegesGeneration.load(std::memory_order_acquire);
+    if ((cache.generation != currentGeneration) || (cache.store != this) || (cache.userId != user->id())
+        || (cache.values.size() >= MaxCachedGrantedPrivilegesPerThread))
     {
-        const auto expiresAt = entry.expiresAt();
-        if ((expiresAt > 0) && (expiresAt < now)) continue;
+        cache.values.clear();
+        cache.generation = currentGeneration;
+        cache.store = this;
+        cache.userId = user->id();
+    }
 
-        const auto value = entry.privilegeValue();
-        if (value > 0)
-        {
-            positiveValue = maximumPrivilegeValue(positiveValue, value);
-        }
-        else
+    auto& cached = cache.values[CachedGrantedPrivilegeKey{ entityId, static_cast<uint8_t>(scope) }];
+    const bool cachedValueIsValid = cached.computed && (cached.computedAt <= now)
+            && ((0 == cached.validUntil) || (now <= cached.validUntil));
+
+    if ( ! cachedValueIsValid)
+    {
+        cached = CachedGrantedPrivilege{};
+        cached.computedAt = now;
+        cached.computed = true;
+
+        auto range = collection.get<PrivilegeEntryCollectionByUserIdEntityId>().equal_range(
+                IdTuple{ user->id(), entityId });
+        for (auto& entry : boost::make_iterator_range(range))
         {
-            negativeValue = minimumPrivilegeValue(negativeValue, value);
+            const auto expiresAt = entry.expiresAt();
+            if ((expiresAt > 0) && (expiresAt < now)) continue;
+
+            if ((expiresAt > 0) && ((0 == cached.validUntil) || (expiresAt < cached.validUntil)))
+            {
+                cached.validUntil = expiresAt;
+            }
+
+            const auto value = entry.privilegeValue();
+            if (value > 0)
+            {
+                cached.positive = maximumPrivilegeValue(cached.positive, value);
+            }
+            else
+            {
+                cached.negative = minimumPrivilegeValue(cached.negative, value);
+            }
         }
     }
+
+    positiveValue = maximumPrivilegeValue(positiveValue, cached.positive);
+    negativeValue = minimumPrivilegeValue(negativeValue, cached.negative);
 }
 
 void GrantedPrivilegeStore::enumerateDiscussionThreadMessagePrivileges(IdTypeRef id,
@@ -20,21 +20,107 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <mutex>
 
+using namespace Forum::Authorization;
 using namespace Forum::Entities;
 using namespace Forum::Helpers;
 
-bool Forum::Authorization::DefaultThrottling::check(UserActionThrottling action, const Timestamp at, const IdType& id,
-                                                    const IpAddress& ip)
+static Timestamp getMaxThrottlingPeriod()
+{
+    Timestamp result = 0;
+    for (auto& value : ThrottlingDefaultValues)
+    {
+        result = std::max(result, static_cast<Timestamp>(value.second));
+    }
+    return result;
+}
+
+bool DefaultThrottling::check(UserActionThrottling action, const Timestamp at, const IdType& id, const IpAddress& ip)
 {
     assert(action < UserActionThrottling::COUNT);
 
-    std::lock_guard<decltype(lock_)> lock(lock_);
     IdOrIpAddress current(id, ip);
 
-    auto it = entries_.find(current);
-    if (it == entries_.end())
+    //use the upper bits of the hash so that the distribution across shards is independent of the buckets
+    const auto hash = std::hash<IdOrIpAddress>{}(current);
+    auto& shard = shards_[(hash >> (sizeof(hash) * 4)) % shards_.size()];
+
+    std::lock_guard<decltype(shard.lock)> lock(shard.lock);
+
+    if (shard.sweeping || (at >= shard.nextSweepAt))
+    {
+        continueSweep(shard, at);
+    }
+
+    auto it = shard.entries.find(current);
+    if (it == shard.entries.end())
+    {
+        it = shard.entries.emplace(current, UserThrottlingChecks{}).first;
+    }
+    auto& checks = it->second;
+    checks.lastActivity = std::max(checks.lastActivity, at);
+
+    const auto throttled = checks.values[static_cast<EnumIntType>(action)].isAllowed(at);
+    if (throttled)
+    {
+        shard.throttled += 1;
+    }
+    return throttled;
+}
+
+void DefaultThrottling::continueSweep(Shard& shard, const Timestamp at)
+{
+    static const auto maxThrottlingPeriod = getMaxThrottlingPeriod();
+
+    if ( ! shard.sweeping)
     {
-        it = entries_.emplace(current, UserThrottlingChecks{}).first;
+        if (at < maxThrottlingPeriod)
+        {
+            shard.nextSweepAt = at + SweepInterval;
+            return;
+        }
+        shard.sweeping = true;
+        shard.sweepBucket = 0;
+    }
+    const auto evictBefore = at - maxThrottlingPeriod;
+    auto& entries = shard.entries;
+
+    //erasing does not rehash, so the bucket indexes stay valid while advancing the hand
+    const auto bucketCount = entries.bucket_count();
+    for (size_t i = 0; (i < BucketsSweptPerCheck) && (shard.sweepBucket < bucketCount); ++i, ++shard.sweepBucket)
+    {
+        const auto bucket = shard.sweepBucket;
+        for (auto it = entries.begin(bucket); it != entries.end(bucket);)
+        {
+            if (it->second.lastActivity < evictBefore)
+            {
+                const IdOrIpAddress key = it->first;
+                ++it;
+                entries.erase(key);
+                shard.evictions += 1;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+    if (shard.sweepBucket >= bucketCount)
+    {
+        shard.sweeping = false;
+        shard.nextSweepAt = at + SweepInterval;
+    }
+}
+
+ThrottlingStatistics DefaultThrottling::statistics() const
+{
+    ThrottlingStatistics result;
+    for (auto& shard : shards_)
+    {
+        std::lock_guard<decltype(shard.lock)> lock(shard.lock);
+
+        result.entries += shard.entries.size();
+        result.evictions += shard.evictions;
+        result.throttled += shard.throttled;
     }
-    return it->second.values[static_cast<EnumIntType>(action)].isAllowed(at);
+    return result;
 }
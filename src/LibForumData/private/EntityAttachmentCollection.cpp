@@ -62,17 +62,24 @@ void AttachmentCollection::stopBatchInsert()
 {
     if ( ! Context::isBatchInsertInProgress()) return;
 
-    byCreated_.clear();
-    byCreated_.insert(byId_.begin(), byId_.end());
-    
-    byName_.clear();
-    byName_.insert(byId_.begin(), byId_.end());
-    
-    bySize_.clear();
-    bySize_.insert(byId_.begin(), byId_.end());
-
-    byApproval_.clear();
-    byApproval_.insert(byId_.begin(), byId_.end());
+    Helpers::ParallelTaskRunner tasks;
+    stopBatchInsert(tasks);
+    tasks.run(1);
+}
+
+void AttachmentCollection::stopBatchInsert(Helpers::ParallelTaskRunner& tasks)
+{
+    if ( ! Context::isBatchInsertInProgress()) return;
+
+    auto rebuild = [this](auto& index)
+    {
+        return [this, &index]() { rebuildIndex(index, byId_.begin(), byId_.end()); };
+    };
+
+    tasks.add("attachments by created", rebuild(byCreated_));
+    tasks.add("attachments by name", rebuild(byName_));
+    tasks.add("attachments by size", rebuild(bySize_));
+    tasks.add("attachments by approval", rebuild(byApproval_));
 }
 
 void AttachmentCollection::prepareUpdateName(AttachmentPtr attachmentPtr)
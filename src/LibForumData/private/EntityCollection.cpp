@@ -19,13 +19,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "EntityCollection.h"
 
 #include "Configuration.h"
+#include "ParallelHelpers.h"
 #include "StateHelpers.h"
 #include "ContextProviders.h"
 #include "Logging.h"
 
 #include <cassert>
 #include <cstdlib>
-#include <future>
 #include <type_traits>
 
 #include <boost/interprocess/file_mapping.hpp>
@@ -84,6 +84,9 @@ struct EntityCollection::Impl
 
     bool batchInsertInProgress_{ false };
 
+    //ordinals are never reused so that bitmaps referencing deleted users stay valid, 0 is kept for anonymous users
+    uint32_t nextUserOrdinal_{ 1 };
+
     boost::interprocess::file_mapping messagesFileMapping_;
     boost::interprocess::mapped_region messagesFileRegion_;
     const char* messagesFileStart_{ nullptr };
@@ -269,7 +272,7 @@ struct EntityCollection::Impl
         for (DiscussionCategoryPtr category : thread.categories())
         {
             assert(category);
-            category->deleteDiscussionThread(threadPtr, deleteMessages, false);
+            category->deleteDiscussionThread(threadPtr, deleteMessages);
         }
 
         for (DiscussionTagPtr tag : thread.tags())
@@ -423,6 +426,14 @@ struct EntityCollection::Impl
         }
         DiscussionCategory& category = *categoryPtr;
 
+        //totals are computed from the categories referencing each thread, so update them before detaching threads
+        auto parent = category.parent();
+        if (parent)
+        {
+            parent->removeTotalsFromChild(category);
+            parent->removeChild(categoryPtr);
+        }
+
         for (DiscussionTagPtr tag : category.tags())
         {
             assert(tag);
@@ -435,13 +446,6 @@ struct EntityCollection::Impl
             threadPtr->removeCategory(categoryPtr);
         });
 
-        auto parent = category.parent();
-        if (parent)
-        {
-            parent->removeTotalsFromChild(category);
-            parent->removeChild(categoryPtr);
-        }
-
         release(categoryPtr);
     }
 
@@ -665,78 +669,71 @@ struct EntityCollection::Impl
             return;
         }
 
-        users_.stopBatchInsert();
+        //all indexes are independent of each other so they can be rebuilt concurrently
+        ParallelTaskRunner tasks;
 
-        std::future<void> futures[] =
+        tasks.add("messages of each user", [this]()
         {
-            std::async(std::launch::async, [this]()
+            for (UserPtr user : this->users_.byId())
             {
-                for (UserPtr user : this->users_.byId())
-                {
-                    user->threadMessages().stopBatchInsert();
-                }
-            }),
-
-            std::async(std::launch::async, [this]()
+                user->threadMessages().stopBatchInsert();
+            }
+        });
+        tasks.add("messages of each thread", [this]()
+        {
+            this->threads_.iterateThreads([](DiscussionThreadPtr threadPtr)
             {
-                this->threads_.iterateThreads([](DiscussionThreadPtr threadPtr)
-                {
-                    threadPtr->messages().stopBatchInsert();
-                });
-            }),
-
-            std::async(std::launch::async, [this]()
+                threadPtr->messages().stopBatchInsert();
+            });
+        });
+        tasks.add("threads of each user", [this]()
+        {
+            for (UserPtr user : this->users_.byId())
             {
-                for (UserPtr user : this->users_.byId())
-                {
-                    user->threads().stopBatchInsert();
-                }
-            }),
-
-            std::async(std::launch::async, [this]()
+                user->threads().stopBatchInsert();
+            }
+        });
+        tasks.add("subscribed threads of each user", [this]()
+        {
+            for (UserPtr user : this->users_.byId())
             {
-                for (UserPtr user : this->users_.byId())
-                {
-                    user->subscribedThreads().stopBatchInsert();
-                }
-            }),
-
-            std::async(std::launch::async, [this]()
+                user->subscribedThreads().stopBatchInsert();
+            }
+        });
+        tasks.add("attachments of each user", [this]()
+        {
+            for (UserPtr user : this->users_.byId())
             {
-                for (UserPtr user : this->users_.byId())
-                {
-                    user->attachmentsStopBatchInsert();
-                }
-            }),
-
-            std::async(std::launch::async, [this]()
+                user->attachmentsStopBatchInsert();
+            }
+        });
+        tasks.add("threads of each tag", [this]()
+        {
+            for (DiscussionTagPtr tag : this->tags_.byId())
             {
-                for (DiscussionTagPtr tag : this->tags_.byId())
-                {
-                    tag->threads().stopBatchInsert();
-                }
-            }),
-
-            std::async(std::launch::async, [this]()
+                tag->threads().stopBatchInsert();
+            }
+        });
+        tasks.add("threads of each category", [this]()
+        {
+            for (DiscussionCategoryPtr category : this->categories_.byId())
             {
-                for (DiscussionCategoryPtr category : this->categories_.byId())
-                {
-                    category->stopBatchInsert();
-                }
-            })
-        };
-
-        for (auto& future : futures)
+                category->stopBatchInsert();
+            }
+        });
+
+        this->users_.stopBatchInsert(tasks);
+        this->threads_.stopBatchInsert(tasks);
+        this->threadMessages_.stopBatchInsert(tasks);
+        this->tags_.stopBatchInsert(tasks);
+        this->categories_.stopBatchInsert(tasks);
+        this->attachments_.stopBatchInsert(tasks);
+
+        for (auto& [name, duration] : tasks.run())
         {
-            future.get();
+            FORUM_LOG_INFO << "Rebuilt index " << name << " in " << duration.count() << " ms";
         }
 
-        this->threads_.stopBatchInsert();
-        this->threadMessages_.stopBatchInsert();
-        this->tags_.stopBatchInsert();
-        this->categories_.stopBatchInsert();
-        this->attachments_.stopBatchInsert();
-
         Context::setBatchInsertInProgres(batchInsertInProgress_ = activate);
     }
 
@@ -930,7 +927,7 @@ StringView EntityCollection::getMessageContentPointer(size_t offset, size_t size
 
 UserPtr EntityCollection::createUser(IdType id, User::NameType&& name, Timestamp created, VisitDetails creationDetails)
 {
-    return impl_->construct<User>(id, std::move(name), created, creationDetails);
+    return impl_->construct<User>(id, impl_->nextUserOrdinal_++, std::move(name), created, creationDetails);
 }
 
 DiscussionThreadPtr EntityCollection::createDiscussionThread(IdType id, User& createdBy, DiscussionThread::NameType&& name,
@@ -47,6 +47,53 @@ static void executeOnCategoryAndAllParents(DiscussionCategory& category, std::fu
     executeOnAllCategoryParents(category, std::move(fn));
 }
 
+static bool isInSubtree(const DiscussionCategory* category, const DiscussionCategory* subtreeRoot)
+{
+    while (category)
+    {
+        if (category == subtreeRoot) return true;
+        category = category->parent();
+    }
+    return false;
+}
+
+static bool referencesThread(const DiscussionCategory* category, const DiscussionThread* thread)
+{
+    return nullptr != category->threads().findById(thread->id());
+}
+
+/**
+* Checks if the thread is directly referenced by a category from the subtree,
+* ignoring the excluded category and all categories from the excluded subtree
+*/
+static bool isReferencedInSubtree(const DiscussionThread* thread, const DiscussionCategory* subtreeRoot,
+                                  const DiscussionCategory* excludedCategory,
+                                  const DiscussionCategory* excludedSubtree)
+{
+    for (const DiscussionCategory* category : thread->categories())
+    {
+        if ((category == excludedCategory) || ! referencesThread(category, thread)) continue;
+        if (excludedSubtree && isInSubtree(category, excludedSubtree)) continue;
+
+        if (isInSubtree(category, subtreeRoot)) return true;
+    }
+    return false;
+}
+
+/**
+* Returns the category that is responsible for updating the totals of a subtree for a thread,
+* so that threads referenced by multiple categories of the same subtree are only counted once
+*/
+static const DiscussionCategory* firstReferencingCategoryInSubtree(const DiscussionThread* thread,
+                                                                   const DiscussionCategory* subtreeRoot)
+{
+    for (const DiscussionCategory* category : thread->categories())
+    {
+        if (referencesThread(category, thread) && isInSubtree(category, subtreeRoot)) return category;
+    }
+    return nullptr;
+}
+
 bool DiscussionCategory::addChild(DiscussionCategory* const category)
 {
     return std::get<1>(children_.insert(category));
@@ -104,14 +151,10 @@ bool DiscussionCategory::insertDiscussionThreads(DiscussionThreadPtr* threads, s
 
     changeNotifications_.onUpdateMessageCount(*this);
 
-    executeOnCategoryAndAllParents(*this, [&](auto& category)
+    for (size_t i = 0; i < count; ++i)
     {
-        //this category and all parents will hold separate references to the new thread
-        for (size_t i = 0; i < count; ++i)
-        {
-            category.totalThreads_.add(threads[i]);            
-        }
-    });
+        addToTotals(threads[i]);
+    }
 
     return true;
 }
@@ -152,20 +195,15 @@ bool DiscussionCategory::insertDiscussionThreadsOfTag(DiscussionTagPtr tag)
     }
     changeNotifications_.onUpdateMessageCount(*this);
 
-    executeOnCategoryAndAllParents(*this, [&](auto& category)
+    for (auto thread : threadsToInsert)
     {
-        //this category and all parents will hold separate references to the new threads
-        for (auto thread : threadsToInsert)
-        {
-            category.totalThreads_.add(thread);
-        }
-    });
+        addToTotals(thread);
+    }
 
     return true;
 }
 
-bool DiscussionCategory::deleteDiscussionThread(DiscussionThreadPtr thread, const bool deleteMessages, 
-                                                const bool onlyThisCategory)
+bool DiscussionCategory::deleteDiscussionThread(DiscussionThreadPtr thread, const bool deleteMessages)
 {
     assert(thread);
     if (deleteMessages)
@@ -182,6 +220,7 @@ bool DiscussionCategory::deleteDiscussionThread(DiscussionThreadPtr thread, cons
         //don't use updateMessageCount() as deleteDiscussionThreadById will take care of that for totals
         messageCount_ -= static_cast<int_fast32_t>(thread->messageCount());
     }
+    removeFromTotals(thread, deleteMessages);
     if ( ! thread->aboutToBeDeleted())
     {
         thread->removeCategory(this);
@@ -190,13 +229,6 @@ bool DiscussionCategory::deleteDiscussionThread(DiscussionThreadPtr thread, cons
     {
         changeNotifications_.onUpdateMessageCount(*this);
     }
-    if ( ! onlyThisCategory)
-    {
-        executeOnCategoryAndAllParents(*this, [&](auto& category)
-        {
-            category.totalThreads_.remove(thread);
-        });
-    }
 
     return true;
 }
@@ -219,13 +251,7 @@ void DiscussionCategory::deleteDiscussionThreadIfNoOtherTagsReferenceIt(Discussi
 
     if ( ! referencedByOtherTags)
     {
-        deleteDiscussionThread(thread, deleteMessages, true);
-
-        //release separate references held by this category and parents, if reference count drops to 0
-        executeOnCategoryAndAllParents(*this, [&](auto& category)
-        {
-            category.totalThreads_.decreaseReferenceCount(thread);
-        });
+        deleteDiscussionThread(thread, deleteMessages);
     }
 }
 
@@ -270,46 +296,116 @@ void DiscussionCategory::updateMessageCount(DiscussionThreadPtr thread, int_fast
     changeNotifications_.onPrepareUpdateMessageCount(*this);
 
     messageCount_ += delta;
-    //make sure totals of the current category are always updated
-    totalThreads_.messageCount() += delta;
 
-    bool stop = false;
-    executeOnAllCategoryParents(*this, [&](DiscussionCategory& category)
+    executeOnCategoryAndAllParents(*this, [&](DiscussionCategory& category)
     {
-        if (stop)
+        //updateMessageCount is called for each category of the thread
+        //only one of them updates the totals of a subtree or else the messages will be counted multiple times
+        if (firstReferencingCategoryInSubtree(thread, &category) == this)
         {
-            return;
+            category.messageTotalCount_ += delta;
         }
+        category.resetLatestMessage();
+    });
 
-        if (category.threads().contains(thread))
+    changeNotifications_.onUpdateMessageCount(*this);
+}
+
+void DiscussionCategory::addToTotals(DiscussionThreadPtr thread)
+{
+    assert(thread);
+    const auto messageCount = static_cast<int_fast32_t>(thread->messageCount());
+    bool alreadyCounted = false;
+
+    executeOnCategoryAndAllParents(*this, [&](DiscussionCategory& category)
+    {
+        //once a category already counts the thread via another descendant, so do all its parents
+        alreadyCounted = alreadyCounted || isReferencedInSubtree(thread, &category, this, nullptr);
+        if ( ! alreadyCounted)
         {
-            //stop any updates on the total or else the messages will be counted multiple times
-            //they will be/have already been taken care of by a call to updateMessageCount of this specific category
-            stop = true;
-            return;
+            category.threadTotalCount_ += 1;
+            category.messageTotalCount_ += messageCount;
         }
-        category.totalThreads_.messageCount() += delta;
+        category.resetLatestMessage();
     });
-
-    changeNotifications_.onUpdateMessageCount(*this);
 }
 
-void DiscussionCategory::removeTotalsFromChild(const DiscussionCategory& childCategory)
+void DiscussionCategory::removeFromTotals(DiscussionThreadPtr thread, const bool deleteMessages)
 {
-    executeOnCategoryAndAllParents(*this, [&childCategory](DiscussionCategory& category)
+    assert(thread);
+    //if the messages are not deleted, the message count has already been updated via updateMessageCount()
+    const auto messageCount = deleteMessages ? static_cast<int_fast32_t>(thread->messageCount()) : 0;
+    bool stillReferenced = false;
+
+    executeOnCategoryAndAllParents(*this, [&](DiscussionCategory& category)
     {
-        category.totalThreads_.decreaseReferenceCount(childCategory.totalThreads_);
+        stillReferenced = stillReferenced || isReferencedInSubtree(thread, &category, this, nullptr);
+        if ( ! stillReferenced)
+        {
+            category.threadTotalCount_ -= 1;
+            category.messageTotalCount_ -= messageCount;
+        }
+        category.resetLatestMessage();
     });
 }
 
-void DiscussionCategory::addTotalsFromChild(const DiscussionCategory& childCategory)
+void DiscussionCategory::updateTotalsFromChild(const DiscussionCategory& childCategory, const int_fast32_t direction)
 {
-    executeOnCategoryAndAllParents(*this, [&childCategory](DiscussionCategory& category)
+    std::vector<const DiscussionCategory*> subtree{ &childCategory };
+    for (size_t i = 0; i < subtree.size(); ++i)
+    {
+        for (const DiscussionCategory* category : subtree[i]->children_)
+        {
+            subtree.push_back(category);
+        }
+    }
+
+    for (const DiscussionCategory* subtreeCategory : subtree)
     {
-        category.totalThreads_.add(childCategory.totalThreads_);
+        subtreeCategory->threads_.iterateThreads([&](const DiscussionThread* thread)
+        {
+            //visit each thread only once, even if it is referenced by multiple categories of the subtree
+            if (firstReferencingCategoryInSubtree(thread, &childCategory) != subtreeCategory) return;
+
+            const auto messageCount = static_cast<int_fast32_t>(thread->messageCount());
+            bool referencedOutsideChild = false;
+
+            executeOnCategoryAndAllParents(*this, [&](DiscussionCategory& category)
+            {
+                referencedOutsideChild = referencedOutsideChild
+                        || isReferencedInSubtree(thread, &category, nullptr, &childCategory);
+                if ( ! referencedOutsideChild)
+                {
+                    category.threadTotalCount_ += direction;
+                    category.messageTotalCount_ += direction * messageCount;
+                }
+            });
+        });
+    }
+
+    executeOnCategoryAndAllParents(*this, [](DiscussionCategory& category)
+    {
+        category.resetLatestMessage();
     });
 }
 
+void DiscussionCategory::removeTotalsFromChild(const DiscussionCategory& childCategory)
+{
+    assert(childCategory.parent_ == this);
+    updateTotalsFromChild(childCategory, -1);
+}
+
+void DiscussionCategory::addTotalsFromChild(const DiscussionCategory& childCategory)
+{
+    assert(childCategory.parent_ == this);
+    updateTotalsFromChild(childCategory, 1);
+}
+
+void DiscussionCategory::resetLatestMessage()
+{
+    latestMessageValid_.store(false, std::memory_order_release);
+}
+
 PrivilegeValueType DiscussionCategory::getDiscussionCategoryPrivilege(DiscussionCategoryPrivilege privilege) const
 {
     if (const auto result = DiscussionCategoryPrivilegeStore::getDiscussionCategoryPrivilege(privilege)) return result;
@@ -319,6 +415,11 @@ PrivilegeValueType DiscussionCategory::getDiscussionCategoryPrivilege(Discussion
 
 const DiscussionThreadMessage* DiscussionCategory::latestMessage() const
 {
+    if (latestMessageValid_.load(std::memory_order_acquire))
+    {
+        return latestMessage_.load(std::memory_order_relaxed);
+    }
+
     const DiscussionThreadMessage* result{};
 
     const auto& index = threads_.byLatestMessageCreated();
@@ -344,5 +445,9 @@ const DiscussionThreadMessage* DiscussionCategory::latestMessage() const
         }
     }
 
+    //concurrent readers compute the same value, writers reset it while holding exclusive access
+    latestMessage_.store(result, std::memory_order_relaxed);
+    latestMessageValid_.store(true, std::memory_order_release);
+
     return result;
 }
\ No newline at end of file
@@ -55,15 +55,18 @@ bool DiscussionCategoryCollection::remove(DiscussionCategoryPtr category)
     return true;
 }
 
-void DiscussionCategoryCollection::stopBatchInsert()
+void DiscussionCategoryCollection::stopBatchInsert(Helpers::ParallelTaskRunner& tasks)
 {
     if ( ! Context::isBatchInsertInProgress()) return;
 
-    byMessageCount_.clear();
-    byMessageCount_.insert(byId_.begin(), byId_.end());
-
-    byDisplayOrderRootPriority_.clear();
-    byDisplayOrderRootPriority_.insert(byId_.begin(), byId_.end());
+    tasks.add("categories by message count", [this]()
+    {
+        rebuildIndex(byMessageCount_, byId_.begin(), byId_.end());
+    });
+    tasks.add("categories by display order", [this]()
+    {
+        rebuildIndex(byDisplayOrderRootPriority_, byId_.begin(), byId_.end());
+    });
 }
 
 void DiscussionCategoryCollection::prepareUpdateName(DiscussionCategoryPtr category)
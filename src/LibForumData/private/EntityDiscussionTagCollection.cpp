@@ -56,16 +56,12 @@ bool DiscussionTagCollection::remove(DiscussionTagPtr tag)
     return true;
 }
 
-void DiscussionTagCollection::stopBatchInsert()
+void DiscussionTagCollection::stopBatchInsert(Helpers::ParallelTaskRunner& tasks)
 {
     if ( ! Context::isBatchInsertInProgress()) return;
 
-    byThreadCount_.clear();
-    byMessageCount_.clear();
-
-    auto byIdIndex = byId_;
-    byThreadCount_.insert(byId_.begin(), byId_.end());
-    byMessageCount_.insert(byId_.begin(), byId_.end());
+    tasks.add("tags by thread count", [this]() { rebuildIndex(byThreadCount_, byId_.begin(), byId_.end()); });
+    tasks.add("tags by message count", [this]() { rebuildIndex(byMessageCount_, byId_.begin(), byId_.end()); });
 }
 
 void DiscussionTagCollection::prepareUpdateName(DiscussionTagPtr tag)
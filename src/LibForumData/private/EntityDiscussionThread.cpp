@@ -19,10 +19,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "EntityDiscussionThread.h"
 #include "EntityCollection.h"
 
-#include "Configuration.h"
 #include "ContextProviders.h"
 
 #include <algorithm>
+#include <mutex>
 
 using namespace Forum;
 using namespace Forum::Entities;
@@ -115,23 +115,27 @@ void DiscussionThread::refreshLatestMessageCreated()
     updateLatestMessageCreated((*it)->created());
 }
 
-void DiscussionThread::addVisitorSinceLastEdit(IdTypeRef userId)
+void DiscussionThread::addVisitorSinceLastEdit(const User& user) const
 {
-    if (static_cast<int_fast32_t>(visitorsSinceLastEdit_.size()) >=
-        Configuration::getGlobalConfig()->discussionThread.maxUsersInVisitedSinceLastChange)
-    {
-        visitorsSinceLastEdit_.clear();
-    }
-    visitorsSinceLastEdit_.insert(userId.value());
+    std::lock_guard<decltype(visitorsSinceLastEditLock_)> _(visitorsSinceLastEditLock_);
+    visitorsSinceLastEdit_.insert(user.ordinal());
+}
+
+bool DiscussionThread::hasVisitedSinceLastEdit(const User& user) const
+{
+    std::lock_guard<decltype(visitorsSinceLastEditLock_)> _(visitorsSinceLastEditLock_);
+    return visitorsSinceLastEdit_.contains(user.ordinal());
 }
 
-bool DiscussionThread::hasVisitedSinceLastEdit(IdTypeRef userId) const
+size_t DiscussionThread::nrOfVisitorsSinceLastEdit() const
 {
-    return visitorsSinceLastEdit_.find(userId.value()) != visitorsSinceLastEdit_.end();
+    std::lock_guard<decltype(visitorsSinceLastEditLock_)> _(visitorsSinceLastEditLock_);
+    return visitorsSinceLastEdit_.size();
 }
 
 void DiscussionThread::resetVisitorsSinceLastEdit()
 {
+    std::lock_guard<decltype(visitorsSinceLastEditLock_)> _(visitorsSinceLastEditLock_);
     visitorsSinceLastEdit_.clear();
 }
 
@@ -17,9 +17,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "EntityDiscussionThreadCollection.h"
+#include "Configuration.h"
 
 #include <boost/iterator/transform_iterator.hpp>
 
+using namespace Forum::Configuration;
 using namespace Forum::Entities;
 
 bool DiscussionThreadCollectionWithHashedId::add(DiscussionThreadPtr thread)
@@ -212,25 +214,30 @@ void DiscussionThreadCollectionWithHashedId::stopBatchInsert()
 {
     if ( ! Context::isBatchInsertInProgress()) return;
 
-    onStopBatchInsert();
+    Helpers::ParallelTaskRunner tasks;
+    onStopBatchInsert(tasks);
+    tasks.run(1);
 }
 
-void DiscussionThreadCollectionWithHashedId::onStopBatchInsert()
+void DiscussionThreadCollectionWithHashedId::stopBatchInsert(Helpers::ParallelTaskRunner& tasks)
 {
-    const auto valuesBegin = byId_.begin();
-    const auto valuesEnd = byId_.end();
+    if ( ! Context::isBatchInsertInProgress()) return;
 
-    byName_.clear();
-    byCreated_.clear();
-    byLastUpdated_.clear();
-    byLatestMessageCreated_.clear();
-    byMessageCount_.clear();
-    
-    byName_.insert(valuesBegin, valuesEnd);
-    byCreated_.insert(valuesBegin, valuesEnd);
-    byLastUpdated_.insert(valuesBegin, valuesEnd);
-    byLatestMessageCreated_.insert(valuesBegin, valuesEnd);
-    byMessageCount_.insert(valuesBegin, valuesEnd);
+    onStopBatchInsert(tasks);
+}
+
+void DiscussionThreadCollectionWithHashedId::onStopBatchInsert(Helpers::ParallelTaskRunner& tasks)
+{
+    auto rebuild = [this](auto& index)
+    {
+        return [this, &index]() { rebuildIndex(index, byId_.begin(), byId_.end()); };
+    };
+
+    tasks.add("threads by name", rebuild(byName_));
+    tasks.add("threads by created", rebuild(byCreated_));
+    tasks.add("threads by last updated", rebuild(byLastUpdated_));
+    tasks.add("threads by latest message created", rebuild(byLatestMessageCreated_));
+    tasks.add("threads by message count", rebuild(byMessageCount_));
 }
 
 bool DiscussionThreadCollectionWithHashedIdAndPinOrder::add(DiscussionThreadPtr thread)
@@ -267,15 +274,11 @@ bool DiscussionThreadCollectionWithHashedIdAndPinOrder::remove(DiscussionThreadP
     return true;
 }
 
-void DiscussionThreadCollectionWithHashedIdAndPinOrder::onStopBatchInsert()
+void DiscussionThreadCollectionWithHashedIdAndPinOrder::onStopBatchInsert(Helpers::ParallelTaskRunner& tasks)
 {
-    DiscussionThreadCollectionWithHashedId::onStopBatchInsert();
-    
-    const auto valuesBegin = byId_.begin();
-    const auto valuesEnd = byId_.end();
+    DiscussionThreadCollectionWithHashedId::onStopBatchInsert(tasks);
 
-    byPinDisplayOrder_.clear();
-    byPinDisplayOrder_.insert(valuesBegin, valuesEnd);
+    tasks.add("threads by pin display order", [this]() { rebuildIndex(byPinDisplayOrder_, byId_.begin(), byId_.end()); });
 }
 
 void DiscussionThreadCollectionWithHashedIdAndPinOrder::prepareUpdatePinDisplayOrder(DiscussionThreadPtr thread)
@@ -295,100 +298,258 @@ void DiscussionThreadCollectionWithHashedIdAndPinOrder::updatePinDisplayOrder(Di
     }
 }
 
-bool DiscussionThreadCollectionWithReferenceCountAndMessageCount::add(DiscussionThreadPtr thread)
+///
+//Lazy Order
+///
+bool DiscussionThreadCollectionWithLazyOrder::add(DiscussionThreadPtr thread)
 {
-    return add(thread, 1);
-}
+    assert(thread);
+    if ( ! std::get<1>(byId_.insert(thread))) return false;
 
-bool DiscussionThreadCollectionWithReferenceCountAndMessageCount::add(DiscussionThreadPtr thread, int_fast32_t amount)
-{
-    auto it = referenceCount_.find(thread);
+    if (Context::isBatchInsertInProgress()) return true;
 
-    if (it == referenceCount_.end())
+    updateTemperature();
+    if (hot_)
+    {
+        forEachOrdering([thread](auto& ordering)
+        {
+            if (ordering.valid.load(std::memory_order_relaxed))
+            {
+                ordering.values->insert(thread);
+            }
+        });
+    }
+    else
     {
-        if ( ! std::get<1>(byId_.insert(thread))) return false;
+        forEachOrdering([](auto& ordering) { discard(ordering); });
+    }
 
-        referenceCount_.insert(std::make_pair(thread, amount));
-        messageCount_ += static_cast<decltype(messageCount_)>(thread->messageCount());
-        return true;
+    if (latestMessageThreadValid_.load(std::memory_order_relaxed))
+    {
+        const auto latestThread = latestMessageThread_.load(std::memory_order_relaxed);
+        if (( ! latestThread) || (thread->latestMessageCreated() >= latestThread->latestMessageCreated()))
+        {
+            latestMessageThread_.store(thread, std::memory_order_relaxed);
+        }
     }
-    it->second += amount;
-    return false;
+    return true;
 }
 
-void DiscussionThreadCollectionWithReferenceCountAndMessageCount::add(
-        const DiscussionThreadCollectionWithReferenceCountAndMessageCount& collection)
+bool DiscussionThreadCollectionWithLazyOrder::add(DiscussionThreadPtr* threads, const size_t threadCount)
 {
-    for (const auto pair : collection.referenceCount_)
+    assert(threads || (threadCount < 1));
+
+    bool result = false;
+    for (size_t i = 0; i < threadCount; ++i)
     {
-        add(pair.first, pair.second);
+        result = add(threads[i]) || result;
     }
+    return result;
 }
 
-void DiscussionThreadCollectionWithReferenceCountAndMessageCount::decreaseReferenceCount(DiscussionThreadPtr thread)
+bool DiscussionThreadCollectionWithLazyOrder::remove(DiscussionThreadPtr thread)
 {
     assert(thread);
+    {
+        const auto itById = byId_.find(thread->id());
+        if (itById == byId_.end()) return false;
+
+        byId_.erase(itById);
+    }
+
+    if (Context::isBatchInsertInProgress()) return true;
 
-    const auto it = referenceCount_.find(thread);
-    if (it == referenceCount_.end())
+    updateTemperature();
+    if (hot_)
+    {
+        auto eraseFrom = [thread](auto& ordering, const auto& value)
+        {
+            if (ordering.valid.load(std::memory_order_relaxed))
+            {
+                eraseFromNonUniqueCollection(*ordering.values, thread, value);
+            }
+        };
+        eraseFrom(byName_, thread->name());
+        eraseFrom(byCreated_, thread->created());
+        eraseFrom(byLastUpdated_, thread->lastUpdated());
+        eraseFrom(byLatestMessageCreated_, thread->latestMessageCreated());
+        eraseFrom(byMessageCount_, thread->messageCount());
+    }
+    else
     {
-        return;
+        forEachOrdering([](auto& ordering) { discard(ordering); });
     }
-    if (--(it->second) < 1)
+
+    if (latestMessageThread_.load(std::memory_order_relaxed) == thread)
     {
-        referenceCount_.erase(it);
-        remove(thread);
+        latestMessageThreadValid_.store(false, std::memory_order_release);
     }
+    return true;
 }
 
+void DiscussionThreadCollectionWithLazyOrder::stopBatchInsert()
+{
+    if ( ! Context::isBatchInsertInProgress()) return;
+
+    //orderings are only built when requested
+    forEachOrdering([](auto& ordering) { discard(ordering); });
+    latestMessageThreadValid_.store(false, std::memory_order_release);
+}
+
+bool DiscussionThreadCollectionWithLazyOrder::contains(DiscussionThreadPtr thread) const
+{
+    assert(thread);
+    return findById(thread->id());
+}
 
-void DiscussionThreadCollectionWithReferenceCountAndMessageCount::decreaseReferenceCount(
-        const DiscussionThreadCollectionWithReferenceCountAndMessageCount& collection)
+const DiscussionThread* DiscussionThreadCollectionWithLazyOrder::findById(IdTypeRef id) const
 {
-    std::vector<DiscussionThreadPtr> toRemove;
+    return (const_cast<DiscussionThreadCollectionWithLazyOrder*>(this))->findById(id);
+}
 
-    for (const auto pair : collection.referenceCount_)
+DiscussionThreadPtr DiscussionThreadCollectionWithLazyOrder::findById(IdTypeRef id)
+{
+    const auto it = byId_.find(id);
+    if (it != byId_.end())
     {
-        auto it = referenceCount_.find(pair.first);
-        if (it == referenceCount_.end()) continue;
-        it->second -= pair.second;
-        if (it->second < 1)
+        return *it;
+    }
+    return {};
+}
+
+void DiscussionThreadCollectionWithLazyOrder::prepareUpdateName(DiscussionThreadPtr thread)
+{
+    if (Context::isBatchInsertInProgress()) return;
+
+    updateTemperature();
+    prepareUpdate(byName_, thread, thread->name());
+}
+
+void DiscussionThreadCollectionWithLazyOrder::updateName(DiscussionThreadPtr thread)
+{
+    if (Context::isBatchInsertInProgress()) return;
+
+    update(byName_, thread);
+}
+
+void DiscussionThreadCollectionWithLazyOrder::prepareUpdateLastUpdated(DiscussionThreadPtr thread)
+{
+    if (Context::isBatchInsertInProgress()) return;
+
+    updateTemperature();
+    prepareUpdate(byLastUpdated_, thread, thread->lastUpdated());
+}
+
+void DiscussionThreadCollectionWithLazyOrder::updateLastUpdated(DiscussionThreadPtr thread)
+{
+    if (Context::isBatchInsertInProgress()) return;
+
+    update(byLastUpdated_, thread);
+}
+
+void DiscussionThreadCollectionWithLazyOrder::prepareUpdateLatestMessageCreated(DiscussionThreadPtr thread)
+{
+    if (Context::isBatchInsertInProgress()) return;
+
+    updateTemperature();
+    prepareUpdate(byLatestMessageCreated_, thread, thread->latestMessageCreated());
+    latestMessageCreatedBeforeUpdate_ = thread->latestMessageCreated();
+}
+
+void DiscussionThreadCollectionWithLazyOrder::updateLatestMessageCreated(DiscussionThreadPtr thread)
+{
+    if (Context::isBatchInsertInProgress()) return;
+
+    update(byLatestMessageCreated_, thread);
+
+    if ( ! latestMessageThreadValid_.load(std::memory_order_relaxed)) return;
+
+    const auto latestThread = latestMessageThread_.load(std::memory_order_relaxed);
+    if (latestThread == thread)
+    {
+        if (thread->latestMessageCreated() < latestMessageCreatedBeforeUpdate_)
         {
-            toRemove.push_back(it->first);
+            //another thread might now have the latest message
+            latestMessageThreadValid_.store(false, std::memory_order_release);
         }
     }
-
-    for (const auto thread : toRemove)
+    else if (( ! latestThread) || (thread->latestMessageCreated() >= latestThread->latestMessageCreated()))
     {
-        referenceCount_.erase(thread);
+        latestMessageThread_.store(thread, std::memory_order_relaxed);
     }
 }
 
-bool DiscussionThreadCollectionWithReferenceCountAndMessageCount::remove(DiscussionThreadPtr thread)
+void DiscussionThreadCollectionWithLazyOrder::prepareUpdateMessageCount(DiscussionThreadPtr thread)
 {
-    assert(thread);
-    {
-        const auto itById = byId_.find(thread->id());
-        if (itById == byId_.end()) return false;
+    if (Context::isBatchInsertInProgress()) return;
 
-        byId_.erase(itById);
-    }
-    referenceCount_.erase(thread);
-    messageCount_ -= static_cast<decltype(messageCount_)>(thread->messageCount());
+    updateTemperature();
+    prepareUpdate(byMessageCount_, thread, thread->messageCount());
+}
 
-    return true;
+void DiscussionThreadCollectionWithLazyOrder::updateMessageCount(DiscussionThreadPtr thread)
+{
+    if (Context::isBatchInsertInProgress()) return;
+
+    update(byMessageCount_, thread);
 }
 
-void DiscussionThreadCollectionWithReferenceCountAndMessageCount::clear()
+const DiscussionThread* DiscussionThreadCollectionWithLazyOrder::latestMessageThread() const
 {
-    byId_.clear();
-    referenceCount_.clear();
-    messageCount_ = 0;
+    if (byLatestMessageCreated_.valid.load(std::memory_order_acquire))
+    {
+        const auto& index = *byLatestMessageCreated_.values;
+        return index.empty() ? nullptr : *(index.rbegin());
+    }
+    if ( ! latestMessageThreadValid_.load(std::memory_order_acquire))
+    {
+        //readers that search at the same time find the same thread, so no lock is needed
+        DiscussionThreadPtr result{};
+        for (const DiscussionThreadPtr thread : byId_)
+        {
+            if (( ! result) || (thread->latestMessageCreated() >= result->latestMessageCreated()))
+            {
+                result = thread;
+            }
+        }
+        latestMessageThread_.store(result, std::memory_order_relaxed);
+        latestMessageThreadValid_.store(true, std::memory_order_release);
+        return result;
+    }
+    return latestMessageThread_.load(std::memory_order_relaxed);
 }
 
-void DiscussionThreadCollectionWithReferenceCountAndMessageCount::stopBatchInsert()
+void DiscussionThreadCollectionWithLazyOrder::recordAccess() const
 {
-    if ( ! Context::isBatchInsertInProgress()) return;
+    recentAccesses_.fetch_add(1, std::memory_order_relaxed);
+    lastAccess_.store(Context::getCurrentTime(), std::memory_order_relaxed);
+}
+
+void DiscussionThreadCollectionWithLazyOrder::updateTemperature()
+{
+    const auto now = Context::getCurrentTime();
+    const auto config = getGlobalConfig();
+    const auto& tagConfig = config->discussionTag;
+
+    if (hot_)
+    {
+        if ((now - lastAccess_.load(std::memory_order_relaxed)) >= tagConfig.maintainThreadOrderingsWithoutAccessFor)
+        {
+            hot_ = false;
+            forEachOrdering([](auto& ordering) { discard(ordering); });
+        }
+    }
+    else if (recentAccesses_.load(std::memory_order_relaxed) >= 
+             static_cast<uint32_t>(tagConfig.minThreadOrderingAccessesToMaintain))
+    {
+        hot_ = true;
+    }
+
+    if ((now - accessWindowStart_) >= tagConfig.threadOrderingAccessWindow)
+    {
+        recentAccesses_.store(0, std::memory_order_relaxed);
+        accessWindowStart_ = now;
+    }
 }
 
 ///
@@ -78,12 +78,11 @@ void DiscussionThreadMessageCollection::clear()
     byCreated_.clear();
 }
 
-void DiscussionThreadMessageCollection::stopBatchInsert()
+void DiscussionThreadMessageCollection::stopBatchInsert(Helpers::ParallelTaskRunner& tasks)
 {
     if ( ! Context::isBatchInsertInProgress()) return;
 
-    byCreated_.clear();
-    byCreated_.insert(byId_.begin(), byId_.end());
+    tasks.add("messages by created", [this]() { rebuildIndex(byCreated_, byId_.begin(), byId_.end()); });
 }
 
 ///
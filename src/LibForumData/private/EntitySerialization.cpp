@@ -52,31 +52,50 @@ JsonWriter& Json::operator<<(JsonWriter& writer, const UuidString& id)
     return writer.writeSafeString(buffer, std::size(buffer));
 }
 
-JsonWriter& Entities::serialize(JsonWriter& writer, const User& user, const SerializationRestriction& restriction)
+SerializationPlan::SerializationPlan(const SerializationRestriction& restriction)
+    : restriction(restriction), currentUser(serializationSettings.currentUser),
+      currentUserId(Context::getCurrentUserId()),
+      showUserInfo(restriction.isAllowed(ForumWidePrivilege::GET_USER_INFO)),
+      showUserSubscribedThreadCount(
+              restriction.isAllowed(ForumWidePrivilege::GET_SUBSCRIBED_DISCUSSION_THREADS_OF_USER)),
+      showUserAttachments(restriction.isAllowed(ForumWidePrivilege::GET_ATTACHMENTS_OF_USER)),
+      showUserAttachmentQuota(restriction.isAllowed(ForumWidePrivilege::CHANGE_USER_ATTACHMENT_QUOTA)),
+      showAllMessageAttachments(restriction.isAllowedToViewAnyAttachment()),
+      showThreadCreatedBy( ! serializationSettings.hideDiscussionThreadCreatedBy),
+      showThreadMessages( ! serializationSettings.hideDiscussionThreadMessages),
+      showLatestMessage( ! serializationSettings.hideLatestMessage),
+      showVisitedThreadSinceLastChange( ! serializationSettings.hideVisitedThreadSinceLastChange),
+      showMessageCreatedBy( ! serializationSettings.hideDiscussionThreadMessageCreatedBy),
+      showMessageParentThread( ! serializationSettings.hideDiscussionThreadMessageParentThread),
+      showPrivileges( ! serializationSettings.hidePrivileges)
+{
+}
+
+static JsonWriter& writeUser(JsonWriter& writer, const User& user, const bool showInfo,
+                             const bool showSubscribedThreadCount, const bool showAttachments,
+                             const bool showAttachmentQuota)
 {
     writer.startObject();
     JSON_WRITE_FIRST_PROP(writer, "id", user.id());
     JSON_WRITE_PROP(writer, "name", user.name());
 
-    const auto sameUser = Context::getCurrentUserId() == user.id();
-
-    if (sameUser || restriction.isAllowed(ForumWidePrivilege::GET_USER_INFO))
+    if (showInfo)
     {
         JSON_WRITE_PROP(writer, "info", user.info());
     }
 
-    if (sameUser || restriction.isAllowed(ForumWidePrivilege::GET_SUBSCRIBED_DISCUSSION_THREADS_OF_USER))
+    if (showSubscribedThreadCount)
     {
         JSON_WRITE_PROP(writer, "subscribedThreadCount", user.subscribedThreads().count());
     }
 
-    if (sameUser || restriction.isAllowed(ForumWidePrivilege::GET_ATTACHMENTS_OF_USER))
+    if (showAttachments)
     {
         JSON_WRITE_PROP(writer, "attachmentCount", user.attachments().count());
         JSON_WRITE_PROP(writer, "attachmentTotalSize", user.attachments().totalSize());
     }
 
-    if (user.attachmentQuota() && (sameUser || restriction.isAllowed(ForumWidePrivilege::CHANGE_USER_ATTACHMENT_QUOTA)))
+    if (showAttachmentQuota)
     {
         JSON_WRITE_PROP(writer, "attachmentQuota", *user.attachmentQuota());
     }
@@ -99,6 +118,29 @@ JsonWriter& Entities::serialize(JsonWriter& writer, const User& user, const Seri
     return writer;
 }
 
+JsonWriter& Entities::serialize(JsonWriter& writer, const User& user, const SerializationRestriction& restriction)
+{
+    const auto sameUser = Context::getCurrentUserId() == user.id();
+
+    const auto showInfo = sameUser || restriction.isAllowed(ForumWidePrivilege::GET_USER_INFO);
+    const auto showSubscribedThreadCount = sameUser
+            || restriction.isAllowed(ForumWidePrivilege::GET_SUBSCRIBED_DISCUSSION_THREADS_OF_USER);
+    const auto showAttachments = sameUser || restriction.isAllowed(ForumWidePrivilege::GET_ATTACHMENTS_OF_USER);
+    const auto showAttachmentQuota = user.attachmentQuota()
+            && (sameUser || restriction.isAllowed(ForumWidePrivilege::CHANGE_USER_ATTACHMENT_QUOTA));
+
+    return writeUser(writer, user, showInfo, showSubscribedThreadCount, showAttachments, showAttachmentQuota);
+}
+
+JsonWriter& Entities::serialize(JsonWriter& writer, const User& user, const SerializationPlan& plan)
+{
+    const auto sameUser = plan.currentUserId == user.id();
+
+    return writeUser(writer, user, sameUser || plan.showUserInfo, sameUser || plan.showUserSubscribedThreadCount,
+                     sameUser || plan.showUserAttachments,
+                     user.attachmentQuota() && (sameUser || plan.showUserAttachmentQuota));
+}
+
 JsonWriter& writeVisitDetails(JsonWriter& writer, const VisitDetails& visitDetails)
 {
     //does not currently start a new object
@@ -111,39 +153,203 @@ JsonWriter& writeVisitDetails(JsonWriter& writer, const VisitDetails& visitDetai
     return writer;
 }
 
-JsonWriter& Entities::serialize(JsonWriter& writer, const DiscussionThreadMessage& message,
-                                const SerializationRestriction& restriction)
+/**
+ * Writes the latest message of a thread, tag or category
+ * The creator is written using either a restriction or a plan
+ */
+template<typename UserSerializationType>
+static void writeLatestMessage(JsonWriter& writer, const DiscussionThreadMessage& latestMessage,
+                               const UserSerializationType& userSerialization, const bool allowView,
+                               const bool allowViewUser)
 {
-    const auto allowView = serializationSettings.allowDisplayDiscussionThreadMessage
-            ? (*serializationSettings.allowDisplayDiscussionThreadMessage
-                && restriction.checkMessageAllowViewApproval(message)
-                && restriction.checkThreadAllowViewApproval(*message.parentThread()))
-            : restriction.isAllowedToViewMessage(message);
+    writer.newPropertyRaw(JSON_RAW_PROP_COMMA("latestMessage"));
+    
+    if ( ! allowView)
+    {
+        writer.null();
+        return;
+    }
 
-    if ( ! allowView) return writer.null();
+    auto parentThread = latestMessage.parentThread();
+    assert(parentThread);
+    
+    writer.startObject();
+    JSON_WRITE_FIRST_PROP(writer, "id", latestMessage.id());
+    JSON_WRITE_PROP(writer, "created", latestMessage.created());
+    JSON_WRITE_PROP(writer, "approved", latestMessage.approved());
+    JSON_WRITE_PROP(writer, "threadId", parentThread->id());
+    JSON_WRITE_PROP(writer, "threadName", parentThread->name());
 
-    const auto allowViewUser = serializationSettings.allowDisplayDiscussionThreadMessageUser
-            ? *serializationSettings.allowDisplayDiscussionThreadMessageUser
-            : restriction.isAllowed(message, DiscussionThreadMessagePrivilege::VIEW_CREATOR_USER);
+    auto content = latestMessage.content();
+    writer.newPropertyRaw(JSON_RAW_PROP_COMMA("content")).writeEscapedString(content.data(), content.size());
 
-    const auto allowViewVotes = serializationSettings.allowDisplayDiscussionThreadMessageVotes
-            ? *serializationSettings.allowDisplayDiscussionThreadMessageVotes
-            : restriction.isAllowed(message, DiscussionThreadMessagePrivilege::VIEW_VOTES);
+    if (allowViewUser)
+    {
+        writer.newPropertyRaw(JSON_RAW_PROP_COMMA("createdBy"));
+        serialize(writer, latestMessage.createdBy(), userSerialization);
+    }
+    writer << objEnd;
+}
 
-    const auto allowViewIpAddress = serializationSettings.allowDisplayDiscussionThreadMessageIpAddress
-            ? *serializationSettings.allowDisplayDiscussionThreadMessageIpAddress
-            : restriction.isAllowed(message, DiscussionThreadMessagePrivilege::VIEW_IP_ADDRESS);
+static void writeLatestMessage(JsonWriter& writer, const DiscussionThreadMessage& latestMessage,
+                               const SerializationRestriction& restriction)
+{
+    const auto allowView = restriction.isAllowedToViewMessage(latestMessage);
+    const auto allowViewUser = allowView
+            && restriction.isAllowed(latestMessage, DiscussionThreadMessagePrivilege::VIEW_CREATOR_USER);
 
-    const auto allowViewCommentCount = serializationSettings.allowDisplayDiscussionThreadMessageComments
-            ? *serializationSettings.allowDisplayDiscussionThreadMessageComments
-            : restriction.isAllowed(message, DiscussionThreadMessagePrivilege::GET_MESSAGE_COMMENTS);
+    writeLatestMessage(writer, latestMessage, restriction, allowView, allowViewUser);
+}
+
+template<typename ThreadCollection>
+static void writeLatestMessage(JsonWriter& writer, const ThreadCollection& threads,
+                               const SerializationRestriction& restriction)
+{
+    auto index = threads.byLatestMessageCreated();
+    if ( ! index.size())
+    {
+        return;
+    }
+    auto thread = *(index.rbegin());
+    auto messageIndex = thread->messages().byCreated();
+    if (messageIndex.size())
+    {
+        writeLatestMessage(writer, **messageIndex.rbegin(), restriction);
+    }
+}
+
+static void writeLatestMessage(JsonWriter& writer, const DiscussionThreadCollectionWithLazyOrder& threads,
+                               const SerializationRestriction& restriction)
+{
+    //avoid building the whole ordering only to find the latest message
+    auto thread = threads.latestMessageThread();
+    if ( ! thread)
+    {
+        return;
+    }
+    auto messageIndex = thread->messages().byCreated();
+    if ( ! messageIndex.size())
+    {
+        return;
+    }
+    auto precomputed = serializationSettings.discussionThreadPrivilegeCheck;
+    if (precomputed && (precomputed->thread == thread))
+    {
+        writeLatestMessage(writer, **messageIndex.rbegin(), restriction, precomputed->allowedToShowLatestMessage,
+                           precomputed->allowedToShowLatestMessageUser);
+    }
+    else
+    {
+        writeLatestMessage(writer, **messageIndex.rbegin(), restriction);
+    }
+}
+
+namespace
+{
+    /**
+     * Decides what is written based on serializationSettings, checking privileges only when they are needed
+     * Used for single entities and entities nested in other ones
+     */
+    struct SerializationSettingsPolicy final
+    {
+        const SerializationRestriction& restriction;
+
+        UserConstPtr currentUser() const { return serializationSettings.currentUser; }
+
+        bool showThreadCreatedBy() const { return ! serializationSettings.hideDiscussionThreadCreatedBy; }
+        bool showThreadMessages() const { return ! serializationSettings.hideDiscussionThreadMessages; }
+        bool showLatestMessage() const { return ! serializationSettings.hideLatestMessage; }
+        bool showMessageCreatedBy() const { return ! serializationSettings.hideDiscussionThreadMessageCreatedBy; }
+        bool showMessageParentThread() const { return ! serializationSettings.hideDiscussionThreadMessageParentThread; }
+        bool showPrivileges() const { return ! serializationSettings.hidePrivileges; }
+        bool showAllMessageAttachments() const { return restriction.isAllowedToViewAnyAttachment(); }
+
+        bool showVisitedSinceLastChange() const { return ! serializationSettings.hideVisitedThreadSinceLastChange; }
+        bool visitedThreadSinceLastChange() const { return serializationSettings.visitedThreadSinceLastChange; }
+
+        void writeUser(JsonWriter& writer, const User& user) const
+        {
+            serialize(writer, user, restriction);
+        }
+
+        void writeLatestMessage(JsonWriter& writer, const DiscussionThreadMessage& latestMessage) const
+        {
+            ::writeLatestMessage(writer, latestMessage, restriction);
+        }
+
+        void writeThreadPrivileges(JsonWriter& writer, const DiscussionThread& thread) const
+        {
+            writePrivileges(writer, thread, DiscussionThreadPrivilegesToSerialize, DiscussionThreadPrivilegeStrings,
+                            restriction);
+        }
+    };
+
+    /**
+     * Decides what is written based on a plan created for the whole page
+     * Privileges specific to a thread are taken from a check computed in advance
+     */
+    struct SerializationPlanPolicy final
+    {
+        const SerializationPlan& plan;
+        const SerializationRestriction& restriction;
+        const DiscussionThreadPrivilegeCheck* threadCheck;
+        bool visitedSinceLastChange;
+
+        UserConstPtr currentUser() const { return plan.currentUser; }
+
+        bool showThreadCreatedBy() const { return plan.showThreadCreatedBy; }
+        bool showThreadMessages() const { return plan.showThreadMessages; }
+        bool showLatestMessage() const { return plan.showLatestMessage; }
+        bool showMessageCreatedBy() const { return plan.showMessageCreatedBy; }
+        bool showMessageParentThread() const { return plan.showMessageParentThread; }
+        bool showPrivileges() const { return plan.showPrivileges; }
+        bool showAllMessageAttachments() const { return plan.showAllMessageAttachments; }
+
+        bool showVisitedSinceLastChange() const { return plan.showVisitedThreadSinceLastChange; }
+        bool visitedThreadSinceLastChange() const { return visitedSinceLastChange; }
+
+        void writeUser(JsonWriter& writer, const User& user) const
+        {
+            serialize(writer, user, plan);
+        }
+
+        void writeLatestMessage(JsonWriter& writer, const DiscussionThreadMessage& latestMessage) const
+        {
+            assert(threadCheck);
+            ::writeLatestMessage(writer, latestMessage, plan, threadCheck->allowedToShowLatestMessage,
+                                 threadCheck->allowedToShowLatestMessageUser);
+        }
+
+        void writeThreadPrivileges(JsonWriter& writer, const DiscussionThread&) const
+        {
+            assert(threadCheck);
+            writePrecomputedPrivileges(writer, threadCheck->allowed, DiscussionThreadPrivilegesToSerialize,
+                                       DiscussionThreadPrivilegeStrings);
+        }
+    };
+
+    struct DiscussionThreadMessageFieldsAllowed final
+    {
+        bool user;
+        bool votes;
+        bool ipAddress;
+        bool comments;
+    };
+}
+
+template<typename Policy>
+static JsonWriter& writeDiscussionThreadMessage(JsonWriter& writer, const DiscussionThreadMessage& message,
+                                                const Policy& policy,
+                                                const DiscussionThreadMessageFieldsAllowed allowed)
+{
+    const auto& restriction = policy.restriction;
 
     writer.startObject();
     JSON_WRITE_FIRST_PROP(writer, "id", message.id());
     JSON_WRITE_PROP(writer, "created", message.created());
     JSON_WRITE_PROP(writer, "approved", message.approved());
 
-    if (allowViewCommentCount)
+    if (allowed.comments)
     {
         JSON_WRITE_PROP(writer, "commentsCount", message.comments().count());
         JSON_WRITE_PROP(writer, "solvedCommentsCount", message.solvedCommentsCount());
@@ -152,14 +358,12 @@ JsonWriter& Entities::serialize(JsonWriter& writer, const DiscussionThreadMessag
     auto content = message.content();
     writer.newPropertyRaw(JSON_RAW_PROP_COMMA("content")).writeEscapedString(content.data(), content.size());
 
-    if (allowViewUser && ( ! serializationSettings.hideDiscussionThreadMessageCreatedBy))
+    if (allowed.user && policy.showMessageCreatedBy())
     {
-        BoolTemporaryChanger _(serializationSettings.hidePrivileges, true);
-
         writer.newPropertyRaw(JSON_RAW_PROP_COMMA("createdBy"));
-        serialize(writer, message.createdBy(), restriction);
+        policy.writeUser(writer, message.createdBy());
     }
-    if ( ! serializationSettings.hideDiscussionThreadMessageParentThread)
+    if (policy.showMessageParentThread())
     {
         DiscussionThreadConstPtr parentThread = message.parentThread();
         assert(parentThread);
@@ -177,7 +381,7 @@ JsonWriter& Entities::serialize(JsonWriter& writer, const DiscussionThreadMessag
         writer.startObject();
 
         UserConstPtr by = message.lastUpdatedBy();
-        if (by && allowViewUser)
+        if (by && allowed.user)
         {
             JSON_WRITE_FIRST_PROP(writer, "userId", by->id());
             JSON_WRITE_PROP(writer, "userName", by->name());
@@ -188,7 +392,7 @@ JsonWriter& Entities::serialize(JsonWriter& writer, const DiscussionThreadMessag
             JSON_WRITE_FIRST_PROP(writer, "at", message.lastUpdated());            
         }
         JSON_WRITE_PROP(writer, "reason", message.lastUpdatedReason());
-        if (allowViewIpAddress)
+        if (allowed.ipAddress)
         {
             writeVisitDetails(writer, message.lastUpdatedDetails());
         }
@@ -196,7 +400,7 @@ JsonWriter& Entities::serialize(JsonWriter& writer, const DiscussionThreadMessag
         writer.endObject();
     }
 
-    if (allowViewIpAddress)
+    if (allowed.ipAddress)
     {
         writeVisitDetails(writer, message.creationDetails());
     }
@@ -204,14 +408,14 @@ JsonWriter& Entities::serialize(JsonWriter& writer, const DiscussionThreadMessag
     const auto& upVotes = message.upVotes();
     const auto& downVotes = message.downVotes();
 
-    if (allowViewVotes)
+    if (allowed.votes)
     {
         JSON_WRITE_PROP(writer, "nrOfUpVotes", upVotes.size());
         JSON_WRITE_PROP(writer, "nrOfDownVotes", downVotes.size());
     }
     auto voteStatus = 0;
     {
-        auto currentUserTemp = const_cast<UserPtr>(serializationSettings.currentUser);
+        auto currentUserTemp = const_cast<UserPtr>(policy.currentUser());
         if (currentUserTemp && (downVotes.find(currentUserTemp) != downVotes.end()))
         {
             voteStatus = -1;
@@ -228,7 +432,7 @@ JsonWriter& Entities::serialize(JsonWriter& writer, const DiscussionThreadMessag
         writer.newPropertyRaw(JSON_RAW_PROP_COMMA("attachments"));
         writer.startArray();
 
-        const auto allowViewAllAttachments = restriction.isAllowedToViewAnyAttachment();
+        const auto allowViewAllAttachments = policy.showAllMessageAttachments();
         for (const auto attachmentPtr: message.attachments())
         {
             const Attachment& attachment = *attachmentPtr;
@@ -242,7 +446,7 @@ JsonWriter& Entities::serialize(JsonWriter& writer, const DiscussionThreadMessag
         writer.endArray();
     }
 
-    if ( ! serializationSettings.hidePrivileges)
+    if (policy.showPrivileges())
     {
         writePrivileges(writer, message, DiscussionThreadMessagePrivilegesToSerialize,
                         DiscussionThreadMessagePrivilegeStrings, restriction);
@@ -252,6 +456,41 @@ JsonWriter& Entities::serialize(JsonWriter& writer, const DiscussionThreadMessag
     return writer;
 }
 
+JsonWriter& Entities::serialize(JsonWriter& writer, const DiscussionThreadMessage& message,
+                                const SerializationRestriction& restriction)
+{
+    if ( ! restriction.isAllowedToViewMessage(message)) return writer.null();
+
+    DiscussionThreadMessageFieldsAllowed allowed{};
+    allowed.user = restriction.isAllowed(message, DiscussionThreadMessagePrivilege::VIEW_CREATOR_USER);
+    allowed.votes = restriction.isAllowed(message, DiscussionThreadMessagePrivilege::VIEW_VOTES);
+    allowed.ipAddress = restriction.isAllowed(message, DiscussionThreadMessagePrivilege::VIEW_IP_ADDRESS);
+    allowed.comments = restriction.isAllowed(message, DiscussionThreadMessagePrivilege::GET_MESSAGE_COMMENTS);
+
+    return writeDiscussionThreadMessage(writer, message, SerializationSettingsPolicy{ restriction }, allowed);
+}
+
+JsonWriter& Entities::serialize(JsonWriter& writer, const DiscussionThreadMessage& message,
+                                const SerializationPlan& plan, const DiscussionThreadMessagePrivilegeCheck& check)
+{
+    const auto& restriction = plan.restriction;
+
+    const auto allowView = check.allowedToShowMessage
+            && restriction.checkMessageAllowViewApproval(message)
+            && restriction.checkThreadAllowViewApproval(*message.parentThread());
+
+    if ( ! allowView) return writer.null();
+
+    DiscussionThreadMessageFieldsAllowed allowed{};
+    allowed.user = check.allowedToShowUser;
+    allowed.votes = check.allowedToShowVotes;
+    allowed.ipAddress = check.allowedToShowIpAddress;
+    allowed.comments = check.allowedToViewComments;
+
+    return writeDiscussionThreadMessage(writer, message, SerializationPlanPolicy{ plan, restriction, nullptr, false },
+                                        allowed);
+}
+
 JsonWriter& Entities::serialize(JsonWriter& writer, const PrivateMessage& message,
                                 const SerializationRestriction& restriction)
 {
@@ -285,56 +524,6 @@ JsonWriter& Entities::serialize(JsonWriter& writer, const PrivateMessage& messag
     return writer;
 }
 
-static void writeLatestMessage(JsonWriter& writer, const DiscussionThreadMessage& latestMessage,
-                               const SerializationRestriction& restriction)
-{
-    writer.newPropertyRaw(JSON_RAW_PROP_COMMA("latestMessage"));
-    
-    if ( ! restriction.isAllowedToViewMessage(latestMessage))
-    {
-        writer.null();
-        return;
-    }
-
-    auto parentThread = latestMessage.parentThread();
-    assert(parentThread);
-    
-    writer.startObject();
-    JSON_WRITE_FIRST_PROP(writer, "id", latestMessage.id());
-    JSON_WRITE_PROP(writer, "created", latestMessage.created());
-    JSON_WRITE_PROP(writer, "approved", latestMessage.approved());
-    JSON_WRITE_PROP(writer, "threadId", parentThread->id());
-    JSON_WRITE_PROP(writer, "threadName", parentThread->name());
-
-    auto content = latestMessage.content();
-    writer.newPropertyRaw(JSON_RAW_PROP_COMMA("content")).writeEscapedString(content.data(), content.size());
-
-    if (restriction.isAllowed(latestMessage, DiscussionThreadMessagePrivilege::VIEW_CREATOR_USER))
-    {
-        writer.newPropertyRaw(JSON_RAW_PROP_COMMA("createdBy"));
-        BoolTemporaryChanger _(serializationSettings.hidePrivileges, true);
-        serialize(writer, latestMessage.createdBy(), restriction);
-    }
-    writer << objEnd;
-}
-
-template<typename ThreadCollection>
-static void writeLatestMessage(JsonWriter& writer, const ThreadCollection& threads,
-                               const SerializationRestriction& restriction)
-{
-    auto index = threads.byLatestMessageCreated();
-    if ( ! index.size())
-    {
-        return;
-    }
-    auto thread = *(index.rbegin());
-    auto messageIndex = thread->messages().byCreated();
-    if (messageIndex.size())
-    {
-        writeLatestMessage(writer, **messageIndex.rbegin(), restriction);
-    }
-}
-
 JsonWriter& Entities::serialize(JsonWriter& writer, const MessageComment& comment,
                                 const SerializationRestriction& restriction)
 {
@@ -381,41 +570,15 @@ void writeDiscussionThreadMessages(const Collection& collection, const int_fast3
 
     privilegeChecks.clear();
 
-    auto firstElementIndex = std::max(static_cast<decltype(totalCount)>(0),
-                                      static_cast<decltype(totalCount)>(pageNumber * pageSize));
-    if (ascending)
-    {
-        for (auto it = collection.nth(firstElementIndex), n = collection.nth(firstElementIndex + pageSize); it != n; ++it)
-        {
-            if (*it)
-            {
-                privilegeChecks.emplace_back(DiscussionThreadMessagePrivilegeCheck(restriction.user(), **it));
-            }
-        }
-    }
-    else
+    forEachEntityInPage(collection, pageNumber, pageSize, ascending, [&](const DiscussionThreadMessage& message)
     {
-        auto itStart = collection.nth(std::max(totalCount - firstElementIndex,
-            static_cast<decltype(totalCount)>(0)));
-        auto itEnd = collection.nth(std::max(totalCount - firstElementIndex - pageSize,
-            static_cast<decltype(totalCount)>(0)));
-
-        if (itStart != collection.begin())
-        {
-            for (auto it = itStart; it != itEnd;)
-            {
-                --it;
-                if (*it)
-                {
-                    privilegeChecks.emplace_back(DiscussionThreadMessagePrivilegeCheck(restriction.user(), **it));
-                }
-            }
-        }
-    }
+        privilegeChecks.emplace_back(DiscussionThreadMessagePrivilegeCheck(restriction.user(), message));
+    });
 
     restriction.privilegeStore().computeDiscussionThreadMessageVisibilityAllowed(privilegeChecks.data(),
                                                                                  privilegeChecks.size(),
                                                                                  restriction.now());
+    const SerializationPlan plan(restriction);
 
     writer.newPropertyWithSafeName(propertyName, PropertyNameSize - 1);
     writer.startArray();
@@ -424,27 +587,74 @@ void writeDiscussionThreadMessages(const Collection& collection, const int_fast3
         if ( ! item.allowedToShowMessage) continue;
         if ( ! item.message) continue;
 
-        OptionalRevertToNoneChanger<bool> _(serializationSettings.allowDisplayDiscussionThreadMessage,
-                                            item.allowedToShowMessage);
-        OptionalRevertToNoneChanger<bool> __(serializationSettings.allowDisplayDiscussionThreadMessageUser,
-                                             item.allowedToShowUser);
-        OptionalRevertToNoneChanger<bool> ___(serializationSettings.allowDisplayDiscussionThreadMessageVotes,
-                                              item.allowedToShowVotes);
-        OptionalRevertToNoneChanger<bool> ____(serializationSettings.allowDisplayDiscussionThreadMessageIpAddress,
-                                               item.allowedToShowIpAddress);
-        OptionalRevertToNoneChanger<bool> _____(serializationSettings.allowDisplayDiscussionThreadMessageComments,
-                                                item.allowedToViewComments);
-
-        serialize(writer, *item.message, restriction);
+        serialize(writer, *item.message, plan, item);
     }
     writer.endArray();
 }
 
+static void writeDiscussionTagFields(JsonWriter& writer, const DiscussionTag& tag)
+{
+    JSON_WRITE_FIRST_PROP(writer, "id", tag.id());
+    JSON_WRITE_PROP(writer, "name", tag.name());
+    JSON_WRITE_PROP(writer, "created", tag.created());
+    JSON_WRITE_PROP(writer, "threadCount", tag.threads().count());
+    JSON_WRITE_PROP(writer, "messageCount", tag.messageCount());
+}
 
-JsonWriter& Entities::serialize(JsonWriter& writer, const DiscussionThread& thread,
-                                const SerializationRestriction& restriction)
+static void writeDiscussionCategoryFields(JsonWriter& writer, const DiscussionCategory& category)
 {
-    if ( ! restriction.isAllowedToViewThread(thread)) return writer.null();
+    JSON_WRITE_FIRST_PROP(writer, "id", category.id());
+    JSON_WRITE_PROP(writer, "name", category.name());
+    JSON_WRITE_PROP(writer, "description", category.description());
+    JSON_WRITE_PROP(writer, "displayOrder", category.displayOrder());
+    JSON_WRITE_PROP(writer, "created", category.created());
+    JSON_WRITE_PROP(writer, "threadCount", category.threads().count());
+    JSON_WRITE_PROP(writer, "messageCount", category.messageCount());
+    JSON_WRITE_PROP(writer, "threadTotalCount", category.threadTotalCount());
+    JSON_WRITE_PROP(writer, "messageTotalCount", category.messageTotalCount());
+}
+
+/**
+ * Writes the tags and categories of a discussion thread without their latest message, relations or privileges
+ */
+static void writeDiscussionThreadTagsAndCategories(JsonWriter& writer, const DiscussionThread& thread,
+                                                   const SerializationRestriction& restriction)
+{
+    writer.newPropertyRaw(JSON_RAW_PROP_COMMA("tags"));
+    writer << arrayStart;
+    for (auto tag : thread.tags())
+    {
+        if ( ! restriction.isAllowed(*tag))
+        {
+            writer.null();
+            continue;
+        }
+        writer.startObject();
+        writeDiscussionTagFields(writer, *tag);
+        writer.endObject();
+    }
+    writer << arrayEnd;
+
+    writer.newPropertyRaw(JSON_RAW_PROP_COMMA("categories"));
+    writer << arrayStart;
+    for (auto category : thread.categories())
+    {
+        if ( ! restriction.isAllowed(*category))
+        {
+            writer.null();
+            continue;
+        }
+        writer.startObject();
+        writeDiscussionCategoryFields(writer, *category);
+        writer.endObject();
+    }
+    writer << arrayEnd;
+}
+
+template<typename Policy>
+static JsonWriter& writeDiscussionThread(JsonWriter& writer, const DiscussionThread& thread, const Policy& policy)
+{
+    const auto& restriction = policy.restriction;
 
     writer.startObject();
     JSON_WRITE_FIRST_PROP(writer, "id", thread.id());
@@ -456,7 +666,7 @@ JsonWriter& Entities::serialize(JsonWriter& writer, const DiscussionThread& thre
     JSON_WRITE_PROP(writer, "pinDisplayOrder", thread.pinDisplayOrder());
     JSON_WRITE_PROP(writer, "subscribedUsersCount", thread.subscribedUsersCount());
 
-    auto currentUser = serializationSettings.currentUser;
+    auto currentUser = policy.currentUser();
 
     if (currentUser)
     {
@@ -470,12 +680,10 @@ JsonWriter& Entities::serialize(JsonWriter& writer, const DiscussionThread& thre
         }
     }
 
-    if ( ! serializationSettings.hideDiscussionThreadCreatedBy)
+    if (policy.showThreadCreatedBy())
     {
-        BoolTemporaryChanger _(serializationSettings.hidePrivileges, true);
-
         writer.newPropertyRaw(JSON_RAW_PROP_COMMA("createdBy"));
-        serialize(writer, thread.createdBy(), restriction);
+        policy.writeUser(writer, thread.createdBy());
     }
 
     const auto& messagesIndex = thread.messages().byCreated();
@@ -483,13 +691,11 @@ JsonWriter& Entities::serialize(JsonWriter& writer, const DiscussionThread& thre
 
     JSON_WRITE_PROP(writer, "messageCount", messageCount);
 
-    if (messageCount && ! serializationSettings.hideLatestMessage)
+    if (messageCount && policy.showLatestMessage())
     {
-        BoolTemporaryChanger _(serializationSettings.hidePrivileges, true);
-
-        writeLatestMessage(writer, **messagesIndex.rbegin(), restriction);
+        policy.writeLatestMessage(writer, **messagesIndex.rbegin());
     }
-    if ( ! serializationSettings.hideDiscussionThreadMessages)
+    if (policy.showThreadMessages())
     {
         const auto pageSize = getGlobalConfig()->discussionThreadMessage.maxMessagesPerPage;
         auto& displayContext = Context::getDisplayContext();
@@ -497,63 +703,51 @@ JsonWriter& Entities::serialize(JsonWriter& writer, const DiscussionThread& thre
         writeDiscussionThreadMessages(messagesIndex, displayContext.pageNumber, pageSize, true, "messages", writer,
                                       restriction);
     }
-    if ( ! serializationSettings.hideVisitedThreadSinceLastChange)
+    if (policy.showVisitedSinceLastChange())
     {
-        JSON_WRITE_PROP(writer, "visitedSinceLastChange", serializationSettings.visitedThreadSinceLastChange);
+        JSON_WRITE_PROP(writer, "visitedSinceLastChange", policy.visitedThreadSinceLastChange());
     }
 
-    {
-        BoolTemporaryChanger _(serializationSettings.hideDiscussionCategoriesOfTags, true);
-        BoolTemporaryChanger __(serializationSettings.hideLatestMessage, true);
-        BoolTemporaryChanger ___(serializationSettings.hidePrivileges, true);
-
-        writer.newPropertyRaw(JSON_RAW_PROP_COMMA("tags"));
-        writer << arrayStart;
-        for (auto tag : thread.tags())
-        {
-            serialize(writer, *tag, restriction);
-        }
-        writer << arrayEnd;
-    }
-    {
-        BoolTemporaryChanger _(serializationSettings.hideDiscussionCategoryParent, true);
-        BoolTemporaryChanger __(serializationSettings.hideDiscussionCategoryTags, true);
-        BoolTemporaryChanger ___(serializationSettings.hideLatestMessage, true);
-        BoolTemporaryChanger ____(serializationSettings.hidePrivileges, true);
+    writeDiscussionThreadTagsAndCategories(writer, thread, restriction);
 
-        writer.newPropertyRaw(JSON_RAW_PROP_COMMA("categories"));
-        writer << arrayStart;
-        for (auto category : thread.categories())
-        {
-            serialize(writer, *category, restriction);
-        }
-        writer << arrayEnd;
-    }
     JSON_WRITE_PROP(writer, "lastUpdated", thread.lastUpdated());
     JSON_WRITE_PROP(writer, "visited", thread.visited().load());
     JSON_WRITE_PROP(writer, "voteScore", thread.voteScore());
 
-    if ( ! serializationSettings.hidePrivileges)
+    if (policy.showPrivileges())
     {
-        writePrivileges(writer, thread, DiscussionThreadPrivilegesToSerialize,
-                        DiscussionThreadPrivilegeStrings,restriction);
+        policy.writeThreadPrivileges(writer, thread);
     }
 
     writer << objEnd;
     return writer;
 }
 
+JsonWriter& Entities::serialize(JsonWriter& writer, const DiscussionThread& thread,
+                                const SerializationRestriction& restriction)
+{
+    if ( ! restriction.isAllowedToViewThread(thread)) return writer.null();
+
+    return writeDiscussionThread(writer, thread, SerializationSettingsPolicy{ restriction });
+}
+
+JsonWriter& Entities::serialize(JsonWriter& writer, const DiscussionThread& thread, const SerializationPlan& plan,
+                                const DiscussionThreadPrivilegeCheck& check, const bool visitedSinceLastChange)
+{
+    assert(check.thread == &thread);
+    if ( ! check.allowedToShowThread) return writer.null();
+
+    return writeDiscussionThread(writer, thread,
+                                 SerializationPlanPolicy{ plan, plan.restriction, &check, visitedSinceLastChange });
+}
+
 JsonWriter& Entities::serialize(JsonWriter& writer, const DiscussionTag& tag,
                                 const SerializationRestriction& restriction)
 {
     if ( ! restriction.isAllowed(tag)) return writer.null();
 
     writer.startObject();
-    JSON_WRITE_FIRST_PROP(writer, "id", tag.id());
-    JSON_WRITE_PROP(writer, "name", tag.name());
-    JSON_WRITE_PROP(writer, "created", tag.created());
-    JSON_WRITE_PROP(writer, "threadCount", tag.threads().count());
-    JSON_WRITE_PROP(writer, "messageCount", tag.messageCount());
+    writeDiscussionTagFields(writer, tag);
 
     if ( ! serializationSettings.hideLatestMessage)
     {
@@ -592,15 +786,7 @@ JsonWriter& Entities::serialize(JsonWriter& writer, const DiscussionCategory& ca
     if ( ! restriction.isAllowed(category)) return writer.null();
 
     writer.startObject();
-    JSON_WRITE_FIRST_PROP(writer, "id", category.id());
-    JSON_WRITE_PROP(writer, "name", category.name());
-    JSON_WRITE_PROP(writer, "description", category.description());
-    JSON_WRITE_PROP(writer, "displayOrder", category.displayOrder());
-    JSON_WRITE_PROP(writer, "created", category.created());
-    JSON_WRITE_PROP(writer, "threadCount", category.threads().count());
-    JSON_WRITE_PROP(writer, "messageCount", category.messageCount());
-    JSON_WRITE_PROP(writer, "threadTotalCount", category.threadTotalCount());
-    JSON_WRITE_PROP(writer, "messageTotalCount", category.messageTotalCount());
+    writeDiscussionCategoryFields(writer, category);
 
     if ( ! serializationSettings.hideLatestMessage)
     {
@@ -683,7 +869,7 @@ JsonWriter& Entities::serialize(JsonWriter& writer, const Attachment& attachment
     JSON_WRITE_PROP(writer, "size", attachment.size());
     JSON_WRITE_PROP(writer, "approved", attachment.approved());
     JSON_WRITE_PROP(writer, "nrOfMessagesAttached", attachment.messages().size());
-    JSON_WRITE_PROP(writer, "nrOfGetRequests", attachment.nrOfGetRequests());
+    JSON_WRITE_PROP(writer, "nrOfGetRequests", attachment.nrOfGetRequests().load());
 
     if (serializationSettings.allowDisplayAttachmentIpAddress)
     {
@@ -66,20 +66,18 @@ bool UserCollection::remove(UserPtr user)
     return true;
 }
 
-void UserCollection::stopBatchInsert()
+void UserCollection::stopBatchInsert(Helpers::ParallelTaskRunner& tasks)
 {
     if ( ! Context::isBatchInsertInProgress()) return;
 
-    const std::vector<UserPtr> byId(byId_.begin(), byId_.end());
-
-    byLastSeen_.clear();
-    byLastSeen_.insert(byId.begin(), byId.end());
-
-    byThreadCount_.clear();
-    byThreadCount_.insert(byId.begin(), byId.end());
+    auto rebuild = [this](auto& index)
+    {
+        return [this, &index]() { rebuildIndex(index, byId_.begin(), byId_.end()); };
+    };
 
-    byMessageCount_.clear();
-    byMessageCount_.insert(byId.begin(), byId.end());
+    tasks.add("users by last seen", rebuild(byLastSeen_));
+    tasks.add("users by thread count", rebuild(byThreadCount_));
+    tasks.add("users by message count", rebuild(byMessageCount_));
 }
 
 void UserCollection::prepareUpdateAuth(UserPtr user)
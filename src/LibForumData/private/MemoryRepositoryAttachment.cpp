@@ -202,7 +202,7 @@ StatusCode MemoryRepositoryAttachment::canGetAttachment(IdTypeRef id, OutStream&
                               return;
                           }
                       
-                          attachment.nrOfGetRequests() += 1;
+                          ++attachment.nrOfGetRequests();
 
                           status.disable();
 
@@ -351,7 +351,7 @@ StatusCode MemoryRepositoryAttachment::addNewAttachment(StringView name, uint64_
                                                JSON_WRITE_PROP(writer, "size", attachment->size());
                                                JSON_WRITE_PROP(writer, "approved", attachment->approved());
                                                JSON_WRITE_PROP(writer, "nrOfMessagesAttached", attachment->messages().size());
-                                               JSON_WRITE_PROP(writer, "nrOfGetRequests", attachment->nrOfGetRequests());
+                                               JSON_WRITE_PROP(writer, "nrOfGetRequests", attachment->nrOfGetRequests().load());
                                            });
                        });
     return status;
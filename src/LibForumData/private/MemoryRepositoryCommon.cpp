@@ -22,10 +22,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "ContextProviders.h"
 #include "EntitySerialization.h"
 #include "OutputHelpers.h"
+#include "SeparateThreadConsumer.h"
 #include "TypeHelpers.h"
 
 #include <algorithm>
+#include <chrono>
 #include <tuple>
+#include <unordered_map>
 
 #include <unicode/uchar.h>
 #include <unicode/ustring.h>
@@ -40,10 +43,120 @@ using namespace Forum::Entities;
 using namespace Forum::Helpers;
 using namespace Forum::Repository;
 
+struct LastSeenUpdate final
+{
+    IdType userId;
+    Timestamp at{};
+};
+
+class Forum::Repository::LastSeenUpdater final : public SeparateThreadConsumer<LastSeenUpdater, LastSeenUpdate>
+{
+public:
+    LastSeenUpdater(ResourceGuard<EntityCollection>& collection, const std::chrono::milliseconds batchInterval)
+        : SeparateThreadConsumer<LastSeenUpdater, LastSeenUpdate>{ batchInterval, MaxQueuedUpdates, true },
+          collection_(collection)
+    {
+    }
+
+    ~LastSeenUpdater() override
+    {
+        //apply the remaining updates while the derived object is still alive
+        stopConsumer();
+    }
+
+    /**
+     * Does not wake up the consumer thread, which applies the queued updates once per batch interval
+     * Updates are dropped if the queue is full, as they are not essential
+     */
+    void add(const IdType& userId, const Timestamp at)
+    {
+        //until the batch is applied, every request of the user would queue another update,
+        //so remember what each thread queued to avoid locking the shared queue for duplicates
+        thread_local RecentlyQueued recentlyQueued;
+        if ((recentlyQueued.updater != this) || (recentlyQueued.values.size() >= MaxRecentlyQueuedPerThread))
+        {
+            recentlyQueued.updater = this;
+            recentlyQueued.values.clear();
+        }
+
+        auto it = recentlyQueued.values.find(userId);
+        if ((it != recentlyQueued.values.end())
+            && ((it->second + getGlobalConfig()->user.lastSeenUpdatePrecision) >= at))
+        {
+            return;
+        }
+        if (tryEnqueue(LastSeenUpdate{ userId, at }))
+        {
+            recentlyQueued.values[userId] = at;
+        }
+    }
+
+private:
+    friend class SeparateThreadConsumer<LastSeenUpdater, LastSeenUpdate>;
+
+    static constexpr uint32_t MaxQueuedUpdates = 16384;
+    static constexpr size_t MaxRecentlyQueuedPerThread = 4096;
+
+    struct RecentlyQueued
+    {
+        const LastSeenUpdater* updater = nullptr;
+        std::unordered_map<IdType, Timestamp> values;
+    };
+
+    void onFail(uint32_t /*failNr*/)
+    {}
+
+    void consumeValues(LastSeenUpdate* values, const size_t nrOfValues)
+    {
+        //the same user might have made several requests before the batch is applied
+        latestUpdates_.clear();
+        for (size_t i = 0; i < nrOfValues; ++i)
+        {
+            auto& latest = latestUpdates_[values[i].userId];
+            latest = std::max(latest, values[i].at);
+        }
+
+        collection_.writeKeepingGeneration([this](EntityCollection& collection)
+                          {
+                              auto& index = collection.users().byId();
+                              for (auto& [userId, at] : latestUpdates_)
+                              {
+                                  auto it = index.find(userId);
+                                  if ((it != index.end()) && ((*it)->lastSeen() < at))
+                                  {
+                                      UserPtr user = *it;
+                                      user->updateLastSeen(at);
+                                  }
+                              }
+                          });
+    }
+
+    void onThreadFinish()
+    {}
+
+    void onThreadWaitNoValues()
+    {}
+
+    ResourceGuard<EntityCollection>& collection_;
+    std::unordered_map<IdType, Timestamp> latestUpdates_;
+};
+
+MemoryStore::MemoryStore(EntityCollectionRef collection) : collection(std::move(collection))
+{
+    const auto batchMilliseconds = getGlobalConfig()->user.lastSeenUpdateBatchMilliseconds;
+    if (batchMilliseconds > 0)
+    {
+        lastSeenUpdater = std::make_unique<LastSeenUpdater>(this->collection,
+                                                            std::chrono::milliseconds(batchMilliseconds));
+    }
+}
+
+MemoryStore::~MemoryStore() = default;
+
 /**
  * Retrieves the user that is performing the current action and also performs an update on the last seen if needed
- * The update is performed on the spot if a write lock is held or
- * delayed until the lock is destroyed in the case of a read lock, to avoid deadlocks
+ * The update is performed on the spot if a write lock is held or, in the case of a read lock,
+ * queued for the next batch of updates or delayed until the lock is destroyed, to avoid deadlocks
  * Do not keep references to it outside of MemoryRepository methods
  */
 PerformedByWithLastSeenUpdateGuard::~PerformedByWithLastSeenUpdateGuard()
@@ -68,11 +181,17 @@ PerformedByType PerformedByWithLastSeenUpdateGuard::get(const EntityCollection&
 
     if ((result.lastSeen() + getGlobalConfig()->user.lastSeenUpdatePrecision) < now)
     {
+        if (store.lastSeenUpdater)
+        {
+            store.lastSeenUpdater->add(result.id(), now);
+            return result;
+        }
+
         auto& userId = result.id();
         const auto& mutableCollection = store.collection;
         lastSeenUpdate_ = [&mutableCollection, now, &userId]()
                           {
-                              mutableCollection.write([&](EntityCollection& collectionToModify)
+                              mutableCollection.writeKeepingGeneration([&](EntityCollection& collectionToModify)
                               {
                                   auto& indexToModify = collectionToModify.users().byId();
                                   auto itToModify = indexToModify.find(userId);
@@ -496,15 +496,16 @@ static void updateCategoryParent(DiscussionCategory& category, DiscussionCategor
 {
     auto oldParent = category.parent();
 
-    category.updateParent(newParentPtr);
-    updateLastUpdated(category, currentUser);
-
+    //totals need to be removed while the category is still attached to the old parent
     if (oldParent)
     {
         oldParent->removeTotalsFromChild(category);
         oldParent->children().erase(&category);
     }
 
+    category.updateParent(newParentPtr);
+    updateLastUpdated(category, currentUser);
+
     if (newParentPtr)
     {
         newParentPtr->addTotalsFromChild(category);
@@ -66,20 +66,20 @@ StatusCode MemoryRepositoryDiscussionTag::getDiscussionTags(OutStream& output, R
             switch (by)
             {
             case RetrieveDiscussionTagsBy::Name:
-                writeArraySafeName(output, "tags", collection.tags().byName().begin(), collection.tags().byName().end(),
-                                   restriction);
+                writeDiscussionTags(output, "tags", collection.tags().byName().begin(),
+                                    collection.tags().byName().end(), restriction);
                 status.disable();
                 break;
             case RetrieveDiscussionTagsBy::ThreadCount:
                 //collection is sorted in greater order
-                writeArraySafeName(output, "tags", collection.tags().byThreadCount().rbegin(),
-                                   collection.tags().byThreadCount().rend(), restriction);
+                writeDiscussionTags(output, "tags", collection.tags().byThreadCount().rbegin(),
+                                    collection.tags().byThreadCount().rend(), restriction);
                 status.disable();
                 break;
             case RetrieveDiscussionTagsBy::MessageCount:
                 //collection is sorted in greater order
-                writeArraySafeName(output, "tags", collection.tags().byMessageCount().rbegin(),
-                                   collection.tags().byMessageCount().rend(), restriction);
+                writeDiscussionTags(output, "tags", collection.tags().byMessageCount().rbegin(),
+                                    collection.tags().byMessageCount().rend(), restriction);
                 status.disable();
                 break;
             }
@@ -89,20 +89,20 @@ StatusCode MemoryRepositoryDiscussionTag::getDiscussionTags(OutStream& output, R
             switch (by)
             {
             case RetrieveDiscussionTagsBy::Name:
-                writeArraySafeName(output, "tags", collection.tags().byName().rbegin(), collection.tags().byName().rend(),
-                                   restriction);
+                writeDiscussionTags(output, "tags", collection.tags().byName().rbegin(),
+                                    collection.tags().byName().rend(), restriction);
                 status.disable();
                 break;
             case RetrieveDiscussionTagsBy::ThreadCount:
                 //collection is sorted in greater order
-                writeArraySafeName(output, "tags", collection.tags().byThreadCount().begin(),
+                writeDiscussionTags(output, "tags", collection.tags().byThreadCount().begin(),
                     collection.tags().byThreadCount().end(), restriction);
                 status.disable();
                 break;
             case RetrieveDiscussionTagsBy::MessageCount:
                 //collection is sorted in greater order
-                writeArraySafeName(output, "tags", collection.tags().byMessageCount().begin(),
-                                   collection.tags().byMessageCount().end(), restriction);
+                writeDiscussionTags(output, "tags", collection.tags().byMessageCount().begin(),
+                                    collection.tags().byMessageCount().end(), restriction);
                 status.disable();
                 break;
             }
@@ -30,6 +30,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <boost/thread/tss.hpp>
 
 #include <utility>
+#include <vector>
 
 using namespace Forum;
 using namespace Forum::Configuration;
@@ -54,8 +55,14 @@ MemoryRepositoryDiscussionThread::MemoryRepositoryDiscussionThread(MemoryStoreRe
     }
 }
 
+static bool visitedSinceLastChange(const DiscussionThread& thread, const User& currentUser)
+{
+    return ( ! isAnonymousUser(currentUser)) && thread.hasVisitedSinceLastEdit(currentUser);
+}
+
 template<typename ThreadsCollection>
-void writePinnedDiscussionThreads(const ThreadsCollection&, Json::JsonWriter&, SerializationRestriction&)
+void writePinnedDiscussionThreads(const ThreadsCollection&, Json::JsonWriter&, const SerializationPlan&,
+                                  const User&)
 {
     //do nothing
 }
@@ -63,17 +70,30 @@ void writePinnedDiscussionThreads(const ThreadsCollection&, Json::JsonWriter&, S
 template<>
 inline void writePinnedDiscussionThreads<DiscussionThreadCollectionWithHashedIdAndPinOrder>
         (const DiscussionThreadCollectionWithHashedIdAndPinOrder& collection, Json::JsonWriter& writer,
-         SerializationRestriction& restriction)
+         const SerializationPlan& plan, const User& currentUser)
 {
-    writer.newPropertyRaw(JSON_RAW_PROP_COMMA("pinned_threads"));
-    writer.startArray();
+    static thread_local std::vector<DiscussionThreadPrivilegeCheck> privilegeChecks(16);
+
+    privilegeChecks.clear();
+
+    const auto& restriction = plan.restriction;
 
     auto it = collection.byPinDisplayOrder().begin(); //collection is sorted in greater order
     auto end = collection.byPinDisplayOrder().end();
 
     for (; (it != end) && ((*it)->pinDisplayOrder() > 0); ++it)
     {
-        serialize(writer, **it, restriction);
+        privilegeChecks.emplace_back(restriction.user(), **it);
+    }
+    restriction.privilegeStore().computeDiscussionThreadPrivileges(privilegeChecks.data(), privilegeChecks.size(),
+                                                                   restriction.now());
+
+    writer.newPropertyRaw(JSON_RAW_PROP_COMMA("pinned_threads"));
+    writer.startArray();
+
+    for (auto& check : privilegeChecks)
+    {
+        serialize(writer, *check.thread, plan, check, visitedSinceLastChange(*check.thread, currentUser));
     }
 
     writer.endArray();
@@ -84,18 +104,11 @@ static void writeDiscussionThreads(const ThreadsCollection& collection, Retrieve
                                    OutStream& output, const GrantedPrivilegeStore& privilegeStore, 
                                    const ForumWidePrivilegeStore& forumWidePrivilegeStore, const User& currentUser)
 {
-    BoolTemporaryChanger _(serializationSettings.visitedThreadSinceLastChange, false);
-    BoolTemporaryChanger __(serializationSettings.hideDiscussionThreadMessages, true);
+    BoolTemporaryChanger _(serializationSettings.hideDiscussionThreadMessages, true);
 
-    auto writeFilter = [&](const DiscussionThread& currentThread)
+    auto visited = [&](const DiscussionThread& currentThread)
     {
-        bool visitedThreadSinceLastChange = false;
-        if ( ! isAnonymousUser(currentUser))
-        {
-            visitedThreadSinceLastChange = currentThread.hasVisitedSinceLastEdit(currentUser.id());
-        }
-        serializationSettings.visitedThreadSinceLastChange = visitedThreadSinceLastChange;
-        return true;
+        return visitedSinceLastChange(currentThread, currentUser);
     };
 
     auto pageSize = getGlobalConfig()->discussionThread.maxThreadsPerPage;
@@ -103,6 +116,7 @@ static void writeDiscussionThreads(const ThreadsCollection& collection, Retrieve
 
     SerializationRestriction restriction(privilegeStore, forumWidePrivilegeStore, 
                                          &currentUser, Context::getCurrentTime());
+    const SerializationPlan plan(restriction);
 
     auto ascending = displayContext.sortOrder == Context::SortOrder::Ascending;
 
@@ -113,31 +127,31 @@ static void writeDiscussionThreads(const ThreadsCollection& collection, Retrieve
     switch (by)
     {
     case RetrieveDiscussionThreadsBy::Name:
-        writeEntitiesWithPagination(collection.byName(), displayContext.pageNumber, pageSize, ascending, "threads",
-            writer, writeFilter, restriction);
+        writeDiscussionThreadsWithPagination(collection.byName(), displayContext.pageNumber, pageSize, ascending,
+                                             "threads", writer, visited, plan);
         break;
     case RetrieveDiscussionThreadsBy::Created:
-        writeEntitiesWithPagination(collection.byCreated(), displayContext.pageNumber, pageSize, ascending, "threads",
-            writer, writeFilter, restriction);
+        writeDiscussionThreadsWithPagination(collection.byCreated(), displayContext.pageNumber, pageSize, ascending,
+                                             "threads", writer, visited, plan);
         break;
     case RetrieveDiscussionThreadsBy::LastUpdated:
-        writeEntitiesWithPagination(collection.byLastUpdated(), displayContext.pageNumber, pageSize, ascending, "threads",
-            writer, writeFilter, restriction);
+        writeDiscussionThreadsWithPagination(collection.byLastUpdated(), displayContext.pageNumber, pageSize, ascending,
+                                             "threads", writer, visited, plan);
         break;
     case RetrieveDiscussionThreadsBy::LatestMessageCreated:
-        writeEntitiesWithPagination(collection.byLatestMessageCreated(), displayContext.pageNumber, pageSize, ascending, "threads",
-            writer, writeFilter, restriction);
+        writeDiscussionThreadsWithPagination(collection.byLatestMessageCreated(), displayContext.pageNumber, pageSize, ascending,
+                                             "threads", writer, visited, plan);
         break;
     case RetrieveDiscussionThreadsBy::MessageCount:
         //collection is sorted in greater order
-        writeEntitiesWithPagination(collection.byMessageCount(), displayContext.pageNumber, pageSize, ! ascending, "threads",
-            writer, writeFilter, restriction);
+        writeDiscussionThreadsWithPagination(collection.byMessageCount(), displayContext.pageNumber, pageSize, ! ascending,
+                                             "threads", writer, visited, plan);
         break;
     }
 
     if (0 == displayContext.pageNumber)
     {
-        writePinnedDiscussionThreads(collection, writer, restriction);
+        writePinnedDiscussionThreads(collection, writer, plan, currentUser);
     }
 
     writer.endObject();
@@ -167,9 +181,6 @@ StatusCode MemoryRepositoryDiscussionThread::getDiscussionThreadById(IdTypeRef i
 
     PerformedByWithLastSeenUpdateGuard performedBy;
 
-    bool addUserToVisitedSinceLastEdit = false;
-    IdType userId{};
-
     collection().read([&](const EntityCollection& collection)
                       {
                           auto& currentUser = performedBy.get(collection, *store_);
@@ -188,18 +199,14 @@ StatusCode MemoryRepositoryDiscussionThread::getDiscussionThreadById(IdTypeRef i
                               return;
                           }
 
-                          thread.visited().fetch_add(1);
+                          ++thread.visited();
 
                           const auto& displayContext = Context::getDisplayContext();
                           uint32_t latestPageNumberToPersist{};
 
                           if ( ! isAnonymousUser(currentUser))
                           {
-                              if ( ! thread.hasVisitedSinceLastEdit(currentUser.id()))
-                              {
-                                  addUserToVisitedSinceLastEdit = true;
-                                  userId = currentUser.id();
-                              }
+                              thread.addVisitorSinceLastEdit(currentUser);
 
                               if (displayContext.pageNumber > 0)
                               {
@@ -234,17 +241,28 @@ StatusCode MemoryRepositoryDiscussionThread::getDiscussionThreadById(IdTypeRef i
                           readEvents().onGetDiscussionThreadById(createObserverContext(currentUser), thread, 
                                                                  latestPageNumberToPersist);
                       });
-    if (addUserToVisitedSinceLastEdit)
+    return status;
+}
+
+StatusCode MemoryRepositoryDiscussionThread::getDiscussionThreadVersion(IdTypeRef id, uint64_t& version) const
+{
+    if ( ! id)
     {
-        collection().write([&](EntityCollection& collection)
-                           {
-                               auto threadPtr = collection.threads().findById(id);
-                               if (threadPtr)
-                               {
-                                   threadPtr->addVisitorSinceLastEdit(userId);
-                               }
-                           });
+        return StatusCode::INVALID_PARAMETERS;
     }
+
+    auto status = StatusCode::NOT_FOUND;
+
+    collection().read([&](const EntityCollection& collection)
+                      {
+                          auto threadPtr = collection.threads().findById(id);
+                          if ( ! threadPtr) return;
+
+                          //read under the lock, so that a change is either reflected in both values or in neither
+                          constexpr uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+                          version = (Context::getSharedWriteGeneration() * multiplier) ^ threadPtr->version();
+                          status = StatusCode::OK;
+                      });
     return status;
 }
 
@@ -965,7 +983,7 @@ StatusCode MemoryRepositoryDiscussionThread::subscribeToDiscussionThread(IdTypeR
 
     PerformedByWithLastSeenUpdateGuard performedBy;
 
-    collection().write([&](EntityCollection& collection)
+    collection().writeSingleDiscussionThread([&](EntityCollection& collection)
                        {
                            auto currentUser = performedBy.getAndUpdate(collection);
 
@@ -1014,6 +1032,7 @@ StatusCode MemoryRepositoryDiscussionThread::subscribeToDiscussionThread(EntityC
     }
 
     currentUser->subscribedThreads().add(threadPtr);
+    threadPtr->incrementVersion();
 
     return StatusCode::OK;
 }
@@ -1028,7 +1047,7 @@ StatusCode MemoryRepositoryDiscussionThread::unsubscribeFromDiscussionThread(IdT
 
     PerformedByWithLastSeenUpdateGuard performedBy;
 
-    collection().write([&](EntityCollection& collection)
+    collection().writeSingleDiscussionThread([&](EntityCollection& collection)
                        {
                            auto currentUser = performedBy.getAndUpdate(collection);
 
@@ -1077,5 +1096,6 @@ StatusCode MemoryRepositoryDiscussionThread::unsubscribeFromDiscussionThread(Ent
     }
 
     currentUser->subscribedThreads().remove(threadPtr);
+    threadPtr->incrementVersion();
     return StatusCode::OK;
 }
@@ -262,7 +262,7 @@ StatusCode MemoryRepositoryDiscussionThreadMessage::addNewDiscussionMessageInThr
     }
     PerformedByWithLastSeenUpdateGuard performedBy;
 
-    collection().write([&](EntityCollection& collection)
+    collection().writeSingleDiscussionThread([&](EntityCollection& collection)
                        {
                            auto currentUser = performedBy.getAndUpdate(collection);
 
@@ -398,6 +398,7 @@ StatusWithResource<DiscussionThreadMessagePtr>
     thread.insertMessage(message);
     thread.resetVisitorsSinceLastEdit();
     thread.latestVisibleChange() = message->created();
+    thread.incrementVersion();
 
     if ( ! isAnonymousUser(currentUser))
     {
@@ -499,7 +500,7 @@ StatusCode MemoryRepositoryDiscussionThreadMessage::changeDiscussionThreadMessag
     }
     PerformedByWithLastSeenUpdateGuard performedBy;
 
-    collection().write([&](EntityCollection& collection)
+    collection().writeSingleDiscussionThread([&](EntityCollection& collection)
                        {
                            auto currentUser = performedBy.getAndUpdate(collection);
 
@@ -582,6 +583,7 @@ StatusCode MemoryRepositoryDiscussionThreadMessage::changeDiscussionThreadMessag
 
     parentThread.resetVisitorsSinceLastEdit();
     parentThread.latestVisibleChange() = message.lastUpdated();
+    parentThread.incrementVersion();
 
     return StatusCode::OK;
 }
@@ -801,7 +803,7 @@ StatusCode MemoryRepositoryDiscussionThreadMessage::voteDiscussionThreadMessage(
     }
     PerformedByWithLastSeenUpdateGuard performedBy;
 
-    collection().write([&](EntityCollection& collection)
+    collection().writeSingleDiscussionThread([&](EntityCollection& collection)
                        {
                            auto currentUser = performedBy.getAndUpdate(collection);
 
@@ -906,6 +908,8 @@ StatusCode MemoryRepositoryDiscussionThreadMessage::voteDiscussionThreadMessage(
     });
     targetUser.voteHistoryNotRead() += 1;
 
+    message.parentThread()->incrementVersion();
+
     return StatusCode::OK;
 }
 
@@ -922,7 +926,7 @@ StatusCode MemoryRepositoryDiscussionThreadMessage::resetVoteDiscussionThreadMes
     }
     PerformedByWithLastSeenUpdateGuard performedBy;
 
-    collection().write([&](EntityCollection& collection)
+    collection().writeSingleDiscussionThread([&](EntityCollection& collection)
                        {
                            auto currentUser = performedBy.getAndUpdate(collection);
 
@@ -1014,6 +1018,8 @@ StatusCode MemoryRepositoryDiscussionThreadMessage::resetVoteDiscussionThreadMes
     });
     targetUser.voteHistoryNotRead() += 1;
 
+    message.parentThread()->incrementVersion();
+
     return StatusCode::OK;
 }
 
@@ -1174,7 +1180,7 @@ StatusCode MemoryRepositoryDiscussionThreadMessage::addCommentToDiscussionThread
     }
     PerformedByWithLastSeenUpdateGuard performedBy;
 
-    collection().write([&](EntityCollection& collection)
+    collection().writeSingleDiscussionThread([&](EntityCollection& collection)
                        {
                            auto currentUser = performedBy.getAndUpdate(collection);
 
@@ -1234,6 +1240,7 @@ StatusWithResource<MessageCommentPtr>
     collection.insertMessageComment(comment);
 
     message.addComment(comment);
+    message.parentThread()->incrementVersion();
     currentUser->messageComments().add(comment);
 
     return comment;
@@ -1252,7 +1259,7 @@ StatusCode MemoryRepositoryDiscussionThreadMessage::setMessageCommentToSolved(Id
     }
     PerformedByWithLastSeenUpdateGuard performedBy;
 
-    collection().write([&](EntityCollection& collection)
+    collection().writeSingleDiscussionThread([&](EntityCollection& collection)
                        {
                            auto currentUser = performedBy.getAndUpdate(collection);
 
@@ -1299,6 +1306,7 @@ StatusCode MemoryRepositoryDiscussionThreadMessage::setMessageCommentToSolved(En
 
     comment.solved() = true;
     comment.parentMessage().incrementSolvedCommentsCount();
+    comment.parentMessage().parentThread()->incrementVersion();
 
     return StatusCode::OK;
 }
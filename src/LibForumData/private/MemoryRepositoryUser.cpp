@@ -167,6 +167,7 @@ StatusCode MemoryRepositoryUser::getUsers(OutStream& output, RetrieveUsersBy by)
 
         SerializationRestriction restriction(collection.grantedPrivileges(), collection, 
                                              &currentUser, Context::getCurrentTime());
+        const SerializationPlan plan(restriction);
 
         auto ascending = displayContext.sortOrder == Context::SortOrder::Ascending;
 
@@ -174,25 +175,25 @@ StatusCode MemoryRepositoryUser::getUsers(OutStream& output, RetrieveUsersBy by)
         {
         case RetrieveUsersBy::Name:
             writeEntitiesWithPagination(collection.users().byName(), "users", output, displayContext.pageNumber,
-                pageSize, ascending, restriction);
+                pageSize, ascending, plan);
             break;
         case RetrieveUsersBy::Created:
             writeEntitiesWithPagination(collection.users().byCreated(), "users", output, displayContext.pageNumber,
-                pageSize, ascending, restriction);
+                pageSize, ascending, plan);
             break;
         case RetrieveUsersBy::LastSeen:
             writeEntitiesWithPagination(collection.users().byLastSeen(), "users", output, displayContext.pageNumber,
-                pageSize, ascending, restriction);
+                pageSize, ascending, plan);
             break;
         case RetrieveUsersBy::ThreadCount:
             //collection is sorted in greater order
             writeEntitiesWithPagination(collection.users().byThreadCount(), "users", output, displayContext.pageNumber,
-                pageSize, ! ascending, restriction);
+                pageSize, ! ascending, plan);
             break;
         case RetrieveUsersBy::MessageCount:
             //collection is sorted in greater order
             writeEntitiesWithPagination(collection.users().byMessageCount(), "users", output, displayContext.pageNumber,
-                pageSize, ! ascending, restriction);
+                pageSize, ! ascending, plan);
             break;
         }
 
@@ -387,7 +388,9 @@ StatusCode MemoryRepositoryUser::getMultipleUsersById(StringView ids, OutStream&
                           SerializationRestriction restriction(collection.grantedPrivileges(), collection,
                                                                &currentUser, Context::getCurrentTime());
 
-                          writeAllEntities(usersFound.begin(), lastUserFound, "users", output, restriction);
+                          const SerializationPlan plan(restriction);
+
+                          writeAllEntities(usersFound.begin(), lastUserFound, "users", output, plan);
                           
                           readEvents().onGetMultipleUsersById(createObserverContext(currentUser), ids);
                       });
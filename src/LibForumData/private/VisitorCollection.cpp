@@ -19,46 +19,101 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "VisitorCollection.h"
 #include "ContextProviders.h"
 
+#include <mutex>
+
 using namespace Forum::Entities;
 using namespace Forum::Repository;
 
+static constexpr Timestamp CleanupEverySeconds = 30;
+
+uint64_t VisitorCollection::currentNumberOfVisitors() const
+{
+    uint64_t result = 0;
+    for (auto& shard : shards_)
+    {
+        result += shard.currentNumberOfVisitors.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
 void VisitorCollection::add(VisitorId visitor)
 {
-    cleanup();
-    auto expiresAt = Context::getCurrentTime() + visitForSeconds_;
+    const auto now = Context::getCurrentTime();
+    const auto expiresAt = now + visitForSeconds_;
+
+    //visitor ids are hashes, so the upper bits are as good as any for picking a shard
+    auto& shard = shards_[(visitor >> 32) % shards_.size()];
 
+    std::lock_guard<decltype(shard.lock)> lock(shard.lock);
+
+    if (shard.cleaningUp || ((now - shard.lastCleanup.load(std::memory_order_relaxed)) >= CleanupEverySeconds))
     {
-        std::lock_guard<decltype(mutex_)> lock(mutex_);
+        continueCleanup(shard, now);
+    }
 
-        auto [it, result] = collection_.insert(std::make_pair(visitor, expiresAt));
-        if (result)
-        {
-            currentNumberOfVisitors_ += 1;
-        }
-        else
-        {
-            it->second = expiresAt;
-        }
+    auto it = shard.collection.find(visitor);
+    if (it != shard.collection.end())
+    {
+        it->second = expiresAt;
+        return;
+    }
+    if (shard.collection.size() >= MaxVisitorsPerShard)
+    {
+        return;
     }
+    shard.collection.emplace(visitor, expiresAt);
+    shard.currentNumberOfVisitors.fetch_add(1, std::memory_order_relaxed);
 }
 
 void VisitorCollection::cleanup()
 {
-    constexpr Timestamp cleanupEverySeconds = 30;
-
     const auto now = Context::getCurrentTime();
-    if ((now - lastCleanup_) < cleanupEverySeconds) return;
 
+    for (auto& shard : shards_)
     {
-        std::lock_guard<decltype(mutex_)> lock(mutex_);
+        if ((now - shard.lastCleanup.load(std::memory_order_relaxed)) < CleanupEverySeconds) continue;
 
-        for (auto it = collection_.begin(); it != collection_.end();)
+        //release the lock between steps so that visitors can still be added in the meantime
+        for (bool completed = false; ! completed;)
+        {
+            std::lock_guard<decltype(shard.lock)> lock(shard.lock);
+
+            if (( ! shard.cleaningUp)
+                && ((now - shard.lastCleanup.load(std::memory_order_relaxed)) < CleanupEverySeconds))
+            {
+                //completed by adding a visitor
+                break;
+            }
+            completed = continueCleanup(shard, now);
+        }
+    }
+}
+
+bool VisitorCollection::continueCleanup(Shard& shard, const Timestamp now)
+{
+    if ( ! shard.cleaningUp)
+    {
+        shard.cleaningUp = true;
+        shard.cleanupBucket = 0;
+    }
+    auto& collection = shard.collection;
+    uint64_t removed = 0;
+
+    //erasing does not rehash, so the bucket indexes stay valid during a step
+    const auto bucketCount = collection.bucket_count();
+    for (size_t i = 0; (i < BucketsCleanedUpPerStep) && (shard.cleanupBucket < bucketCount);
+         ++i, ++shard.cleanupBucket)
+    {
+        const auto bucket = shard.cleanupBucket;
+        for (auto it = collection.begin(bucket); it != collection.end(bucket);)
         {
             const auto expiresAt = it->second;
             if (expiresAt < now)
             {
-                it = collection_.erase(it);
-                currentNumberOfVisitors_ -= 1;
+                const auto visitor = it->first;
+                ++it;
+                collection.erase(visitor);
+                removed += 1;
             }
             else
             {
@@ -66,6 +121,13 @@ void VisitorCollection::cleanup()
             }
         }
     }
+    shard.currentNumberOfVisitors.fetch_sub(removed, std::memory_order_relaxed);
 
-    lastCleanup_ = now;
+    if (shard.cleanupBucket < bucketCount)
+    {
+        return false;
+    }
+    shard.cleaningUp = false;
+    shard.lastCleanup.store(now, std::memory_order_relaxed);
+    return true;
 }
@@ -0,0 +1,82 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Forum::Helpers
+{
+    /**
+     * Set of 32-bit integers stored in the style of roaring bitmaps
+     * Values are grouped by their upper 16 bits into containers which store the lower 16 bits either as a sorted
+     * array (while sparse) or as a fixed 8 KiB bitset (once dense), so memory stays proportional to the content
+     * Not thread-safe, callers need to provide their own synchronization
+     */
+    class CompressedBitmap final
+    {
+    public:
+        CompressedBitmap() = default;
+        CompressedBitmap(const CompressedBitmap&) = delete;
+        CompressedBitmap(CompressedBitmap&&) = default;
+        ~CompressedBitmap() = default;
+
+        CompressedBitmap& operator=(const CompressedBitmap&) = delete;
+        CompressedBitmap& operator=(CompressedBitmap&&) = default;
+
+        bool contains(uint32_t value) const;
+
+        /**
+         * @return true if the value was not already present
+         */
+        bool insert(uint32_t value);
+
+        void clear();
+
+        size_t size() const;
+        bool empty() const { return containers_.empty(); }
+
+    private:
+        /**
+         * Array containers are converted into bitsets once they would use more memory than one
+         */
+        static constexpr size_t MaxArrayContainerSize = 4096;
+        static constexpr size_t BitsetWords = 65536 / 64;
+
+        typedef std::array<uint64_t, BitsetWords> BitsetType;
+
+        struct Container
+        {
+            uint16_t highBits;
+            uint32_t cardinality;
+            std::vector<uint16_t> array;
+            std::unique_ptr<BitsetType> bitset;
+
+            bool contains(uint16_t lowBits) const;
+            bool insert(uint16_t lowBits);
+        };
+
+        std::vector<Container>::iterator findContainer(uint16_t highBits);
+        std::vector<Container>::const_iterator findContainer(uint16_t highBits) const;
+
+        std::vector<Container> containers_;
+    };
+}
@@ -77,29 +77,24 @@ namespace Forum::Helpers
         writeSingleValueSafeName(output, "status", code);
     }
 
-    template<typename Collection, size_t PropertyNameSize, typename FilterType>
-    void writeEntitiesWithPagination(const Collection& collection, int_fast32_t pageNumber, int_fast32_t pageSize,
-                                     bool ascending, const char(&propertyName)[PropertyNameSize], Json::JsonWriter& writer,
-                                     FilterType&& filter, const Authorization::SerializationRestriction& restriction)
+    /**
+     * Calls the callback for each entity on a page of the collection, in the order in which they are displayed
+     */
+    template<typename Collection, typename Fn>
+    void forEachEntityInPage(const Collection& collection, int_fast32_t pageNumber, int_fast32_t pageSize,
+                             bool ascending, Fn&& callback)
     {
         auto totalCount = static_cast<int_fast32_t>(collection.size());
 
-        JSON_WRITE_FIRST_PROP(writer, "totalCount", totalCount);
-        JSON_WRITE_PROP(writer, "pageSize", pageSize);
-        JSON_WRITE_PROP(writer, "page", pageNumber);
-
-        writer.newPropertyWithSafeName(propertyName, PropertyNameSize - 1);
-        writer.startArray();
-
         auto firstElementIndex = std::max(static_cast<decltype(totalCount)>(0),
                                           static_cast<decltype(totalCount)>(pageNumber * pageSize));
         if (ascending)
         {
             for (auto it = collection.nth(firstElementIndex), n = collection.nth(firstElementIndex + pageSize); it != n; ++it)
             {
-                if (*it && filter(**it))
+                if (*it)
                 {
-                    serialize(writer, **it, restriction);
+                    callback(**it);
                 }
             }
         }
@@ -115,21 +110,59 @@ namespace Forum::Helpers
                 for (auto it = itStart; it != itEnd;)
                 {
                     --it;
-                    if (*it && filter(**it))
+                    if (*it)
                     {
-                        serialize(writer, **it, restriction);
+                        callback(**it);
                     }
                 }
             }
         }
+    }
+
+    /**
+     * Writes the pagination details and an array with the entities on a page, each one written by the callback
+     */
+    template<typename Collection, size_t PropertyNameSize, typename WriteFn>
+    void writePageOfEntities(const Collection& collection, int_fast32_t pageNumber, int_fast32_t pageSize,
+                             bool ascending, const char(&propertyName)[PropertyNameSize], Json::JsonWriter& writer,
+                             WriteFn&& writeEntity)
+    {
+        auto totalCount = static_cast<int_fast32_t>(collection.size());
+
+        JSON_WRITE_FIRST_PROP(writer, "totalCount", totalCount);
+        JSON_WRITE_PROP(writer, "pageSize", pageSize);
+        JSON_WRITE_PROP(writer, "page", pageNumber);
+
+        writer.newPropertyWithSafeName(propertyName, PropertyNameSize - 1);
+        writer.startArray();
+
+        forEachEntityInPage(collection, pageNumber, pageSize, ascending, writeEntity);
+
         writer.endArray();
     }
 
-    template<typename Collection, size_t PropertyNameSize, typename FilterFn>
+    /**
+     * The restriction can also be a plan for serializing the entities, if the entities support it
+     */
+    template<typename Collection, size_t PropertyNameSize, typename FilterType, typename RestrictionType>
+    void writeEntitiesWithPagination(const Collection& collection, int_fast32_t pageNumber, int_fast32_t pageSize,
+                                     bool ascending, const char(&propertyName)[PropertyNameSize], Json::JsonWriter& writer,
+                                     FilterType&& filter, const RestrictionType& restriction)
+    {
+        writePageOfEntities(collection, pageNumber, pageSize, ascending, propertyName, writer, [&](auto& entity)
+        {
+            if (filter(entity))
+            {
+                serialize(writer, entity, restriction);
+            }
+        });
+    }
+
+    template<typename Collection, size_t PropertyNameSize, typename FilterFn, typename RestrictionType>
     void writeEntitiesWithPagination(const Collection& collection, const char(&propertyName)[PropertyNameSize],
                                      Repository::OutStream& output, int_fast32_t pageNumber,
                                      int_fast32_t pageSize, bool ascending, FilterFn&& filter,
-                                     const Authorization::SerializationRestriction& restriction)
+                                     const RestrictionType& restriction)
     {
         Json::JsonWriter writer(output);
 
@@ -139,11 +172,10 @@ namespace Forum::Helpers
         writer.endObject();
     }
 
-    template<typename Collection, size_t PropertyNameSize>
+    template<typename Collection, size_t PropertyNameSize, typename RestrictionType>
     void writeEntitiesWithPagination(const Collection& collection, const char(&propertyName)[PropertyNameSize],
                                      Repository::OutStream& output, int_fast32_t pageNumber,
-                                     int_fast32_t pageSize, bool ascending,
-                                     const Authorization::SerializationRestriction& restriction)
+                                     int_fast32_t pageSize, bool ascending, const RestrictionType& restriction)
     {
         writeEntitiesWithPagination(collection, propertyName, output, pageNumber, pageSize, ascending,
                                     [](auto&) { return true; }, restriction);
@@ -194,9 +226,9 @@ namespace Forum::Helpers
         writeAllEntities(collection, propertyName, output, ascending, [](auto&) { return true; }, restriction);
     }
 
-    template<typename It, size_t PropertyNameSize>
+    template<typename It, size_t PropertyNameSize, typename RestrictionType>
     void writeAllEntities(It begin, It end, const char(&propertyName)[PropertyNameSize],
-                          Repository::OutStream& output, const Authorization::SerializationRestriction& restriction)
+                          Repository::OutStream& output, const RestrictionType& restriction)
     {
         Json::JsonWriter writer(output);
 
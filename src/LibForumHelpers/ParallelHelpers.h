@@ -0,0 +1,134 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+namespace Forum::Helpers
+{
+    /**
+     * Ranges smaller than this are sorted on the calling thread
+     */
+    static constexpr size_t MinimumSizeForParallelSort = 65536;
+
+    size_t availableParallelism();
+
+    /**
+     * Sorts the range by splitting it into chunks that are sorted on separate threads and then merged
+     */
+    template<typename It, typename Compare>
+    void parallelSort(const It begin, const It end, Compare compare)
+    {
+        const auto size = static_cast<size_t>(std::distance(begin, end));
+        const auto nrOfChunks = std::min(availableParallelism(), size / (MinimumSizeForParallelSort / 2));
+
+        if ((size < MinimumSizeForParallelSort) || (nrOfChunks < 2))
+        {
+            std::sort(begin, end, compare);
+            return;
+        }
+
+        std::vector<It> boundaries;
+        boundaries.reserve(nrOfChunks + 1);
+        for (size_t i = 0; i < nrOfChunks; ++i)
+        {
+            boundaries.push_back(begin + (size * i / nrOfChunks));
+        }
+        boundaries.push_back(end);
+
+        std::vector<std::future<void>> futures;
+        futures.reserve(nrOfChunks);
+
+        for (size_t i = 0; i < nrOfChunks; ++i)
+        {
+            futures.push_back(std::async(std::launch::async, [first = boundaries[i], last = boundaries[i + 1],
+                                                              &compare]()
+            {
+                std::sort(first, last, compare);
+            }));
+        }
+        for (auto& future : futures)
+        {
+            future.get();
+        }
+
+        //merge neighbouring chunks two by two until a single sorted range remains
+        while (boundaries.size() > 2)
+        {
+            std::vector<It> newBoundaries;
+            futures.clear();
+
+            size_t i = 0;
+            for (; (i + 2) < boundaries.size(); i += 2)
+            {
+                newBoundaries.push_back(boundaries[i]);
+                futures.push_back(std::async(std::launch::async, [first = boundaries[i], middle = boundaries[i + 1],
+                                                                  last = boundaries[i + 2], &compare]()
+                {
+                    std::inplace_merge(first, middle, last, compare);
+                }));
+            }
+            for (; i < (boundaries.size() - 1); ++i)
+            {
+                newBoundaries.push_back(boundaries[i]);
+            }
+            newBoundaries.push_back(end);
+
+            for (auto& future : futures)
+            {
+                future.get();
+            }
+            boundaries = std::move(newBoundaries);
+        }
+    }
+
+    /**
+     * Executes independent named tasks on a pool of worker threads, measuring how long each task takes
+     */
+    class ParallelTaskRunner final : boost::noncopyable
+    {
+    public:
+        typedef std::function<void()> TaskType;
+
+        struct TaskResult
+        {
+            std::string name;
+            std::chrono::milliseconds duration;
+        };
+
+        void add(std::string name, TaskType&& task);
+
+        /**
+         * Runs all tasks added so far, using at most maxThreads workers (0 = one per available core)
+         * Running with a single thread executes the tasks on the calling thread
+         */
+        std::vector<TaskResult> run(size_t maxThreads = 0);
+
+    private:
+        std::vector<std::pair<std::string, TaskType>> tasks_;
+    };
+}
@@ -19,6 +19,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <condition_variable>
 #include <memory>
@@ -35,9 +36,15 @@ namespace Forum::Helpers
     class SeparateThreadConsumer : boost::noncopyable
     {
     public:
-        explicit SeparateThreadConsumer(const std::chrono::milliseconds loopWaitMilliseconds, uint32_t capacity = 131072)
+        /**
+         * @param consumeOncePerInterval If true, queued values are consumed at most once every loopWaitMilliseconds
+         *                               instead of as soon as they are enqueued, so that they are processed in batches
+         */
+        explicit SeparateThreadConsumer(const std::chrono::milliseconds loopWaitMilliseconds,
+                                        uint32_t capacity = 131072, const bool consumeOncePerInterval = false)
             : capacity_{ capacity }, buffer1_ { std::make_unique<T[]>(capacity) }, buffer2_{ std::make_unique<T[]>(capacity) },
-              loopWaitMilliseconds_(loopWaitMilliseconds), writeThread_{ [this]() { this->threadLoop(); } }
+              loopWaitMilliseconds_(loopWaitMilliseconds), consumeOncePerInterval_(consumeOncePerInterval),
+              writeThread_{ [this]() { this->threadLoop(); } }
         {
             writeBuffer_ = buffer1_.get();
             readBuffer_ = buffer2_.get();
@@ -91,10 +98,28 @@ namespace Forum::Helpers
     private:
         void threadLoop()
         {
+            auto nextConsumeAt = std::chrono::steady_clock::now() + loopWaitMilliseconds_;
             while ( ! stopWriteThread_)
             {
                 std::unique_lock<decltype(conditionMutex_)> lock(conditionMutex_);
-                if (blobInQueueCondition_.wait_for(lock, loopWaitMilliseconds_, [this]()
+                if (consumeOncePerInterval_)
+                {
+                    //sleep for the full interval even if values are already queued
+                    blobInQueueCondition_.wait_until(lock, nextConsumeAt, [this]()
+                    {
+                        return stopWriteThread_.load();
+                    });
+                    nextConsumeAt = std::chrono::steady_clock::now() + loopWaitMilliseconds_;
+                    if (queueEmpty())
+                    {
+                        static_cast<Derived*>(this)->onThreadWaitNoValues();
+                    }
+                    else
+                    {
+                        consumeValues();
+                    }
+                }
+                else if (blobInQueueCondition_.wait_for(lock, loopWaitMilliseconds_, [this]()
                 {
                     return ! queueEmpty() || stopWriteThread_;
                 }))
@@ -138,6 +163,7 @@ namespace Forum::Helpers
         std::condition_variable blobInQueueCondition_;
         std::mutex conditionMutex_;
         std::chrono::milliseconds loopWaitMilliseconds_;
+        const bool consumeOncePerInterval_;
         //other variables need to be initialized once the thread starts
         std::thread writeThread_;        
     };
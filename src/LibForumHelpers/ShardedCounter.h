@@ -0,0 +1,130 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+#include <boost/noncopyable.hpp>
+
+namespace Forum::Helpers
+{
+    /**
+     * Number of shards used by data structures that spread concurrent updates across separate cache lines
+     */
+    static constexpr size_t NrOfShards = 16;
+    static constexpr size_t CacheLineSize = 64;
+
+    /**
+     * Returns a value in [0, NrOfShards) that is fixed for the calling thread
+     * Threads are assigned shards in a round robin fashion
+     */
+    size_t currentThreadShardIndex();
+
+    /**
+     * Thread-safe counter that starts as a single atomic value and switches to one padded value per shard
+     * once concurrent updates are detected, so that frequently updated counters do not bounce a single cache line
+     * between cores. The shards are only summed up when the value is read.
+     */
+    template<typename T>
+    class ShardedCounter final : boost::noncopyable
+    {
+    public:
+        ShardedCounter() = default;
+        explicit ShardedCounter(const T initialValue) : base_(initialValue) {}
+
+        ~ShardedCounter()
+        {
+            delete shards_.load(std::memory_order_acquire);
+        }
+
+        void add(const T value)
+        {
+            if (auto shards = shards_.load(std::memory_order_acquire))
+            {
+                (*shards)[currentThreadShardIndex()].value.fetch_add(value, std::memory_order_relaxed);
+                return;
+            }
+
+            auto expected = base_.load(std::memory_order_relaxed);
+            if ( ! base_.compare_exchange_strong(expected, expected + value, std::memory_order_relaxed))
+            {
+                //another thread updated the counter at the same time
+                allocateShards();
+                add(value);
+            }
+        }
+
+        T load() const
+        {
+            auto result = base_.load(std::memory_order_relaxed);
+            if (auto shards = shards_.load(std::memory_order_acquire))
+            {
+                for (auto& shard : *shards)
+                {
+                    result += shard.value.load(std::memory_order_relaxed);
+                }
+            }
+            return result;
+        }
+
+        operator T() const
+        {
+            return load();
+        }
+
+        ShardedCounter& operator+=(const T value)
+        {
+            add(value);
+            return *this;
+        }
+
+        ShardedCounter& operator++()
+        {
+            add(1);
+            return *this;
+        }
+
+        bool isSharded() const
+        {
+            return nullptr != shards_.load(std::memory_order_acquire);
+        }
+
+    private:
+        struct alignas(CacheLineSize) Shard
+        {
+            std::atomic<T> value{ 0 };
+        };
+        typedef std::array<Shard, NrOfShards> ShardArray;
+
+        void allocateShards()
+        {
+            auto newShards = new ShardArray;
+            ShardArray* expected = nullptr;
+            if ( ! shards_.compare_exchange_strong(expected, newShards, std::memory_order_acq_rel))
+            {
+                delete newShards;
+            }
+        }
+
+        std::atomic<T> base_{ 0 };
+        std::atomic<ShardArray*> shards_{ nullptr };
+    };
+}
@@ -98,9 +98,37 @@ namespace Forum::Helpers
         return StringView{};
     }
 
+    /**
+     * Returns the number of bytes at the start of the view that are ASCII characters
+     * Checks 8 bytes at a time, as ASCII bytes never have the most significant bit set
+     */
+    inline size_t countASCIIPrefix(StringView view)
+    {
+        constexpr uint64_t highBits = 0x8080808080808080ull;
+
+        const auto* data = view.data();
+        const auto size = view.size();
+        size_t index = 0;
+
+        for (; index + sizeof(uint64_t) <= size; index += sizeof(uint64_t))
+        {
+            uint64_t word;
+            std::memcpy(&word, data + index, sizeof(word));
+            if (word & highBits)
+            {
+                break;
+            }
+        }
+        while ((index < size) && (static_cast<uint8_t>(data[index]) < 128))
+        {
+            ++index;
+        }
+        return index;
+    }
+
     inline bool onlyASCII(StringView view)
     {
-        return std::all_of(view.begin(), view.end(), [](auto c) { return static_cast<uint8_t>(c) < 128; });
+        return countASCIIPrefix(view) == view.size();
     }
 
     /**
@@ -298,6 +326,36 @@ namespace Forum::Helpers
     char* getCurrentSortKey();
     size_t getCurrentSortKeyLength();
 
+    namespace Detail
+    {
+        /**
+         * Packs the first 8 bytes of a sort key into an integer that compares the same way as the bytes
+         */
+        inline uint64_t getSortKeyPrefix(StringView sortKey)
+        {
+            uint64_t result = 0;
+            for (size_t i = 0; i < sizeof(result); ++i)
+            {
+                result <<= 8;
+                if (i < sortKey.size())
+                {
+                    result |= static_cast<uint8_t>(sortKey[i]);
+                }
+            }
+            return result;
+        }
+
+        inline int compareSortKeys(StringView first, StringView second)
+        {
+            const auto result = std::memcmp(first.data(), second.data(), std::min(first.size(), second.size()));
+            if (result)
+            {
+                return result;
+            }
+            return (first.size() < second.size()) ? -1 : (first.size() > second.size() ? 1 : 0);
+        }
+    }
+
     template<size_t StackSize = sizeof(char*)>
     class JsonReadyStringWithSortKey final
         : public Json::JsonReadyStringBase<StackSize, JsonReadyStringWithSortKey<StackSize>, Detail::SizeWithBoolAndSortKeySize>
@@ -322,6 +380,12 @@ namespace Forum::Helpers
         size_t getExtraSize() const noexcept;
 
         static size_t extraBytesNeeded(StringView source);
+
+    private:
+        int compare(const JsonReadyStringWithSortKey& other) const;
+
+        //most comparisons are decided by the start of the sort key, which is kept inline to avoid chasing pointers
+        uint64_t sortKeyPrefix_;
     };
 
     template <size_t StackSize>
@@ -334,38 +398,48 @@ namespace Forum::Helpers
 
         std::copy(sortKeyStart, sortKeyStart + sizeInfo.sortKeySize,
                   *(this->container_) + sizeInfo.size - sizeInfo.sortKeySize);
+
+        sortKeyPrefix_ = Detail::getSortKeyPrefix(sortKey());
+    }
+
+    template <size_t StackSize>
+    int JsonReadyStringWithSortKey<StackSize>::compare(const JsonReadyStringWithSortKey& other) const
+    {
+        if (sortKeyPrefix_ != other.sortKeyPrefix_)
+        {
+            return (sortKeyPrefix_ < other.sortKeyPrefix_) ? -1 : 1;
+        }
+        return Detail::compareSortKeys(sortKey(), other.sortKey());
     }
 
     template <size_t StackSize>
     bool JsonReadyStringWithSortKey<StackSize>::operator==(const JsonReadyStringWithSortKey& other) const
     {
-        return std::equal(sortKey().begin(), sortKey().end(), other.sortKey().begin(), other.sortKey().end());
+        return (sortKeyPrefix_ == other.sortKeyPrefix_) && (sortKey() == other.sortKey());
     }
 
     template <size_t StackSize>
     bool JsonReadyStringWithSortKey<StackSize>::operator<(const JsonReadyStringWithSortKey& other) const
     {
-        return std::lexicographical_compare(sortKey().begin(), sortKey().end(), 
-                                            other.sortKey().begin(), other.sortKey().end());
+        return compare(other) < 0;
     }
 
     template <size_t StackSize>
     bool JsonReadyStringWithSortKey<StackSize>::operator<=(const JsonReadyStringWithSortKey& other) const
     {
-        return ! (*this > other);
+        return compare(other) <= 0;
     }
 
     template <size_t StackSize>
     bool JsonReadyStringWithSortKey<StackSize>::operator>(const JsonReadyStringWithSortKey& other) const
     {
-        return std::lexicographical_compare(other.sortKey().begin(), other.sortKey().end(),
-                                            sortKey().begin(), sortKey().end());
+        return compare(other) > 0;
     }
 
     template <size_t StackSize>
     bool JsonReadyStringWithSortKey<StackSize>::operator>=(const JsonReadyStringWithSortKey& other) const
     {
-        return ! (*this < other);
+        return compare(other) >= 0;
     }
 
     template <size_t StackSize>
@@ -0,0 +1,119 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CompressedBitmap.h"
+
+#include <algorithm>
+
+using namespace Forum::Helpers;
+
+static auto compareContainerHighBits = [](const auto& container, const uint16_t highBits)
+{
+    return container.highBits < highBits;
+};
+
+bool CompressedBitmap::Container::contains(const uint16_t lowBits) const
+{
+    if (bitset)
+    {
+        return ((*bitset)[lowBits / 64] >> (lowBits % 64)) & 1;
+    }
+    return std::binary_search(array.begin(), array.end(), lowBits);
+}
+
+bool CompressedBitmap::Container::insert(const uint16_t lowBits)
+{
+    if (bitset)
+    {
+        auto& word = (*bitset)[lowBits / 64];
+        const uint64_t mask = uint64_t(1) << (lowBits % 64);
+        if (word & mask) return false;
+
+        word |= mask;
+        ++cardinality;
+        return true;
+    }
+
+    const auto it = std::lower_bound(array.begin(), array.end(), lowBits);
+    if ((it != array.end()) && (*it == lowBits)) return false;
+
+    if (array.size() < MaxArrayContainerSize)
+    {
+        array.insert(it, lowBits);
+        ++cardinality;
+        return true;
+    }
+
+    //convert to a bitset container
+    bitset = std::make_unique<BitsetType>();
+    bitset->fill(0);
+    for (const auto value : array)
+    {
+        (*bitset)[value / 64] |= uint64_t(1) << (value % 64);
+    }
+    std::vector<uint16_t>().swap(array);
+
+    return insert(lowBits);
+}
+
+std::vector<CompressedBitmap::Container>::iterator CompressedBitmap::findContainer(const uint16_t highBits)
+{
+    return std::lower_bound(containers_.begin(), containers_.end(), highBits, compareContainerHighBits);
+}
+
+std::vector<CompressedBitmap::Container>::const_iterator CompressedBitmap::findContainer(const uint16_t highBits) const
+{
+    return std::lower_bound(containers_.begin(), containers_.end(), highBits, compareContainerHighBits);
+}
+
+bool CompressedBitmap::contains(const uint32_t value) const
+{
+    const auto highBits = static_cast<uint16_t>(value >> 16);
+
+    const auto it = findContainer(highBits);
+    if ((it == containers_.end()) || (it->highBits != highBits)) return false;
+
+    return it->contains(static_cast<uint16_t>(value & 0xFFFF));
+}
+
+bool CompressedBitmap::insert(const uint32_t value)
+{
+    const auto highBits = static_cast<uint16_t>(value >> 16);
+
+    auto it = findContainer(highBits);
+    if ((it == containers_.end()) || (it->highBits != highBits))
+    {
+        it = containers_.insert(it, Container{ highBits, 0, {}, {} });
+    }
+    return it->insert(static_cast<uint16_t>(value & 0xFFFF));
+}
+
+void CompressedBitmap::clear()
+{
+    std::vector<Container>().swap(containers_);
+}
+
+size_t CompressedBitmap::size() const
+{
+    size_t result = 0;
+    for (const auto& container : containers_)
+    {
+        result += container.cardinality;
+    }
+    return result;
+}
@@ -0,0 +1,88 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ParallelHelpers.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace Forum::Helpers;
+
+size_t Forum::Helpers::availableParallelism()
+{
+    return std::max(static_cast<size_t>(std::thread::hardware_concurrency()), static_cast<size_t>(1));
+}
+
+void ParallelTaskRunner::add(std::string name, TaskType&& task)
+{
+    tasks_.emplace_back(std::move(name), std::move(task));
+}
+
+std::vector<ParallelTaskRunner::TaskResult> ParallelTaskRunner::run(size_t maxThreads)
+{
+    std::vector<TaskResult> results(tasks_.size());
+
+    auto runTask = [this, &results](const size_t index)
+    {
+        auto& [name, task] = tasks_[index];
+
+        const auto start = std::chrono::steady_clock::now();
+        task();
+        const auto end = std::chrono::steady_clock::now();
+
+        results[index] = { name, std::chrono::duration_cast<std::chrono::milliseconds>(end - start) };
+    };
+
+    if (0 == maxThreads)
+    {
+        maxThreads = availableParallelism();
+    }
+    const auto nrOfThreads = std::min(maxThreads, tasks_.size());
+
+    if (nrOfThreads < 2)
+    {
+        for (size_t i = 0; i < tasks_.size(); ++i)
+        {
+            runTask(i);
+        }
+    }
+    else
+    {
+        std::atomic<size_t> nextTask{ 0 };
+        std::vector<std::future<void>> workers;
+        workers.reserve(nrOfThreads);
+
+        for (size_t i = 0; i < nrOfThreads; ++i)
+        {
+            workers.push_back(std::async(std::launch::async, [this, &nextTask, &runTask]()
+            {
+                for (size_t index; (index = nextTask.fetch_add(1)) < tasks_.size(); )
+                {
+                    runTask(index);
+                }
+            }));
+        }
+        for (auto& worker : workers)
+        {
+            worker.get();
+        }
+    }
+
+    tasks_.clear();
+    return results;
+}
@@ -18,6 +18,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "StringHelpers.h"
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include <mutex>
@@ -124,8 +125,19 @@ size_t Forum::Helpers::calculateSortKey(StringView view)
         ucharBuffer = ucharBufferIfThreadLocalOneIsNotYetInitialized.get();
     }
 
-    auto u16Chars = u_strFromUTF8Lenient(ucharBuffer, MaxSortKeyGenerationUCharBufferSize,
-                                         &u16Written, view.data(), static_cast<int32_t>(view.size()), &errorCode);
+    UChar* u16Chars;
+    if (onlyASCII(view))
+    {
+        //ASCII characters have the same values in UTF-16, so there is nothing to decode
+        std::copy(view.begin(), view.end(), ucharBuffer);
+        u16Chars = ucharBuffer;
+        u16Written = static_cast<int32_t>(stringLength);
+    }
+    else
+    {
+        u16Chars = u_strFromUTF8Lenient(ucharBuffer, MaxSortKeyGenerationUCharBufferSize,
+                                        &u16Written, view.data(), static_cast<int32_t>(view.size()), &errorCode);
+    }
     if (U_FAILURE(errorCode))
     {
         //use string as sort key
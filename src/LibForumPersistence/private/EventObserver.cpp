@@ -22,12 +22,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "TypeHelpers.h"
 #include "Logging.h"
 #include "SeparateThreadConsumer.h"
+#include "ShardedCounter.h"
+#include "SpinLock.h"
 
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <map>
 #include <mutex>
 #include <numeric>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 #include <cstring>
 
@@ -1074,42 +1079,24 @@ struct EventObserver::EventObserverImpl final : private boost::noncopyable
     void onGetDiscussionThreadById(ObserverContext context, const DiscussionThread& thread, 
                                    const uint32_t latestVisitedPage)
     {
-        std::lock_guard<decltype(periodicUpdatesMutex)> lock(periodicUpdatesMutex);
+        auto& shard = periodicUpdatesShards[currentThreadShardIndex()];
+        std::lock_guard<decltype(shard.lock)> lock(shard.lock);
 
         auto& threadId = thread.id();
-        {
-            auto it = cachedNrOfThreadVisits.find(threadId);
-            if (it != cachedNrOfThreadVisits.end())
-            {
-                ++it->second;
-            }
-            else
-            {
-                cachedNrOfThreadVisits.insert(std::make_pair(threadId, 1));
-            }
-        }
+        ++shard.cachedNrOfThreadVisits[threadId];
+
         if (latestVisitedPage > 0)
         {
-            cachedLatestVisitedPage[std::make_pair(context.performedBy.id(), threadId)] = latestVisitedPage;
+            shard.cachedLatestVisitedPage[std::make_pair(context.performedBy.id(), threadId)] = latestVisitedPage;
         }
     }
 
     void onGetAttachment(ObserverContext /*context*/, const Attachment& attachment)
     {
-        std::lock_guard<decltype(periodicUpdatesMutex)> lock(periodicUpdatesMutex);
+        auto& shard = periodicUpdatesShards[currentThreadShardIndex()];
+        std::lock_guard<decltype(shard.lock)> lock(shard.lock);
 
-        auto& attachmentId = attachment.id();
-        {
-            auto it = cachedNrOfAttachmentGets.find(attachmentId);
-            if (it != cachedNrOfAttachmentGets.end())
-            {
-                ++it->second;
-            }
-            else
-            {
-                cachedNrOfAttachmentGets.insert(std::make_pair(attachmentId, 1));
-            }
-        }
+        ++shard.cachedNrOfAttachmentGets[attachment.id()];
     }
 
     void changeDiscussionThreadMessageRequiredPrivilegeForThreadMessage(ObserverContext context,
@@ -1461,7 +1448,36 @@ struct EventObserver::EventObserverImpl final : private boost::noncopyable
 
     void updatePeriodicWrites()
     {
-        std::lock_guard<decltype(periodicUpdatesMutex)> lock(periodicUpdatesMutex);
+        std::map<IdType, uint32_t> cachedNrOfThreadVisits;
+        std::map<std::pair<IdType, IdType>, uint32_t> cachedLatestVisitedPage;
+        std::map<IdType, uint32_t> cachedNrOfAttachmentGets;
+
+        for (auto& shard : periodicUpdatesShards)
+        {
+            PeriodicUpdatesShard::VisitsType shardNrOfThreadVisits;
+            PeriodicUpdatesShard::LatestVisitedPageType shardLatestVisitedPage;
+            PeriodicUpdatesShard::VisitsType shardNrOfAttachmentGets;
+            {
+                std::lock_guard<decltype(shard.lock)> lock(shard.lock);
+
+                shardNrOfThreadVisits.swap(shard.cachedNrOfThreadVisits);
+                shardLatestVisitedPage.swap(shard.cachedLatestVisitedPage);
+                shardNrOfAttachmentGets.swap(shard.cachedNrOfAttachmentGets);
+            }
+            for (const auto& [threadId, nrOfVisits] : shardNrOfThreadVisits)
+            {
+                cachedNrOfThreadVisits[threadId] += nrOfVisits;
+            }
+            for (const auto& [key, latestVisitedPage] : shardLatestVisitedPage)
+            {
+                auto& value = cachedLatestVisitedPage[key];
+                value = std::max(value, latestVisitedPage);
+            }
+            for (const auto& [attachmentId, nrOfGets] : shardNrOfAttachmentGets)
+            {
+                cachedNrOfAttachmentGets[attachmentId] += nrOfGets;
+            }
+        }
 
         for (const auto& pair : cachedNrOfThreadVisits)
         {
@@ -1474,7 +1490,6 @@ struct EventObserver::EventObserverImpl final : private boost::noncopyable
 
             recordBlob(EventType::INCREMENT_DISCUSSION_THREAD_NUMBER_OF_VISITS, 1, parts, std::size(parts));
         }
-        cachedNrOfThreadVisits.clear();
 
         for (const auto& pair : cachedLatestVisitedPage)
         {
@@ -1491,7 +1506,6 @@ struct EventObserver::EventObserverImpl final : private boost::noncopyable
 
             recordBlob(EventType::INCREMENT_USER_LATEST_VISITED_PAGE, 1, parts, std::size(parts));
         }
-        cachedLatestVisitedPage.clear();
 
         for (const auto& pair : cachedNrOfAttachmentGets)
         {
@@ -1504,7 +1518,6 @@ struct EventObserver::EventObserverImpl final : private boost::noncopyable
 
             recordBlob(EventType::INCREMENT_ATTACHMENT_NUMBER_OF_GETS, 1, parts, std::size(parts));
         }
-        cachedNrOfAttachmentGets.clear();
     }
 
     ReadEvents& readEvents;
@@ -1517,10 +1530,25 @@ struct EventObserver::EventObserverImpl final : private boost::noncopyable
     static constexpr uint32_t updatePeriodicUpdatesIncrement = 30;
     uint32_t timerPeriodicUpdates = 0;
 
-    std::mutex periodicUpdatesMutex;
-    std::map<IdType, uint32_t> cachedNrOfThreadVisits;
-    std::map<std::pair<IdType, IdType>, uint32_t> cachedLatestVisitedPage;
-    std::map<IdType, uint32_t> cachedNrOfAttachmentGets;
+    /**
+     * Visits are cached separately for each shard so that concurrent readers do not contend on a single lock
+     * The shards are merged when the periodic updates are written
+     *
+     * The totals kept by the ShardedCounter of each entity cannot replace these maps: the events store the number
+     * of visits since the previous write for each id, and the observer cannot enumerate or safely dereference
+     * entities from the timer thread, as they may be deleted in the meantime
+     */
+    struct alignas(CacheLineSize) PeriodicUpdatesShard
+    {
+        typedef std::unordered_map<IdType, uint32_t> VisitsType;
+        typedef std::map<std::pair<IdType, IdType>, uint32_t> LatestVisitedPageType;
+
+        SpinLock lock;
+        VisitsType cachedNrOfThreadVisits;
+        LatestVisitedPageType cachedLatestVisitedPage;
+        VisitsType cachedNrOfAttachmentGets;
+    };
+    std::array<PeriodicUpdatesShard, NrOfShards> periodicUpdatesShards;
 };
 
 const PersistentTimestampType EventObserver::EventObserverImpl::ZeroTimestamp{ 0 };
@@ -242,12 +242,25 @@ namespace Forum::Commands
         struct Result
         {
             Repository::StatusCode statusCode;
+            //if an output sink is set, only contains what was written after the output was last passed to it
             StringView output;
         };
 
         Result handle(Command command, const std::vector<StringView>& parameters);
         Result handle(View view, const std::vector<StringView>& parameters);
 
+        /**
+         * Outputs of commands handled on the current thread that outgrow the output buffer are passed to the sink
+         * instead of growing the buffer, until the sink is set back to nullptr
+         */
+        static void setOutputSink(Json::OutputSink* sink);
+
+        /**
+         * Retrieves a value that changes every time the output of View::GET_DISCUSSION_THREAD_BY_ID might change,
+         * so that requests for content the client already has can be answered without handling the view
+         */
+        Repository::StatusCode getDiscussionThreadVersion(StringView id, uint64_t& version);
+
         Repository::ReadEvents& readEvents();
         Repository::WriteEvents& writeEvents();
 
@@ -20,82 +20,175 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "ContextProviders.h"
 #include "EntityCommonTypes.h"
-#include "ResourceGuard.h"
-
-#include <atomic>
+#include "ShardedCounter.h"
+#include "SpinLock.h"
+
+#include <array>
+#include <cassert>
+#include <functional>
+#include <map>
+#include <mutex>
 #include <unordered_map>
 #include <string>
-#include <tuple>
+#include <string_view>
 
 namespace Forum::Commands
 {
     /**
      * Thread-safe collection for mappings between auth tokens and auth ids
+     * Tokens are spread across shards with separate locks and are looked up by hash, so that no temporary strings
+     * are needed. Each shard keeps its entries ordered by expiry as well, so that cleaning up only visits expired
+     * entries. The expired entries are erased in small steps, so the lock of a shard is only held briefly.
      */
     class AuthStore
     {
     public:
-        void add(const std::string& authToken, const std::string& authId, const Entities::Timestamp expiresIn)
+        void add(std::string_view authToken, std::string_view authId, const Entities::Timestamp expiresIn)
         {
-            cleanup();
-            auto expiresAt = Context::getCurrentTime() + expiresIn;
+            const auto now = Context::getCurrentTime();
+            const auto expiresAt = now + expiresIn;
+            const auto hash = std::hash<std::string_view>{}(authToken);
+
+            auto& shard = getShard(hash);
+            std::lock_guard<decltype(shard.lock)> lock(shard.lock);
+
+            cleanup(shard, now, MaxEntriesErasedPerAdd);
 
-            mapGuard_.write([&](MapType& collection)
+            if (findEntry(shard, hash, authToken) != shard.entries.end())
             {
-                collection.insert(std::make_pair(authToken, std::make_tuple(authId, expiresAt)));
-            });
+                //keep the existing mapping
+                return;
+            }
+
+            auto it = shard.entries.emplace(hash, Entry{ std::string(authToken), std::string(authId), expiresAt });
+            shard.byExpiresAt.emplace(expiresAt, ExpiringEntry{ hash, &it->second });
         }
 
-        //returns a copy of the string as the value might be removed at any time
-        std::string find(const std::string& authToken) const
+        /**
+         * Calls the callback with the auth id while the entry cannot be removed
+         * Returns whether a valid entry was found
+         */
+        template<typename Callback>
+        bool find(std::string_view authToken, Callback&& callback) const
         {
-            std::string result;
+            const auto hash = std::hash<std::string_view>{}(authToken);
 
-            mapGuard_.read([&](const MapType& collection)
-            {
-                const auto it = collection.find(authToken);
-                if (it == collection.end()) return;
+            auto& shard = getShard(hash);
+            std::lock_guard<decltype(shard.lock)> lock(shard.lock);
 
-                auto&[authId, expiresAt] = it->second;
-                if (expiresAt < Context::getCurrentTime()) return;
+            const auto it = findEntry(shard, hash, authToken);
+            if (it == shard.entries.end()) return false;
 
-                result = authId;
-            });
+            const auto& entry = it->second;
+            if (entry.expiresAt < Context::getCurrentTime()) return false;
 
-            return result;
+            callback(std::string_view(entry.authId));
+            return true;
         }
 
         void cleanup()
         {
-            constexpr Entities::Timestamp cleanupEverySeconds = 30;
-
             const auto now = Context::getCurrentTime();
-            if ((now - lastCleanup_) < cleanupEverySeconds) return;
 
-            mapGuard_.write([now](MapType& collection)
+            for (auto& shard : shards_)
             {
-               for (auto it = collection.begin(); it != collection.end();)
-               {
-                   auto&[authId, expiresAt] = it->second;
-                   (void)authId;
-                   if (expiresAt < now)
-                   {
-                       it = collection.erase(it);
-                   }
-                   else
-                   {
-                       ++it;
-                   }
-               }
-            });
-
-            lastCleanup_ = now;
+                //release the lock between steps so that the shard can still be used in the meantime
+                for (bool completed = false; ! completed;)
+                {
+                    std::lock_guard<decltype(shard.lock)> lock(shard.lock);
+                    completed = cleanup(shard, now, MaxEntriesErasedPerAdd);
+                }
+            }
         }
 
+        /**
+         * Upper limit for the number of expired entries erased while holding the lock of a shard, so that adding a
+         * token never waits for a large number of entries that expired at once
+         */
+        static constexpr size_t MaxEntriesErasedPerAdd = 64;
+
     private:
-        using MapType = std::unordered_map<std::string, std::tuple<std::string, Entities::Timestamp>>;
-        
-        Helpers::ResourceGuard<MapType> mapGuard_{ std::make_shared<MapType>() };
-        std::atomic<Entities::Timestamp> lastCleanup_{};
+        struct Entry
+        {
+            std::string authToken;
+            std::string authId;
+            Entities::Timestamp expiresAt;
+        };
+
+        using EntriesType = std::unordered_multimap<size_t, Entry>;
+
+        /**
+         * Identifies an entry without keeping an iterator, as iterators are invalidated when the entries are rehashed
+         * References to the elements remain valid until they are erased
+         */
+        struct ExpiringEntry
+        {
+            size_t hash;
+            const Entry* entry;
+        };
+
+        struct alignas(Helpers::CacheLineSize) Shard
+        {
+            EntriesType entries;
+            std::multimap<Entities::Timestamp, ExpiringEntry> byExpiresAt;
+            mutable Helpers::SpinLock lock;
+        };
+
+        Shard& getShard(const size_t hash)
+        {
+            return shards_[(hash >> (sizeof(hash) * 4)) % shards_.size()];
+        }
+
+        const Shard& getShard(const size_t hash) const
+        {
+            return shards_[(hash >> (sizeof(hash) * 4)) % shards_.size()];
+        }
+
+        template<typename ShardType>
+        static auto findEntry(ShardType& shard, const size_t hash, std::string_view authToken)
+            -> decltype(shard.entries.begin())
+        {
+            auto [it, end] = shard.entries.equal_range(hash);
+            for (; it != end; ++it)
+            {
+                if (it->second.authToken == authToken)
+                {
+                    return it;
+                }
+            }
+            return shard.entries.end();
+        }
+
+        static void eraseEntry(Shard& shard, const ExpiringEntry& toErase)
+        {
+            auto [it, end] = shard.entries.equal_range(toErase.hash);
+            for (; it != end; ++it)
+            {
+                if (&it->second == toErase.entry)
+                {
+                    shard.entries.erase(it);
+                    return;
+                }
+            }
+            assert(false);
+        }
+
+        /**
+         * Erases at most maxEntries expired entries, starting with the ones that expired first
+         * @returns true if no more expired entries are left
+         */
+        static bool cleanup(Shard& shard, const Entities::Timestamp now, const size_t maxEntries)
+        {
+            auto it = shard.byExpiresAt.begin();
+            for (size_t i = 0; (i < maxEntries) && (it != shard.byExpiresAt.end()) && (it->first < now); ++i, ++it)
+            {
+                eraseEntry(shard, it->second);
+            }
+            shard.byExpiresAt.erase(shard.byExpiresAt.begin(), it);
+
+            return (it == shard.byExpiresAt.end()) || (it->first >= now);
+        }
+
+        std::array<Shard, Helpers::NrOfShards> shards_;
     };
 }
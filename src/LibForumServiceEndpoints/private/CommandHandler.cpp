@@ -43,17 +43,36 @@ using namespace Forum::Authorization;
 #define COMMAND_HANDLER_METHOD_SIMPLE(name) \
     StatusCode name(const std::vector<StringView>& /*parameters*/, OutStream& output)
 
+static constexpr size_t OutputBufferInitialCapacity = 64 * 1024;
+static constexpr size_t OutputBufferMaxCapacityToKeep = 1 << 20;
+
+static thread_local Json::OutputSink* currentOutputSink = nullptr;
+
+/**
+ * Returns an empty buffer for the output of the current command
+ * The buffer is per thread and only grows beyond 1 MiB for as long as a large output needs it,
+ * unless an output sink takes over what does not fit
+ */
 static Json::StringBuffer& getOutputBuffer()
 {
     static boost::thread_specific_ptr<Json::StringBuffer> value;
 
     if ( ! value.get())
     {
-        value.reset(new Json::StringBuffer{ 1 << 20 }); //1 MiByte buffer / thread initial and for each increment
+        value.reset(new Json::StringBuffer{ OutputBufferInitialCapacity });
     }
+    value->clear();
+    value->releaseIfLargerThan(OutputBufferMaxCapacityToKeep);
+    value->setSink(currentOutputSink);
+
     return *value;
 }
 
+void CommandHandler::setOutputSink(Json::OutputSink* sink)
+{
+    currentOutputSink = sink;
+}
+
 static const std::string EmptyString;
 
 template<typename Collection>
@@ -66,6 +85,35 @@ auto countNonEmpty(const Collection& collection)
 static constexpr size_t NormalizeBuffer16MaxChars = 2 << 20;
 static constexpr size_t NormalizeBuffer8MaxChars = 2 * NormalizeBuffer16MaxChars;
 
+/**
+ * Returns whether the input is valid UTF-8 that only contains code points below U+0300 (ASCII, Latin-1 Supplement,
+ * Latin Extended-A/B and IPA Extensions). None of them decomposes or combines with a preceding character,
+ * so such input is already in NFC form and does not need to go through ICU
+ */
+static bool isValidUTF8AlreadyInNFC(StringView input)
+{
+    const auto* data = reinterpret_cast<const uint8_t*>(input.data());
+    const auto size = input.size();
+    size_t index = 0;
+
+    while (index < size)
+    {
+        index += countASCIIPrefix(StringView(input.data() + index, size - index));
+        if (index >= size)
+        {
+            break;
+        }
+        //two byte sequences starting with 0xC2 - 0xCB encode U+0080 - U+02FF, 0xC0 and 0xC1 would be overlong
+        const auto lead = data[index];
+        if ((lead < 0xC2) || (lead > 0xCB) || ((index + 1) >= size) || ((data[index + 1] & 0xC0) != 0x80))
+        {
+            return false;
+        }
+        index += 2;
+    }
+    return true;
+}
+
 /**
  * Performs a Unicode NFC normalization on a UTF-8 encoded string and returns a view also to a UTF-8 encoded string
  * If an error occurs or the input contains invalid characters, an empty view is returned
@@ -76,8 +124,8 @@ static StringView normalize(StringView input)
     static boost::thread_specific_ptr<UChar> normalizeBuffer16AfterPtr;
     static boost::thread_specific_ptr<char> normalizeBuffer8Ptr;
 
-    if (onlyASCII(input)) {
-
+    if (isValidUTF8AlreadyInNFC(input))
+    {
         //no normalization needed
         return input;
     }
@@ -1509,6 +1557,11 @@ CommandHandler::~CommandHandler()
     delete impl_;
 }
 
+StatusCode CommandHandler::getDiscussionThreadVersion(const StringView id, uint64_t& version)
+{
+    return impl_->discussionThreadRepository->getDiscussionThreadVersion(id, version);
+}
+
 ReadEvents& CommandHandler::readEvents()
 {
     return impl_->observerRepository->readEvents();
@@ -1537,8 +1590,6 @@ CommandHandler::Result CommandHandler::handle(const Command command, const std::
 
     auto& outputBuffer = getOutputBuffer();
 
-    outputBuffer.clear();
-
     StatusCode statusCode;
     if (command >= 0 && command < LAST_COMMAND)
     {
@@ -1548,11 +1599,9 @@ CommandHandler::Result CommandHandler::handle(const Command command, const std::
     {
         statusCode = StatusCode::NOT_FOUND;
     }
-    auto outputView = outputBuffer.view();
-    if (outputView.empty())
+    if (0 == outputBuffer.size())
     {
         writeStatusCode(outputBuffer, statusCode);
-        outputView = outputBuffer.view();
     }
     return { statusCode, outputBuffer.view() };
 }
@@ -1563,8 +1612,6 @@ CommandHandler::Result CommandHandler::handle(const View view, const std::vector
     
     auto& outputBuffer = getOutputBuffer();
 
-    outputBuffer.clear();
-
     StatusCode statusCode;
     if (view >= 0 && view < LAST_VIEW)
     {
@@ -1574,11 +1621,9 @@ CommandHandler::Result CommandHandler::handle(const View view, const std::vector
     {
         statusCode = StatusCode::NOT_FOUND;
     }
-    auto outputView = outputBuffer.view();
-    if (outputView.empty())
+    if (0 == outputBuffer.size())
     {
         writeStatusCode(outputBuffer, statusCode);
-        outputView = outputBuffer.view();
     }
-    return{ statusCode, outputView };
+    return{ statusCode, outputBuffer.view() };
 }
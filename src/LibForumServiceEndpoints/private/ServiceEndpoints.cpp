@@ -21,11 +21,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Configuration.h"
 #include "ContextProviders.h"
 #include "HttpStringHelpers.h"
+#include "OutputHelpers.h"
 
-#include <boost/crc.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/noncopyable.hpp>
 #include <boost/thread/tss.hpp>
 
+#include <functional>
+#include <optional>
+#include <string_view>
 #include <vector>
 
 using namespace Forum;
@@ -90,16 +94,11 @@ static CommandHandler::Result loginUser(const Http::HttpStringView authToken, co
         return { Repository::StatusCode::INVALID_PARAMETERS, "" };
     }
 
-    authStore.add(std::string{ authToken }, std::string{ authId }, expiresIn);
+    authStore.add(authToken, authId, expiresIn);
 
     return { Repository::StatusCode::OK, "ok" };
 }
 
-static std::string getAuth(const Http::HttpStringView token)
-{
-    return authStore.find(std::string{ token });
-}
-
 static void updateContextForRequest(const Http::HttpRequest& request, const bool allowAuth)
 {
     Context::setCurrentUserId({});
@@ -111,11 +110,11 @@ static void updateContextForRequest(const Http::HttpRequest& request, const bool
         const auto authToken = request.getCookie("auth");
         if ( ! authToken.empty())
         {
-            auto authResult = getAuth(authToken);
-            if ( ! authResult.empty())
+            authStore.find(authToken, [](const std::string_view authId)
             {
-                Context::setCurrentUserAuth(authResult);
-            }
+                //the thread-local auth string keeps its capacity between requests
+                Context::setCurrentUserAuth(authId);
+            });
         }
     }
 
@@ -173,45 +172,249 @@ static StringView getPointerToEntireRequestBody(const Http::HttpRequest& request
     return StringView(currentRequestContent.data(), currentRequestContent.size());
 }
 
-static uint32_t crc32(IpAddress value)
+static uint64_t hashBytes(const void* data, const size_t size)
 {
-    boost::crc_32_type hash;
-    hash.process_bytes(value.data(), value.nrOfBytes());
-    return hash.checksum();
-}
-
-static uint32_t crc32(StringView value)
-{
-    boost::crc_32_type hash;
-    hash.process_bytes(value.data(), value.size());
-    return hash.checksum();
+    return std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char*>(data), size));
 }
 
 static void updateVisitorsCount(const Http::HttpRequest& request)
 {
+    constexpr uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+
+    const IpAddress ip(request.remoteAddress);
+    const auto userAgent = request.headers[Http::Request::HttpHeader::User_Agent];
     const Repository::VisitorCollection::VisitorId id =
-        static_cast<uint64_t>(crc32(request.remoteAddress)) << 32
-        | static_cast<uint64_t>(crc32(request.headers[Http::Request::HttpHeader::User_Agent]));
+        (hashBytes(ip.data(), ip.nrOfBytes()) * multiplier) ^ hashBytes(userAgent.data(), userAgent.size());
 
     Context::getVisitorCollection().add(id);
 }
 
+/**
+ * Some values change with time alone (e.g. last seen, expiring privileges and votes), so clients have to
+ * download responses again at least this often
+ */
+static constexpr Entities::Timestamp EntityTagTimeBucketSeconds = 60;
+
+/**
+ * The tag covers the version of the data in the response (the write generation, or the version of the single
+ * entity requested) together with everything else from the request context that changes the output
+ */
+static Http::HttpStringView computeEntityTag(const uint64_t version, char (&buffer)[24])
+{
+    constexpr uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+
+    const auto& auth = Context::getCurrentUserAuth();
+    uint64_t value = version;
+    value = (value * multiplier) ^ Configuration::getGlobalConfigVersion();
+    value = (value * multiplier) ^ hashBytes(auth.data(), auth.size());
+    value = (value * multiplier) ^ (Context::getCurrentUserShowInOnlineUsers() ? 1 : 0);
+    value = (value * multiplier) ^ static_cast<uint64_t>(Context::getCurrentTime() / EntityTagTimeBucketSeconds);
+
+    static constexpr char hexDigits[] = "0123456789abcdef";
+    char* output = buffer;
+    *output++ = 'W';
+    *output++ = '/';
+    *output++ = '"';
+    for (int shift = 60; shift >= 0; shift -= 4)
+    {
+        *output++ = hexDigits[(value >> shift) & 0xF];
+    }
+    *output++ = '"';
+
+    return Http::HttpStringView(buffer, output - buffer);
+}
+
 void AbstractEndpoint::handle(Http::RequestState& requestState, ExecuteFn executeCommand)
 {
-    handleInternal(requestState, "application/json", executeCommand, true);
+    handleInternal(requestState, "application/json", executeCommand, true, true);
+}
+
+void AbstractEndpoint::handleWithoutEntityTag(Http::RequestState& requestState, ExecuteFn executeCommand)
+{
+    handleInternal(requestState, "application/json", executeCommand, true, false);
+}
+
+void AbstractEndpoint::handleWithEntityVersion(Http::RequestState& requestState, const VersionFn getVersion,
+                                               const ExecuteFn executeCommand)
+{
+    handleInternal(requestState, "application/json", executeCommand, true, true, getVersion);
 }
 
 void AbstractEndpoint::handleBinary(Http::RequestState& requestState, const StringView contentType, 
                                     const ExecuteFn executeCommand)
 {
-    handleInternal(requestState, contentType, executeCommand, false);
+    handleInternal(requestState, contentType, executeCommand, false, true);
+}
+
+/**
+ * Binary content such as images is usually already compressed
+ */
+static bool isCompressible(const StringView contentType)
+{
+    return (0 == contentType.find("application/json")) || (0 == contentType.find("text/"));
+}
+
+namespace
+{
+    /**
+     * What the response to a command depends on, besides the command's status code and output
+     */
+    struct ResponseOptions final
+    {
+        StringView contentType;
+        Http::HttpStringView cacheControl;
+        //not sent if empty
+        Http::HttpStringView entityTag;
+        StringView prefix;
+        bool compressionEnabled = false;
+        Http::BodyCompression compression;
+    };
+}
+
+static void writeResponseCodeAndHeaders(Http::HttpResponseBuilder& response, const Http::HttpRequest& request,
+                                        const Repository::StatusCode statusCode, const ResponseOptions& options)
+{
+    const auto isOk = statusCode == Repository::StatusCode::OK;
+
+    response.writeResponseCode(request, commandStatusToHttpStatus(statusCode));
+    if (isOk && ! options.entityTag.empty())
+    {
+        response.writeHeader("Cache-Control", options.cacheControl);
+        response.writeHeader("ETag", options.entityTag);
+    }
+    else
+    {
+        response.writeHeader("Cache-Control", "no-cache, no-store, must-revalidate");
+    }
+    response.writeHeader("Content-Type", isOk ? options.contentType : StringView("application/json"));
+}
+
+namespace
+{
+    /**
+     * Takes over command outputs that outgrow the output buffer, writing them straight into the response,
+     * so that they are not copied once more and the output buffer does not need to grow
+     * The response is started as soon as the output is large enough, assuming that the command succeeds
+     */
+    class ResponseBodySink final : public Json::OutputSink
+    {
+    public:
+        ResponseBodySink(const Http::HttpRequest& request, Http::HttpResponseBuilder& response,
+                         const ResponseOptions& options)
+            : request_(request), response_(response), options_(options)
+        {}
+
+        char* flush(const std::string_view content, size_t& blockSize) override
+        {
+            if ( ! started_)
+            {
+                started_ = true;
+                writeResponseCodeAndHeaders(response_, request_, Repository::StatusCode::OK, options_);
+                if (options_.compressionEnabled && isCompressible(options_.contentType))
+                {
+                    response_.startBodyInParts(options_.compression, options_.prefix.size() + content.size());
+                }
+                else
+                {
+                    response_.startBodyInParts();
+                }
+                response_.writeBodyPart(options_.prefix);
+            }
+            writeContent(content);
+
+            const auto block = response_.prepareBodyPart();
+            blockSize = boost::asio::buffer_size(block);
+            prepared_ = (blockSize > 0) ? static_cast<char*>(block.data()) : nullptr;
+            return prepared_;
+        }
+
+        bool started() const
+        {
+            return started_;
+        }
+
+        /**
+         * Completes the response with the rest of the output
+         * @returns false if the response could not be written completely
+         */
+        bool finish(const std::string_view rest)
+        {
+            assert(started_);
+            writeContent(rest);
+            return response_.endBodyInParts();
+        }
+
+        /**
+         * Drops the response started so far, as the command did not succeed after all
+         */
+        void discard()
+        {
+            assert(started_);
+            writeContent({});
+            response_.discardResponse();
+        }
+
+    private:
+        void writeContent(const std::string_view content)
+        {
+            if (prepared_)
+            {
+                //the content was written in place
+                assert((0 == content.size()) || (content.data() == prepared_));
+                response_.commitBodyPart(content.size());
+                prepared_ = nullptr;
+            }
+            else
+            {
+                response_.writeBodyPart(content);
+            }
+        }
+
+        const Http::HttpRequest& request_;
+        Http::HttpResponseBuilder& response_;
+        const ResponseOptions& options_;
+        bool started_ = false;
+        char* prepared_ = nullptr;
+    };
+
+    /**
+     * Makes sure the sink is no longer used once the command is handled
+     */
+    struct OutputSinkScope final : boost::noncopyable
+    {
+        explicit OutputSinkScope(Json::OutputSink* sink)
+        {
+            CommandHandler::setOutputSink(sink);
+        }
+
+        ~OutputSinkScope()
+        {
+            CommandHandler::setOutputSink(nullptr);
+        }
+    };
+}
+
+static void writeNotModified(Http::HttpResponseBuilder& response, const Http::HttpRequest& request,
+                             const Http::HttpStringView entityTag, const Http::HttpStringView cacheControl)
+{
+    response.writeResponseCode(request, Http::HttpStatusCode::Not_Modified);
+    response.writeHeader("Cache-Control", cacheControl);
+    response.writeHeader("ETag", entityTag);
+    if (Configuration::getGlobalConfig()->service.compressionMinimumSize > 0)
+    {
+        response.writeHeader("Vary", "Accept-Encoding");
+    }
+    response.writeBody({});
 }
 
 void AbstractEndpoint::handleInternal(Http::RequestState& requestState, const StringView contentType,
-                                      const ExecuteFn executeCommand, const bool writePrefix)
+                                      const ExecuteFn executeCommand, const bool writePrefix,
+                                      const bool allowEntityTag, const VersionFn getVersion)
 {
     assert(nullptr != executeCommand);
 
+    const Configuration::ConfigSnapshot configSnapshot;
+
     auto& request = requestState.request;
     auto& response = requestState.response;
 
@@ -233,25 +436,90 @@ void AbstractEndpoint::handleInternal(Http::RequestState& requestState, const St
     currentParameters.clear();
     updateContextForRequest(request, allowAuth);
 
-    const auto result = executeCommand(requestState, commandHandler_, currentParameters);
-    
-    response.writeResponseCode(request, commandStatusToHttpStatus(result.statusCode));
-    response.writeHeader("Cache-Control", "no-cache, no-store, must-revalidate");
-    if (result.statusCode == Repository::StatusCode::OK)
+    //only read-only requests are revalidated
+    auto useEntityTag = allowEntityTag && (Http::HttpVerb::GET == request.verb);
+    const auto isAnonymous = Context::getCurrentUserAuth().empty();
+    const auto cacheControl = isAnonymous ? Http::HttpStringView("no-cache") : Http::HttpStringView("private, no-cache");
+    char entityTagBuffer[24];
+    Http::HttpStringView entityTag;
+
+    //the version is read before executing the command, so it can never be newer than the output
+    uint64_t version = Context::getWriteGeneration();
+    if (useEntityTag && getVersion
+        && (Repository::StatusCode::OK != getVersion(requestState, commandHandler_, version)))
     {
-        response.writeHeader("Content-Type", contentType);
+        //let the command report the error
+        useEntityTag = false;
     }
-    else
+    if (useEntityTag)
+    {
+        entityTag = computeEntityTag(version, entityTagBuffer);
+
+        //tags are only sent with successful responses, and the output cannot change without changing the tag,
+        //so the command is not executed at all; its side effects (e.g. visit counters, observers, throttling,
+        //last seen) only happen for requests that receive the output
+        if (Http::entityTagMatches(request.headers[Http::Request::HttpHeader::If_None_Match], entityTag))
+        {
+            writeNotModified(response, request, entityTag, cacheControl);
+            return;
+        }
+    }
+
+    ResponseOptions options;
+    options.contentType = contentType;
+    options.cacheControl = cacheControl;
+    options.entityTag = entityTag;
+    options.prefix = writePrefix ? StringView(prefix_) : StringView{};
+
+    const auto compressionMinimumSize = Configuration::getGlobalConfig()->service.compressionMinimumSize;
+    if (compressionMinimumSize > 0)
     {
-        response.writeHeader("Content-Type", "application/json");
+        options.compressionEnabled = true;
+        options.compression.encoding =
+                Http::chooseContentEncoding(request.headers[Http::Request::HttpHeader::Accept_Encoding]);
+        options.compression.minimumSize = compressionMinimumSize;
+        options.compression.level = Configuration::getGlobalConfig()->service.compressionLevel;
     }
-    if (writePrefix)
+
+    ResponseBodySink sink(request, response, options);
+    CommandHandler::Result result;
+    std::optional<Json::StringBuffer> statusOutput;
     {
-        response.writeBodyAndContentLength(result.output, prefix_);
+        OutputSinkScope _(response.canWriteBodyInParts() ? &sink : nullptr);
+        result = executeCommand(requestState, commandHandler_, currentParameters);
+    }
+
+    if (sink.started())
+    {
+        if (Repository::StatusCode::OK == result.statusCode)
+        {
+            if ( ! sink.finish(result.output))
+            {
+                response.discardResponse();
+                response.writeResponseCode(request, Http::HttpStatusCode::Internal_Server_Error);
+                response.writeBodyAndContentLength({});
+            }
+            return;
+        }
+        //the output is incomplete, only the status is sent
+        sink.discard();
+        statusOutput.emplace(128);
+        writeStatusCode(*statusOutput, result.statusCode);
+        result.output = statusOutput->view();
+    }
+
+    writeResponseCodeAndHeaders(response, request, result.statusCode, options);
+
+    const auto isOk = result.statusCode == Repository::StatusCode::OK;
+    const auto outputContentType = isOk ? contentType : StringView("application/json");
+
+    if (options.compressionEnabled && isCompressible(outputContentType))
+    {
+        response.writeBodyAndContentLength(result.output, options.prefix, options.compression);
     }
     else
     {
-        response.writeBodyAndContentLength(result.output);
+        response.writeBodyAndContentLength(result.output, options.prefix);
     }
 }
 
@@ -343,7 +611,7 @@ StatisticsEndpoint::StatisticsEndpoint(CommandHandler& handler) : AbstractEndpoi
 
 void StatisticsEndpoint::getEntitiesCount(Http::RequestState& requestState)
 {
-    handle(requestState,
+    handleWithoutEntityTag(requestState,
            [](const Http::RequestState& /*requestState*/, CommandHandler& commandHandler, std::vector<StringView>& parameters)
     {
         return commandHandler.handle(View::COUNT_ENTITIES, parameters);
@@ -413,7 +681,7 @@ void UsersEndpoint::getCurrent(Http::RequestState& requestState)
 
 void UsersEndpoint::getOnline(Http::RequestState& requestState)
 {
-    handle(requestState,
+    handleWithoutEntityTag(requestState,
            [](const Http::RequestState& /*requestState*/, CommandHandler& commandHandler, std::vector<StringView>& parameters)
     {
         return commandHandler.handle(View::GET_USERS_ONLINE, parameters);
@@ -697,7 +965,11 @@ void DiscussionThreadsEndpoint::getAll(Http::RequestState& requestState)
 
 void DiscussionThreadsEndpoint::getThreadById(Http::RequestState& requestState)
 {
-    handle(requestState,
+    handleWithEntityVersion(requestState,
+           [](const Http::RequestState& requestState, CommandHandler& commandHandler, uint64_t& version)
+    {
+        return commandHandler.getDiscussionThreadVersion(requestState.extraPathParts[0], version);
+    },
            [](const Http::RequestState& requestState, CommandHandler& commandHandler, std::vector<StringView>& parameters)
     {
         parameters.push_back(requestState.extraPathParts[0]);
@@ -1563,7 +1835,7 @@ void AuthorizationEndpoint::getRequiredPrivilegesForThreadMessage(Http::RequestS
 
 void AuthorizationEndpoint::getAssignedPrivilegesForThreadMessage(Http::RequestState& requestState)
 {
-    handle(requestState,
+    handleWithoutEntityTag(requestState,
            [](const Http::RequestState& requestState, CommandHandler& commandHandler, std::vector<StringView>& parameters)
     {
         parameters.push_back(requestState.extraPathParts[0]);
@@ -1583,7 +1855,7 @@ void AuthorizationEndpoint::getRequiredPrivilegesForThread(Http::RequestState& r
 
 void AuthorizationEndpoint::getAssignedPrivilegesForThread(Http::RequestState& requestState)
 {
-    handle(requestState,
+    handleWithoutEntityTag(requestState,
            [](const Http::RequestState& requestState, CommandHandler& commandHandler, std::vector<StringView>& parameters)
     {
         parameters.push_back(requestState.extraPathParts[0]);
@@ -1603,7 +1875,7 @@ void AuthorizationEndpoint::getRequiredPrivilegesForTag(Http::RequestState& requ
 
 void AuthorizationEndpoint::getAssignedPrivilegesForTag(Http::RequestState& requestState)
 {
-    handle(requestState,
+    handleWithoutEntityTag(requestState,
            [](const Http::RequestState& requestState, CommandHandler& commandHandler, std::vector<StringView>& parameters)
     {
         parameters.push_back(requestState.extraPathParts[0]);
@@ -1623,7 +1895,7 @@ void AuthorizationEndpoint::getRequiredPrivilegesForCategory(Http::RequestState&
 
 void AuthorizationEndpoint::getAssignedPrivilegesForCategory(Http::RequestState& requestState)
 {
-    handle(requestState,
+    handleWithoutEntityTag(requestState,
            [](const Http::RequestState& requestState, CommandHandler& commandHandler, std::vector<StringView>& parameters)
     {
         parameters.push_back(requestState.extraPathParts[0]);
@@ -1660,7 +1932,7 @@ void AuthorizationEndpoint::getForumWideDefaultPrivilegeLevels(Http::RequestStat
 
 void AuthorizationEndpoint::getForumWideAssignedPrivileges(Http::RequestState& requestState)
 {
-    handle(requestState,
+    handleWithoutEntityTag(requestState,
            [](const Http::RequestState& /*requestState*/, CommandHandler& commandHandler, std::vector<StringView>& parameters)
     {
         return commandHandler.handle(View::GET_FORUM_WIDE_ASSIGNED_PRIVILEGES, parameters);
@@ -1669,7 +1941,7 @@ void AuthorizationEndpoint::getForumWideAssignedPrivileges(Http::RequestState& r
 
 void AuthorizationEndpoint::getAssignedPrivilegesForUser(Http::RequestState& requestState)
 {
-    handle(requestState,
+    handleWithoutEntityTag(requestState,
            [](const Http::RequestState& requestState, CommandHandler& commandHandler, std::vector<StringView>& parameters)
     {
         parameters.push_back(requestState.extraPathParts[0]);
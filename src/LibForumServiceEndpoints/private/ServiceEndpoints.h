@@ -40,8 +40,21 @@ namespace Forum::Commands
                                                     std::vector<StringView>&);
 
         void handle(Http::RequestState& requestState, ExecuteFn executeCommand);
+        /**
+         * For responses that change with time alone, which cannot be revalidated using the write generation
+         */
+        void handleWithoutEntityTag(Http::RequestState& requestState, ExecuteFn executeCommand);
+
+        typedef Repository::StatusCode (*VersionFn)(const Http::RequestState&, CommandHandler&, uint64_t&);
+
+        /**
+         * For responses about a single entity, whose version is used instead of the write generation,
+         * so that changes to other entities do not invalidate them
+         */
+        void handleWithEntityVersion(Http::RequestState& requestState, VersionFn getVersion,
+                                     ExecuteFn executeCommand);
         void handleInternal(Http::RequestState& requestState, StringView contentType, ExecuteFn executeCommand,
-                            bool writePrefix);
+                            bool writePrefix, bool allowEntityTag, VersionFn getVersion = nullptr);
         void handleBinary(Http::RequestState& requestState, StringView contentType, ExecuteFn executeCommand);
 
         bool validateRequest(const Http::HttpRequest& request, Http::HttpStatusCode& responseCode, 
@@ -32,9 +32,10 @@ namespace Http
         explicit ConnectionManagerWithTimeout(boost::asio::io_service& ioService, 
             std::shared_ptr<IConnectionManager> delegateTo, size_t connectionTimeoutSeconds);
 
-        ConnectionIdentifier newConnection(IConnectionManager* manager, boost::asio::ip::tcp::socket&& socket) override;
+        ConnectionIdentifier newConnection(IConnectionManager* manager, StreamSocket&& socket) override;
         void closeConnection(ConnectionIdentifier identifier) override;
         void disconnectConnection(ConnectionIdentifier identifier) override;
+        void refreshConnection(ConnectionIdentifier identifier) override;
 
         void stop() override;
 
@@ -37,7 +37,7 @@ namespace Http
                                    size_t connectionPoolSize, size_t numberOfReadBuffers, size_t numberOfWriteBuffers,
                                    bool trustIpFromXForwardedFor);
 
-        ConnectionIdentifier newConnection(IConnectionManager* manager, boost::asio::ip::tcp::socket&& socket) override;
+        ConnectionIdentifier newConnection(IConnectionManager* manager, StreamSocket&& socket) override;
         void closeConnection(ConnectionIdentifier identifier) override;
         void disconnectConnection(ConnectionIdentifier identifier) override;
 
@@ -49,6 +49,7 @@ namespace Http
         std::unique_ptr<HttpRouter> httpRouter_;
         std::unique_ptr<HttpConnection::ReadBufferPoolType> readBuffers_;
         std::unique_ptr<HttpConnection::WriteBufferPoolType> writeBuffers_;
+        ResponseOverflowBudget responseOverflowBudget_;
         bool trustIpFromXForwardedFor_;
     };
 }
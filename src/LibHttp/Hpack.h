@@ -0,0 +1,97 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "HttpConstants.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+namespace Http::Hpack
+{
+    /**
+     * Decodes header blocks compressed using HPACK (RFC 7541)
+     * The dynamic table is kept between calls, as it is shared by all header blocks received on a connection
+     */
+    class Decoder final : boost::noncopyable
+    {
+    public:
+        //returns false to stop decoding
+        typedef bool (*OnHeaderFn)(HttpStringView name, HttpStringView value, void* state);
+
+        static constexpr size_t DefaultDynamicTableSize = 4096;
+
+        explicit Decoder(size_t maxDynamicTableSize = DefaultDynamicTableSize);
+
+        /**
+         * Decodes a complete header block, calling onHeader for each field in the order they were sent
+         * The views passed to onHeader are only valid during the call
+         * @returns false if the block is malformed, after which the decoder can no longer be used
+         */
+        bool decode(const char* data, size_t size, OnHeaderFn onHeader, void* state);
+
+        size_t dynamicTableSize() const
+        {
+            return dynamicTableSize_;
+        }
+
+    private:
+        struct Entry
+        {
+            std::string name;
+            std::string value;
+        };
+
+        bool getEntry(size_t index, HttpStringView& name, HttpStringView& value) const;
+        void addEntry(HttpStringView name, HttpStringView value);
+        void evictUntilAtMost(size_t size);
+
+        //the newest entry is at the front
+        std::deque<Entry> dynamicTable_;
+        size_t dynamicTableSize_ = 0;
+        //upper limit announced to the encoder via SETTINGS_HEADER_TABLE_SIZE
+        size_t maxDynamicTableSize_;
+        //limit currently chosen by the encoder, never more than maxDynamicTableSize_
+        size_t currentMaxDynamicTableSize_;
+        std::string nameBuffer_;
+        std::string valueBuffer_;
+    };
+
+    /**
+     * Decodes a Huffman encoded string, appending the result to output
+     * @returns false if the input is not valid
+     */
+    bool decodeHuffman(const char* data, size_t size, std::string& output);
+
+    /**
+     * Appends the :status pseudo-header to a header block
+     */
+    void encodeStatus(uint16_t code, std::vector<char>& output);
+
+    /**
+     * Appends a field to a header block as a literal that is not added to the dynamic table,
+     * so the encoder does not need to keep any state; the name is converted to lowercase
+     */
+    void encodeHeader(HttpStringView name, HttpStringView value, std::vector<char>& output);
+}
@@ -0,0 +1,166 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "FixedSizeBufferPool.h"
+#include "Hpack.h"
+#include "HttpConstants.h"
+#include "HttpParser.h"
+#include "HttpRequest.h"
+#include "HttpResponseBuilder.h"
+#include "ReadWriteBufferArray.h"
+#include "ResponseBuffer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+namespace Http
+{
+    /**
+     * Server side of cleartext HTTP/2 with prior knowledge (h2c), for reverse proxies that multiplex many requests
+     * over a few connections
+     *
+     * The header block of each stream is decoded into the same HttpRequest structure used for HTTP/1.x and the
+     * response written for it is converted into HEADERS and DATA frames, honoring the flow control windows of the
+     * client. The session does no I/O of its own: received bytes are passed to process() and the bytes to send
+     * are handed to a callback, so it can be driven by any connection.
+     */
+    class Http2Session final : boost::noncopyable
+    {
+    public:
+        typedef FixedSizeBufferPool<Buffer::ReadBufferSize> ReadBufferPoolType;
+        typedef void (*ProcessRequestFn)(HttpRequest& request, HttpResponseBuilder& response, void* state);
+        typedef void (*WriteFn)(const char* data, size_t size, void* state);
+
+        static constexpr HttpStringView ConnectionPreface{ "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n", 24 };
+        static constexpr uint32_t MaxConcurrentStreams = 32;
+        //the read buffer pool is shared by all connections, so a session may not lease more buffers from it than
+        //a single HTTP/1.x connection does; streams that would need more are refused
+        static constexpr size_t MaxLeasedBuffers = 1 + Buffer::MaximumBuffersForRequestBody;
+
+        Http2Session(ReadBufferPoolType& readBufferPool, ResponseOverflowBudget& responseOverflowBudget,
+                     ProcessRequestFn processRequest, WriteFn write, void* state);
+        ~Http2Session();
+
+        /**
+         * Processes bytes received from the client, starting with the connection preface
+         * @returns false if the connection is to be closed once the bytes written so far are sent
+         */
+        bool process(const char* data, size_t size);
+
+        /**
+         * Tells the client that the connection is about to be closed, no more bytes are processed afterwards
+         */
+        void goAway();
+
+        /**
+         * Returns whether the first bytes received on a connection match the start of the HTTP/2 preface
+         * At least 4 bytes are needed to tell it apart from HTTP/1.x verbs
+         */
+        static bool startsWithConnectionPreface(const char* data, size_t size);
+
+    private:
+        struct Stream;
+
+        size_t processFrames(const char* data, size_t size);
+        bool processFrame(uint8_t type, uint8_t flags, uint32_t streamId, const char* payload, size_t size);
+        bool onHeaders(uint8_t flags, uint32_t streamId, const char* payload, size_t size);
+        bool onContinuation(uint8_t flags, uint32_t streamId, const char* payload, size_t size);
+        bool onData(uint8_t flags, uint32_t streamId, const char* payload, size_t size);
+        bool onSettings(uint8_t flags, uint32_t streamId, const char* payload, size_t size);
+        bool onWindowUpdate(uint32_t streamId, const char* payload, size_t size);
+        bool onHeaderBlockComplete();
+
+        static bool onHeaderDecoded(HttpStringView name, HttpStringView value, void* state);
+        bool startRequest(Stream& stream);
+        void processRequest(Stream& stream);
+        void writeSimpleResponse(Stream& stream, HttpStatusCode code);
+        void sendResponse(Stream& stream);
+        void sendPendingData();
+        bool sendPendingData(Stream& stream);
+        void finishStream(Stream& stream);
+
+        Stream* findStream(uint32_t streamId);
+        Stream* newStream(uint32_t streamId);
+        size_t leasedBuffers() const;
+        void refuseStream(Stream& stream);
+        void closeStream(Stream& stream);
+
+        void writeFrameHeader(size_t length, uint8_t type, uint8_t flags, uint32_t streamId);
+        void writeSettings();
+        void writeResetStream(uint32_t streamId, uint32_t errorCode);
+        void writeWindowUpdate(uint32_t streamId, uint32_t increment);
+        void writeGoAway(uint32_t errorCode);
+        bool connectionError(uint32_t errorCode);
+
+        ReadBufferPoolType& readBufferPool_;
+        //responses are kept until the flow control windows allow sending them, so their memory is reserved
+        //from the budget shared with the responses of HTTP/1.x connections
+        ResponseOverflowBudget& responseOverflowBudget_;
+        ProcessRequestFn processRequest_;
+        WriteFn write_;
+        void* state_;
+
+        size_t prefaceBytesReceived_ = 0;
+        bool settingsReceived_ = false;
+        bool closing_ = false;
+        //the client will not start new streams, the connection is closed once the existing ones are finished
+        bool goAwayReceived_ = false;
+        //frames that were only partially received
+        std::vector<char> incompleteFrames_;
+
+        Hpack::Decoder decoder_;
+        //header block fragments of HEADERS and CONTINUATION frames
+        std::vector<char> headerBlock_;
+        uint32_t headerBlockStreamId_ = 0;
+        bool headerBlockEndsStream_ = false;
+        std::vector<char> responseHeaderBlock_;
+
+        //values decoded from the latest header block
+        std::string method_;
+        std::string path_;
+        std::string authority_;
+        std::string headerLines_;
+        std::string cookies_;
+        bool hostReceived_ = false;
+        bool malformedHeaders_ = false;
+        //size of the decoded header list, as defined for SETTINGS_MAX_HEADER_LIST_SIZE
+        size_t headerListSize_ = 0;
+
+        std::vector<std::unique_ptr<Stream>> streams_;
+        //kept so that their memory can be reused
+        std::vector<std::unique_ptr<Stream>> unusedStreams_;
+        uint32_t lastStreamId_ = 0;
+
+        std::vector<char> response_;
+        BudgetedResponseStorage responseStorage_;
+        HttpResponseBuilder responseBuilder_;
+
+        int64_t connectionSendWindow_;
+        int64_t peerInitialWindowSize_;
+        size_t peerMaxFrameSize_;
+        uint32_t pendingConnectionWindowUpdate_ = 0;
+    };
+}
@@ -20,11 +20,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "StreamingConnection.h"
 #include "FixedSizeBufferPool.h"
+#include "Http2Session.h"
 #include "ReadWriteBufferArray.h"
 #include "HttpConstants.h"
 #include "HttpParser.h"
 #include "HttpResponseBuilder.h"
 #include "HttpRouter.h"
+#include "ResponseBuffer.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
 
 namespace Http
 {
@@ -36,30 +42,49 @@ namespace Http
         typedef FixedSizeBufferPool<Buffer::WriteBufferSize> WriteBufferPoolType;
         typedef FixedSizeBufferPool<Buffer::WriteBufferSize>::LeasedBufferType WriteBufferType;
         typedef ReadWriteBufferArray<Buffer::ReadBufferSize, Buffer::MaximumBuffersForRequestBody> RequestBodyBufferType;
-        typedef ReadWriteBufferArray<Buffer::WriteBufferSize, Buffer::MaximumBuffersForResponse> ResponseBufferType;
         
         explicit HttpConnection(IConnectionManager& connectionManager, HttpRouter& router, 
-            boost::asio::ip::tcp::socket& socket, boost::asio::io_context& context,
+            StreamSocket& socket, boost::asio::io_context& context,
             ReadBufferType&& headerBuffer, ReadBufferPoolType& readBufferPool, WriteBufferPoolType& writeBufferPool,
-            bool trustIpFromXForwardedFor);
+            ResponseOverflowBudget& responseOverflowBudget, bool trustIpFromXForwardedFor);
+
+        void disconnect() override;
 
     protected:
+        boost::asio::mutable_buffer nextReadBuffer() override;
         bool onBytesRead(char* bytes, size_t bytesTransferred) override;
         void onWritten(size_t bytesTransferred) override;
+        void onReadClosed() override;
 
     private:
+        void writeResponseBytes(const char* data, size_t size);
         bool onReadBody(const char* buffer, size_t size);
         void writeStatusCode(HttpStatusCode code);
         void processRequest(HttpRequest& request);
+        void writeResponseBuffers();
+        bool processHttp2(const char* bytes, size_t size);
         boost::asio::ip::address getRemoteAddress(const HttpRequest& request);
 
         HttpRouter& router_;
+        ReadBufferPoolType& readBufferPool_;
+        ResponseOverflowBudget& responseOverflowBudget_;
         ReadBufferType headerBuffer_;
         RequestBodyBufferType requestBodyBuffer_;
-        ResponseBufferType responseBuffer_;
+        ResponseBuffer responseBuffer_;
         HttpResponseBuilder responseBuilder_;
+        //bytes received after the end of the current request, which start the next pipelined request;
+        //they remain in the header buffer, as parsing only ever moves bytes towards its start
+        char* pipelinedBytes_ = nullptr;
+        size_t pipelinedBytesSize_ = 0;
+        bool readingBodyInPlace_ = false;
         bool keepConnectionAlive_ = false;
         bool trustIpFromXForwardedFor_ = false;
+        //HTTP/2 is only detected at the start of a connection, before any HTTP/1.x request
+        bool anyRequestProcessed_ = false;
         Parser parser_;
+        std::unique_ptr<Http2Session> http2Session_;
+        //written in the strand and read by disconnect(), which is called by the thread checking for timeouts
+        std::atomic<bool> waitingForHttp2Frames_{ false };
+        std::atomic<bool> http2TimedOut_{ false };
     };
 }
@@ -41,6 +41,14 @@ namespace Http
 
 #ifndef HTTP_WRITE_BUFFER_SIZE
 #define HTTP_WRITE_BUFFER_SIZE 8192
+#endif
+
+#ifndef HTTP_MAXIMUM_RESPONSE_OVERFLOW_SIZE
+#define HTTP_MAXIMUM_RESPONSE_OVERFLOW_SIZE (64 * 1024 * 1024)
+#endif
+
+#ifndef HTTP_MAXIMUM_TOTAL_RESPONSE_OVERFLOW_SIZE
+#define HTTP_MAXIMUM_TOTAL_RESPONSE_OVERFLOW_SIZE (256 * 1024 * 1024)
 #endif
 
     namespace Buffer
@@ -65,6 +73,15 @@ namespace Http
         * Each response can request multiple buffers
         */
         static constexpr size_t WriteBufferSize = HTTP_WRITE_BUFFER_SIZE;
+        /**
+        * Memory a response can use in addition to its pooled buffers; larger responses are replaced with 500
+        */
+        static constexpr size_t MaximumResponseOverflowSize = HTTP_MAXIMUM_RESPONSE_OVERFLOW_SIZE;
+        /**
+        * Memory all responses can use at once in addition to their pooled buffers; responses that would exceed it
+        * are replaced with 503 until the memory is released
+        */
+        static constexpr size_t MaximumTotalResponseOverflowSize = HTTP_MAXIMUM_TOTAL_RESPONSE_OVERFLOW_SIZE;
     }
 
     enum class HttpVerb
@@ -43,6 +43,42 @@ namespace Http
 
         Parser& process(char* buffer, size_t size);
 
+        /**
+         * Accounts for request body bytes that were received directly into the body storage
+         * instead of being passed to process()
+         */
+        Parser& processStoredBody(size_t size);
+
+        /**
+         * Returns how many bytes of the header buffer are in use
+         */
+        size_t headerSize() const
+        {
+            return headerSize_;
+        }
+
+        /**
+         * Returns whether the headers were parsed and only request body bytes are expected next
+         */
+        bool expectsBody() const
+        {
+            return valid_ && ( ! finished_) && (currentParser_ == &Parser::parseBody);
+        }
+
+        size_t remainingBodyBytes() const
+        {
+            return expectsBody() ? (expectedContentLength_ - requestBodyBytesProcessed_) : 0;
+        }
+
+        /**
+         * Returns how many bytes at the end of the buffer passed to the last process() call were not consumed
+         * because the request was already complete. They belong to the next request on the same connection.
+         */
+        size_t unprocessedBytes() const
+        {
+            return unprocessedBytes_;
+        }
+
         /**
          * Resets the state of the parser, making it ready to start processing a new request
          */
@@ -108,5 +144,6 @@ namespace Http
         size_t expectedContentLength_ = 0;
         size_t maxContentLength_;
         size_t requestBodyBytesProcessed_ = 0;
+        size_t unprocessedBytes_ = 0;
     };
 }
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "HttpConstants.h"
 #include "HttpRequest.h"
+#include "IResponseStorage.h"
 
 #include <cstddef>
 #include <cstdint>
@@ -49,6 +50,34 @@ namespace Http
     */
     size_t writeHttpDateGMT(time_t value, char* output);
 
+    /**
+     * Checks if an If-None-Match header value matches an entity tag using the weak comparison
+     * The header may contain a comma separated list of tags or *
+     */
+    bool entityTagMatches(HttpStringView ifNoneMatch, HttpStringView entityTag);
+
+    enum class ContentEncoding
+    {
+        Identity,
+        Deflate,
+        Gzip
+    };
+
+    /**
+     * Chooses the supported encoding with the highest quality value from an Accept-Encoding header value,
+     * preferring gzip over deflate when both are equally acceptable
+     */
+    ContentEncoding chooseContentEncoding(HttpStringView acceptEncoding);
+
+    struct BodyCompression final
+    {
+        ContentEncoding encoding = ContentEncoding::Identity;
+        //bodies smaller than this are sent as they are, as compressing them saves little
+        size_t minimumSize = 1024;
+        //zlib compression level, from 1 (fastest) to 9 (smallest output)
+        int level = 1;
+    };
+
     struct CookieExtra final
     {
         CookieExtra& expiresAt(const time_t value)
@@ -100,7 +129,10 @@ namespace Http
     public:
         typedef void (*WriteFn)(const char* data, size_t size, void* state);
 
-        HttpResponseBuilder(WriteFn writeFn, void* writeState);
+        /**
+         * @param storage Optional access to where writeFn stores the response, needed for writing bodies in parts
+         */
+        HttpResponseBuilder(WriteFn writeFn, void* writeState, IResponseStorage* storage = nullptr);
 
         void reset()
         {
@@ -143,6 +175,52 @@ namespace Http
         void writeBodyAndContentLength(HttpStringView value);
         void writeBodyAndContentLength(HttpStringView value, HttpStringView prefix);
 
+        /**
+         * Writes the body and its length, compressing prefix + value if the client accepts it and it is large enough
+         * Also writes the Vary header, as the response depends on the Accept-Encoding of the request
+         */
+        void writeBodyAndContentLength(HttpStringView value, HttpStringView prefix, const BodyCompression& compression);
+
+        bool canWriteBodyInParts() const
+        {
+            return nullptr != storage_;
+        }
+
+        /**
+         * Starts a body whose length is only known once it is complete, after the headers
+         * A placeholder is written for the Content-Length, which endBodyInParts() fills in
+         */
+        void startBodyInParts();
+
+        /**
+         * Starts a body written in parts, which is compressed as it is written if the client accepts it
+         * and the size known so far is large enough
+         * Also writes the Vary header, as the response depends on the Accept-Encoding of the request
+         */
+        void startBodyInParts(const BodyCompression& compression, size_t sizeSoFar);
+
+        void writeBodyPart(HttpStringView value);
+
+        /**
+         * Returns free memory after the response, where the next part of the body can be written in place
+         * commitBodyPart() must be called afterwards with the number of bytes written
+         * An empty buffer is returned if the body is compressed, as the response then holds the compressed bytes
+         */
+        boost::asio::mutable_buffer prepareBodyPart();
+        void commitBodyPart(size_t size);
+
+        /**
+         * Finishes a body written in parts and fills in its length
+         * @returns false if the body could not be written completely
+         */
+        bool endBodyInParts();
+
+        /**
+         * Drops everything written for the current response, so that a different one can be written instead
+         * Requires the storage used for writing bodies in parts
+         */
+        void discardResponse();
+
     private:
         void write(const char* data, const size_t size)
         {
@@ -164,11 +242,19 @@ namespace Http
         {
             NothingWritten,
             ResponseCodeWritten,
+            WritingBodyInParts,
             BodyWritten,
         };
 
         ProtocolState protocolState_ = ProtocolState::NothingWritten;
         WriteFn writeFn_;
         void* writeState_;
+        IResponseStorage* storage_;
+        //offsets in the storage
+        size_t responseStart_ = 0;
+        size_t contentLengthValueStart_ = 0;
+        size_t bodyStart_ = 0;
+        bool compressBodyParts_ = false;
+        bool bodyPartsFailed_ = false;
     };
 }
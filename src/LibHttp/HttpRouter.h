@@ -21,9 +21,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "HttpRequest.h"
 #include "HttpResponseBuilder.h"
 
-#include <functional>
-#include <map>
-#include <tuple>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
 
 namespace Http
 {
@@ -46,45 +49,98 @@ namespace Http
         void extractExtraPathParts(size_t nrOfPathCharactersUsedInRoute);
     };
 
+    /**
+     * Plain function pointer plus state, so that dispatching a request needs no type-erased callable
+     */
+    struct RouteHandler final
+    {
+        typedef void (*HandlerFn)(RequestState& requestState, void* state);
+
+        HandlerFn fn = nullptr;
+        void* state = nullptr;
+
+        explicit operator bool() const
+        {
+            return fn != nullptr;
+        }
+
+        void operator()(RequestState& requestState) const
+        {
+            fn(requestState, state);
+        }
+
+        /**
+         * Creates a handler that calls a member function on an object which outlives the router
+         */
+        template<auto Method, typename T>
+        static RouteHandler fromMethod(T& object)
+        {
+            return { [](RequestState& requestState, void* state)
+                     {
+                         (static_cast<T*>(state)->*Method)(requestState);
+                     }, &object };
+        }
+    };
+
     class HttpRouter final : boost::noncopyable
     {
     public:
-        void forward(const HttpRequest& request, HttpResponseBuilder& response);
-
-        typedef std::function<void(RequestState&)> HandlerFn;
+        void forward(const HttpRequest& request, HttpResponseBuilder& response) const;
 
         static const size_t MaxRouteSize = 128;
-        static const size_t FirstIndexMaxValue = 128;
 
         /**
          * Registers a route with a maximum size of MaxRouteSize.
-         * Managing the lifetime of the string view and the handler is the responsibility of the caller
+         * Routes can only be added before the router is frozen
          *
          * @param pathLowerCase Lowercase version of the path to match, with trailing / but without leading /
          * @param verb Verb to match
          * @param handler Handler that will be called if the route is matched.
          *
          */
-        void addRoute(HttpStringView pathLowerCase, HttpVerb verb, HandlerFn&& handler);
+        void addRoute(HttpStringView pathLowerCase, HttpVerb verb, RouteHandler handler);
 
         /**
          * Registers a route to be used if no other route matches
          */
-        void setDefaultRoute(HandlerFn&& handler);
+        void setDefaultRoute(RouteHandler handler);
 
-    private:
+        /**
+         * Compiles the registered routes into a compact trie; must be called before forwarding requests.
+         * Calling it again has no effect
+         */
+        void freeze();
 
-        struct StringViewByLengthGreater
+    private:
+        struct MatchedRoute
         {
-            constexpr bool operator()(HttpStringView first, HttpStringView second) const
-            {
-                return std::make_tuple(first.length(), first) > std::make_tuple(second.length(), second);
-            }
+            const RouteHandler* handler;
+            size_t nrOfPathCharactersUsed;
         };
+        MatchedRoute findRoute(HttpVerb verb, HttpStringView path) const;
 
-        typedef std::map<HttpStringView, HandlerFn, StringViewByLengthGreater> MapType;
-        MapType routes_[FirstIndexMaxValue][static_cast<size_t>(HttpVerb::HTTP_VERBS_COUNT)];
+        struct RouteToAdd
+        {
+            std::string path;
+            size_t handlerIndex;
+        };
+        void addTrieLevel(uint32_t nodeIndex, std::vector<std::pair<HttpStringView, size_t>>& routes);
 
-        HandlerFn defaultRoute_;
+        //the children of a node are stored one after the other in nodes_, with their keys stored at the same indexes
+        //in nodeKeys_, so finding the next node only requires scanning a few consecutive bytes
+        struct TrieNode
+        {
+            uint32_t firstChild = 0;
+            uint16_t nrOfChildren = 0;
+            int16_t handlerIndex = -1;
+        };
+        std::vector<TrieNode> nodes_;
+        std::vector<char> nodeKeys_;
+        uint32_t roots_[static_cast<size_t>(HttpVerb::HTTP_VERBS_COUNT)]{};
+
+        std::vector<RouteToAdd> routesToAdd_[static_cast<size_t>(HttpVerb::HTTP_VERBS_COUNT)];
+        std::vector<RouteHandler> handlers_;
+        RouteHandler defaultRoute_;
+        bool frozen_ = false;
     };
 }
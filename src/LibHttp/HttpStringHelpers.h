@@ -24,6 +24,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <boost/lexical_cast.hpp>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace Http
 {
     typedef std::string_view HttpStringView;
@@ -100,6 +104,46 @@ namespace Http
         view.remove_prefix(toRemove);
     }
 
+    /**
+     * Searches for the first character that is equal to any of Chars
+     *
+     * @return A pointer to the character found or end if there is none
+     */
+    template<char... Chars>
+    const char* findFirstOf(const char* begin, const char* end)
+    {
+#ifdef __SSE2__
+        //compare 16 bytes at a time against each of the searched characters
+        while ((end - begin) >= 16)
+        {
+            const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            auto matches = _mm_setzero_si128();
+            ((matches = _mm_or_si128(matches, _mm_cmpeq_epi8(block, _mm_set1_epi8(Chars)))), ...);
+
+            const auto matchMask = _mm_movemask_epi8(matches);
+            if (matchMask)
+            {
+                return begin + __builtin_ctz(static_cast<unsigned>(matchMask));
+            }
+            begin += 16;
+        }
+#endif
+        for (; begin != end; ++begin)
+        {
+            if (((*begin == Chars) || ...))
+            {
+                return begin;
+            }
+        }
+        return end;
+    }
+
+    template<char... Chars>
+    char* findFirstOf(char* begin, char* end)
+    {
+        return const_cast<char*>(findFirstOf<Chars...>(static_cast<const char*>(begin), static_cast<const char*>(end)));
+    }
+
     static constexpr unsigned char CharToLower[] =
     {
           0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,  15,
@@ -22,6 +22,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 namespace Http
 {
+    /**
+     * Connections may be accepted on TCP as well as on local (AF_UNIX) stream sockets
+     */
+    using StreamSocket = boost::asio::generic::stream_protocol::socket;
+
     class IConnectionManager
     {
     public:
@@ -35,9 +40,13 @@ namespace Http
 
         using ConnectionIdentifier = void*;
 
-        virtual ConnectionIdentifier newConnection(IConnectionManager* manager, boost::asio::ip::tcp::socket&& socket) = 0;
+        virtual ConnectionIdentifier newConnection(IConnectionManager* manager, StreamSocket&& socket) = 0;
         virtual void closeConnection(ConnectionIdentifier identifier) = 0;
         virtual void disconnectConnection(ConnectionIdentifier identifier) = 0;
+        /**
+         * Postpones the timeout of a long lived connection that is still in use
+         */
+        virtual void refreshConnection(ConnectionIdentifier /*identifier*/) {}
         virtual void stop() {}
     };
 }
\ No newline at end of file
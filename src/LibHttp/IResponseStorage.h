@@ -0,0 +1,110 @@
+/*
+Fast Forum Backend
+Copyright (C) Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include <boost/asio/buffer.hpp>
+
+namespace Http
+{
+    /**
+     * Storage of responses that allows writing bodies in place and going back to fill in values which are only
+     * known once the body is complete, such as its length
+     */
+    class IResponseStorage
+    {
+    public:
+        virtual ~IResponseStorage() = default;
+
+        /**
+         * Returns the number of bytes stored
+         */
+        virtual size_t size() const = 0;
+
+        /**
+         * Returns free memory after the stored bytes, or an empty buffer if no more bytes can be stored
+         * commit() must be called afterwards with the number of bytes written
+         */
+        virtual boost::asio::mutable_buffer prepare() = 0;
+
+        /**
+         * Marks bytes written to the memory returned by prepare() as stored
+         */
+        virtual void commit(size_t size) = 0;
+
+        /**
+         * Replaces bytes that were already stored
+         */
+        virtual void overwrite(size_t offset, const char* data, size_t size) = 0;
+
+        /**
+         * Drops the stored bytes that follow the first ones
+         */
+        virtual void truncate(size_t size) = 0;
+    };
+
+    /**
+     * Keeps a response in a vector, which grows as needed
+     */
+    class VectorResponseStorage final : public IResponseStorage
+    {
+    public:
+        explicit VectorResponseStorage(std::vector<char>& output) : output_(output)
+        {}
+
+        size_t size() const override
+        {
+            return output_.size() - prepared_;
+        }
+
+        boost::asio::mutable_buffer prepare() override
+        {
+            constexpr size_t BlockSize = 16384;
+
+            output_.resize(output_.size() - prepared_ + BlockSize);
+            prepared_ = BlockSize;
+            return boost::asio::mutable_buffer(output_.data() + output_.size() - BlockSize, BlockSize);
+        }
+
+        void commit(const size_t size) override
+        {
+            output_.resize(output_.size() - prepared_ + size);
+            prepared_ = 0;
+        }
+
+        void overwrite(const size_t offset, const char* data, const size_t size) override
+        {
+            std::copy(data, data + size, output_.data() + offset);
+        }
+
+        void truncate(const size_t size) override
+        {
+            output_.resize(size);
+            prepared_ = 0;
+        }
+
+    private:
+        std::vector<char>& output_;
+        //bytes added by prepare() that are not yet committed
+        size_t prepared_ = 0;
+    };
+}
@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <algorithm>
 #include <array>
+#include <cassert>
 #include <cstddef>
 
 #include <boost/noncopyable.hpp>
@@ -76,6 +77,67 @@ namespace Http
             return true;
         }
 
+        /**
+         * Returns the free space after the stored data, leasing a new buffer if needed, so that data can be
+         * received directly into it. commit() must be called afterwards with the number of bytes written.
+         * An empty buffer is returned if there is no more room.
+         */
+        boost::asio::mutable_buffer prepare()
+        {
+            if ((latestBuffer_ < 0) || (usedBytesInLatestBuffer_ >= BufferSize))
+            {
+                if ( ! requestNewBuffer())
+                {
+                    notEnoughRoom_ = true;
+                    return {};
+                }
+            }
+            return boost::asio::mutable_buffer(buffers_[latestBuffer_]->data + usedBytesInLatestBuffer_,
+                                               BufferSize - usedBytesInLatestBuffer_);
+        }
+
+        /**
+         * Marks bytes written to the buffer returned by prepare() as stored
+         */
+        void commit(const size_t size)
+        {
+            usedBytesInLatestBuffer_ += size;
+        }
+
+        /**
+         * Replaces stored bytes, starting at the specified offset
+         */
+        void overwrite(size_t offset, const char* input, size_t size)
+        {
+            assert((offset + size) <= this->size());
+
+            while (size > 0)
+            {
+                const auto offsetInBuffer = offset % BufferSize;
+                const auto toCopy = std::min(BufferSize - offsetInBuffer, size);
+                std::copy(input, input + toCopy, buffers_[offset / BufferSize]->data + offsetInBuffer);
+                input += toCopy;
+                offset += toCopy;
+                size -= toCopy;
+            }
+        }
+
+        /**
+         * Keeps only the first bytes, returning the buffers that are no longer needed to the pool
+         */
+        void truncate(const size_t size)
+        {
+            if (size >= this->size()) return;
+
+            const auto buffersToKeep = static_cast<int>((size + BufferSize - 1) / BufferSize);
+            for (int i = buffersToKeep; i <= latestBuffer_; ++i)
+            {
+                buffers_[i] = {};
+            }
+            latestBuffer_ = buffersToKeep - 1;
+            usedBytesInLatestBuffer_ = (buffersToKeep > 0) ? (size - latestBuffer_ * BufferSize) : 0;
+        }
+
         /**
          * Returns the size of data stored in the buffers
          */
@@ -86,6 +148,14 @@ namespace Http
             return latestBuffer_ * BufferSize + usedBytesInLatestBuffer_;
         }
 
+        /**
+         * Returns the number of buffers leased from the pool
+         */
+        size_t nrOfBuffers() const
+        {
+            return static_cast<size_t>(latestBuffer_ + 1);
+        }
+
         bool notEnoughRoom() const
         {
             return notEnoughRoom_;
@@ -0,0 +1,197 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "FixedSizeBufferPool.h"
+#include "HttpConstants.h"
+#include "IResponseStorage.h"
+#include "ReadWriteBufferArray.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <boost/asio/buffer.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace Http
+{
+    /**
+     * Limits the heap memory used at the same time by all responses that do not fit in the pooled write buffers
+     */
+    class ResponseOverflowBudget final : boost::noncopyable
+    {
+    public:
+        explicit ResponseOverflowBudget(size_t maxSize = Buffer::MaximumTotalResponseOverflowSize);
+
+        bool tryReserve(size_t size);
+        void release(size_t size);
+
+        size_t used() const
+        {
+            return used_;
+        }
+
+    private:
+        const size_t maxSize_;
+        std::atomic<size_t> used_{ 0 };
+    };
+
+    /**
+     * Collects a response before it is written to the socket
+     * Pooled buffers are used first. What does not fit in them is kept in heap memory which is limited per response
+     * and reserved from a budget shared by all connections, so large responses succeed with bounded memory.
+     */
+    class ResponseBuffer final : public IResponseStorage, boost::noncopyable
+    {
+    public:
+        typedef FixedSizeBufferPool<Buffer::WriteBufferSize> WriteBufferPoolType;
+        typedef ReadWriteBufferArray<Buffer::WriteBufferSize, Buffer::MaximumBuffersForResponse> PooledBufferType;
+
+        ResponseBuffer(WriteBufferPoolType& writeBufferPool, ResponseOverflowBudget& overflowBudget,
+                       size_t maxOverflowSize = Buffer::MaximumResponseOverflowSize);
+        ~ResponseBuffer() override;
+
+        /**
+         * Appends data to the response
+         * @returns false if the response can no longer be stored; errorCode() tells what to send instead
+         */
+        bool write(const char* data, size_t size);
+
+        size_t size() const override
+        {
+            return pooled_.size() + overflowSize_;
+        }
+
+        size_t overflowSize() const
+        {
+            return overflowSize_;
+        }
+
+        /**
+         * Returns free memory in the pooled buffers or, once they are used up, in the overflow
+         * An empty buffer is returned if the response can no longer be stored
+         */
+        boost::asio::mutable_buffer prepare() override;
+        void commit(size_t size) override;
+        void overwrite(size_t offset, const char* data, size_t size) override;
+        void truncate(size_t size) override;
+
+        bool failed() const
+        {
+            return HttpStatusCode::OK != errorCode_;
+        }
+
+        /**
+         * 500 if the response is larger than allowed, 503 if the shared overflow budget is exhausted
+         */
+        HttpStatusCode errorCode() const
+        {
+            return errorCode_;
+        }
+
+        PooledBufferType::ConstBufferWrapper pooledBuffers() const
+        {
+            return pooled_.constBufferWrapper();
+        }
+
+        /**
+         * Appends all buffers to be sent to the output, in order
+         */
+        void getBuffers(std::vector<boost::asio::const_buffer>& output) const;
+
+        /**
+         * Returns the pooled buffers and the reserved overflow memory, making the object ready for a new response
+         */
+        void reset();
+
+    private:
+        bool reserveOverflow(size_t required);
+
+        PooledBufferType pooled_;
+        ResponseOverflowBudget& overflowBudget_;
+        const size_t maxOverflowSize_;
+        std::unique_ptr<char[]> overflow_;
+        size_t overflowSize_ = 0;
+        size_t overflowReserved_ = 0;
+        //if the memory last returned by prepare() is in the pooled buffers
+        bool preparedPooled_ = false;
+        HttpStatusCode errorCode_ = HttpStatusCode::OK;
+    };
+
+    /**
+     * Collects a response in a vector whose size is limited and reserved from the shared overflow budget
+     * Used where responses are kept until they can be sent, such as HTTP/2 streams waiting for flow control windows
+     */
+    class BudgetedResponseStorage final : public IResponseStorage, boost::noncopyable
+    {
+    public:
+        BudgetedResponseStorage(std::vector<char>& output, ResponseOverflowBudget& overflowBudget,
+                                size_t maxSize = Buffer::MaximumResponseOverflowSize);
+        ~BudgetedResponseStorage() override;
+
+        /**
+         * Appends data to the response
+         * @returns false if the response is larger than allowed or the budget is exhausted
+         */
+        bool write(const char* data, size_t size);
+
+        size_t size() const override
+        {
+            return output_.size() - prepared_;
+        }
+
+        boost::asio::mutable_buffer prepare() override;
+        void commit(size_t size) override;
+        void overwrite(size_t offset, const char* data, size_t size) override;
+        void truncate(size_t size) override;
+
+        bool failed() const
+        {
+            return failed_;
+        }
+
+        /**
+         * Hands the reservation of the stored bytes to the caller, who needs to release it from the budget
+         * once the bytes are no longer needed
+         */
+        size_t takeReservation()
+        {
+            return std::exchange(reserved_, 0);
+        }
+
+        /**
+         * Clears the stored bytes and returns their reservation, making the object ready for a new response
+         */
+        void reset();
+
+    private:
+        bool reserve(size_t required);
+
+        std::vector<char>& output_;
+        ResponseOverflowBudget& overflowBudget_;
+        const size_t maxSize_;
+        size_t reserved_ = 0;
+        //bytes added by prepare() that are not yet committed
+        size_t prepared_ = 0;
+        bool failed_ = false;
+    };
+}
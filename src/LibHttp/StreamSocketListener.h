@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <string_view>
 
 #include <boost/noncopyable.hpp>
@@ -29,12 +30,21 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 namespace Http
 {
-    class TcpListener final : boost::noncopyable
+    /**
+     * Accepts stream connections either on a TCP address and port or on a local (AF_UNIX) socket path
+     */
+    class StreamSocketListener final : boost::noncopyable
     {
     public:
-        explicit TcpListener(boost::asio::io_service& ioService, std::string_view listenIpAddress, uint16_t listenPort,
+        explicit StreamSocketListener(boost::asio::io_service& ioService, std::string_view listenIpAddress,
+            uint16_t listenPort, std::shared_ptr<IConnectionManager> connectionManager);
+        /**
+         * Listens on a local socket; a socket file already present at the path is replaced,
+         * while any other kind of file makes startListening() throw
+         */
+        explicit StreamSocketListener(boost::asio::io_service& ioService, std::string_view unixSocketPath,
             std::shared_ptr<IConnectionManager> connectionManager);
-        ~TcpListener();
+        ~StreamSocketListener();
 
         void startListening();
         void stopListening();
@@ -43,11 +53,11 @@ namespace Http
 
         void startAccept();
         void onAccept(const boost::system::error_code& ec);
-        
-        boost::asio::ip::address listenIpAddress_;
-        uint16_t listenPort_;
-        boost::asio::ip::tcp::acceptor acceptor_;
-        boost::asio::ip::tcp::socket currentSocket_;
+
+        boost::asio::generic::stream_protocol::endpoint endpoint_;
+        std::string unixSocketPath_;
+        boost::asio::basic_socket_acceptor<boost::asio::generic::stream_protocol> acceptor_;
+        StreamSocket currentSocket_;
         std::shared_ptr<IConnectionManager> connectionManager_;
         bool listening_;
     };
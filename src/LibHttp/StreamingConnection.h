@@ -28,15 +28,28 @@ namespace Http
     class StreamingConnection : boost::noncopyable
     {
     public:
-        StreamingConnection(IConnectionManager& connectionManager, boost::asio::ip::tcp::socket&& socket, 
+        StreamingConnection(IConnectionManager& connectionManager, StreamSocket&& socket, 
                             boost::asio::io_context& context);
         virtual ~StreamingConnection() = default;
 
         void startReading();
-        void disconnect();
+        /**
+         * Called from outside the strand of the connection, e.g. when it times out
+         */
+        virtual void disconnect();
 
     protected:
         void release();
+        void refreshTimeout();
+        /**
+         * Called when the peer closed its side of the connection or it was shut down for reading
+         */
+        virtual void onReadClosed();
+        /**
+         * Returns where the next bytes received from the socket are to be stored and how many may be read at once
+         */
+        virtual boost::asio::mutable_buffer nextReadBuffer();
+
         virtual bool onBytesRead(char* bytes, size_t bytesTransferred) = 0;
         virtual void onWritten(size_t bytesTransferred) = 0;
 
@@ -53,16 +66,16 @@ namespace Http
             });
         }     
 
-        boost::asio::ip::tcp::socket socket_;
+        StreamSocket socket_;
         std::array<char, 1024> readBuffer_{};
 
     private:
-        void onRead(const boost::system::error_code& ec, size_t bytesTransferred);
+        void onRead(const boost::system::error_code& ec, char* bytes, size_t bytesTransferred);
         void onWritten(const boost::system::error_code& ec, size_t bytesTransferred);
 
         boost::asio::io_service::strand strand_;
         IConnectionManager& connectionManager_;
     };
 
-    void closeSocket(boost::asio::ip::tcp::socket& socket);
+    void closeSocket(StreamSocket& socket);
 }
@@ -65,6 +65,25 @@ namespace Http
             collection_.insert(std::make_pair(element, expiresAt));
         }
 
+        /**
+         * Changes when an element expires, unless it already did
+         */
+        void refreshExpireIn(T element, const Timestamp expiresIn)
+        {
+            const auto expiresAt = getTimeSinceEpoch() + expiresIn;
+
+            std::lock_guard<decltype(mutex_)> lock(mutex_);
+
+            auto& index = collection_.template get<TimeoutManagerCollectionByElement>();
+
+            auto it = index.find(element);
+            if (it == index.end())
+            {
+                return;
+            }
+            index.modify(it, [expiresAt](EntryPair& entry) { entry.second = expiresAt; });
+        }
+
         void remove(T element)
         {
             std::lock_guard<decltype(mutex_)> lock(mutex_);
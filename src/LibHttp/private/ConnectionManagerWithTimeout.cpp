@@ -36,7 +36,7 @@ ConnectionManagerWithTimeout::ConnectionManagerWithTimeout(boost::asio::io_servi
 }
 
 IConnectionManager::ConnectionIdentifier ConnectionManagerWithTimeout::newConnection(IConnectionManager* manager,
-    boost::asio::ip::tcp::socket&& socket)
+    StreamSocket&& socket)
 {
     const auto result = delegateTo_->newConnection(manager ? manager : this, std::move(socket));
 
@@ -64,6 +64,11 @@ void ConnectionManagerWithTimeout::disconnectConnection(const ConnectionIdentifi
     delegateTo_->disconnectConnection(identifier);
 }
 
+void ConnectionManagerWithTimeout::refreshConnection(const ConnectionIdentifier identifier)
+{
+    timeoutManager_.refreshExpireIn(identifier, timeoutManager_.defaultTimeout());
+}
+
 void ConnectionManagerWithTimeout::stop()
 {
     boost::asio::dispatch(timeoutTimer_.get_executor(), [&]
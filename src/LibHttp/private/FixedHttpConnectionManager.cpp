@@ -28,10 +28,13 @@ FixedHttpConnectionManager::FixedHttpConnectionManager(boost::asio::io_context&
     readBuffers_{ std::make_unique<HttpConnection::ReadBufferPoolType>(numberOfReadBuffers) },
     writeBuffers_{ std::make_unique<HttpConnection::WriteBufferPoolType>(numberOfWriteBuffers) },
     trustIpFromXForwardedFor_{ trustIpFromXForwardedFor }
-{}
+{
+    //all routes are known by the time connections are accepted
+    httpRouter_->freeze();
+}
 
 IConnectionManager::ConnectionIdentifier FixedHttpConnectionManager::newConnection(IConnectionManager* manager,
-    boost::asio::ip::tcp::socket&& socket)
+    StreamSocket&& socket)
 {
     ConnectionIdentifier result = nullptr;
 
@@ -44,7 +47,8 @@ IConnectionManager::ConnectionIdentifier FixedHttpConnectionManager::newConnecti
     if (headerBuffer)
     {
         auto connection = connectionPool_.getObject(*manager, *httpRouter_, socket, context_,
-            std::move(headerBuffer), *readBuffers_, *writeBuffers_, trustIpFromXForwardedFor_);
+            std::move(headerBuffer), *readBuffers_, *writeBuffers_, responseOverflowBudget_,
+            trustIpFromXForwardedFor_);
         if (nullptr != connection)
         {
             closeConnection = false;
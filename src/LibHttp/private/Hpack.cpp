@@ -0,0 +1,415 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Hpack.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <iterator>
+
+using namespace Http;
+using namespace Http::Hpack;
+
+namespace
+{
+    struct StaticEntry
+    {
+        HttpStringView name;
+        HttpStringView value;
+    };
+
+    //https://tools.ietf.org/html/rfc7541#appendix-A, index 0 is unused
+    constexpr StaticEntry StaticTable[] =
+    {
+        { "", "" },
+        { ":authority", "" },
+        { ":method", "GET" },
+        { ":method", "POST" },
+        { ":path", "/" },
+        { ":path", "/index.html" },
+        { ":scheme", "http" },
+        { ":scheme", "https" },
+        { ":status", "200" },
+        { ":status", "204" },
+        { ":status", "206" },
+        { ":status", "304" },
+        { ":status", "400" },
+        { ":status", "404" },
+        { ":status", "500" },
+        { "accept-charset", "" },
+        { "accept-encoding", "gzip, deflate" },
+        { "accept-language", "" },
+        { "accept-ranges", "" },
+        { "accept", "" },
+        { "access-control-allow-origin", "" },
+        { "age", "" },
+        { "allow", "" },
+        { "authorization", "" },
+        { "cache-control", "" },
+        { "content-disposition", "" },
+        { "content-encoding", "" },
+        { "content-language", "" },
+        { "content-length", "" },
+        { "content-location", "" },
+        { "content-range", "" },
+        { "content-type", "" },
+        { "cookie", "" },
+        { "date", "" },
+        { "etag", "" },
+        { "expect", "" },
+        { "expires", "" },
+        { "from", "" },
+        { "host", "" },
+        { "if-match", "" },
+        { "if-modified-since", "" },
+        { "if-none-match", "" },
+        { "if-range", "" },
+        { "if-unmodified-since", "" },
+        { "last-modified", "" },
+        { "link", "" },
+        { "location", "" },
+        { "max-forwards", "" },
+        { "proxy-authenticate", "" },
+        { "proxy-authorization", "" },
+        { "range", "" },
+        { "referer", "" },
+        { "refresh", "" },
+        { "retry-after", "" },
+        { "server", "" },
+        { "set-cookie", "" },
+        { "strict-transport-security", "" },
+        { "transfer-encoding", "" },
+        { "user-agent", "" },
+        { "vary", "" },
+        { "via", "" },
+        { "www-authenticate", "" },
+    };
+
+    constexpr size_t StaticTableSize = std::size(StaticTable) - 1;
+    constexpr size_t StatusIndex = 8;
+
+    //each entry of the dynamic table is accounted with an overhead of 32 bytes
+    constexpr size_t EntryOverhead = 32;
+
+    /*
+     * The Huffman code from https://tools.ietf.org/html/rfc7541#appendix-B is canonical,
+     * so it can be decoded knowing only how many codes have each length and the symbols sorted by their code
+     */
+    constexpr size_t MaxHuffmanCodeLength = 30;
+
+    constexpr uint16_t HuffmanCodesWithLength[MaxHuffmanCodeLength + 1] =
+    {
+        0, 0, 0, 0, 0, 10, 26, 32, 6, 0, 5, 3, 2, 6, 2, 3, 0, 0, 0, 3, 8, 13, 26, 29, 12, 4, 15, 19, 29, 0, 3
+    };
+
+    constexpr uint8_t HuffmanSymbolsSortedByCode[256] =
+    {
+         48,  49,  50,  97,  99, 101, 105, 111, 115, 116,  32,  37,  45,  46,  47,  51,
+         52,  53,  54,  55,  56,  57,  61,  65,  95,  98, 100, 102, 103, 104, 108, 109,
+        110, 112, 114, 117,  58,  66,  67,  68,  69,  70,  71,  72,  73,  74,  75,  76,
+         77,  78,  79,  80,  81,  82,  83,  84,  85,  86,  87,  89, 106, 107, 113, 118,
+        119, 120, 121, 122,  38,  42,  44,  59,  88,  90,  33,  34,  40,  41,  63,  39,
+         43, 124,  35,  62,   0,  36,  64,  91,  93, 126,  94, 125,  60,  96, 123,  92,
+        195, 208, 128, 130, 131, 162, 184, 194, 224, 226, 153, 161, 167, 172, 176, 177,
+        179, 209, 216, 217, 227, 229, 230, 129, 132, 133, 134, 136, 146, 154, 156, 160,
+        163, 164, 169, 170, 173, 178, 181, 185, 186, 187, 189, 190, 196, 198, 228, 232,
+        233,   1, 135, 137, 138, 139, 140, 141, 143, 147, 149, 150, 151, 152, 155, 157,
+        158, 165, 166, 168, 174, 175, 180, 182, 183, 188, 191, 197, 231, 239,   9, 142,
+        144, 145, 148, 159, 171, 206, 215, 225, 236, 237, 199, 207, 234, 235, 192, 193,
+        200, 201, 202, 205, 210, 213, 218, 219, 238, 240, 242, 243, 255, 203, 204, 211,
+        212, 214, 221, 222, 223, 241, 244, 245, 246, 247, 248, 250, 251, 252, 253, 254,
+          2,   3,   4,   5,   6,   7,   8,  11,  12,  14,  15,  16,  17,  18,  19,  20,
+         21,  23,  24,  25,  26,  27,  28,  29,  30,  31, 127, 220, 249,  10,  13,  22,
+    };
+
+    bool decodeInteger(const uint8_t*& current, const uint8_t* end, const uint8_t prefixBits, size_t& result)
+    {
+        if (current >= end) return false;
+
+        const uint8_t mask = static_cast<uint8_t>((1u << prefixBits) - 1);
+        result = *current++ & mask;
+        if (result < mask) return true;
+
+        for (unsigned shift = 0; current < end; shift += 7)
+        {
+            //values this large are never needed and would overflow
+            if (shift > 28) return false;
+
+            const auto byte = *current++;
+            result += static_cast<size_t>(byte & 0x7F) << shift;
+            if (0 == (byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    bool decodeString(const uint8_t*& current, const uint8_t* end, std::string& buffer, HttpStringView& result)
+    {
+        if (current >= end) return false;
+
+        const auto huffmanEncoded = 0 != (*current & 0x80);
+        size_t length;
+        if ( ! decodeInteger(current, end, 7, length)) return false;
+        if (length > static_cast<size_t>(end - current)) return false;
+
+        const auto data = reinterpret_cast<const char*>(current);
+        current += length;
+
+        if ( ! huffmanEncoded)
+        {
+            //no need to copy anything
+            result = HttpStringView(data, length);
+            return true;
+        }
+        buffer.clear();
+        if ( ! decodeHuffman(data, length, buffer)) return false;
+
+        result = buffer;
+        return true;
+    }
+
+    void encodeInteger(size_t value, const uint8_t prefixBits, const uint8_t flags, std::vector<char>& output)
+    {
+        const size_t mask = (1u << prefixBits) - 1;
+        if (value < mask)
+        {
+            output.push_back(static_cast<char>(flags | value));
+            return;
+        }
+        output.push_back(static_cast<char>(flags | mask));
+        value -= mask;
+        while (value >= 0x80)
+        {
+            output.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        output.push_back(static_cast<char>(value));
+    }
+
+    void encodeString(const HttpStringView value, std::vector<char>& output)
+    {
+        encodeInteger(value.size(), 7, 0, output);
+        output.insert(output.end(), value.begin(), value.end());
+    }
+}
+
+bool Hpack::decodeHuffman(const char* data, const size_t size, std::string& output)
+{
+    int code = 0;
+    int first = 0;
+    size_t index = 0;
+    size_t length = 0;
+    bool onlyOnes = true;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        const auto byte = static_cast<uint8_t>(data[i]);
+        for (int bit = 7; bit >= 0; --bit)
+        {
+            const int bitValue = (byte >> bit) & 1;
+            code |= bitValue;
+            onlyOnes = onlyOnes && (1 == bitValue);
+            ++length;
+
+            const int count = HuffmanCodesWithLength[length];
+            if ((code - first) < count)
+            {
+                output.push_back(static_cast<char>(HuffmanSymbolsSortedByCode[index + (code - first)]));
+                code = first = 0;
+                index = length = 0;
+                onlyOnes = true;
+                continue;
+            }
+            if (length >= MaxHuffmanCodeLength)
+            {
+                //also rejects the EOS symbol
+                return false;
+            }
+            index += count;
+            first = (first + count) << 1;
+            code <<= 1;
+        }
+    }
+    //the last byte is padded with at most 7 bits from the start of EOS, which has all bits set
+    return (length < 8) && onlyOnes;
+}
+
+Decoder::Decoder(const size_t maxDynamicTableSize)
+    : maxDynamicTableSize_(maxDynamicTableSize), currentMaxDynamicTableSize_(maxDynamicTableSize)
+{}
+
+bool Decoder::decode(const char* data, const size_t size, const OnHeaderFn onHeader, void* state)
+{
+    auto current = reinterpret_cast<const uint8_t*>(data);
+    const auto end = current + size;
+    bool fieldsDecoded = false;
+
+    while (current < end)
+    {
+        const auto firstByte = *current;
+        HttpStringView name, value;
+
+        if (firstByte & 0x80)
+        {
+            //indexed header field
+            size_t index;
+            if ( ! decodeInteger(current, end, 7, index)) return false;
+            if ( ! getEntry(index, name, value)) return false;
+        }
+        else if (0x20 == (firstByte & 0xE0))
+        {
+            //dynamic table size update, only allowed before the first field of a block
+            size_t newSize;
+            if (fieldsDecoded || ! decodeInteger(current, end, 5, newSize)) return false;
+            if (newSize > maxDynamicTableSize_) return false;
+
+            currentMaxDynamicTableSize_ = newSize;
+            evictUntilAtMost(newSize);
+            continue;
+        }
+        else
+        {
+            //literal header field, with incremental indexing (01), without indexing (0000) or never indexed (0001)
+            const auto addToTable = 0x40 == (firstByte & 0xC0);
+            size_t index;
+            if ( ! decodeInteger(current, end, addToTable ? 6 : 4, index)) return false;
+            if (index > 0)
+            {
+                HttpStringView ignore;
+                if ( ! getEntry(index, name, ignore)) return false;
+            }
+            else if ( ! decodeString(current, end, nameBuffer_, name))
+            {
+                return false;
+            }
+            if ( ! decodeString(current, end, valueBuffer_, value)) return false;
+
+            if (addToTable)
+            {
+                //may evict the entry the name refers to, so the views must be consumed first
+                const auto keepGoing = onHeader(name, value, state);
+                addEntry(name, value);
+                fieldsDecoded = true;
+                if ( ! keepGoing) return true;
+                continue;
+            }
+        }
+        fieldsDecoded = true;
+        if ( ! onHeader(name, value, state)) return true;
+    }
+    return true;
+}
+
+bool Decoder::getEntry(const size_t index, HttpStringView& name, HttpStringView& value) const
+{
+    if (0 == index) return false;
+
+    if (index <= StaticTableSize)
+    {
+        name = StaticTable[index].name;
+        value = StaticTable[index].value;
+        return true;
+    }
+    const auto dynamicIndex = index - StaticTableSize - 1;
+    if (dynamicIndex >= dynamicTable_.size()) return false;
+
+    const auto& entry = dynamicTable_[dynamicIndex];
+    name = entry.name;
+    value = entry.value;
+    return true;
+}
+
+void Decoder::addEntry(const HttpStringView name, const HttpStringView value)
+{
+    const auto entrySize = name.size() + value.size() + EntryOverhead;
+    if (entrySize > currentMaxDynamicTableSize_)
+    {
+        //an entry larger than the table empties it
+        evictUntilAtMost(0);
+        return;
+    }
+    //copy before evicting as the name might be one of the evicted entries
+    Entry entry{ std::string(name), std::string(value) };
+
+    evictUntilAtMost(currentMaxDynamicTableSize_ - entrySize);
+    dynamicTable_.push_front(std::move(entry));
+    dynamicTableSize_ += entrySize;
+}
+
+void Decoder::evictUntilAtMost(const size_t size)
+{
+    while (dynamicTableSize_ > size)
+    {
+        assert( ! dynamicTable_.empty());
+        const auto& oldest = dynamicTable_.back();
+        dynamicTableSize_ -= oldest.name.size() + oldest.value.size() + EntryOverhead;
+        dynamicTable_.pop_back();
+    }
+}
+
+void Hpack::encodeStatus(const uint16_t code, std::vector<char>& output)
+{
+    char digits[3];
+    digits[0] = static_cast<char>('0' + (code / 100) % 10);
+    digits[1] = static_cast<char>('0' + (code / 10) % 10);
+    digits[2] = static_cast<char>('0' + code % 10);
+    const HttpStringView codeString(digits, std::size(digits));
+
+    for (size_t i = StatusIndex; (i <= StaticTableSize) && (":status" == StaticTable[i].name); ++i)
+    {
+        if (codeString == StaticTable[i].value)
+        {
+            encodeInteger(i, 7, 0x80, output);
+            return;
+        }
+    }
+    encodeInteger(StatusIndex, 4, 0, output);
+    encodeString(codeString, output);
+}
+
+void Hpack::encodeHeader(const HttpStringView name, const HttpStringView value, std::vector<char>& output)
+{
+    const auto toLower = [](const char c)
+    {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    };
+
+    //names in the static table are lowercase
+    size_t nameIndex = 0;
+    for (size_t i = 1; i <= StaticTableSize; ++i)
+    {
+        const auto tableName = StaticTable[i].name;
+        if ((tableName.size() == name.size())
+            && std::equal(name.begin(), name.end(), tableName.begin(), [&toLower](const char first, const char second)
+                {
+                    return toLower(first) == second;
+                }))
+        {
+            nameIndex = i;
+            break;
+        }
+    }
+    encodeInteger(nameIndex, 4, 0, output);
+    if (0 == nameIndex)
+    {
+        //convert the name while copying it, so that names of any length are kept entirely
+        encodeInteger(name.size(), 7, 0, output);
+        std::transform(name.begin(), name.end(), std::back_inserter(output), toLower);
+    }
+    encodeString(value, output);
+}
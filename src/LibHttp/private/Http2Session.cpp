@@ -0,0 +1,1100 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Http2Session.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+using namespace Http;
+
+namespace
+{
+    //https://tools.ietf.org/html/rfc7540#section-6
+    namespace FrameType
+    {
+        enum : uint8_t
+        {
+            Data = 0x0,
+            Headers = 0x1,
+            Priority = 0x2,
+            ResetStream = 0x3,
+            Settings = 0x4,
+            PushPromise = 0x5,
+            Ping = 0x6,
+            GoAway = 0x7,
+            WindowUpdate = 0x8,
+            Continuation = 0x9
+        };
+    }
+
+    namespace FrameFlag
+    {
+        enum : uint8_t
+        {
+            EndStream = 0x1,
+            Ack = 0x1,
+            EndHeaders = 0x4,
+            Padded = 0x8,
+            Priority = 0x20
+        };
+    }
+
+    //https://tools.ietf.org/html/rfc7540#section-7
+    namespace ErrorCode
+    {
+        enum : uint32_t
+        {
+            NoError = 0x0,
+            ProtocolError = 0x1,
+            InternalError = 0x2,
+            FlowControlError = 0x3,
+            StreamClosed = 0x5,
+            FrameSizeError = 0x6,
+            RefusedStream = 0x7,
+            CompressionError = 0x9,
+            EnhanceYourCalm = 0xB
+        };
+    }
+
+    namespace SettingId
+    {
+        enum : uint16_t
+        {
+            HeaderTableSize = 0x1,
+            EnablePush = 0x2,
+            MaxConcurrentStreams = 0x3,
+            InitialWindowSize = 0x4,
+            MaxFrameSize = 0x5,
+            MaxHeaderListSize = 0x6
+        };
+    }
+
+    constexpr size_t FrameHeaderSize = 9;
+    constexpr size_t SettingSize = 6;
+    constexpr size_t DefaultMaxFrameSize = 16384;
+    constexpr size_t MaxAllowedFrameSize = 16777215;
+    constexpr int64_t DefaultWindowSize = 65535;
+    constexpr int64_t MaxWindowSize = 0x7FFFFFFF;
+    //the decoded headers need to fit into a single buffer anyway
+    constexpr size_t MaxHeaderBlockSize = 4 * Buffer::ReadBufferSize;
+    //the client can send an entire request body without waiting for WINDOW_UPDATE frames on the stream
+    constexpr uint32_t InitialWindowSizeForClient =
+            static_cast<uint32_t>(std::min<size_t>(Buffer::MaxRequestBodyLength, MaxWindowSize));
+    //large responses are rare, don't keep their memory around
+    constexpr size_t MaxPendingDataCapacityToKeep = 1 << 20;
+    //advertised as SETTINGS_MAX_HEADER_LIST_SIZE, the converted request needs to fit in a read buffer anyway
+    constexpr size_t MaxDecodedHeaderListSize = Buffer::ReadBufferSize;
+    //https://tools.ietf.org/html/rfc7540#section-6.5.2
+    constexpr size_t HeaderFieldOverhead = 32;
+
+    uint32_t readUInt16(const char* data)
+    {
+        const auto bytes = reinterpret_cast<const uint8_t*>(data);
+        return (static_cast<uint32_t>(bytes[0]) << 8) | bytes[1];
+    }
+
+    uint32_t readUInt24(const char* data)
+    {
+        const auto bytes = reinterpret_cast<const uint8_t*>(data);
+        return (static_cast<uint32_t>(bytes[0]) << 16) | (static_cast<uint32_t>(bytes[1]) << 8) | bytes[2];
+    }
+
+    uint32_t readUInt32(const char* data)
+    {
+        const auto bytes = reinterpret_cast<const uint8_t*>(data);
+        return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16)
+             | (static_cast<uint32_t>(bytes[2]) << 8) | bytes[3];
+    }
+
+    char* writeUInt16(char* output, const uint32_t value)
+    {
+        *output++ = static_cast<char>((value >> 8) & 0xFF);
+        *output++ = static_cast<char>(value & 0xFF);
+        return output;
+    }
+
+    char* writeUInt32(char* output, const uint32_t value)
+    {
+        *output++ = static_cast<char>((value >> 24) & 0xFF);
+        *output++ = static_cast<char>((value >> 16) & 0xFF);
+        *output++ = static_cast<char>((value >> 8) & 0xFF);
+        *output++ = static_cast<char>(value & 0xFF);
+        return output;
+    }
+
+    /**
+     * Header fields that only make sense for a single HTTP/1.x connection
+     */
+    bool isConnectionSpecificHeader(const HttpStringView name)
+    {
+        return matchStringUpperOrLower(name, "connectionCONNECTION")
+            || matchStringUpperOrLower(name, "keep-aliveKEEP-ALIVE")
+            || matchStringUpperOrLower(name, "proxy-connectionPROXY-CONNECTION")
+            || matchStringUpperOrLower(name, "transfer-encodingTRANSFER-ENCODING")
+            || matchStringUpperOrLower(name, "upgradeUPGRADE");
+    }
+
+    bool containsLineBreakOrNull(const HttpStringView value)
+    {
+        const auto end = value.data() + value.size();
+        return findFirstOf<'\r', '\n', '\0'>(value.data(), end) != end;
+    }
+}
+
+struct Http2Session::Stream final
+{
+    explicit Stream(ReadBufferPoolType& readBufferPool) : body(readBufferPool)
+    {}
+
+    void reset()
+    {
+        id = 0;
+        endStreamReceived = false;
+        responded = false;
+        sendWindow = 0;
+        parser.reset();
+        headerBuffer.reset();
+        body.reset();
+        pendingData.clear();
+        if (pendingData.capacity() > MaxPendingDataCapacityToKeep)
+        {
+            std::vector<char>().swap(pendingData);
+        }
+        pendingDataOffset = 0;
+    }
+
+    uint32_t id = 0;
+    //the client will not send anything else on this stream
+    bool endStreamReceived = false;
+    //a response was generated, what remains is sending it
+    bool responded = false;
+    int64_t sendWindow = 0;
+    //holds the header block converted to HTTP/1.1 so that it can be interpreted by the same parser
+    ReadBufferPoolType::LeasedBufferType headerBuffer;
+    std::optional<Parser> parser;
+    ReadWriteBufferArray<Buffer::ReadBufferSize, Buffer::MaximumBuffersForRequestBody> body;
+    //response data waiting for the flow control windows to allow sending it, starting at pendingDataOffset
+    std::vector<char> pendingData;
+    size_t pendingDataOffset = 0;
+    //reserved from the response overflow budget for pendingData
+    size_t pendingDataReserved = 0;
+};
+
+Http2Session::Http2Session(ReadBufferPoolType& readBufferPool, ResponseOverflowBudget& responseOverflowBudget,
+                           const ProcessRequestFn processRequest, const WriteFn write, void* state) :
+    readBufferPool_(readBufferPool), responseOverflowBudget_(responseOverflowBudget),
+    processRequest_(processRequest), write_(write), state_(state),
+    responseStorage_(response_, responseOverflowBudget),
+    responseBuilder_([](auto data, auto size, auto state)
+                     {
+                         reinterpret_cast<Http2Session*>(state)->responseStorage_.write(data, size);
+                     }, this, &responseStorage_),
+    connectionSendWindow_(DefaultWindowSize), peerInitialWindowSize_(DefaultWindowSize),
+    peerMaxFrameSize_(DefaultMaxFrameSize)
+{}
+
+Http2Session::~Http2Session()
+{
+    for (const auto& stream : streams_)
+    {
+        responseOverflowBudget_.release(stream->pendingDataReserved);
+    }
+}
+
+bool Http2Session::startsWithConnectionPreface(const char* data, const size_t size)
+{
+    //the longest HTTP/1.x verb that shares a prefix with the preface is "PR", for PROPFIND
+    constexpr size_t MinBytesToCompare = 4;
+    if (size < MinBytesToCompare) return false;
+
+    return 0 == std::memcmp(data, ConnectionPreface.data(), std::min(size, ConnectionPreface.size()));
+}
+
+bool Http2Session::process(const char* data, size_t size)
+{
+    if (closing_) return false;
+
+    if (prefaceBytesReceived_ < ConnectionPreface.size())
+    {
+        const auto toCompare = std::min(size, ConnectionPreface.size() - prefaceBytesReceived_);
+        if (0 != std::memcmp(data, ConnectionPreface.data() + prefaceBytesReceived_, toCompare))
+        {
+            return false;
+        }
+        prefaceBytesReceived_ += toCompare;
+        data += toCompare;
+        size -= toCompare;
+
+        if (prefaceBytesReceived_ < ConnectionPreface.size()) return true;
+
+        //the server preface consists of a SETTINGS frame
+        writeSettings();
+    }
+
+    if (incompleteFrames_.empty())
+    {
+        //parse in place as much as possible
+        const auto processed = processFrames(data, size);
+        if ( ! closing_)
+        {
+            incompleteFrames_.insert(incompleteFrames_.end(), data + processed, data + size);
+        }
+    }
+    else
+    {
+        incompleteFrames_.insert(incompleteFrames_.end(), data, data + size);
+        const auto processed = processFrames(incompleteFrames_.data(), incompleteFrames_.size());
+        incompleteFrames_.erase(incompleteFrames_.begin(), incompleteFrames_.begin() + processed);
+    }
+
+    if (goAwayReceived_ && streams_.empty())
+    {
+        closing_ = true;
+    }
+    if (( ! closing_) && (pendingConnectionWindowUpdate_ > 0))
+    {
+        writeWindowUpdate(0, std::exchange(pendingConnectionWindowUpdate_, 0));
+    }
+    return ! closing_;
+}
+
+void Http2Session::goAway()
+{
+    //frames may only be sent after the server preface
+    if (( ! closing_) && (prefaceBytesReceived_ >= ConnectionPreface.size()))
+    {
+        writeGoAway(ErrorCode::NoError);
+    }
+    closing_ = true;
+}
+
+size_t Http2Session::processFrames(const char* data, const size_t size)
+{
+    size_t processed = 0;
+
+    while (( ! closing_) && ((size - processed) >= FrameHeaderSize))
+    {
+        const auto header = data + processed;
+        const auto length = readUInt24(header);
+        const auto type = static_cast<uint8_t>(header[3]);
+        const auto flags = static_cast<uint8_t>(header[4]);
+        const auto streamId = readUInt32(header + 5) & 0x7FFFFFFF;
+
+        //SETTINGS_MAX_FRAME_SIZE is never increased for the client
+        if (length > DefaultMaxFrameSize)
+        {
+            connectionError(ErrorCode::FrameSizeError);
+            break;
+        }
+        if ((size - processed - FrameHeaderSize) < length) break;
+
+        processFrame(type, flags, streamId, header + FrameHeaderSize, length);
+        processed += FrameHeaderSize + length;
+    }
+    return processed;
+}
+
+bool Http2Session::processFrame(const uint8_t type, const uint8_t flags, const uint32_t streamId,
+                                const char* payload, const size_t size)
+{
+    //the client preface must continue with a SETTINGS frame
+    if (( ! settingsReceived_) && (FrameType::Settings != type)) return connectionError(ErrorCode::ProtocolError);
+
+    //header blocks must be sent without interruption
+    if ((0 != headerBlockStreamId_) && (FrameType::Continuation != type))
+    {
+        return connectionError(ErrorCode::ProtocolError);
+    }
+
+    switch (type)
+    {
+    case FrameType::Data:
+        return onData(flags, streamId, payload, size);
+    case FrameType::Headers:
+        return onHeaders(flags, streamId, payload, size);
+    case FrameType::Priority:
+        //streams are served in the order their requests complete, priorities are ignored
+        if (0 == streamId) return connectionError(ErrorCode::ProtocolError);
+        if (5 != size) return connectionError(ErrorCode::FrameSizeError);
+        return true;
+    case FrameType::ResetStream:
+        if (0 == streamId) return connectionError(ErrorCode::ProtocolError);
+        if (4 != size) return connectionError(ErrorCode::FrameSizeError);
+        if (auto stream = findStream(streamId))
+        {
+            closeStream(*stream);
+        }
+        else if (streamId > lastStreamId_)
+        {
+            return connectionError(ErrorCode::ProtocolError);
+        }
+        return true;
+    case FrameType::Settings:
+        return onSettings(flags, streamId, payload, size);
+    case FrameType::PushPromise:
+        //only servers may push
+        return connectionError(ErrorCode::ProtocolError);
+    case FrameType::Ping:
+        if (0 != streamId) return connectionError(ErrorCode::ProtocolError);
+        if (8 != size) return connectionError(ErrorCode::FrameSizeError);
+        if (0 == (flags & FrameFlag::Ack))
+        {
+            writeFrameHeader(size, FrameType::Ping, FrameFlag::Ack, 0);
+            write_(payload, size, state_);
+        }
+        return true;
+    case FrameType::GoAway:
+        if (0 != streamId) return connectionError(ErrorCode::ProtocolError);
+        if (size < 8) return connectionError(ErrorCode::FrameSizeError);
+        //the client will not start new streams, but still expects responses for the ones already started
+        goAwayReceived_ = true;
+        return true;
+    case FrameType::WindowUpdate:
+        return onWindowUpdate(streamId, payload, size);
+    case FrameType::Continuation:
+        return onContinuation(flags, streamId, payload, size);
+    default:
+        //unknown frame types must be ignored
+        return true;
+    }
+}
+
+bool Http2Session::onHeaders(const uint8_t flags, const uint32_t streamId, const char* payload, size_t size)
+{
+    if (0 == streamId) return connectionError(ErrorCode::ProtocolError);
+
+    size_t padding = 0;
+    if (flags & FrameFlag::Padded)
+    {
+        if (size < 1) return connectionError(ErrorCode::FrameSizeError);
+        padding = static_cast<uint8_t>(*payload);
+        payload += 1;
+        size -= 1;
+    }
+    if (flags & FrameFlag::Priority)
+    {
+        //stream dependency and weight
+        if (size < 5) return connectionError(ErrorCode::FrameSizeError);
+        payload += 5;
+        size -= 5;
+    }
+    if (padding > size) return connectionError(ErrorCode::ProtocolError);
+    size -= padding;
+
+    headerBlock_.assign(payload, payload + size);
+    headerBlockStreamId_ = streamId;
+    headerBlockEndsStream_ = 0 != (flags & FrameFlag::EndStream);
+
+    if (flags & FrameFlag::EndHeaders)
+    {
+        return onHeaderBlockComplete();
+    }
+    return true;
+}
+
+bool Http2Session::onContinuation(const uint8_t flags, const uint32_t streamId, const char* payload,
+                                  const size_t size)
+{
+    if ((0 == headerBlockStreamId_) || (streamId != headerBlockStreamId_))
+    {
+        return connectionError(ErrorCode::ProtocolError);
+    }
+    if ((headerBlock_.size() + size) > MaxHeaderBlockSize)
+    {
+        return connectionError(ErrorCode::EnhanceYourCalm);
+    }
+    headerBlock_.insert(headerBlock_.end(), payload, payload + size);
+
+    if (flags & FrameFlag::EndHeaders)
+    {
+        return onHeaderBlockComplete();
+    }
+    return true;
+}
+
+bool Http2Session::onHeaderBlockComplete()
+{
+    const auto streamId = std::exchange(headerBlockStreamId_, 0);
+
+    method_.clear();
+    path_.clear();
+    authority_.clear();
+    headerLines_.clear();
+    cookies_.clear();
+    hostReceived_ = false;
+    malformedHeaders_ = false;
+    headerListSize_ = 0;
+
+    //always decode, even if the stream is refused, so that the dynamic table stays in sync with the client
+    if ( ! decoder_.decode(headerBlock_.data(), headerBlock_.size(), onHeaderDecoded, this))
+    {
+        return connectionError(ErrorCode::CompressionError);
+    }
+    if (headerListSize_ > MaxDecodedHeaderListSize)
+    {
+        //decoding stopped early, so the dynamic table is no longer in sync with the client
+        return connectionError(ErrorCode::EnhanceYourCalm);
+    }
+
+    if (auto stream = findStream(streamId))
+    {
+        //trailers are not used, but they end the request
+        if (stream->endStreamReceived || ( ! headerBlockEndsStream_))
+        {
+            //a header block after the end of the stream, or a second one that does not end it
+            writeResetStream(streamId, stream->endStreamReceived ? ErrorCode::StreamClosed : ErrorCode::ProtocolError);
+            closeStream(*stream);
+            return true;
+        }
+        stream->endStreamReceived = true;
+        if ( ! stream->responded)
+        {
+            processRequest(*stream);
+        }
+        return true;
+    }
+
+    //new streams must use odd identifiers, larger than all previous ones
+    if ((streamId <= lastStreamId_) || (0 == (streamId % 2)))
+    {
+        return connectionError(ErrorCode::ProtocolError);
+    }
+    lastStreamId_ = streamId;
+
+    const auto canStartStream = ( ! goAwayReceived_) && (streams_.size() < MaxConcurrentStreams)
+            && (leasedBuffers() < MaxLeasedBuffers);
+    auto stream = canStartStream ? newStream(streamId) : nullptr;
+    if (nullptr == stream)
+    {
+        //the client can safely retry the request later
+        writeResetStream(streamId, ErrorCode::RefusedStream);
+        return true;
+    }
+    stream->endStreamReceived = headerBlockEndsStream_;
+
+    if (startRequest(*stream) && stream->endStreamReceived)
+    {
+        processRequest(*stream);
+    }
+    return true;
+}
+
+bool Http2Session::onHeaderDecoded(const HttpStringView name, const HttpStringView value, void* state)
+{
+    auto& session = *reinterpret_cast<Http2Session*>(state);
+
+    //a small block can reference large table entries many times, so limit what it expands to
+    session.headerListSize_ += name.size() + value.size() + HeaderFieldOverhead;
+    if (session.headerListSize_ > MaxDecodedHeaderListSize)
+    {
+        return false;
+    }
+
+    //keep decoding malformed headers, the rest of the block can still change the dynamic table
+    if (name.empty() || containsLineBreakOrNull(name) || containsLineBreakOrNull(value))
+    {
+        session.malformedHeaders_ = true;
+        return true;
+    }
+
+    if (':' == name[0])
+    {
+        if (":method" == name)
+        {
+            session.method_ = value;
+        }
+        else if (":path" == name)
+        {
+            session.path_ = value;
+        }
+        else if (":authority" == name)
+        {
+            session.authority_ = value;
+        }
+        //:scheme is not needed, TLS ends at the proxy
+        return true;
+    }
+    if (name.find_first_of(": ") != HttpStringView::npos)
+    {
+        session.malformedHeaders_ = true;
+        return true;
+    }
+    if ("cookie" == name)
+    {
+        //cookies may be sent as separate fields, which need to be joined
+        if ( ! session.cookies_.empty())
+        {
+            session.cookies_.append("; ");
+        }
+        session.cookies_.append(value);
+        return true;
+    }
+    //the body is delimited by DATA frames, so content-length and expect are not used
+    if (isConnectionSpecificHeader(name) || ("te" == name) || ("content-length" == name) || ("expect" == name))
+    {
+        return true;
+    }
+    if ("host" == name)
+    {
+        session.hostReceived_ = true;
+    }
+    session.headerLines_.append(name).append(": ").append(value).append("\r\n");
+    return true;
+}
+
+bool Http2Session::startRequest(Stream& stream)
+{
+    if (malformedHeaders_ || method_.empty() || path_.empty())
+    {
+        writeResetStream(stream.id, ErrorCode::ProtocolError);
+        closeStream(stream);
+        return false;
+    }
+
+    //rebuild the request as HTTP/1.1 so that the parser can interpret the path, the query and the cookies
+    static constexpr HttpStringView RequestLineEnd{ " HTTP/1.1\r\n" };
+    static constexpr HttpStringView HostStart{ "host: " };
+    static constexpr HttpStringView CookieStart{ "cookie: " };
+    static constexpr HttpStringView LineEnd{ "\r\n" };
+
+    const auto addHost = ( ! hostReceived_) && ( ! authority_.empty());
+    const auto size = method_.size() + 1 + path_.size() + RequestLineEnd.size()
+            + (addHost ? (HostStart.size() + authority_.size() + LineEnd.size()) : 0)
+            + headerLines_.size()
+            + (cookies_.empty() ? 0 : (CookieStart.size() + cookies_.size() + LineEnd.size()))
+            + LineEnd.size();
+
+    if (size > Buffer::ReadBufferSize)
+    {
+        writeSimpleResponse(stream, HttpStatusCode::Request_Header_Fields_Too_Large);
+        return false;
+    }
+
+    char* const buffer = stream.headerBuffer->data;
+    char* output = buffer;
+    const auto append = [&output](const HttpStringView value)
+    {
+        output = std::copy(value.begin(), value.end(), output);
+    };
+
+    append(method_);
+    append(" ");
+    append(path_);
+    append(RequestLineEnd);
+    if (addHost)
+    {
+        append(HostStart);
+        append(authority_);
+        append(LineEnd);
+    }
+    append(headerLines_);
+    if ( ! cookies_.empty())
+    {
+        append(CookieStart);
+        append(cookies_);
+        append(LineEnd);
+    }
+    append(LineEnd);
+    assert(static_cast<size_t>(output - buffer) == size);
+
+    stream.parser.emplace(buffer, Buffer::ReadBufferSize, Buffer::MaxRequestBodyLength,
+                          [](auto /*buffer*/, auto /*size*/, auto /*state*/)
+                          {
+                              //no content-length is passed on, DATA frames are stored separately
+                              return false;
+                          }, nullptr);
+
+    auto& parser = stream.parser->process(buffer, size);
+    if (parser != Parser::ParseResult::FINISHED)
+    {
+        writeSimpleResponse(stream, (parser == Parser::ParseResult::INVALID_INPUT) ? parser.errorCode()
+                                                                                  : HttpStatusCode::Bad_Request);
+        return false;
+    }
+    //the connection is persistent and the stream ends with the response
+    parser.mutableRequest().keepConnectionAlive = true;
+    return true;
+}
+
+void Http2Session::processRequest(Stream& stream)
+{
+    assert(stream.parser);
+    auto& request = stream.parser->mutableRequest();
+
+    //add references to request content buffers
+    for (const auto buffer : stream.body.constBufferWrapper())
+    {
+        if ((request.nrOfRequestContentBuffers >= request.requestContentBuffers.size())
+            || (0 == boost::asio::buffer_size(buffer)))
+        {
+            break;
+        }
+        request.requestContentBuffers[request.nrOfRequestContentBuffers++] =
+            HttpStringView(boost::asio::buffer_cast<const char*>(buffer), boost::asio::buffer_size(buffer));
+    }
+
+    responseStorage_.reset();
+    responseBuilder_.reset();
+
+    processRequest_(request, responseBuilder_, state_);
+
+    if (responseStorage_.failed())
+    {
+        //too large or not enough memory available right now, the stream ends without a response
+        responseStorage_.reset();
+        std::vector<char>().swap(response_);
+        writeResetStream(stream.id, ErrorCode::InternalError);
+        closeStream(stream);
+        return;
+    }
+    if (response_.empty())
+    {
+        writeSimpleResponse(stream, HttpStatusCode::Internal_Server_Error);
+        return;
+    }
+    sendResponse(stream);
+}
+
+void Http2Session::writeSimpleResponse(Stream& stream, const HttpStatusCode code)
+{
+    char buffer[256];
+    const auto size = buildSimpleResponseFromStatusCode(code, 1, 1, buffer);
+
+    responseStorage_.reset();
+    if ( ! responseStorage_.write(buffer, size))
+    {
+        writeResetStream(stream.id, ErrorCode::InternalError);
+        closeStream(stream);
+        return;
+    }
+    sendResponse(stream);
+}
+
+void Http2Session::sendResponse(Stream& stream)
+{
+    //the response is in HTTP/1.1 format, as written by HttpResponseBuilder
+    stream.responded = true;
+    stream.parser.reset();
+    stream.headerBuffer.reset();
+    stream.body.reset();
+
+    const HttpStringView response(response_.data(), response_.size());
+    auto headersEnd = response.find("\r\n\r\n");
+    if (HttpStringView::npos == headersEnd)
+    {
+        headersEnd = response.size();
+    }
+    const auto bodyStart = std::min(headersEnd + 4, response.size());
+
+    auto headers = response.substr(0, headersEnd);
+    auto statusLineEnd = headers.find("\r\n");
+    const auto statusLine = headers.substr(0, statusLineEnd);
+    headers.remove_prefix((HttpStringView::npos == statusLineEnd) ? headers.size() : (statusLineEnd + 2));
+
+    uint16_t statusCode = 0;
+    const auto codeStart = statusLine.find(' ');
+    if ((HttpStringView::npos != codeStart) && ((codeStart + 4) <= statusLine.size()))
+    {
+        fromStringOrDefault(statusLine.substr(codeStart + 1, 3), statusCode, static_cast<uint16_t>(0));
+    }
+    if ((statusCode < 100) || (statusCode > 999))
+    {
+        statusCode = static_cast<uint16_t>(HttpStatusCode::Internal_Server_Error);
+    }
+
+    responseHeaderBlock_.clear();
+    Hpack::encodeStatus(statusCode, responseHeaderBlock_);
+
+    while ( ! headers.empty())
+    {
+        const auto lineEnd = headers.find("\r\n");
+        const auto line = headers.substr(0, lineEnd);
+        headers.remove_prefix((HttpStringView::npos == lineEnd) ? headers.size() : (lineEnd + 2));
+
+        const auto separator = line.find(':');
+        if (HttpStringView::npos == separator) continue;
+
+        const auto name = line.substr(0, separator);
+        auto value = line.substr(separator + 1);
+        trimLeadingChar(value, ' ');
+
+        if (isConnectionSpecificHeader(name)) continue;
+
+        Hpack::encodeHeader(name, value, responseHeaderBlock_);
+    }
+
+    const auto hasBody = bodyStart < response.size();
+
+    size_t offset = 0;
+    do
+    {
+        const auto fragmentSize = std::min(responseHeaderBlock_.size() - offset, peerMaxFrameSize_);
+        const auto lastFragment = (offset + fragmentSize) == responseHeaderBlock_.size();
+        const auto firstFragment = 0 == offset;
+
+        uint8_t flags = lastFragment ? FrameFlag::EndHeaders : 0;
+        if (firstFragment && ( ! hasBody))
+        {
+            flags |= FrameFlag::EndStream;
+        }
+        writeFrameHeader(fragmentSize, firstFragment ? FrameType::Headers : FrameType::Continuation, flags,
+                         stream.id);
+        write_(responseHeaderBlock_.data() + offset, fragmentSize, state_);
+        offset += fragmentSize;
+    } while (offset < responseHeaderBlock_.size());
+
+    if ( ! hasBody)
+    {
+        responseStorage_.reset();
+        finishStream(stream);
+        return;
+    }
+
+    //keep the response without copying it, the stream's previous buffer is reused for the next response
+    std::swap(stream.pendingData, response_);
+    stream.pendingDataOffset = bodyStart;
+    stream.pendingDataReserved = responseStorage_.takeReservation();
+    responseStorage_.reset();
+
+    if (sendPendingData(stream))
+    {
+        finishStream(stream);
+    }
+}
+
+void Http2Session::sendPendingData()
+{
+    //streams are kept in the order they were opened
+    for (size_t i = 0; (i < streams_.size()) && (connectionSendWindow_ > 0);)
+    {
+        auto& stream = *streams_[i];
+        if (stream.responded && sendPendingData(stream))
+        {
+            //removes the stream from streams_
+            finishStream(stream);
+            continue;
+        }
+        ++i;
+    }
+}
+
+bool Http2Session::sendPendingData(Stream& stream)
+{
+    while (true)
+    {
+        const auto remaining = stream.pendingData.size() - stream.pendingDataOffset;
+        const auto window = std::min(stream.sendWindow, connectionSendWindow_);
+        if (window <= 0) return false;
+
+        const auto toSend = std::min({ remaining, peerMaxFrameSize_, static_cast<size_t>(window) });
+        const auto lastFrame = toSend == remaining;
+
+        writeFrameHeader(toSend, FrameType::Data, lastFrame ? FrameFlag::EndStream : 0, stream.id);
+        write_(stream.pendingData.data() + stream.pendingDataOffset, toSend, state_);
+
+        stream.pendingDataOffset += toSend;
+        stream.sendWindow -= toSend;
+        connectionSendWindow_ -= toSend;
+
+        if (lastFrame) return true;
+    }
+}
+
+bool Http2Session::onData(const uint8_t flags, const uint32_t streamId, const char* payload, size_t size)
+{
+    if (0 == streamId) return connectionError(ErrorCode::ProtocolError);
+
+    //the entire frame counts for flow control, padding included
+    pendingConnectionWindowUpdate_ += static_cast<uint32_t>(size);
+
+    if (flags & FrameFlag::Padded)
+    {
+        if (size < 1) return connectionError(ErrorCode::FrameSizeError);
+        const size_t padding = static_cast<uint8_t>(*payload);
+        payload += 1;
+        size -= 1;
+        if (padding > size) return connectionError(ErrorCode::ProtocolError);
+        size -= padding;
+    }
+
+    auto stream = findStream(streamId);
+    if ((nullptr == stream) || stream->endStreamReceived || stream->responded)
+    {
+        if (streamId > lastStreamId_) return connectionError(ErrorCode::ProtocolError);
+        //the stream was reset or already answered, the data is no longer needed
+        return true;
+    }
+    const auto newBodySize = stream->body.size() + size;
+    if (newBodySize > Buffer::MaxRequestBodyLength)
+    {
+        writeSimpleResponse(*stream, HttpStatusCode::Payload_Too_Large);
+        return true;
+    }
+    const auto buffersNeeded = (newBodySize + Buffer::ReadBufferSize - 1) / Buffer::ReadBufferSize;
+    const auto buffersUsed = stream->body.nrOfBuffers();
+    if ((buffersNeeded > buffersUsed) && ((leasedBuffers() + buffersNeeded - buffersUsed) > MaxLeasedBuffers))
+    {
+        refuseStream(*stream);
+        return true;
+    }
+    if ( ! stream->body.write(payload, size))
+    {
+        //the pool is exhausted
+        refuseStream(*stream);
+        return true;
+    }
+    if (flags & FrameFlag::EndStream)
+    {
+        stream->endStreamReceived = true;
+        processRequest(*stream);
+    }
+    return true;
+}
+
+bool Http2Session::onSettings(const uint8_t flags, const uint32_t streamId, const char* payload, const size_t size)
+{
+    if (0 != streamId) return connectionError(ErrorCode::ProtocolError);
+
+    if (flags & FrameFlag::Ack)
+    {
+        return (0 == size) ? true : connectionError(ErrorCode::FrameSizeError);
+    }
+    if (0 != (size % SettingSize)) return connectionError(ErrorCode::FrameSizeError);
+
+    for (size_t offset = 0; offset < size; offset += SettingSize)
+    {
+        const auto id = readUInt16(payload + offset);
+        const auto value = readUInt32(payload + offset + 2);
+
+        switch (id)
+        {
+        case SettingId::InitialWindowSize:
+            if (value > MaxWindowSize) return connectionError(ErrorCode::FlowControlError);
+            //no window of an existing stream may grow beyond the maximum
+            for (const auto& stream : streams_)
+            {
+                if ((stream->sendWindow + static_cast<int64_t>(value) - peerInitialWindowSize_) > MaxWindowSize)
+                {
+                    return connectionError(ErrorCode::FlowControlError);
+                }
+            }
+            for (auto& stream : streams_)
+            {
+                stream->sendWindow += static_cast<int64_t>(value) - peerInitialWindowSize_;
+            }
+            peerInitialWindowSize_ = value;
+            break;
+        case SettingId::MaxFrameSize:
+            if ((value < DefaultMaxFrameSize) || (value > MaxAllowedFrameSize))
+            {
+                return connectionError(ErrorCode::ProtocolError);
+            }
+            peerMaxFrameSize_ = value;
+            break;
+        default:
+            //the encoder does not use the dynamic table and nothing is pushed, so the other settings don't matter
+            break;
+        }
+    }
+    settingsReceived_ = true;
+
+    writeFrameHeader(0, FrameType::Settings, FrameFlag::Ack, 0);
+    sendPendingData();
+    return true;
+}
+
+bool Http2Session::onWindowUpdate(const uint32_t streamId, const char* payload, const size_t size)
+{
+    if (4 != size) return connectionError(ErrorCode::FrameSizeError);
+
+    const auto increment = readUInt32(payload) & 0x7FFFFFFF;
+
+    if (0 == streamId)
+    {
+        if (0 == increment) return connectionError(ErrorCode::ProtocolError);
+
+        connectionSendWindow_ += increment;
+        if (connectionSendWindow_ > MaxWindowSize) return connectionError(ErrorCode::FlowControlError);
+    }
+    else
+    {
+        auto stream = findStream(streamId);
+        if (nullptr == stream)
+        {
+            //might still arrive for streams that were closed recently
+            return (streamId > lastStreamId_) ? connectionError(ErrorCode::ProtocolError) : true;
+        }
+        stream->sendWindow += increment;
+        if ((0 == increment) || (stream->sendWindow > MaxWindowSize))
+        {
+            writeResetStream(streamId, (0 == increment) ? ErrorCode::ProtocolError : ErrorCode::FlowControlError);
+            closeStream(*stream);
+            return true;
+        }
+    }
+    sendPendingData();
+    return true;
+}
+
+Http2Session::Stream* Http2Session::findStream(const uint32_t streamId)
+{
+    for (auto& stream : streams_)
+    {
+        if (stream->id == streamId)
+        {
+            return stream.get();
+        }
+    }
+    return nullptr;
+}
+
+Http2Session::Stream* Http2Session::newStream(const uint32_t streamId)
+{
+    auto headerBuffer = readBufferPool_.leaseBuffer();
+    if ( ! headerBuffer)
+    {
+        return nullptr;
+    }
+    std::unique_ptr<Stream> stream;
+    if (unusedStreams_.empty())
+    {
+        stream = std::make_unique<Stream>(readBufferPool_);
+    }
+    else
+    {
+        stream = std::move(unusedStreams_.back());
+        unusedStreams_.pop_back();
+    }
+    stream->id = streamId;
+    stream->sendWindow = peerInitialWindowSize_;
+    stream->headerBuffer = std::move(headerBuffer);
+
+    streams_.push_back(std::move(stream));
+    return streams_.back().get();
+}
+
+size_t Http2Session::leasedBuffers() const
+{
+    size_t result = 0;
+    for (const auto& stream : streams_)
+    {
+        result += (stream->headerBuffer ? 1 : 0) + stream->body.nrOfBuffers();
+    }
+    return result;
+}
+
+void Http2Session::refuseStream(Stream& stream)
+{
+    //the request was not processed, so the client can safely retry it later
+    writeResetStream(stream.id, ErrorCode::RefusedStream);
+    closeStream(stream);
+}
+
+void Http2Session::finishStream(Stream& stream)
+{
+    if ( ! stream.endStreamReceived)
+    {
+        //the response was sent before the entire request was received, no need to send the rest
+        writeResetStream(stream.id, ErrorCode::NoError);
+    }
+    closeStream(stream);
+}
+
+void Http2Session::closeStream(Stream& stream)
+{
+    const auto it = std::find_if(streams_.begin(), streams_.end(), [&stream](const auto& value)
+    {
+        return value.get() == &stream;
+    });
+    assert(it != streams_.end());
+
+    responseOverflowBudget_.release(std::exchange(stream.pendingDataReserved, 0));
+    stream.reset();
+    unusedStreams_.push_back(std::move(*it));
+    streams_.erase(it);
+}
+
+void Http2Session::writeFrameHeader(const size_t length, const uint8_t type, const uint8_t flags,
+                                    const uint32_t streamId)
+{
+    char header[FrameHeaderSize];
+    header[0] = static_cast<char>((length >> 16) & 0xFF);
+    header[1] = static_cast<char>((length >> 8) & 0xFF);
+    header[2] = static_cast<char>(length & 0xFF);
+    header[3] = static_cast<char>(type);
+    header[4] = static_cast<char>(flags);
+    writeUInt32(header + 5, streamId);
+
+    write_(header, FrameHeaderSize, state_);
+}
+
+void Http2Session::writeSettings()
+{
+    char payload[3 * SettingSize];
+    auto output = payload;
+
+    output = writeUInt16(output, SettingId::MaxConcurrentStreams);
+    output = writeUInt32(output, MaxConcurrentStreams);
+    output = writeUInt16(output, SettingId::InitialWindowSize);
+    output = writeUInt32(output, InitialWindowSizeForClient);
+    output = writeUInt16(output, SettingId::MaxHeaderListSize);
+    output = writeUInt32(output, static_cast<uint32_t>(MaxDecodedHeaderListSize));
+    assert(output == (payload + std::size(payload)));
+
+    writeFrameHeader(std::size(payload), FrameType::Settings, 0, 0);
+    write_(payload, std::size(payload), state_);
+}
+
+void Http2Session::writeResetStream(const uint32_t streamId, const uint32_t errorCode)
+{
+    char payload[4];
+    writeUInt32(payload, errorCode);
+
+    writeFrameHeader(std::size(payload), FrameType::ResetStream, 0, streamId);
+    write_(payload, std::size(payload), state_);
+}
+
+void Http2Session::writeWindowUpdate(const uint32_t streamId, const uint32_t increment)
+{
+    char payload[4];
+    writeUInt32(payload, increment);
+
+    writeFrameHeader(std::size(payload), FrameType::WindowUpdate, 0, streamId);
+    write_(payload, std::size(payload), state_);
+}
+
+void Http2Session::writeGoAway(const uint32_t errorCode)
+{
+    char payload[8];
+    writeUInt32(writeUInt32(payload, lastStreamId_), errorCode);
+
+    writeFrameHeader(std::size(payload), FrameType::GoAway, 0, 0);
+    write_(payload, std::size(payload), state_);
+}
+
+bool Http2Session::connectionError(const uint32_t errorCode)
+{
+    //https://tools.ietf.org/html/rfc7540#section-5.4.1
+    writeGoAway(errorCode);
+
+    closing_ = true;
+    return false;
+}
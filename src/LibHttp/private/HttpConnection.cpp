@@ -18,23 +18,27 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "HttpConnection.h"
 
-using namespace Http;
+#include <cassert>
+#include <cstring>
+#include <utility>
+#include <vector>
 
-static void writeToBuffer(const char* data, const size_t size, void* state)
-{
-    reinterpret_cast<HttpConnection::ResponseBufferType*>(state)->write(data, size);
-}
+using namespace Http;
 
 HttpConnection::HttpConnection(IConnectionManager& connectionManager, HttpRouter& router,
-    boost::asio::ip::tcp::socket& socket, boost::asio::io_context& context,
+    StreamSocket& socket, boost::asio::io_context& context,
     ReadBufferType&& headerBuffer, ReadBufferPoolType& readBufferPool, WriteBufferPoolType& writeBufferPool,
-    const bool trustIpFromXForwardedFor) :
+    ResponseOverflowBudget& responseOverflowBudget, const bool trustIpFromXForwardedFor) :
 
     StreamingConnection(connectionManager, std::move(socket), context), router_{ router },
+    readBufferPool_(readBufferPool), responseOverflowBudget_(responseOverflowBudget),
     headerBuffer_(std::move(headerBuffer)), 
     requestBodyBuffer_(readBufferPool), 
-    responseBuffer_(writeBufferPool),
-    responseBuilder_(writeToBuffer, &responseBuffer_),
+    responseBuffer_(writeBufferPool, responseOverflowBudget),
+    responseBuilder_([](auto data, auto size, auto state)
+                     {
+                         reinterpret_cast<HttpConnection*>(state)->writeResponseBytes(data, size);
+                     }, this, &responseBuffer_),
     trustIpFromXForwardedFor_(trustIpFromXForwardedFor),
     parser_(headerBuffer_->data, Buffer::ReadBufferSize, Buffer::MaxRequestBodyLength,
             [](auto buffer, auto size, auto state)
@@ -43,17 +47,87 @@ HttpConnection::HttpConnection(IConnectionManager& connectionManager, HttpRouter
             }, this)
 {}
 
+boost::asio::mutable_buffer HttpConnection::nextReadBuffer()
+{
+    if (http2Session_)
+    {
+        waitingForHttp2Frames_ = true;
+        //the session keeps incomplete frames, so the whole buffer can be reused for each read
+        return boost::asio::buffer(headerBuffer_->data, Buffer::ReadBufferSize);
+    }
+    if (parser_.expectsBody())
+    {
+        //receive the body straight into its storage, without reading past it so pipelined requests are not split
+        const auto buffer = requestBodyBuffer_.prepare();
+        if (buffer.size() > 0)
+        {
+            readingBodyInPlace_ = true;
+            return boost::asio::buffer(buffer, parser_.remainingBodyBytes());
+        }
+    }
+    else
+    {
+        //headers are parsed in place, as much as possible is read at once
+        const auto headerSize = parser_.headerSize();
+        if (headerSize < Buffer::ReadBufferSize)
+        {
+            return boost::asio::buffer(headerBuffer_->data + headerSize, Buffer::ReadBufferSize - headerSize);
+        }
+    }
+    //no more room, let the parser report the appropriate error
+    return StreamingConnection::nextReadBuffer();
+}
+
 bool HttpConnection::onBytesRead(char* bytes, size_t bytesTransferred)
 {
-    if (parser_.process(bytes, bytesTransferred) == Parser::ParseResult::INVALID_INPUT)
+    if (http2Session_)
     {
-        //invalid input
+        return processHttp2(bytes, bytesTransferred);
+    }
+    if (( ! readingBodyInPlace_) && ( ! anyRequestProcessed_) && (bytes >= headerBuffer_->data)
+        && (bytes < (headerBuffer_->data + Buffer::ReadBufferSize)))
+    {
+        //the bytes of the first request accumulate at the start of the header buffer
+        const auto received = static_cast<size_t>(bytes + bytesTransferred - headerBuffer_->data);
+        if (Http2Session::startsWithConnectionPreface(headerBuffer_->data, received))
+        {
+            http2Session_ = std::make_unique<Http2Session>(readBufferPool_, responseOverflowBudget_,
+                [](auto& request, auto& response, auto state)
+                {
+                    auto& connection = *reinterpret_cast<HttpConnection*>(state);
+                    request.remoteAddress = connection.getRemoteAddress(request);
+                    connection.router_.forward(request, response);
+                },
+                [](auto data, auto size, auto state)
+                {
+                    reinterpret_cast<HttpConnection*>(state)->writeResponseBytes(data, size);
+                }, this);
+            parser_.reset();
+            return processHttp2(headerBuffer_->data, received);
+        }
+    }
+
+    if (std::exchange(readingBodyInPlace_, false))
+    {
+        requestBodyBuffer_.commit(bytesTransferred);
+        parser_.processStoredBody(bytesTransferred);
+    }
+    else if (parser_.process(bytes, bytesTransferred) == Parser::ParseResult::INVALID_INPUT)
+    {
+        //invalid input, there is no way of knowing where the next request would start
+        keepConnectionAlive_ = false;
         writeStatusCode(parser_.errorCode());
         return false;
     }
 
     if (parser_ != Parser::ParseResult::FINISHED) return true;
 
+    //keep what the client already sent of the next request until the response for the current one is written
+    pipelinedBytesSize_ = parser_.unprocessedBytes();
+    pipelinedBytes_ = bytes + bytesTransferred - pipelinedBytesSize_;
+    assert((0 == pipelinedBytesSize_) || ((pipelinedBytes_ >= headerBuffer_->data)
+                                          && (pipelinedBytes_ < headerBuffer_->data + Buffer::ReadBufferSize)));
+
     //finished reading everything needed for the current request, so process it
     auto& request = parser_.mutableRequest();
 
@@ -71,6 +145,16 @@ void HttpConnection::onWritten(size_t /*bytesTransferred*/)
         requestBodyBuffer_.reset();
         responseBuffer_.reset();
         responseBuilder_.reset();
+
+        if (pipelinedBytesSize_ > 0)
+        {
+            //responses are sent in the order the requests were received, one after the other
+            if (onBytesRead(pipelinedBytes_, std::exchange(pipelinedBytesSize_, 0)))
+            {
+                startReading();
+            }
+            return;
+        }
         startReading();
     }
     else
@@ -79,6 +163,43 @@ void HttpConnection::onWritten(size_t /*bytesTransferred*/)
     }
 }
 
+void HttpConnection::onReadClosed()
+{
+    if (http2Session_ && http2TimedOut_)
+    {
+        waitingForHttp2Frames_ = false;
+        //the connection was shut down for reading by disconnect(), let the client know it is being closed
+        http2Session_->goAway();
+        if (( ! responseBuffer_.failed()) && (responseBuffer_.size() > 0))
+        {
+            keepConnectionAlive_ = false;
+            writeResponseBuffers();
+            return;
+        }
+    }
+    release();
+}
+
+void HttpConnection::disconnect()
+{
+    if (waitingForHttp2Frames_)
+    {
+        //HTTP/2 connections should end with GOAWAY, which can only be written from the strand;
+        //shutting down the reading side completes the pending read, which then sends it
+        http2TimedOut_ = true;
+        boost::system::error_code ec;
+        socket_.shutdown(boost::asio::socket_base::shutdown_receive, ec);
+        return;
+    }
+    StreamingConnection::disconnect();
+}
+
+void HttpConnection::writeResponseBytes(const char* data, size_t size)
+{
+    //on failure, the response is replaced with a status code once it is complete
+    responseBuffer_.write(data, size);
+}
+
 bool HttpConnection::onReadBody(const char* buffer, const size_t size)
 {
     return requestBodyBuffer_.write(buffer, size);
@@ -112,15 +233,64 @@ void HttpConnection::processRequest(HttpRequest& request)
     request.remoteAddress = getRemoteAddress(request);
     
     router_.forward(request, responseBuilder_);
+    anyRequestProcessed_ = true;
 
-    if ((0 == responseBuffer_.size()) || responseBuffer_.notEnoughRoom())
+    if (responseBuffer_.failed())
+    {
+        //too large or not enough memory available right now
+        const auto code = responseBuffer_.errorCode();
+        responseBuffer_.reset();
+        writeStatusCode(code);
+        return;
+    }
+    if (0 == responseBuffer_.size())
     {
         writeStatusCode(HttpStatusCode::Internal_Server_Error);
+        return;
+    }
+    writeResponseBuffers();
+}
+
+void HttpConnection::writeResponseBuffers()
+{
+    if (0 == responseBuffer_.overflowSize())
+    {
+        write(responseBuffer_.pooledBuffers());
     }
     else
     {
-        write(responseBuffer_.constBufferWrapper());
+        //send the pooled buffers followed by what did not fit in them, in one gathered write
+        std::vector<boost::asio::const_buffer> buffers;
+        responseBuffer_.getBuffers(buffers);
+        write(buffers);
+    }
+}
+
+bool HttpConnection::processHttp2(const char* bytes, const size_t size)
+{
+    waitingForHttp2Frames_ = false;
+    //unlike HTTP/1.x connections, HTTP/2 ones are kept open by proxies for as long as they are in use
+    refreshTimeout();
+
+    const auto keepConnection = http2Session_->process(bytes, size);
+
+    if (responseBuffer_.failed())
+    {
+        //frames were lost, the connection state can no longer be kept in sync with the client
+        release();
+        return false;
+    }
+    if (0 == responseBuffer_.size())
+    {
+        if (keepConnection) return true;
+
+        release();
+        return false;
     }
+    //frames are written before reading again, onWritten() then resumes reading or closes the connection
+    keepConnectionAlive_ = keepConnection;
+    writeResponseBuffers();
+    return false;
 }
 
 boost::asio::ip::address HttpConnection::getRemoteAddress(const HttpRequest& request)
@@ -144,11 +314,21 @@ boost::asio::ip::address HttpConnection::getRemoteAddress(const HttpRequest& req
     else
     {
         boost::system::error_code getAddressCode;
-        auto remoteEndpoint = socket_.remote_endpoint(getAddressCode);
-        if ( ! getAddressCode)
+        const auto remoteEndpoint = socket_.remote_endpoint(getAddressCode);
+        if (getAddressCode)
+        {
+            return {};
+        }
+        const auto family = remoteEndpoint.protocol().family();
+        if ((AF_INET == family) || (AF_INET6 == family))
         {
-            return remoteEndpoint.address();
+            boost::asio::ip::tcp::endpoint ipEndpoint;
+            std::memcpy(ipEndpoint.data(), remoteEndpoint.data(), remoteEndpoint.size());
+            ipEndpoint.resize(remoteEndpoint.size());
+            return ipEndpoint.address();
         }
+        //peers connected via a local socket are on the same host
+        return boost::asio::ip::address_v4::loopback();
     }
     return {};
 }
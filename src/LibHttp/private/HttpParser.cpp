@@ -19,7 +19,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "HttpParser.h"
 #include "HttpStringHelpers.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <limits>
 
 #include <boost/lexical_cast/try_lexical_convert.hpp>
@@ -42,12 +44,28 @@ Parser& Parser::process(char* buffer, size_t size)
     if (finished_)
     {
         //no more parsing necessary
+        unprocessedBytes_ = size;
         return *this;
     }
     while ((size > 0) && valid_ && ! finished_)//once the input contains errors, it will always contain them
     {
         (this->*currentParser_)(buffer, size);
     }
+    unprocessedBytes_ = valid_ ? size : 0;
+    return *this;
+}
+
+Parser& Parser::processStoredBody(const size_t size)
+{
+    assert(expectsBody());
+    assert(size <= remainingBodyBytes());
+
+    requestBodyBytesProcessed_ += size;
+    unprocessedBytes_ = 0;
+    if (requestBodyBytesProcessed_ >= expectedContentLength_)
+    {
+        finished_ = true;
+    }
     return *this;
 }
 
@@ -67,6 +85,7 @@ void Parser::reset()
     parseCurrentHeaderValue_ = {};
     expectedContentLength_ = 0;
     requestBodyBytesProcessed_ = 0;
+    unprocessedBytes_ = 0;
 }
 
 /**
@@ -77,23 +96,33 @@ void Parser::reset()
 static bool copyUntil(const char toSearch, char*& buffer, size_t& size, bool& valid, HttpStatusCode& errorCode,
                       char* headerBuffer, size_t& headerSize, const size_t headerBufferSize)
 {
-    bool continueLoop = true;
-    do
+    if (0 == size) return false;
+    if (headerSize >= headerBufferSize)
     {
-        if (0 == size) return false;
-        if (headerSize >= headerBufferSize)
-        {
-            valid = false;
-            errorCode = HttpStatusCode::Payload_Too_Large;
-            return false;
-        }
-        if (toSearch == *buffer) continueLoop = false;
+        valid = false;
+        errorCode = HttpStatusCode::Payload_Too_Large;
+        return false;
+    }
+    const auto toSearchIn = std::min(size, headerBufferSize - headerSize);
+    const auto found = static_cast<const char*>(std::memchr(buffer, toSearch, toSearchIn));
+    const auto toCopy = found ? static_cast<size_t>(found - buffer) + 1 : toSearchIn;
 
-        headerBuffer[headerSize++] = *buffer++;
-        --size;
+    //the bytes are usually received directly in the header buffer so there is nothing to copy
+    if (buffer != headerBuffer + headerSize)
+    {
+        std::memmove(headerBuffer + headerSize, buffer, toCopy);
     }
-    while (continueLoop);
-    return true;
+    headerSize += toCopy;
+    buffer += toCopy;
+    size -= toCopy;
+
+    if (found) return true;
+    if (size > 0)
+    {
+        valid = false;
+        errorCode = HttpStatusCode::Payload_Too_Large;
+    }
+    return false;
 }
 
 static HttpVerb parseHttpVerb(char* buffer, const size_t size)
@@ -209,6 +238,12 @@ void Parser::parseNewLine(char*& buffer, size_t& size)
             errorCode_ = HttpStatusCode::Not_Implemented;
             return;
         }
+        if (expectedContentLength_ > maxContentLength_)
+        {
+            valid_ = false;
+            errorCode_ = HttpStatusCode::Payload_Too_Large;
+            return;
+        }
         currentParser_ = &Parser::parseBody;
     }
     else
@@ -281,21 +316,19 @@ void Parser::parseHeaderValue(char*& buffer, size_t& size)
 void Parser::parseBody(char*& buffer, size_t& size)
 {
     //TODO: chunked encoding
-    if (expectedContentLength_ > maxContentLength_)
-    {
-        valid_ = false;
-        errorCode_ = HttpStatusCode::Payload_Too_Large;
-        return;
-    }
+    //the declared content length was already checked against the limit in parseNewLine()
+    //any bytes after the declared content length are the start of a pipelined request
+    const auto bodyBytes = std::min(size, expectedContentLength_ - requestBodyBytesProcessed_);
 
-    if ( ! pushBodyBytes_(buffer, size, pushBodyBytesState_))
+    if ( ! pushBodyBytes_(buffer, bodyBytes, pushBodyBytesState_))
     {
         //no more room to store the request body
         valid_ = false;
         errorCode_ = HttpStatusCode::Payload_Too_Large;
     }
-    requestBodyBytesProcessed_ += size;
-    size = 0;
+    requestBodyBytesProcessed_ += bodyBytes;
+    buffer += bodyBytes;
+    size -= bodyBytes;
     if (requestBodyBytesProcessed_ >= expectedContentLength_)
     {
         finished_ = true;
@@ -335,122 +368,98 @@ void Parser::interpretImportantHeaders()
 
 void Parser::interpretPathString()
 {
-    int state = 0;
     const auto pathStart = parsePathStartsAt_;
-    int keyStart = 0, keyEnd = 0, valueStart = 0, valueEnd = 0;
+    const auto size = request_.path.size();
+    if (0 == size) return;
+
+    //the last character is the separator that ended the path
+    const auto end = pathStart + size - 1;
 
-    auto fullPath = request_.path;
+    auto current = findFirstOf<'?'>(pathStart, end);
+    request_.path = viewAfterDecodingUrlEncodingInPlace(pathStart, current - pathStart);
+    if (current == end) return;
 
-    for (int i = 0, n = static_cast<int>(fullPath.size()); i < n; ++i)
+    while (++current < end)
     {
-        const auto c = fullPath[i];
-        switch (state)
+        const auto keyStart = current;
+        const auto keyEnd = findFirstOf<'='>(keyStart, end);
+        if (keyEnd == end) return;
+
+        const auto valueStart = keyEnd + 1;
+        const auto valueEnd = findFirstOf<'&'>(valueStart, end);
+
+        if (request_.nrOfQueryPairs < HttpRequest::MaxQueryPairs)
         {
-        case 0: //path
-            if (('?' == c) || ((i + 1) == n))
-            {
-                request_.path = viewAfterDecodingUrlEncodingInPlace(parsePathStartsAt_, i);
-                state = 1;
-                keyStart = keyEnd = i + 1;
-            }
-            break;
-        case 1: //query string key
-            if ('=' == c)
-            {
-                keyEnd = i;
-                state = 2;
-                valueStart = valueEnd = i + 1;
-            }
-            break;
-        case 2: //query string value
-            if (('&' == c) || ((i + 1) == n))
-            {
-                valueEnd = i;
-                request_.queryPairs[request_.nrOfQueryPairs].first =
-                        viewAfterDecodingUrlEncodingInPlace(keyEnd > keyStart ? pathStart + keyStart : nullptr,
-                                                            keyEnd - keyStart);
-                request_.queryPairs[request_.nrOfQueryPairs].second =
-                        viewAfterDecodingUrlEncodingInPlace(valueEnd > valueStart ? pathStart + valueStart : nullptr,
-                                                            valueEnd - valueStart);
-                request_.nrOfQueryPairs += 1;
-                keyStart = keyEnd = i + 1;
-                state = 1;
-            }
-            break;
-        default: 
-            assert(false);
-            break;
+            request_.queryPairs[request_.nrOfQueryPairs].first =
+                    viewAfterDecodingUrlEncodingInPlace(keyEnd > keyStart ? keyStart : nullptr, keyEnd - keyStart);
+            request_.queryPairs[request_.nrOfQueryPairs].second =
+                    viewAfterDecodingUrlEncodingInPlace(valueEnd > valueStart ? valueStart : nullptr,
+                                                        valueEnd - valueStart);
+            request_.nrOfQueryPairs += 1;
         }
+        current = valueEnd;
     }
 }
 
 void Parser::interpretCookies(char* value, const size_t size)
 {
-    int state = 0;
+    if (0 == size) return;
+
     const auto cookieStart = value;
-    size_t nameStart = 0, nameEnd = 0, valueStart = 0, valueEnd = 0;
+    //the last character always ends the current cookie
+    const auto lastIndex = size - 1;
 
-    for (size_t i = 0; i < size; ++i)
+    auto addCookie = [this, cookieStart](size_t nameStart, size_t nameEnd, size_t valueStart, size_t valueEnd,
+                                         const bool hasName)
     {
-        const auto c = value[i];
+        if (request_.nrOfCookies >= HttpRequest::MaxCookies) return;
 
-        switch (state)
+        if (hasName)
         {
-        case 0: //name
-            if ('=' == c)
-            {
-                nameEnd = i;
-                state = 1;
-                valueStart = valueEnd = i + 1;
-            }
-            else if ((';' == c) || ((i + 1) == size))
+            while (cookieStart[nameStart] == ' ') nameStart += 1;
+            while (cookieStart[nameEnd - 1] == ' ') nameEnd -= 1;
+        }
+        while (cookieStart[valueStart] == ' ') valueStart += 1;
+        while (cookieStart[valueEnd - 1] == ' ') valueEnd -= 1;
+
+        request_.cookies[request_.nrOfCookies].first = hasName
+                ? viewAfterDecodingUrlEncodingInPlace(nameEnd > nameStart ? cookieStart + nameStart : nullptr,
+                                                      nameEnd - nameStart)
+                : HttpStringView{};
+        request_.cookies[request_.nrOfCookies].second =
+                viewAfterDecodingUrlEncodingInPlace(valueEnd > valueStart ? cookieStart + valueStart : nullptr,
+                                                    valueEnd - valueStart);
+        request_.nrOfCookies += 1;
+    };
+
+    size_t currentStart = 0;
+    while (currentStart < size)
+    {
+        const auto separator = findFirstOf<'=', ';'>(value + currentStart, value + lastIndex) - value;
+        if (static_cast<size_t>(separator) == lastIndex)
+        {
+            if ('=' != value[lastIndex])
             {
                 //no name, just a value
-                valueEnd = i;
-                if ((i + 1) == size)
-                {
-                    valueEnd += 1;
-                }
-                while (cookieStart[valueStart] == ' ') valueStart += 1;
-                while (cookieStart[valueEnd - 1] == ' ') valueEnd -= 1;
-
-                request_.cookies[request_.nrOfCookies].first = {};
-                request_.cookies[request_.nrOfCookies].second =
-                    viewAfterDecodingUrlEncodingInPlace(valueEnd > valueStart ? cookieStart + valueStart : nullptr,
-                        valueEnd - valueStart);
-
-                request_.nrOfCookies += 1;
-                nameStart = nameEnd = valueStart = valueEnd = i + 1;
-                state = 0;
+                addCookie(currentStart, currentStart, currentStart, size, false);
             }
-            break;
-        case 1: //value
-            if ((';' == c) || ((i + 1) == size))
-            {
-                valueEnd = i;
-                if ((i + 1) == size)
-                {
-                    valueEnd += 1;
-                }
-                while (cookieStart[nameStart] == ' ') nameStart += 1;
-                while (cookieStart[nameEnd - 1] == ' ') nameEnd -= 1;
-                while (cookieStart[valueStart] == ' ') valueStart += 1;
-                while (cookieStart[valueEnd - 1] == ' ') valueEnd -= 1;
-
-                request_.cookies[request_.nrOfCookies].first =
-                        viewAfterDecodingUrlEncodingInPlace(nameEnd > nameStart ? cookieStart + nameStart : nullptr,
-                                                            nameEnd - nameStart);
-                request_.cookies[request_.nrOfCookies].second =
-                        viewAfterDecodingUrlEncodingInPlace(valueEnd > valueStart ? cookieStart + valueStart : nullptr,
-                                                            valueEnd - valueStart);
-                request_.nrOfCookies += 1;
-                nameStart = nameEnd = valueStart = valueEnd = i + 1;
-                state = 0;
-            }
-            break;
-        default: 
-            assert(false);
-            break;
+            return;
+        }
+        if (';' == value[separator])
+        {
+            //no name, just a value
+            addCookie(currentStart, currentStart, currentStart, separator, false);
+            currentStart = separator + 1;
+            continue;
+        }
+        const auto valueStart = static_cast<size_t>(separator) + 1;
+        const auto valueEnd = static_cast<size_t>(findFirstOf<';'>(value + valueStart, value + lastIndex) - value);
+        if (valueEnd == lastIndex)
+        {
+            addCookie(currentStart, separator, valueStart, size, true);
+            return;
         }
+        addCookie(currentStart, separator, valueStart, valueEnd, true);
+        currentStart = valueEnd + 1;
     }
 }
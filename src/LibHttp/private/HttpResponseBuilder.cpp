@@ -17,10 +17,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "HttpResponseBuilder.h"
+#include "HttpStringHelpers.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstdio>
+#include <iterator>
+#include <vector>
+
+#include <zlib.h>
 
 using namespace Http;
 
@@ -44,7 +49,7 @@ size_t Http::buildSimpleResponseFromStatusCode(const HttpStatusCode code, const
     const auto intCode = static_cast<int>(code);
     *buffer++ = (intCode / 100) + '0';
     *buffer++ = ((intCode / 10) % 10) + '0';
-    *buffer++ = (intCode % 100) + '0';
+    *buffer++ = (intCode % 10) + '0';
     *buffer++ = ' ';
 
     auto codeString = getStatusCodeString(code);
@@ -115,8 +120,302 @@ size_t Http::writeHttpDateGMT(time_t value, char* output)
     return currentOutput - output;
 }
 
-HttpResponseBuilder::HttpResponseBuilder(WriteFn writeFn, void* writeState)
-    : writeFn_(writeFn), writeState_(writeState)
+static HttpStringView trimWhitespace(HttpStringView value)
+{
+    while ( ! value.empty() && ((' ' == value.front()) || ('\t' == value.front())))
+    {
+        value.remove_prefix(1);
+    }
+    while ( ! value.empty() && ((' ' == value.back()) || ('\t' == value.back())))
+    {
+        value.remove_suffix(1);
+    }
+    return value;
+}
+
+/**
+ * Returns the next item of a comma separated list, removing it from the list
+ */
+static HttpStringView extractNextListItem(HttpStringView& list)
+{
+    const auto separator = list.find(',');
+    const auto result = list.substr(0, separator);
+    list.remove_prefix((HttpStringView::npos == separator) ? list.size() : (separator + 1));
+
+    return trimWhitespace(result);
+}
+
+static HttpStringView removeWeakIndicator(HttpStringView value)
+{
+    if ((value.size() > 1) && ('W' == value[0]) && ('/' == value[1]))
+    {
+        value.remove_prefix(2);
+    }
+    return value;
+}
+
+bool Http::entityTagMatches(HttpStringView ifNoneMatch, HttpStringView entityTag)
+{
+    //https://developer.mozilla.org/en-US/docs/Web/HTTP/Headers/If-None-Match
+    entityTag = removeWeakIndicator(entityTag);
+    if (entityTag.empty())
+    {
+        return false;
+    }
+
+    while ( ! ifNoneMatch.empty())
+    {
+        const auto current = extractNextListItem(ifNoneMatch);
+        if (("*" == current) || (removeWeakIndicator(current) == entityTag))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static constexpr int MaxQualityValue = 1000;
+
+/**
+ * Parses the q parameter of an Accept-Encoding item, e.g. ";q=0.5" in thousandths
+ */
+static int parseQualityValue(const HttpStringView parameters)
+{
+    const auto qPosition = parameters.find("q=");
+    if (HttpStringView::npos == qPosition)
+    {
+        return MaxQualityValue;
+    }
+    int result = 0;
+    int scale = MaxQualityValue;
+    bool afterPoint = false;
+
+    for (const char c : parameters.substr(qPosition + 2))
+    {
+        if ((c >= '0') && (c <= '9'))
+        {
+            if ( ! afterPoint)
+            {
+                result = (c - '0') * MaxQualityValue;
+            }
+            else if (scale > 1)
+            {
+                scale /= 10;
+                result += (c - '0') * scale;
+            }
+        }
+        else if (('.' == c) && ! afterPoint)
+        {
+            afterPoint = true;
+        }
+        else
+        {
+            break;
+        }
+    }
+    return std::min(result, MaxQualityValue);
+}
+
+ContentEncoding Http::chooseContentEncoding(HttpStringView acceptEncoding)
+{
+    //https://developer.mozilla.org/en-US/docs/Web/HTTP/Headers/Accept-Encoding
+    int gzipQuality = -1;
+    int deflateQuality = -1;
+    int anyQuality = -1;
+
+    while ( ! acceptEncoding.empty())
+    {
+        const auto item = extractNextListItem(acceptEncoding);
+        const auto parametersStart = item.find(';');
+        const auto coding = trimWhitespace(item.substr(0, parametersStart));
+        const auto parameters = (HttpStringView::npos == parametersStart) ? HttpStringView{}
+                                                                           : item.substr(parametersStart + 1);
+
+        if (matchStringUpperOrLower(coding, "gzipGZIP") || matchStringUpperOrLower(coding, "x-gzipX-GZIP"))
+        {
+            gzipQuality = parseQualityValue(parameters);
+        }
+        else if (matchStringUpperOrLower(coding, "deflateDEFLATE"))
+        {
+            deflateQuality = parseQualityValue(parameters);
+        }
+        else if ("*" == coding)
+        {
+            anyQuality = parseQualityValue(parameters);
+        }
+    }
+
+    //codings that are not listed explicitly are only acceptable through *
+    if (gzipQuality < 0) gzipQuality = std::max(anyQuality, 0);
+    if (deflateQuality < 0) deflateQuality = std::max(anyQuality, 0);
+
+    if ((gzipQuality > 0) && (gzipQuality >= deflateQuality))
+    {
+        return ContentEncoding::Gzip;
+    }
+    if (deflateQuality > 0)
+    {
+        return ContentEncoding::Deflate;
+    }
+    return ContentEncoding::Identity;
+}
+
+namespace
+{
+    /**
+     * Keeps a zlib stream and an output buffer per thread so they are not allocated again for every response
+     */
+    class ThreadCompressor final : boost::noncopyable
+    {
+    public:
+        ~ThreadCompressor()
+        {
+            if (initialized_)
+            {
+                deflateEnd(&stream_);
+            }
+        }
+
+        /**
+         * Compresses prefix followed by value
+         * @returns An empty view if the compression failed
+         */
+        HttpStringView compress(const HttpStringView prefix, const HttpStringView value,
+                                const ContentEncoding encoding, const int level)
+        {
+            if ( ! prepare(getWindowBits(encoding), level))
+            {
+                return {};
+            }
+
+            if (buffer_.size() > MaxBufferSizeToKeep)
+            {
+                //don't keep the memory reserved because of a previous large response
+                std::vector<char>().swap(buffer_);
+            }
+            const auto bound = deflateBound(&stream_, static_cast<uLong>(prefix.size() + value.size()));
+            if (buffer_.size() < bound)
+            {
+                buffer_.resize(bound);
+            }
+
+            stream_.next_out = reinterpret_cast<Bytef*>(buffer_.data());
+            stream_.avail_out = static_cast<uInt>(buffer_.size());
+
+            stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(prefix.data()));
+            stream_.avail_in = static_cast<uInt>(prefix.size());
+            if (Z_OK != deflate(&stream_, Z_NO_FLUSH))
+            {
+                return {};
+            }
+
+            stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(value.data()));
+            stream_.avail_in = static_cast<uInt>(value.size());
+            if (Z_STREAM_END != deflate(&stream_, Z_FINISH))
+            {
+                return {};
+            }
+
+            return HttpStringView(buffer_.data(), stream_.total_out);
+        }
+
+        /**
+         * Starts compressing input that is passed in parts to compressPart()
+         */
+        bool start(const ContentEncoding encoding, const int level)
+        {
+            return prepare(getWindowBits(encoding), level);
+        }
+
+        /**
+         * Compresses the input straight into the free memory of the storage
+         * @param finish Set for the last part, so that everything zlib still keeps is written
+         */
+        bool compressPart(const HttpStringView input, IResponseStorage& storage, const bool finish)
+        {
+            stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+            stream_.avail_in = static_cast<uInt>(input.size());
+            const auto flush = finish ? Z_FINISH : Z_NO_FLUSH;
+
+            while (true)
+            {
+                const auto output = storage.prepare();
+                const auto outputSize = boost::asio::buffer_size(output);
+                if (0 == outputSize)
+                {
+                    return false;
+                }
+                stream_.next_out = reinterpret_cast<Bytef*>(output.data());
+                stream_.avail_out = static_cast<uInt>(outputSize);
+
+                const auto result = deflate(&stream_, flush);
+                storage.commit(outputSize - stream_.avail_out);
+
+                if (Z_STREAM_END == result)
+                {
+                    return true;
+                }
+                if ((Z_OK != result) && (Z_BUF_ERROR != result))
+                {
+                    return false;
+                }
+                //until the last part, zlib can keep some of the output for later
+                if (( ! finish) && (0 == stream_.avail_in) && (stream_.avail_out > 0))
+                {
+                    return true;
+                }
+            }
+        }
+
+    private:
+        static int getWindowBits(const ContentEncoding encoding)
+        {
+            //adding 16 to the window bits produces a gzip wrapper instead of a zlib one
+            return (ContentEncoding::Gzip == encoding) ? (MAX_WBITS + 16) : MAX_WBITS;
+        }
+
+        bool prepare(const int windowBits, const int level)
+        {
+            if (initialized_ && (windowBits == windowBits_) && (level == level_))
+            {
+                //keeps the allocated internal state
+                return Z_OK == deflateReset(&stream_);
+            }
+            if (initialized_)
+            {
+                deflateEnd(&stream_);
+                initialized_ = false;
+            }
+            stream_ = {};
+            if (Z_OK != deflateInit2(&stream_, level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY))
+            {
+                return false;
+            }
+            initialized_ = true;
+            windowBits_ = windowBits;
+            level_ = level;
+            return true;
+        }
+
+        static constexpr size_t MaxBufferSizeToKeep = 1 << 20;
+
+        z_stream stream_{};
+        bool initialized_ = false;
+        int windowBits_ = 0;
+        int level_ = 0;
+        std::vector<char> buffer_;
+    };
+}
+
+static thread_local ThreadCompressor threadCompressor;
+
+static HttpStringView getContentEncodingName(const ContentEncoding encoding)
+{
+    return (ContentEncoding::Gzip == encoding) ? HttpStringView("gzip") : HttpStringView("deflate");
+}
+
+HttpResponseBuilder::HttpResponseBuilder(WriteFn writeFn, void* writeState, IResponseStorage* storage)
+    : writeFn_(writeFn), writeState_(writeState), storage_(storage)
 {
     assert(writeFn);
 }
@@ -127,6 +426,11 @@ void HttpResponseBuilder::writeResponseCode(const int majorVersion, const int mi
     assert(1 == majorVersion);
     assert((0 == minorVersion) || (1 == minorVersion));
 
+    if (storage_)
+    {
+        responseStart_ = storage_->size();
+    }
+
     char buffer[] = "HTTP/x.y zzz ";
 
     buffer[5] = majorVersion + '0';
@@ -135,7 +439,7 @@ void HttpResponseBuilder::writeResponseCode(const int majorVersion, const int mi
     const auto intCode = static_cast<int>(code);
     buffer[9] = (intCode / 100) + '0';
     buffer[10] = ((intCode / 10) % 10) + '0';
-    buffer[11] = (intCode % 100) + '0';
+    buffer[11] = (intCode % 10) + '0';
 
     write(buffer);
     write(getStatusCodeString(code));
@@ -278,3 +582,141 @@ void HttpResponseBuilder::writeBodyAndContentLength(const HttpStringView value,
     writeHeader("Content-Length", static_cast<int>(value.size() + prefix.size()));
     writeBody(value, prefix);
 }
+
+void HttpResponseBuilder::writeBodyAndContentLength(const HttpStringView value, const HttpStringView prefix,
+                                                    const BodyCompression& compression)
+{
+    assert(ProtocolState::ResponseCodeWritten == protocolState_);
+
+    writeHeader("Vary", "Accept-Encoding");
+
+    const auto size = value.size() + prefix.size();
+    if ((ContentEncoding::Identity != compression.encoding) && (size >= compression.minimumSize))
+    {
+        const auto compressed = threadCompressor.compress(prefix, value, compression.encoding, compression.level);
+        //the output can be larger than the input for data that does not compress well
+        if ( ! compressed.empty() && (compressed.size() < size))
+        {
+            writeHeader("Content-Encoding", getContentEncodingName(compression.encoding));
+            writeBodyAndContentLength(compressed);
+            return;
+        }
+    }
+    writeBodyAndContentLength(value, prefix);
+}
+
+//room for the Content-Length of a body written in parts, which is only known at the end
+static constexpr char ContentLengthPlaceholder[] = "          ";
+static constexpr size_t ContentLengthPlaceholderSize = std::size(ContentLengthPlaceholder) - 1;
+
+void HttpResponseBuilder::startBodyInParts()
+{
+    assert(ProtocolState::ResponseCodeWritten == protocolState_);
+    assert(storage_);
+
+    write("Content-Length: ");
+    contentLengthValueStart_ = storage_->size();
+    write(ContentLengthPlaceholder);
+    write("\r\n\r\n");
+    bodyStart_ = storage_->size();
+
+    compressBodyParts_ = false;
+    bodyPartsFailed_ = false;
+    protocolState_ = ProtocolState::WritingBodyInParts;
+}
+
+void HttpResponseBuilder::startBodyInParts(const BodyCompression& compression, const size_t sizeSoFar)
+{
+    assert(ProtocolState::ResponseCodeWritten == protocolState_);
+
+    writeHeader("Vary", "Accept-Encoding");
+
+    //unlike for complete bodies, there is no going back if the compressed output turns out larger
+    const auto compress = (ContentEncoding::Identity != compression.encoding)
+                          && (sizeSoFar >= compression.minimumSize)
+                          && threadCompressor.start(compression.encoding, compression.level);
+    if (compress)
+    {
+        writeHeader("Content-Encoding", getContentEncodingName(compression.encoding));
+    }
+    startBodyInParts();
+    compressBodyParts_ = compress;
+}
+
+void HttpResponseBuilder::writeBodyPart(const HttpStringView value)
+{
+    assert(ProtocolState::WritingBodyInParts == protocolState_);
+
+    if ( ! compressBodyParts_)
+    {
+        write(value);
+        return;
+    }
+    if (( ! bodyPartsFailed_) && ( ! threadCompressor.compressPart(value, *storage_, false)))
+    {
+        bodyPartsFailed_ = true;
+    }
+}
+
+boost::asio::mutable_buffer HttpResponseBuilder::prepareBodyPart()
+{
+    assert(ProtocolState::WritingBodyInParts == protocolState_);
+
+    if (compressBodyParts_)
+    {
+        return {};
+    }
+    return storage_->prepare();
+}
+
+void HttpResponseBuilder::commitBodyPart(const size_t size)
+{
+    assert(ProtocolState::WritingBodyInParts == protocolState_);
+    assert( ! compressBodyParts_);
+
+    storage_->commit(size);
+}
+
+bool HttpResponseBuilder::endBodyInParts()
+{
+    assert(ProtocolState::WritingBodyInParts == protocolState_);
+
+    if (compressBodyParts_ && ( ! bodyPartsFailed_) && ( ! threadCompressor.compressPart({}, *storage_, true)))
+    {
+        bodyPartsFailed_ = true;
+    }
+    protocolState_ = ProtocolState::BodyWritten;
+
+    //the storage stops growing if it runs out of room
+    if ((contentLengthValueStart_ + ContentLengthPlaceholderSize) > storage_->size())
+    {
+        return false;
+    }
+    auto bodySize = storage_->size() - bodyStart_;
+
+    //the value is aligned to the right, the whitespace before it is ignored
+    char value[ContentLengthPlaceholderSize];
+    std::fill(std::begin(value), std::end(value), ' ');
+    auto position = ContentLengthPlaceholderSize;
+    do
+    {
+        value[--position] = '0' + (bodySize % 10);
+        bodySize /= 10;
+    } while ((bodySize > 0) && (position > 0));
+
+    if (bodySize > 0)
+    {
+        return false;
+    }
+    storage_->overwrite(contentLengthValueStart_, value, ContentLengthPlaceholderSize);
+
+    return ! bodyPartsFailed_;
+}
+
+void HttpResponseBuilder::discardResponse()
+{
+    assert(storage_);
+
+    storage_->truncate(responseStart_);
+    protocolState_ = ProtocolState::NothingWritten;
+}
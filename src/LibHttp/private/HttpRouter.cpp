@@ -20,12 +20,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "HttpStringHelpers.h"
 
 #include <algorithm>
+#include <cassert>
 #include <cstdint>
+#include <cstring>
+#include <limits>
 
 using namespace Http;
 
 const size_t HttpRouter::MaxRouteSize;
-const size_t HttpRouter::FirstIndexMaxValue;
 
 void RequestState::extractExtraPathParts(size_t nrOfPathCharactersUsedInRoute)
 {
@@ -35,24 +37,23 @@ void RequestState::extractExtraPathParts(size_t nrOfPathCharactersUsedInRoute)
     {
         nrOfPathCharactersUsedInRoute += 1;
     }
-    auto currentPartStartIndex = nrOfPathCharactersUsedInRoute;
+    const auto pathEnd = path + request.path.size();
+    auto currentPartStart = path + nrOfPathCharactersUsedInRoute;
 
-    for (auto i = nrOfPathCharactersUsedInRoute, n = request.path.size(); i < n; ++i)
+    while (currentPartStart < pathEnd)
     {
         if (nrOfExtraPathParts >= (MaxExtraPathParts - 1))
         {
             return;
         }
-        if (path[i] == '/')
+        const auto separator = static_cast<const char*>(std::memchr(currentPartStart, '/', pathEnd - currentPartStart));
+        if ( ! separator)
         {
-            extraPathParts[nrOfExtraPathParts++] = HttpStringView(path + currentPartStartIndex, i - currentPartStartIndex);
-            currentPartStartIndex = i + 1;
+            extraPathParts[nrOfExtraPathParts++] = HttpStringView(currentPartStart, pathEnd - currentPartStart);
+            return;
         }
-    }
-    const auto lastPartLength = request.path.size() - currentPartStartIndex;
-    if ((lastPartLength > 0) && (lastPartLength <= request.path.size()))
-    {
-        extraPathParts[nrOfExtraPathParts++] = HttpStringView(path + currentPartStartIndex, lastPartLength);
+        extraPathParts[nrOfExtraPathParts++] = HttpStringView(currentPartStart, separator - currentPartStart);
+        currentPartStart = separator + 1;
     }
 }
 
@@ -65,65 +66,139 @@ static void writeNotFound(const HttpRequest& request, HttpResponseBuilder& respo
     response.writeBodyAndContentLength(HttpStringView(reply, std::size(reply) - 1));
 }
 
-static uint8_t getFirstIndexForRoutes(const char* path, size_t length)
+HttpRouter::MatchedRoute HttpRouter::findRoute(const HttpVerb verb, const HttpStringView path) const
 {
-    const auto firstChar = length > 0 ? static_cast<uint8_t>(path[0]) : 0;
-    return firstChar % HttpRouter::FirstIndexMaxValue;
-}
+    static_assert(std::size(CharToLower) > 255, "CharToLower is not big enough");
 
-void HttpRouter::forward(const HttpRequest& request, HttpResponseBuilder& response)
-{
-    char tempPath[MaxRouteSize + 1];
-    auto tempPathLength = std::min(request.path.size(), MaxRouteSize);
+    const TrieNode* node = &nodes_[roots_[static_cast<size_t>(verb)]];
+    MatchedRoute result{ (node->handlerIndex >= 0) ? &handlers_[node->handlerIndex] : nullptr, 0 };
 
-    static_assert(std::size(CharToLower) > 255, "CharToLower is not big enough");
+    //paths are matched as if they always ended in /
+    const auto pathSize = path.size();
+    const auto charactersToMatch = ((pathSize > 0) && ('/' == path.back())) ? pathSize : pathSize + 1;
+
+    for (size_t i = 0; i < charactersToMatch; ++i)
+    {
+        const auto key = (i < pathSize) ? static_cast<char>(CharToLower[static_cast<uint8_t>(path[i])]) : '/';
+        const char* childKeys = nodeKeys_.data() + node->firstChild;
+        uint32_t childIndex = 0;
+        while ((childIndex < node->nrOfChildren) && (childKeys[childIndex] != key))
+        {
+            ++childIndex;
+        }
+        if (childIndex == node->nrOfChildren)
+        {
+            break;
+        }
+        node = &nodes_[node->firstChild + childIndex];
+        if (node->handlerIndex >= 0)
+        {
+            result = { &handlers_[node->handlerIndex], std::min(i + 1, pathSize) };
+        }
+    }
+    return result;
+}
 
-    std::transform(request.path.begin(), request.path.begin() + tempPathLength, tempPath,
-                   [](char c) { return static_cast<char>(CharToLower[static_cast<uint8_t>(c)]); });
+void HttpRouter::forward(const HttpRequest& request, HttpResponseBuilder& response) const
+{
+    assert(frozen_);
 
-    if (tempPath[tempPathLength - 1] != '/')
+    const auto [handler, nrOfPathCharactersUsed] = findRoute(request.verb, request.path);
+    if (handler)
     {
-        tempPath[tempPathLength++] = '/';
+        if (*handler)
+        {
+            RequestState state(request, response, nrOfPathCharactersUsed);
+            (*handler)(state);
+        }
     }
+    else if (defaultRoute_)
+    {
+        RequestState state(request, response, 0);
+        defaultRoute_(state);
+    }
+    else
+    {
+        writeNotFound(request, response);
+    }
+}
+
+void HttpRouter::addRoute(const HttpStringView pathLowerCase, const HttpVerb verb, const RouteHandler handler)
+{
+    assert( ! frozen_);
+    assert(pathLowerCase.size() <= MaxRouteSize);
+    assert(handlers_.size() < static_cast<size_t>(std::numeric_limits<decltype(TrieNode::handlerIndex)>::max()));
+
+    handlers_.push_back(handler);
+    routesToAdd_[static_cast<size_t>(verb)].push_back({ std::string(pathLowerCase), handlers_.size() - 1 });
+}
 
-    bool routeFound = false;
-    for (auto& pair : routes_[getFirstIndexForRoutes(tempPath, tempPathLength)][static_cast<size_t>(request.verb)])
+void HttpRouter::setDefaultRoute(const RouteHandler handler)
+{
+    defaultRoute_ = handler;
+}
+
+void HttpRouter::freeze()
+{
+    if (frozen_) return;
+    frozen_ = true;
+
+    for (size_t verb = 0; verb < static_cast<size_t>(HttpVerb::HTTP_VERBS_COUNT); ++verb)
     {
-        auto& currentPath = pair.first;
-        if (currentPath.size() <= tempPathLength)
+        auto& routesToAdd = routesToAdd_[verb];
+        //keep the first handler registered for a path
+        std::stable_sort(routesToAdd.begin(), routesToAdd.end(),
+                         [](const RouteToAdd& first, const RouteToAdd& second) { return first.path < second.path; });
+
+        std::vector<std::pair<HttpStringView, size_t>> routes;
+        for (const auto& route : routesToAdd)
         {
-            if (std::equal(pair.first.begin(), pair.first.end(), tempPath))
-            {
-                if (pair.second)
-                {
-                    RequestState state(request, response, currentPath.size());
-                    pair.second(state);
-                }
-                routeFound = true;
-                break;
-            }
+            routes.emplace_back(route.path, route.handlerIndex);
         }
+
+        roots_[verb] = static_cast<uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+        nodeKeys_.push_back(0);
+        addTrieLevel(roots_[verb], routes);
+
+        routesToAdd = {};
     }
-    if ( ! routeFound)
+}
+
+void HttpRouter::addTrieLevel(const uint32_t nodeIndex, std::vector<std::pair<HttpStringView, size_t>>& routes)
+{
+    //routes are sorted, so the ones continuing with the same character are next to each other
+    std::vector<char> childKeys;
+    std::vector<std::vector<std::pair<HttpStringView, size_t>>> childRoutes;
+
+    for (const auto& [path, handlerIndex] : routes)
     {
-        if (defaultRoute_)
+        if (path.empty())
         {
-            RequestState state(request, response, 0);
-            defaultRoute_(state);
+            if (nodes_[nodeIndex].handlerIndex < 0)
+            {
+                nodes_[nodeIndex].handlerIndex = static_cast<decltype(TrieNode::handlerIndex)>(handlerIndex);
+            }
+            continue;
         }
-        else
+        if (childKeys.empty() || (childKeys.back() != path.front()))
         {
-            writeNotFound(request, response);
+            childKeys.push_back(path.front());
+            childRoutes.emplace_back();
         }
+        childRoutes.back().emplace_back(path.substr(1), handlerIndex);
     }
-}
+    if (childKeys.empty()) return;
 
-void HttpRouter::addRoute(HttpStringView pathLowerCase, HttpVerb verb, HandlerFn&& handler)
-{
-    routes_[getFirstIndexForRoutes(pathLowerCase.data(), pathLowerCase.length())][static_cast<size_t>(verb)].emplace(pathLowerCase, handler);
-}
+    const auto firstChild = static_cast<uint32_t>(nodes_.size());
+    nodes_[nodeIndex].firstChild = firstChild;
+    nodes_[nodeIndex].nrOfChildren = static_cast<uint16_t>(childKeys.size());
 
-void HttpRouter::setDefaultRoute(HandlerFn&& handler)
-{
-    defaultRoute_ = std::move(handler);
+    nodes_.resize(nodes_.size() + childKeys.size());
+    nodeKeys_.insert(nodeKeys_.end(), childKeys.begin(), childKeys.end());
+
+    for (size_t i = 0; i < childKeys.size(); ++i)
+    {
+        addTrieLevel(firstChild + static_cast<uint32_t>(i), childRoutes[i]);
+    }
 }
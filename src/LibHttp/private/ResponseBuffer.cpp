@@ -0,0 +1,285 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ResponseBuffer.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace Http;
+
+ResponseOverflowBudget::ResponseOverflowBudget(const size_t maxSize) : maxSize_(maxSize)
+{}
+
+bool ResponseOverflowBudget::tryReserve(const size_t size)
+{
+    auto used = used_.load();
+    do
+    {
+        if ((size > maxSize_) || (used > (maxSize_ - size)))
+        {
+            return false;
+        }
+    } while ( ! used_.compare_exchange_weak(used, used + size));
+
+    return true;
+}
+
+void ResponseOverflowBudget::release(const size_t size)
+{
+    used_ -= size;
+}
+
+ResponseBuffer::ResponseBuffer(WriteBufferPoolType& writeBufferPool, ResponseOverflowBudget& overflowBudget,
+                               const size_t maxOverflowSize) :
+    pooled_(writeBufferPool), overflowBudget_(overflowBudget), maxOverflowSize_(maxOverflowSize)
+{}
+
+ResponseBuffer::~ResponseBuffer()
+{
+    reset();
+}
+
+bool ResponseBuffer::write(const char* data, size_t size)
+{
+    if (failed()) return false;
+
+    if (0 == overflowSize_)
+    {
+        const auto sizeBefore = pooled_.size();
+        if (pooled_.write(data, size))
+        {
+            return true;
+        }
+        //the pooled buffers are full or the pool has run out, only part of the data was copied
+        const auto written = pooled_.size() - sizeBefore;
+        data += written;
+        size -= written;
+    }
+
+    if ( ! reserveOverflow(overflowSize_ + size))
+    {
+        return false;
+    }
+    std::copy(data, data + size, overflow_.get() + overflowSize_);
+    overflowSize_ += size;
+    return true;
+}
+
+bool ResponseBuffer::reserveOverflow(const size_t required)
+{
+    if (required <= overflowReserved_)
+    {
+        return true;
+    }
+    if (required > maxOverflowSize_)
+    {
+        errorCode_ = HttpStatusCode::Internal_Server_Error;
+        return false;
+    }
+    //reserve geometrically, so that the shared budget is not updated for each write
+    constexpr size_t MinimumReservation = 64 * 1024;
+    const auto newReserved = std::min(std::max({ required, 2 * overflowReserved_, MinimumReservation }),
+                                      maxOverflowSize_);
+    if ( ! overflowBudget_.tryReserve(newReserved - overflowReserved_))
+    {
+        errorCode_ = HttpStatusCode::Service_Unavailable;
+        return false;
+    }
+    auto newOverflow = std::unique_ptr<char[]>(new char[newReserved]);
+    std::copy(overflow_.get(), overflow_.get() + overflowSize_, newOverflow.get());
+    std::swap(overflow_, newOverflow);
+    overflowReserved_ = newReserved;
+    return true;
+}
+
+boost::asio::mutable_buffer ResponseBuffer::prepare()
+{
+    if (failed()) return {};
+
+    if (0 == overflowSize_)
+    {
+        const auto buffer = pooled_.prepare();
+        if (boost::asio::buffer_size(buffer) > 0)
+        {
+            preparedPooled_ = true;
+            return buffer;
+        }
+    }
+    preparedPooled_ = false;
+
+    if (overflowSize_ >= maxOverflowSize_)
+    {
+        errorCode_ = HttpStatusCode::Internal_Server_Error;
+        return {};
+    }
+    constexpr size_t MinimumPreparedOverflow = 16 * 1024;
+    if ( ! reserveOverflow(std::min(overflowSize_ + MinimumPreparedOverflow, maxOverflowSize_)))
+    {
+        return {};
+    }
+    return boost::asio::mutable_buffer(overflow_.get() + overflowSize_, overflowReserved_ - overflowSize_);
+}
+
+void ResponseBuffer::commit(const size_t size)
+{
+    if (std::exchange(preparedPooled_, false))
+    {
+        pooled_.commit(size);
+    }
+    else
+    {
+        overflowSize_ += size;
+    }
+}
+
+void ResponseBuffer::overwrite(size_t offset, const char* data, size_t size)
+{
+    const auto pooledSize = pooled_.size();
+    if (offset < pooledSize)
+    {
+        const auto toCopy = std::min(size, pooledSize - offset);
+        pooled_.overwrite(offset, data, toCopy);
+        offset += toCopy;
+        data += toCopy;
+        size -= toCopy;
+    }
+    std::copy(data, data + size, overflow_.get() + (offset - pooledSize));
+}
+
+void ResponseBuffer::truncate(const size_t size)
+{
+    const auto pooledSize = pooled_.size();
+    if (size >= pooledSize)
+    {
+        overflowSize_ = std::min(overflowSize_, size - pooledSize);
+        return;
+    }
+    overflowSize_ = 0;
+    pooled_.truncate(size);
+}
+
+void ResponseBuffer::getBuffers(std::vector<boost::asio::const_buffer>& output) const
+{
+    if (pooled_.size() > 0)
+    {
+        for (const auto buffer : pooled_.constBufferWrapper())
+        {
+            output.push_back(buffer);
+        }
+    }
+    if (overflowSize_ > 0)
+    {
+        output.push_back(boost::asio::buffer(overflow_.get(), overflowSize_));
+    }
+}
+
+void ResponseBuffer::reset()
+{
+    pooled_.reset();
+    //large responses are rare, don't keep the memory around
+    overflow_.reset();
+    overflowSize_ = 0;
+    preparedPooled_ = false;
+    overflowBudget_.release(std::exchange(overflowReserved_, 0));
+    errorCode_ = HttpStatusCode::OK;
+}
+
+BudgetedResponseStorage::BudgetedResponseStorage(std::vector<char>& output, ResponseOverflowBudget& overflowBudget,
+                                                 const size_t maxSize) :
+    output_(output), overflowBudget_(overflowBudget), maxSize_(maxSize)
+{}
+
+BudgetedResponseStorage::~BudgetedResponseStorage()
+{
+    overflowBudget_.release(reserved_);
+}
+
+bool BudgetedResponseStorage::write(const char* data, const size_t size)
+{
+    if (failed_ || ( ! reserve(output_.size() + size))) return false;
+
+    output_.insert(output_.end(), data, data + size);
+    return true;
+}
+
+bool BudgetedResponseStorage::reserve(const size_t required)
+{
+    if (required <= reserved_)
+    {
+        return true;
+    }
+    if (required > maxSize_)
+    {
+        failed_ = true;
+        return false;
+    }
+    //reserve geometrically, so that the shared budget is not updated for each write
+    constexpr size_t MinimumReservation = 16 * 1024;
+    const auto newReserved = std::min(std::max({ required, 2 * reserved_, MinimumReservation }), maxSize_);
+    if ( ! overflowBudget_.tryReserve(newReserved - reserved_))
+    {
+        failed_ = true;
+        return false;
+    }
+    reserved_ = newReserved;
+    return true;
+}
+
+boost::asio::mutable_buffer BudgetedResponseStorage::prepare()
+{
+    constexpr size_t BlockSize = 16384;
+
+    if (failed_) return {};
+
+    const auto stored = size();
+    const auto toPrepare = std::min(BlockSize, maxSize_ - std::min(stored, maxSize_));
+    if ((0 == toPrepare) || ( ! reserve(stored + toPrepare)))
+    {
+        failed_ = true;
+        return {};
+    }
+    output_.resize(stored + toPrepare);
+    prepared_ = toPrepare;
+    return boost::asio::mutable_buffer(output_.data() + stored, toPrepare);
+}
+
+void BudgetedResponseStorage::commit(const size_t size)
+{
+    output_.resize(output_.size() - prepared_ + size);
+    prepared_ = 0;
+}
+
+void BudgetedResponseStorage::overwrite(const size_t offset, const char* data, const size_t size)
+{
+    std::copy(data, data + size, output_.data() + offset);
+}
+
+void BudgetedResponseStorage::truncate(const size_t size)
+{
+    output_.resize(size);
+    prepared_ = 0;
+}
+
+void BudgetedResponseStorage::reset()
+{
+    output_.clear();
+    prepared_ = 0;
+    failed_ = false;
+    overflowBudget_.release(std::exchange(reserved_, 0));
+}
@@ -0,0 +1,131 @@
+/*
+Fast Forum Backend
+Copyright (C) Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "StreamSocketListener.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Http;
+
+/**
+ * Removes a socket file left behind at the path by a previous run
+ * @returns false if the path exists but is not a socket, in which case it is left untouched
+ */
+static bool removeStaleSocketFile(const std::string& path)
+{
+    struct stat status{};
+    if (0 != ::lstat(path.c_str(), &status))
+    {
+        //nothing to remove; other errors are reported when binding
+        return true;
+    }
+    if ( ! S_ISSOCK(status.st_mode))
+    {
+        return false;
+    }
+    ::unlink(path.c_str());
+    return true;
+}
+
+StreamSocketListener::StreamSocketListener(boost::asio::io_service& ioService, std::string_view listenIpAddress,
+    const uint16_t listenPort, std::shared_ptr<IConnectionManager> connectionManager) :
+
+    endpoint_{ boost::asio::ip::tcp::endpoint{ boost::asio::ip::address::from_string(std::string{ listenIpAddress }),
+                                               listenPort } },
+    acceptor_{ ioService }, currentSocket_{ ioService },
+    connectionManager_{ std::move(connectionManager) }, listening_{ false }
+{}
+
+StreamSocketListener::StreamSocketListener(boost::asio::io_service& ioService, std::string_view unixSocketPath,
+    std::shared_ptr<IConnectionManager> connectionManager) :
+
+    endpoint_{ boost::asio::local::stream_protocol::endpoint{ unixSocketPath } },
+    unixSocketPath_{ unixSocketPath }, acceptor_{ ioService }, currentSocket_{ ioService },
+    connectionManager_{ std::move(connectionManager) }, listening_{ false }
+{}
+
+StreamSocketListener::~StreamSocketListener()
+{
+    if (listening_)
+    {
+        stopListening();
+    }
+}
+
+void StreamSocketListener::startListening()
+{
+    if (listening_) return;
+
+    //a socket file left behind by a previous run would make bind fail
+    if (( ! unixSocketPath_.empty()) && ( ! removeStaleSocketFile(unixSocketPath_)))
+    {
+        throw boost::system::system_error(make_error_code(boost::system::errc::file_exists),
+                                          "Refusing to replace a file that is not a socket: " + unixSocketPath_);
+    }
+    listening_ = true;
+
+    acceptor_.open(endpoint_.protocol());
+    if (unixSocketPath_.empty())
+    {
+        acceptor_.set_option(boost::asio::socket_base::reuse_address(true));
+    }
+    acceptor_.bind(endpoint_);
+    acceptor_.listen();
+
+    startAccept();
+}
+
+void StreamSocketListener::stopListening()
+{
+    if ( ! listening_) return;
+    listening_ = false;
+
+    boost::asio::dispatch(acceptor_.get_executor(), [this]
+    {
+        boost::system::error_code ec;
+        this->acceptor_.close(ec);
+    });
+    if ( ! unixSocketPath_.empty())
+    {
+        removeStaleSocketFile(unixSocketPath_);
+    }
+
+    connectionManager_->stop();
+}
+
+void StreamSocketListener::startAccept()
+{
+    acceptor_.async_accept(currentSocket_, [this](const boost::system::error_code& ec) { this->onAccept(ec); });
+}
+
+void StreamSocketListener::onAccept(const boost::system::error_code& ec)
+{
+    if ( ! acceptor_.is_open())
+    {
+        return;
+    }
+    if (ec)
+    {
+        //TODO: handle error
+        return;
+    }
+    connectionManager_->newConnection(nullptr, std::move(currentSocket_));
+
+    startAccept();
+}
@@ -20,7 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 using namespace Http;
 
-StreamingConnection::StreamingConnection(IConnectionManager& connectionManager, boost::asio::ip::tcp::socket&& socket, 
+StreamingConnection::StreamingConnection(IConnectionManager& connectionManager, StreamSocket&& socket, 
                                          boost::asio::io_context& context)
     : socket_{std::move(socket)}, strand_{context}, connectionManager_(connectionManager)
 {}
@@ -30,30 +30,48 @@ void StreamingConnection::release()
     connectionManager_.closeConnection(this);
 }
 
+void StreamingConnection::refreshTimeout()
+{
+    connectionManager_.refreshConnection(this);
+}
+
 void StreamingConnection::startReading()
 {
     boost::asio::post(strand_, [this]()
     {
-        boost::asio::async_read(socket_, boost::asio::buffer(readBuffer_), boost::asio::transfer_at_least(1),
+        const auto buffer = nextReadBuffer();
+        auto* bytes = static_cast<char*>(buffer.data());
+
+        boost::asio::async_read(socket_, buffer, boost::asio::transfer_at_least(1),
             strand_.wrap(
-                [this](const boost::system::error_code& ec, const size_t bytesTransferred)
+                [this, bytes](const boost::system::error_code& ec, const size_t bytesTransferred)
                 {
-                    this->onRead(ec, bytesTransferred);
+                    this->onRead(ec, bytes, bytesTransferred);
                 }));
     });
 }
 
+boost::asio::mutable_buffer StreamingConnection::nextReadBuffer()
+{
+    return boost::asio::buffer(readBuffer_);
+}
+
 void StreamingConnection::disconnect()
 {
     closeSocket(socket_);
 }
 
-void StreamingConnection::onRead(const boost::system::error_code& ec, const size_t bytesTransferred)
+void StreamingConnection::onReadClosed()
+{
+    //connection closed, nothing more to do regarding this connection
+    release();
+}
+
+void StreamingConnection::onRead(const boost::system::error_code& ec, char* bytes, const size_t bytesTransferred)
 {
     if (ec == boost::asio::error::eof)
     {
-        //connection closed, nothing more to do regarding this connection
-        release();
+        onReadClosed();
         return;
     }
     if (ec)
@@ -69,7 +87,7 @@ void StreamingConnection::onRead(const boost::system::error_code& ec, const size
         return;
     }
 
-    if (onBytesRead(readBuffer_.data(), bytesTransferred))
+    if (onBytesRead(bytes, bytesTransferred))
     {
         startReading();
     }
@@ -87,7 +105,7 @@ void StreamingConnection::onWritten(const boost::system::error_code& ec, const s
     onWritten(bytesTransferred);
 }
 
-void Http::closeSocket(boost::asio::ip::tcp::socket& socket)
+void Http::closeSocket(StreamSocket& socket)
 {
     try
     {
@@ -0,0 +1,224 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TestHelpers.h"
+#include "private/AuthStore.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Forum::Commands;
+using namespace Forum::Helpers;
+
+static bool findAuthId(const AuthStore& store, const std::string& authToken, std::string& authId)
+{
+    return store.find(authToken, [&authId](std::string_view value) { authId = value; });
+}
+
+static std::string tokenName(const int index)
+{
+    return "token" + std::to_string(index);
+}
+
+BOOST_AUTO_TEST_CASE( AuthStore_finds_added_tokens_until_they_expire )
+{
+    AuthStore store;
+    std::string authId;
+    {
+        TimestampChanger _(1000);
+        store.add("token", "id", 100);
+
+        BOOST_REQUIRE(findAuthId(store, "token", authId));
+        BOOST_REQUIRE_EQUAL("id", authId);
+        BOOST_REQUIRE( ! findAuthId(store, "other token", authId));
+    }
+    {
+        TimestampChanger _(1100);
+        BOOST_REQUIRE(findAuthId(store, "token", authId));
+    }
+    {
+        TimestampChanger _(1101);
+        BOOST_REQUIRE( ! findAuthId(store, "token", authId));
+    }
+}
+
+BOOST_AUTO_TEST_CASE( AuthStore_keeps_the_existing_mapping_of_a_token_until_it_expires )
+{
+    AuthStore store;
+    std::string authId;
+    {
+        TimestampChanger _(1000);
+        store.add("token", "id1", 100);
+        store.add("token", "id2", 100);
+
+        BOOST_REQUIRE(findAuthId(store, "token", authId));
+        BOOST_REQUIRE_EQUAL("id1", authId);
+    }
+    {
+        TimestampChanger _(2000);
+        store.add("token", "id2", 100);
+
+        BOOST_REQUIRE(findAuthId(store, "token", authId));
+        BOOST_REQUIRE_EQUAL("id2", authId);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( AuthStore_removes_expired_tokens_from_all_shards )
+{
+    AuthStore store;
+    std::string authId;
+
+    //enough tokens to be spread across all shards
+    const int nrOfTokens = 2000;
+    {
+        TimestampChanger _(1000);
+        for (int i = 0; i < nrOfTokens; ++i)
+        {
+            store.add(tokenName(i), std::to_string(i), (i % 2) ? 100 : 1000);
+        }
+        for (int i = 0; i < nrOfTokens; ++i)
+        {
+            BOOST_REQUIRE(findAuthId(store, tokenName(i), authId));
+            BOOST_REQUIRE_EQUAL(std::to_string(i), authId);
+        }
+    }
+    {
+        TimestampChanger _(1500);
+        store.cleanup();
+
+        for (int i = 0; i < nrOfTokens; ++i)
+        {
+            BOOST_REQUIRE_EQUAL((i % 2) == 0, findAuthId(store, tokenName(i), authId));
+        }
+
+        //removed tokens can receive a new mapping
+        store.add(tokenName(1), "new id", 100);
+        BOOST_REQUIRE(findAuthId(store, tokenName(1), authId));
+        BOOST_REQUIRE_EQUAL("new id", authId);
+    }
+    {
+        TimestampChanger _(3000);
+        store.cleanup();
+
+        for (int i = 0; i < nrOfTokens; ++i)
+        {
+            BOOST_REQUIRE( ! findAuthId(store, tokenName(i), authId));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( AuthStore_removes_expired_tokens_after_the_entries_are_rehashed )
+{
+    AuthStore store;
+    std::string authId;
+
+    const int nrOfExpiringTokens = 100;
+    const int nrOfTokens = 20000;
+    {
+        TimestampChanger _(1000);
+        for (int i = 0; i < nrOfExpiringTokens; ++i)
+        {
+            store.add(tokenName(i), std::to_string(i), 10);
+        }
+    }
+    {
+        //adding many more tokens to each shard rehashes the entries multiple times
+        TimestampChanger _(1005);
+        for (int i = nrOfExpiringTokens; i < nrOfTokens; ++i)
+        {
+            store.add(tokenName(i), std::to_string(i), 1000);
+        }
+        for (int i = 0; i < nrOfTokens; ++i)
+        {
+            BOOST_REQUIRE(findAuthId(store, tokenName(i), authId));
+            BOOST_REQUIRE_EQUAL(std::to_string(i), authId);
+        }
+    }
+    {
+        TimestampChanger _(1100);
+        store.cleanup();
+
+        for (int i = 0; i < nrOfTokens; ++i)
+        {
+            BOOST_REQUIRE_EQUAL(i >= nrOfExpiringTokens, findAuthId(store, tokenName(i), authId));
+        }
+
+        //the removed tokens can receive new mappings
+        for (int i = 0; i < nrOfExpiringTokens; ++i)
+        {
+            store.add(tokenName(i), "new id", 100);
+            BOOST_REQUIRE(findAuthId(store, tokenName(i), authId));
+            BOOST_REQUIRE_EQUAL("new id", authId);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( AuthStore_supports_concurrent_access )
+{
+    AuthStore store;
+
+    const int nrOfThreads = 8;
+    const int tokensPerThread = 2000;
+    std::atomic<int> mismatches{ 0 };
+
+    std::vector<std::thread> threads;
+    for (int threadIndex = 0; threadIndex < nrOfThreads; ++threadIndex)
+    {
+        threads.emplace_back([&store, &mismatches, threadIndex]()
+        {
+            std::string authId;
+            for (int i = 0; i < tokensPerThread; ++i)
+            {
+                const auto index = threadIndex * tokensPerThread + i;
+                store.add(tokenName(index), std::to_string(index), 3600);
+
+                if ( ! findAuthId(store, tokenName(index), authId) || (authId != std::to_string(index)))
+                {
+                    ++mismatches;
+                }
+                //tokens of other threads might not be added yet, but if found they must be mapped correctly
+                const auto otherIndex = ((threadIndex + 1) % nrOfThreads) * tokensPerThread + i;
+                if (findAuthId(store, tokenName(otherIndex), authId) && (authId != std::to_string(otherIndex)))
+                {
+                    ++mismatches;
+                }
+                if (0 == (i % 500))
+                {
+                    store.cleanup();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    BOOST_REQUIRE_EQUAL(0, mismatches.load());
+
+    std::string authId;
+    for (int i = 0; i < nrOfThreads * tokensPerThread; ++i)
+    {
+        BOOST_REQUIRE(findAuthId(store, tokenName(i), authId));
+        BOOST_REQUIRE_EQUAL(std::to_string(i), authId);
+    }
+}
@@ -0,0 +1,80 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CompressedBitmap.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Forum::Helpers;
+
+BOOST_AUTO_TEST_CASE( CompressedBitmap_is_empty_by_default )
+{
+    CompressedBitmap bitmap;
+
+    BOOST_REQUIRE(bitmap.empty());
+    BOOST_REQUIRE_EQUAL(0u, bitmap.size());
+    BOOST_REQUIRE( ! bitmap.contains(0));
+    BOOST_REQUIRE( ! bitmap.contains(123456));
+}
+
+BOOST_AUTO_TEST_CASE( CompressedBitmap_only_contains_inserted_values )
+{
+    CompressedBitmap bitmap;
+
+    BOOST_REQUIRE(bitmap.insert(5));
+    BOOST_REQUIRE(bitmap.insert(70000));
+    BOOST_REQUIRE(bitmap.insert(4000000000u));
+    BOOST_REQUIRE( ! bitmap.insert(70000));
+
+    BOOST_REQUIRE_EQUAL(3u, bitmap.size());
+    BOOST_REQUIRE(bitmap.contains(5));
+    BOOST_REQUIRE(bitmap.contains(70000));
+    BOOST_REQUIRE(bitmap.contains(4000000000u));
+    BOOST_REQUIRE( ! bitmap.contains(6));
+    BOOST_REQUIRE( ! bitmap.contains(5 + 65536));
+}
+
+BOOST_AUTO_TEST_CASE( CompressedBitmap_keeps_values_when_switching_to_dense_storage )
+{
+    CompressedBitmap bitmap;
+
+    const uint32_t nrOfValues = 20000;
+    for (uint32_t i = 0; i < nrOfValues; ++i)
+    {
+        BOOST_REQUIRE(bitmap.insert(i * 3));
+    }
+
+    BOOST_REQUIRE_EQUAL(nrOfValues, bitmap.size());
+    for (uint32_t i = 0; i < nrOfValues * 3; ++i)
+    {
+        BOOST_REQUIRE_EQUAL(0 == (i % 3), bitmap.contains(i));
+    }
+}
+
+BOOST_AUTO_TEST_CASE( CompressedBitmap_can_be_cleared )
+{
+    CompressedBitmap bitmap;
+
+    bitmap.insert(1);
+    bitmap.insert(100000);
+    bitmap.clear();
+
+    BOOST_REQUIRE(bitmap.empty());
+    BOOST_REQUIRE( ! bitmap.contains(1));
+    BOOST_REQUIRE( ! bitmap.contains(100000));
+}
@@ -878,6 +878,75 @@ BOOST_AUTO_TEST_CASE( Discussion_categories_recursively_include_total_thread_and
     BOOST_REQUIRE_EQUAL(27, categories[1].messageTotalCount);
 }
 
+BOOST_AUTO_TEST_CASE( Discussion_category_totals_are_updated_when_changing_parent_and_deleting_categories )
+{
+    auto handler = createCommandHandler();
+
+    LoggedInUserChanger __(createUserAndGetId(handler, "User"));
+
+    auto category1Id = createDiscussionCategoryAndGetId(handler, "Category1");
+    auto childCategory1Id = createDiscussionCategoryAndGetId(handler, "ChildCategory1", category1Id);
+    auto category2Id = createDiscussionCategoryAndGetId(handler, "Category2");
+
+    auto tag1Id = createDiscussionTagAndGetId(handler, "Tag1");
+    auto tag11Id = createDiscussionTagAndGetId(handler, "Tag11");
+    auto tag2Id = createDiscussionTagAndGetId(handler, "Tag2");
+
+    addTagToCategory(handler, tag1Id, category1Id);
+    addTagToCategory(handler, tag11Id, childCategory1Id);
+    addTagToCategory(handler, tag2Id, category2Id);
+
+    auto thread11BothId = createDiscussionThreadAndGetId(handler, "Thread11 on Category1 and ChildCategory1");
+    addTagToThread(handler, tag1Id, thread11BothId);
+    addTagToThread(handler, tag11Id, thread11BothId);
+    for (size_t i = 0; i < 5; i++)
+    {
+        createDiscussionMessageAndGetId(handler, thread11BothId, "Message for Thread11 Both");
+    }
+
+    auto thread12BothId = createDiscussionThreadAndGetId(handler, "Thread12 on ChildCategory1 and Category2");
+    addTagToThread(handler, tag11Id, thread12BothId);
+    addTagToThread(handler, tag2Id, thread12BothId);
+    for (size_t i = 0; i < 3; i++)
+    {
+        createDiscussionMessageAndGetId(handler, thread12BothId, "Message for Thread12 Both");
+    }
+
+    auto category1 = getCategory(handler, category1Id);
+    BOOST_REQUIRE_EQUAL(2, category1.threadTotalCount);
+    BOOST_REQUIRE_EQUAL(8, category1.messageTotalCount);
+
+    auto category2 = getCategory(handler, category2Id);
+    BOOST_REQUIRE_EQUAL(1, category2.threadTotalCount);
+    BOOST_REQUIRE_EQUAL(3, category2.messageTotalCount);
+
+    assertStatusCodeEqual(StatusCode::OK,
+                          handlerToObj(handler, Forum::Commands::CHANGE_DISCUSSION_CATEGORY_PARENT,
+                                       { childCategory1Id, category2Id }));
+
+    category1 = getCategory(handler, category1Id);
+    BOOST_REQUIRE_EQUAL(1, category1.threadTotalCount);
+    BOOST_REQUIRE_EQUAL(5, category1.messageTotalCount);
+
+    category2 = getCategory(handler, category2Id);
+    BOOST_REQUIRE_EQUAL(2, category2.threadTotalCount);
+    BOOST_REQUIRE_EQUAL(8, category2.messageTotalCount);
+
+    assertStatusCodeEqual(StatusCode::OK, handlerToObj(handler, Forum::Commands::DELETE_DISCUSSION_CATEGORY,
+                                                       { childCategory1Id }));
+
+    category2 = getCategory(handler, category2Id);
+    BOOST_REQUIRE_EQUAL(1, category2.threadTotalCount);
+    BOOST_REQUIRE_EQUAL(3, category2.messageTotalCount);
+
+    assertStatusCodeEqual(StatusCode::OK, handlerToObj(handler, Forum::Commands::DELETE_DISCUSSION_THREAD,
+                                                       { thread12BothId }));
+
+    category2 = getCategory(handler, category2Id);
+    BOOST_REQUIRE_EQUAL(0, category2.threadTotalCount);
+    BOOST_REQUIRE_EQUAL(0, category2.messageTotalCount);
+}
+
 static Forum::Commands::View GetDiscussionThreadsOfCategoryViews[] =
 {
     Forum::Commands::GET_DISCUSSION_THREADS_OF_CATEGORY_BY_NAME,
@@ -17,6 +17,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "CommandsCommon.h"
+#include "EntityCollection.h"
+#include "RandomGenerator.h"
 #include "TestHelpers.h"
 
 #include <algorithm>
@@ -816,3 +818,186 @@ BOOST_AUTO_TEST_CASE( Merging_discussion_threads_with_different_tags_updates_dis
 //deferred for a later release
 //BOOST_AUTO_TEST_CASE( Discussion_threads_attached_to_multiple_tags_can_be_distinctly_retrieved_sorted_by_various_criteria ) {}
 //BOOST_AUTO_TEST_CASE( Discussion_threads_attached_to_multiple_tags_can_be_filtered_by_excluded_by_tag ) {}
+
+BOOST_AUTO_TEST_CASE( Discussion_tag_lists_show_the_latest_message_of_each_tag )
+{
+    auto handler = createCommandHandler();
+
+    LoggedInUserChanger _(createUserAndGetId(handler, "User"));
+
+    auto tag1Id = createDiscussionTagAndGetId(handler, "Tag1");
+    auto tag2Id = createDiscussionTagAndGetId(handler, "Tag2");
+    createDiscussionTagAndGetId(handler, "Tag3");
+
+    auto thread1Id = createDiscussionThreadAndGetId(handler, "Thread1");
+    auto thread2Id = createDiscussionThreadAndGetId(handler, "Thread2");
+    createDiscussionMessageAndGetId(handler, thread1Id, "Message1");
+    createDiscussionMessageAndGetId(handler, thread2Id, "Message2");
+
+    assertStatusCodeEqual(StatusCode::OK, handlerToObj(handler, Forum::Commands::ADD_DISCUSSION_TAG_TO_THREAD,
+                                                       { tag1Id, thread1Id }));
+    assertStatusCodeEqual(StatusCode::OK, handlerToObj(handler, Forum::Commands::ADD_DISCUSSION_TAG_TO_THREAD,
+                                                       { tag2Id, thread2Id }));
+
+    for (auto sortOrder : { SortOrder::Ascending, SortOrder::Descending })
+    {
+        auto result = handlerToObj(handler, Forum::Commands::GET_DISCUSSION_TAGS_BY_NAME, sortOrder);
+
+        std::vector<std::string> latestMessageThreadIds;
+        for (auto& pair : result.get_child("tags"))
+        {
+            auto latestMessage = pair.second.get_child_optional("latestMessage");
+            if ( ! latestMessage)
+            {
+                latestMessageThreadIds.emplace_back();
+                continue;
+            }
+            BOOST_REQUIRE_EQUAL(1u, latestMessage->count("createdBy"));
+            latestMessageThreadIds.push_back(latestMessage->get<std::string>("threadId"));
+        }
+        std::vector<std::string> expected{ thread1Id, thread2Id, "" };
+        if (SortOrder::Descending == sortOrder)
+        {
+            std::reverse(expected.begin(), expected.end());
+        }
+        BOOST_REQUIRE(expected == latestMessageThreadIds);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( Thread_orderings_of_frequently_read_discussion_tags_are_kept_up_to_date )
+{
+    ConfigChanger _([](auto& config)
+                    {
+                        config.discussionTag.minThreadOrderingAccessesToMaintain = 1;
+                    });
+
+    auto handler = createCommandHandler();
+
+    LoggedInUserChanger __(createUserAndGetId(handler, "User"));
+
+    auto tagId = createDiscussionTagAndGetId(handler, "Tag");
+    auto thread1Id = createDiscussionThreadAndGetId(handler, "Thread1");
+    auto thread2Id = createDiscussionThreadAndGetId(handler, "Thread2");
+    auto thread3Id = createDiscussionThreadAndGetId(handler, "Thread3");
+
+    for (auto& threadId : { thread1Id, thread2Id, thread3Id })
+    {
+        assertStatusCodeEqual(StatusCode::OK, handlerToObj(handler, Forum::Commands::ADD_DISCUSSION_TAG_TO_THREAD,
+                                                           { tagId, threadId }));
+    }
+
+    auto getThreadIds = [&](Forum::Commands::View view)
+    {
+        std::vector<std::string> result;
+        for (auto& thread : deserializeThreads(handlerToObj(handler, view, { tagId }).get_child("threads")))
+        {
+            result.push_back(thread.id);
+        }
+        return result;
+    };
+
+    //reading the orderings causes them to be maintained on subsequent changes
+    std::vector<std::string> expected{ thread1Id, thread2Id, thread3Id };
+    BOOST_REQUIRE(expected == getThreadIds(Forum::Commands::GET_DISCUSSION_THREADS_WITH_TAG_BY_NAME));
+
+    for (int i = 0; i < 3; ++i)
+    {
+        createDiscussionMessageAndGetId(handler, thread1Id, "Message");
+    }
+    createDiscussionMessageAndGetId(handler, thread3Id, "Message");
+
+    expected = { thread2Id, thread3Id, thread1Id };
+    BOOST_REQUIRE(expected == getThreadIds(Forum::Commands::GET_DISCUSSION_THREADS_WITH_TAG_BY_MESSAGE_COUNT));
+
+    assertStatusCodeEqual(StatusCode::OK, handlerToObj(handler, Forum::Commands::CHANGE_DISCUSSION_THREAD_NAME,
+                                                       { thread1Id, "Thread4" }));
+    createDiscussionMessageAndGetId(handler, thread2Id, "Message");
+    createDiscussionMessageAndGetId(handler, thread2Id, "Message");
+
+    expected = { thread2Id, thread3Id, thread1Id };
+    BOOST_REQUIRE(expected == getThreadIds(Forum::Commands::GET_DISCUSSION_THREADS_WITH_TAG_BY_NAME));
+
+    expected = { thread3Id, thread2Id, thread1Id };
+    BOOST_REQUIRE(expected == getThreadIds(Forum::Commands::GET_DISCUSSION_THREADS_WITH_TAG_BY_MESSAGE_COUNT));
+
+    assertStatusCodeEqual(StatusCode::OK, handlerToObj(handler, Forum::Commands::REMOVE_DISCUSSION_TAG_FROM_THREAD,
+                                                       { tagId, thread2Id }));
+
+    expected = { thread3Id, thread1Id };
+    BOOST_REQUIRE(expected == getThreadIds(Forum::Commands::GET_DISCUSSION_THREADS_WITH_TAG_BY_NAME));
+}
+
+BOOST_AUTO_TEST_CASE( Discussion_tags_maintain_thread_orderings_while_read_often_and_stop_when_no_longer_read )
+{
+    ConfigChanger _([](auto& config)
+                    {
+                        config.discussionTag.minThreadOrderingAccessesToMaintain = 2;
+                        config.discussionTag.threadOrderingAccessWindow = 60;
+                        config.discussionTag.maintainThreadOrderingsWithoutAccessFor = 600;
+                    });
+
+    EntityCollection collection{ StringView{} };
+    auto user = collection.createUser(generateUniqueId(), User::NameType("User"), 1000, {});
+    auto createThread = [&](const char* name)
+    {
+        return collection.createDiscussionThread(generateUniqueId(), *user, DiscussionThread::NameType(name), 1000,
+                                                 {}, true);
+    };
+    auto thread1 = createThread("Thread1");
+    auto thread2 = createThread("Thread2");
+    auto thread3 = createThread("Thread3");
+
+    auto getNames = [](const auto& index)
+    {
+        std::vector<std::string> result;
+        for (const DiscussionThread* thread : index)
+        {
+            result.emplace_back(thread->name().string());
+        }
+        return result;
+    };
+
+    DiscussionThreadCollectionWithLazyOrder threads;
+    {
+        TimestampChanger __(1000);
+        threads.add(thread3);
+        threads.add(thread1);
+        BOOST_REQUIRE( ! threads.maintainsOrderings());
+
+        std::vector<std::string> expected{ "Thread1", "Thread3" };
+        BOOST_REQUIRE(expected == getNames(threads.byName()));
+        BOOST_REQUIRE(expected == getNames(threads.byName()));
+    }
+    {
+        //enough reads within the access window promote the tag on the next change
+        TimestampChanger __(1010);
+        threads.add(thread2);
+        BOOST_REQUIRE(threads.maintainsOrderings());
+
+        std::vector<std::string> expected{ "Thread1", "Thread2", "Thread3" };
+        BOOST_REQUIRE(expected == getNames(threads.byName()));
+    }
+    {
+        TimestampChanger __(1500);
+        threads.remove(thread1);
+        BOOST_REQUIRE(threads.maintainsOrderings());
+
+        std::vector<std::string> expected{ "Thread2", "Thread3" };
+        BOOST_REQUIRE(expected == getNames(threads.byName()));
+    }
+    {
+        //no reads for long enough evict the tag on the next change
+        TimestampChanger __(1500 + 600);
+        threads.add(thread1);
+        BOOST_REQUIRE( ! threads.maintainsOrderings());
+
+        std::vector<std::string> expected{ "Thread1", "Thread2", "Thread3" };
+        BOOST_REQUIRE(expected == getNames(threads.byName()));
+    }
+    {
+        //a single read is not enough to promote the tag again
+        TimestampChanger __(2200);
+        threads.remove(thread2);
+        BOOST_REQUIRE( ! threads.maintainsOrderings());
+    }
+}
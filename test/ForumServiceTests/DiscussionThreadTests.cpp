@@ -1604,6 +1604,44 @@ BOOST_AUTO_TEST_CASE( Discussion_threads_include_info_about_latest_message_only_
     BOOST_REQUIRE_EQUAL(1, threads[1].latestMessage.createdBy.messageCount);
 }
 
+BOOST_AUTO_TEST_CASE( Privileges_of_discussion_threads_are_the_same_in_lists_and_when_retrieved_individually )
+{
+    auto handler = createCommandHandler();
+
+    auto userId = createUserAndGetId(handler, "User");
+
+    LoggedInUserChanger __(userId);
+
+    auto threadId = createDiscussionThreadAndGetId(handler, "Thread");
+    createDiscussionMessageAndGetId(handler, threadId, "Message");
+    auto tagId = createDiscussionTagAndGetId(handler, "Tag");
+
+    assertStatusCodeEqual(StatusCode::OK, handlerToObj(handler, Forum::Commands::ADD_DISCUSSION_TAG_TO_THREAD,
+                                                       { tagId, threadId }));
+
+    auto readPrivileges = [](const boost::property_tree::ptree& tree)
+    {
+        std::vector<std::string> result;
+        for (auto& pair : tree.get_child("privileges"))
+        {
+            result.push_back(pair.second.get_value<std::string>());
+        }
+        return result;
+    };
+
+    auto expected = readPrivileges(handlerToObj(handler, Forum::Commands::GET_DISCUSSION_THREAD_BY_ID, { threadId })
+                                           .get_child("thread"));
+    BOOST_REQUIRE( ! expected.empty());
+
+    auto result = handlerToObj(handler, Forum::Commands::GET_DISCUSSION_THREADS_BY_NAME);
+    for (auto& pair : result.get_child("threads"))
+    {
+        auto actual = readPrivileges(pair.second);
+        BOOST_REQUIRE_EQUAL_COLLECTIONS(expected.begin(), expected.end(), actual.begin(), actual.end());
+        BOOST_REQUIRE_EQUAL(1u, pair.second.get_child("latestMessage").count("createdBy"));
+    }
+}
+
 BOOST_AUTO_TEST_CASE( Latest_discussion_message_of_thread_includes_message_content )
 {
     auto handler = createCommandHandler();
@@ -0,0 +1,288 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CommandsCommon.h"
+#include "HttpParser.h"
+#include "HttpRouter.h"
+#include "ServiceEndpointManager.h"
+#include "TestHelpers.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/test/unit_test.hpp>
+
+using namespace Forum::Configuration;
+using namespace Forum::Context;
+using namespace Forum::Entities;
+using namespace Forum::Helpers;
+using namespace Forum::Repository;
+
+namespace
+{
+    struct Response
+    {
+        std::string statusLine;
+        std::string entityTag;
+        std::string cacheControl;
+        std::string contentEncoding;
+        std::string contentLength;
+        std::string body;
+    };
+
+    std::string getHeader(const std::string& headers, const std::string& name)
+    {
+        const auto start = headers.find("\r\n" + name + ": ");
+        if (std::string::npos == start) return {};
+
+        const auto valueStart = start + 4 + name.size();
+        return headers.substr(valueStart, headers.find("\r\n", valueStart) - valueStart);
+    }
+
+    std::string trimLeadingSpaces(const std::string& value)
+    {
+        return value.substr(std::min(value.find_first_not_of(' '), value.size()));
+    }
+
+    struct EndpointFixture
+    {
+        EndpointFixture() : handler(createCommandHandler()), endpointManager(*handler)
+        {
+            endpointManager.registerRoutes(router);
+            router.freeze();
+        }
+
+        Response get(const std::string& path, const std::string& ifNoneMatch = {},
+                     const std::string& acceptEncoding = {})
+        {
+            auto requestText = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n";
+            if ( ! ifNoneMatch.empty())
+            {
+                requestText += "If-None-Match: " + ifNoneMatch + "\r\n";
+            }
+            if ( ! acceptEncoding.empty())
+            {
+                requestText += "Accept-Encoding: " + acceptEncoding + "\r\n";
+            }
+            requestText += "\r\n";
+
+            std::vector<char> headerBuffer(Http::Buffer::ReadBufferSize);
+            Http::Parser parser(headerBuffer.data(), headerBuffer.size(), 0,
+                                [](auto, auto, auto) { return true; }, nullptr);
+            BOOST_REQUIRE(Http::Parser::ParseResult::FINISHED == parser.process(requestText.data(),
+                                                                                requestText.size()));
+
+            //large outputs are written straight into the response, like for connections
+            std::vector<char> responseBytes;
+            Http::VectorResponseStorage storage(responseBytes);
+            Http::HttpResponseBuilder response{ [](const char* data, size_t size, void* state)
+                                                {
+                                                    auto& output = *static_cast<std::vector<char>*>(state);
+                                                    output.insert(output.end(), data, data + size);
+                                                }, &responseBytes, &storage };
+            router.forward(parser.mutableRequest(), response);
+            const std::string responseText(responseBytes.begin(), responseBytes.end());
+
+            const auto headersEnd = responseText.find("\r\n\r\n");
+            BOOST_REQUIRE(std::string::npos != headersEnd);
+            const auto headers = responseText.substr(0, headersEnd + 2);
+
+            Response result;
+            result.statusLine = headers.substr(0, headers.find("\r\n"));
+            result.entityTag = getHeader(headers, "ETag");
+            result.cacheControl = getHeader(headers, "Cache-Control");
+            result.contentEncoding = getHeader(headers, "Content-Encoding");
+            result.contentLength = getHeader(headers, "Content-Length");
+            result.body = responseText.substr(headersEnd + 4);
+            return result;
+        }
+
+        Forum::Commands::CommandHandlerRef handler;
+        Forum::Commands::ServiceEndpointManager endpointManager;
+        Http::HttpRouter router;
+    };
+}
+
+BOOST_FIXTURE_TEST_CASE( Conditional_requests_are_answered_with_not_modified_without_executing_the_command,
+                         EndpointFixture )
+{
+    std::string threadId;
+    {
+        LoggedInUserChanger _(createUserAndGetId(handler, "User"));
+        threadId = createDiscussionThreadAndGetId(handler, "Thread");
+    }
+
+    const auto first = get("/threads/id/" + threadId);
+    BOOST_REQUIRE_EQUAL("HTTP/1.1 200 OK", first.statusLine);
+    BOOST_REQUIRE( ! first.entityTag.empty());
+    BOOST_REQUIRE_EQUAL("no-cache", first.cacheControl);
+    BOOST_REQUIRE( ! first.body.empty());
+
+    const auto second = get("/threads/id/" + threadId, first.entityTag);
+    BOOST_REQUIRE_EQUAL("HTTP/1.1 304 Not Modified", second.statusLine);
+    BOOST_REQUIRE_EQUAL(first.entityTag, second.entityTag);
+    BOOST_REQUIRE(second.body.empty());
+
+    //only the request that received the thread counted as a visit
+    const auto threads = handlerToObj(handler, Forum::Commands::GET_DISCUSSION_THREADS_BY_NAME);
+    BOOST_REQUIRE_EQUAL(1, threads.get_child("threads").front().second.get<int>("visited"));
+
+    auto notFound = get("/threads/id/" + sampleValidIdString, first.entityTag);
+    BOOST_REQUIRE_EQUAL("HTTP/1.1 404 Not Found", notFound.statusLine);
+}
+
+BOOST_FIXTURE_TEST_CASE( Conditional_requests_are_answered_without_serializing_or_compressing_the_output,
+                         EndpointFixture )
+{
+    ConfigChanger _([](auto& config)
+                    {
+                        config.service.compressionMinimumSize = 1;
+                    });
+    std::string threadId;
+    {
+        LoggedInUserChanger __(createUserAndGetId(handler, "User"));
+        threadId = createDiscussionThreadAndGetId(handler, "Thread");
+    }
+
+    const auto first = get("/threads/id/" + threadId, {}, "gzip");
+    BOOST_REQUIRE_EQUAL("HTTP/1.1 200 OK", first.statusLine);
+    BOOST_REQUIRE_EQUAL("gzip", first.contentEncoding);
+
+    const auto second = get("/threads/id/" + threadId, first.entityTag, "gzip");
+    BOOST_REQUIRE_EQUAL("HTTP/1.1 304 Not Modified", second.statusLine);
+    BOOST_REQUIRE(second.contentEncoding.empty());
+    BOOST_REQUIRE(second.body.empty());
+
+    const auto threads = handlerToObj(handler, Forum::Commands::GET_DISCUSSION_THREADS_BY_NAME);
+    BOOST_REQUIRE_EQUAL(1, threads.get_child("threads").front().second.get<int>("visited"));
+}
+
+BOOST_FIXTURE_TEST_CASE( Entity_tags_of_a_thread_do_not_change_when_other_threads_are_modified, EndpointFixture )
+{
+    TimestampChanger _(6000);
+
+    const auto userId = createUserAndGetId(handler, "User");
+    std::string threadId, otherThreadId;
+    {
+        LoggedInUserChanger __(userId);
+        threadId = createDiscussionThreadAndGetId(handler, "Thread");
+        otherThreadId = createDiscussionThreadAndGetId(handler, "Other Thread");
+    }
+
+    const auto threadTag = get("/threads/id/" + threadId).entityTag;
+    const auto otherThreadTag = get("/threads/id/" + otherThreadId).entityTag;
+    const auto threadsTag = get("/threads").entityTag;
+    {
+        LoggedInUserChanger __(userId);
+        createDiscussionMessageAndGetId(handler, otherThreadId, "Message in the other thread");
+    }
+
+    BOOST_REQUIRE_EQUAL("HTTP/1.1 304 Not Modified", get("/threads/id/" + threadId, threadTag).statusLine);
+    BOOST_REQUIRE_EQUAL("HTTP/1.1 200 OK", get("/threads/id/" + otherThreadId, otherThreadTag).statusLine);
+    BOOST_REQUIRE_EQUAL("HTTP/1.1 200 OK", get("/threads", threadsTag).statusLine);
+
+    //changes that are not limited to a thread invalidate the tags of all threads
+    {
+        LoggedInUserChanger __(userId);
+        assertStatusCodeEqual(StatusCode::OK, handlerToObj(handler, Forum::Commands::CHANGE_USER_NAME,
+                                                           { userId, "Other User" }));
+    }
+
+    BOOST_REQUIRE_EQUAL("HTTP/1.1 200 OK", get("/threads/id/" + threadId, threadTag).statusLine);
+}
+
+BOOST_FIXTURE_TEST_CASE( Entity_tags_change_when_entities_are_modified_or_time_passes, EndpointFixture )
+{
+    std::string firstTag;
+    {
+        TimestampChanger _(6000);
+        firstTag = get("/users").entityTag;
+        BOOST_REQUIRE( ! firstTag.empty());
+    }
+    {
+        TimestampChanger _(6010);
+        BOOST_REQUIRE_EQUAL(firstTag, get("/users").entityTag);
+    }
+    {
+        TimestampChanger _(6000 + 3600);
+        BOOST_REQUIRE_NE(firstTag, get("/users").entityTag);
+    }
+    {
+        TimestampChanger _(6000);
+        createUserAndGetId(handler, "User");
+        BOOST_REQUIRE_NE(firstTag, get("/users").entityTag);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE( Responses_that_change_with_time_alone_have_no_entity_tag, EndpointFixture )
+{
+    for (const auto& path : { "/users/online", "/statistics/entitycount" })
+    {
+        const auto response = get(path);
+        BOOST_REQUIRE_EQUAL("HTTP/1.1 200 OK", response.statusLine);
+        BOOST_REQUIRE(response.entityTag.empty());
+        BOOST_REQUIRE_EQUAL("no-cache, no-store, must-revalidate", response.cacheControl);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE( Large_outputs_are_written_straight_into_the_response, EndpointFixture )
+{
+    std::string threadId;
+    const std::string content(5000, 'a');
+    {
+        LoggedInUserChanger _(createUserAndGetId(handler, "User"));
+        threadId = createDiscussionThreadAndGetId(handler, "Thread");
+        for (int i = 0; i < 20; ++i)
+        {
+            createDiscussionMessageAndGetId(handler, threadId, content);
+        }
+    }
+
+    const auto response = get("/threads/id/" + threadId);
+    BOOST_REQUIRE_EQUAL("HTTP/1.1 200 OK", response.statusLine);
+    BOOST_REQUIRE( ! response.entityTag.empty());
+    BOOST_REQUIRE_GT(response.body.size(), 20 * content.size());
+    //the length was filled in after writing the body, in the room left for it
+    BOOST_REQUIRE_EQUAL(' ', response.contentLength.front());
+    BOOST_REQUIRE_EQUAL(std::to_string(response.body.size()), trimLeadingSpaces(response.contentLength));
+
+    const auto prefix = getGlobalConfig()->service.responsePrefix;
+    BOOST_REQUIRE_EQUAL(0u, response.body.find(prefix));
+
+    std::istringstream stream(response.body.substr(prefix.size()));
+    boost::property_tree::ptree tree;
+    boost::property_tree::read_json(stream, tree);
+    BOOST_REQUIRE_EQUAL(20u, tree.get_child("thread.messages").size());
+    for (auto& pair : tree.get_child("thread.messages"))
+    {
+        BOOST_REQUIRE_EQUAL(content, pair.second.get<std::string>("content"));
+    }
+
+    ConfigChanger __([](auto& config)
+                     {
+                         config.service.compressionMinimumSize = 1;
+                     });
+    const auto compressed = get("/threads/id/" + threadId, {}, "gzip");
+    BOOST_REQUIRE_EQUAL("HTTP/1.1 200 OK", compressed.statusLine);
+    BOOST_REQUIRE_EQUAL("gzip", compressed.contentEncoding);
+    BOOST_REQUIRE_LT(compressed.body.size(), 20 * content.size());
+    BOOST_REQUIRE_EQUAL(std::to_string(compressed.body.size()), trimLeadingSpaces(compressed.contentLength));
+}
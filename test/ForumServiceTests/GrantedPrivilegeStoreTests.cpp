@@ -0,0 +1,111 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AuthorizationGrantedPrivilegeStore.h"
+#include "EntityCollection.h"
+#include "EntitySerialization.h"
+#include "EntityUser.h"
+#include "RandomGenerator.h"
+#include "StateHelpers.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Forum::Authorization;
+using namespace Forum::Entities;
+using namespace Forum::Helpers;
+
+static PrivilegeValueType getForumWidePositiveValue(const GrantedPrivilegeStore& store, const User& user,
+                                                    Timestamp now)
+{
+    PrivilegeValueType positive, negative;
+    store.calculateForumWidePrivilege(&user, now, positive, negative);
+    return positive;
+}
+
+BOOST_AUTO_TEST_CASE( Granted_privileges_are_reevaluated_once_they_expire )
+{
+    GrantedPrivilegeStore store;
+    User user(generateUniqueId(), 1, User::NameType("User"), 1000, {});
+
+    store.grantForumWidePrivilege(user.id(), {}, 100, 1000, 2000);
+    store.grantForumWidePrivilege(user.id(), {}, 50, 1000, 3000);
+
+    BOOST_REQUIRE_EQUAL(100, optionalOrZero(getForumWidePositiveValue(store, user, 1500)));
+    BOOST_REQUIRE_EQUAL(100, optionalOrZero(getForumWidePositiveValue(store, user, 2000)));
+    BOOST_REQUIRE_EQUAL(50, optionalOrZero(getForumWidePositiveValue(store, user, 2001)));
+    BOOST_REQUIRE_EQUAL(50, optionalOrZero(getForumWidePositiveValue(store, user, 3000)));
+    BOOST_REQUIRE_GT(50, optionalOrZero(getForumWidePositiveValue(store, user, 3001)));
+
+    //going back in time does not use values computed for a later moment
+    BOOST_REQUIRE_EQUAL(100, optionalOrZero(getForumWidePositiveValue(store, user, 1500)));
+}
+
+BOOST_AUTO_TEST_CASE( Granted_privileges_are_reevaluated_when_privileges_change )
+{
+    GrantedPrivilegeStore store;
+    User user(generateUniqueId(), 1, User::NameType("User"), 1000, {});
+    User otherUser(generateUniqueId(), 2, User::NameType("Other"), 1000, {});
+
+    BOOST_REQUIRE_GT(100, optionalOrZero(getForumWidePositiveValue(store, user, 1500)));
+
+    store.grantForumWidePrivilege(user.id(), {}, 100, 1000, 0);
+    BOOST_REQUIRE_EQUAL(100, optionalOrZero(getForumWidePositiveValue(store, user, 1500)));
+    BOOST_REQUIRE_GT(100, optionalOrZero(getForumWidePositiveValue(store, otherUser, 1500)));
+    BOOST_REQUIRE_EQUAL(100, optionalOrZero(getForumWidePositiveValue(store, user, 1500)));
+
+    store.grantForumWidePrivilege(user.id(), {}, 0, 1000, 0);
+    BOOST_REQUIRE_GT(100, optionalOrZero(getForumWidePositiveValue(store, user, 1500)));
+}
+
+BOOST_AUTO_TEST_CASE( Serialization_plans_use_the_forum_wide_privileges_valid_when_they_are_created )
+{
+    GrantedPrivilegeStore store;
+    EntityCollection collection{ StringView{} };
+    collection.setForumWidePrivilege(ForumWidePrivilege::GET_USER_INFO, 100);
+    collection.setForumWidePrivilege(ForumWidePrivilege::GET_ATTACHMENTS_OF_USER, 200);
+    User user(generateUniqueId(), 1, User::NameType("User"), 1000, {});
+
+    SerializationRestriction restriction(store, collection, &user, 1500);
+    {
+        const SerializationPlan plan(restriction);
+        BOOST_REQUIRE( ! plan.showUserInfo);
+        BOOST_REQUIRE( ! plan.showUserAttachments);
+
+        //the plan keeps the values resolved when it was created
+        store.grantForumWidePrivilege(user.id(), {}, 100, 1000, 2000);
+        BOOST_REQUIRE( ! plan.showUserInfo);
+    }
+    {
+        const SerializationPlan plan(restriction);
+        BOOST_REQUIRE(plan.showUserInfo);
+        BOOST_REQUIRE( ! plan.showUserAttachments);
+    }
+    {
+        //the granted privilege expired
+        SerializationRestriction laterRestriction(store, collection, &user, 2001);
+        const SerializationPlan plan(laterRestriction);
+        BOOST_REQUIRE( ! plan.showUserInfo);
+    }
+    {
+        //view settings are copied as well
+        BoolTemporaryChanger _(serializationSettings.hidePrivileges, true);
+        const SerializationPlan plan(restriction);
+        BOOST_REQUIRE( ! plan.showPrivileges);
+    }
+    BOOST_REQUIRE(SerializationPlan(restriction).showPrivileges);
+}
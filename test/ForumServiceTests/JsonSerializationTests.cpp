@@ -19,6 +19,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "JsonWriter.h"
 
 #include <limits>
+#include <string>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -147,3 +149,89 @@ BOOST_AUTO_TEST_CASE( JsonReadyString_does_not_add_quotes_for_strings_that_requi
         BOOST_REQUIRE_EQUAL(view, copy.string());
     }
 }
+
+BOOST_AUTO_TEST_CASE( StringBuffer_grows_as_needed_and_can_release_excess_capacity )
+{
+    StringBuffer buffer(128);
+    const std::string input(1000, 'a');
+
+    buffer.write(input.data(), input.size());
+    BOOST_REQUIRE_EQUAL(input, buffer.view());
+    BOOST_REQUIRE_GE(buffer.capacity(), input.size());
+
+    buffer.clear();
+    buffer.releaseIfLargerThan(4096);
+    BOOST_REQUIRE_GE(buffer.capacity(), input.size());
+
+    buffer.releaseIfLargerThan(512);
+    BOOST_REQUIRE_EQUAL(128u, buffer.capacity());
+
+    buffer.write(input.data(), input.size());
+    BOOST_REQUIRE_EQUAL(input, buffer.view());
+}
+
+namespace
+{
+    /**
+     * Collects the content in blocks of a fixed size, like the buffers of a response
+     */
+    struct BlockOutputSink final : public OutputSink
+    {
+        char* flush(const std::string_view content, size_t& blockSize) override
+        {
+            if ( ! blocks.empty() && (content.data() == blocks.back().data()))
+            {
+                blocks.back().resize(content.size());
+            }
+            else
+            {
+                blocks.emplace_back(content);
+            }
+            blocks.emplace_back(BlockSize, '\0');
+            blockSize = BlockSize;
+            return blocks.back().data();
+        }
+
+        std::string content(const std::string_view rest) const
+        {
+            std::string result;
+            for (auto& block : blocks)
+            {
+                result += (block.data() == rest.data()) ? std::string(rest) : block;
+            }
+            return result;
+        }
+
+        static constexpr size_t BlockSize = 100;
+        std::vector<std::string> blocks;
+    };
+}
+
+BOOST_AUTO_TEST_CASE( StringBuffer_passes_what_does_not_fit_to_the_sink_and_continues_in_its_memory )
+{
+    StringBuffer buffer(128);
+    BlockOutputSink sink;
+    buffer.setSink(&sink);
+
+    std::string expected;
+    for (int i = 0; i < 100; ++i)
+    {
+        const std::string value = "value " + std::to_string(i) + ",";
+        buffer.write(value.data(), value.size());
+        buffer.writeFixed<2>("ab");
+        buffer.write('c');
+        expected += value + "abc";
+    }
+
+    BOOST_REQUIRE(buffer.anyFlushedToSink());
+    BOOST_REQUIRE_EQUAL(expected.size(), buffer.size());
+    BOOST_REQUIRE_EQUAL(expected, sink.content(buffer.view()));
+    //the buffer does not grow while a sink is set
+    BOOST_REQUIRE_EQUAL(128u, buffer.capacity());
+
+    buffer.clear();
+    buffer.setSink(nullptr);
+    buffer.write(expected.data(), expected.size());
+    BOOST_REQUIRE( ! buffer.anyFlushedToSink());
+    BOOST_REQUIRE_EQUAL(expected, buffer.view());
+}
@@ -0,0 +1,73 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ShardedCounter.h"
+
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Forum::Helpers;
+
+BOOST_AUTO_TEST_CASE( ShardedCounter_starts_from_the_initial_value )
+{
+    ShardedCounter<int64_t> counter;
+    BOOST_REQUIRE_EQUAL(0, counter.load());
+
+    ShardedCounter<int64_t> otherCounter(10);
+    BOOST_REQUIRE_EQUAL(10, otherCounter.load());
+}
+
+BOOST_AUTO_TEST_CASE( ShardedCounter_adds_values )
+{
+    ShardedCounter<uint32_t> counter;
+
+    ++counter;
+    counter += 5;
+    counter.add(4);
+
+    BOOST_REQUIRE_EQUAL(10u, counter.load());
+    BOOST_REQUIRE( ! counter.isSharded());
+}
+
+BOOST_AUTO_TEST_CASE( ShardedCounter_does_not_lose_concurrent_updates )
+{
+    ShardedCounter<int64_t> counter;
+
+    const int nrOfThreads = 8;
+    const int incrementsPerThread = 100000;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nrOfThreads; ++i)
+    {
+        threads.emplace_back([&counter]()
+        {
+            for (int j = 0; j < incrementsPerThread; ++j)
+            {
+                ++counter;
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    BOOST_REQUIRE_EQUAL(static_cast<int64_t>(nrOfThreads) * incrementsPerThread, counter.load());
+}
@@ -20,9 +20,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "TestHelpers.h"
 #include "Version.h"
 #include "CommandsCommon.h"
+#include "ContextProviders.h"
 
 #include <boost/test/unit_test.hpp>
 
+using namespace Forum;
 using namespace Forum::Helpers;
 using namespace Forum::Repository;
 
@@ -41,3 +43,99 @@ BOOST_AUTO_TEST_CASE( Executing_a_command_beyond_the_range_of_available_commands
     assertStatusCodeEqual(StatusCode::NOT_FOUND,
                           std::get<1>(handlerToObjAndStatus(handler, static_cast<Forum::Commands::Command>(0xFFFFFF))));
 }
+
+BOOST_AUTO_TEST_CASE( Configuration_snapshot_keeps_the_same_values_until_it_goes_out_of_scope )
+{
+    const auto initialMaxNameLength = Configuration::getGlobalConfig()->user.maxNameLength;
+    {
+        const Configuration::ConfigSnapshot snapshot;
+
+        ConfigChanger _([](auto& config)
+                        {
+                            config.user.maxNameLength += 10;
+                        });
+
+        BOOST_REQUIRE_EQUAL(initialMaxNameLength, Configuration::getGlobalConfig()->user.maxNameLength);
+    }
+    {
+        ConfigChanger _([](auto& config)
+                        {
+                            config.user.maxNameLength += 10;
+                        });
+
+        BOOST_REQUIRE_EQUAL(initialMaxNameLength + 10, Configuration::getGlobalConfig()->user.maxNameLength);
+    }
+    BOOST_REQUIRE_EQUAL(initialMaxNameLength, Configuration::getGlobalConfig()->user.maxNameLength);
+}
+
+BOOST_AUTO_TEST_CASE( Each_published_configuration_receives_a_greater_version_that_snapshots_keep )
+{
+    const auto initialVersion = Configuration::getGlobalConfigVersion();
+    {
+        ConfigChanger _([](auto& config)
+                        {
+                            config.user.maxNameLength += 10;
+                        });
+
+        const auto changedVersion = Configuration::getGlobalConfigVersion();
+        BOOST_REQUIRE_GT(changedVersion, initialVersion);
+        {
+            const Configuration::ConfigSnapshot snapshot;
+
+            ConfigChanger __([](auto& config)
+                             {
+                                 config.user.maxNameLength += 10;
+                             });
+
+            BOOST_REQUIRE_EQUAL(changedVersion, Configuration::getGlobalConfigVersion());
+            {
+                const Configuration::ConfigSnapshot nestedSnapshot;
+                BOOST_REQUIRE_EQUAL(changedVersion, Configuration::getGlobalConfigVersion());
+            }
+        }
+        BOOST_REQUIRE_GT(Configuration::getGlobalConfigVersion(), changedVersion);
+    }
+    //restoring the previous values publishes a new configuration
+    BOOST_REQUIRE_GT(Configuration::getGlobalConfigVersion(), initialVersion);
+}
+
+BOOST_AUTO_TEST_CASE( Write_generation_only_changes_when_entities_are_modified )
+{
+    auto handler = createCommandHandler();
+
+    const auto initialGeneration = Context::getWriteGeneration();
+
+    handlerToObj(handler, Forum::Commands::GET_USERS_BY_NAME);
+    handlerToObj(handler, Forum::Commands::SHOW_VERSION);
+
+    BOOST_REQUIRE_EQUAL(initialGeneration, Context::getWriteGeneration());
+
+    createUserAndGetId(handler, "User");
+
+    BOOST_REQUIRE_NE(initialGeneration, Context::getWriteGeneration());
+}
+
+BOOST_AUTO_TEST_CASE( Write_generation_does_not_change_when_only_last_seen_is_updated )
+{
+    ConfigChanger _([](auto& config)
+                    {
+                        config.user.lastSeenUpdateBatchMilliseconds = 0;
+                    });
+
+    auto handler = createCommandHandler();
+    std::string userId;
+    {
+        TimestampChanger __(1000);
+        userId = createUserAndGetId(handler, "User");
+    }
+
+    const auto initialGeneration = Context::getWriteGeneration();
+    {
+        TimestampChanger __(100000);
+        LoggedInUserChanger ___(userId);
+        handlerToObj(handler, Forum::Commands::GET_USER_BY_NAME, { "User" });
+    }
+    BOOST_REQUIRE_EQUAL(initialGeneration, Context::getWriteGeneration());
+    BOOST_REQUIRE_EQUAL(100000u, handlerToObj(handler, Forum::Commands::GET_USER_BY_NAME, { "User" })
+                                 .get<Entities::Timestamp>("user.lastSeen"));
+}
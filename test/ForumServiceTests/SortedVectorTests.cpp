@@ -386,3 +386,25 @@ BOOST_AUTO_TEST_CASE( SortedVectorUnique_removes_the_item_on_replacement_if_a_un
     BOOST_REQUIRE_EQUAL(4, (vector.begin() + 1)->getValue());
     BOOST_REQUIRE_EQUAL(4, (vector.begin() + 1)->getExtra());
 }
+
+BOOST_AUTO_TEST_CASE( SortedVectorMultiValue_can_be_rebuilt_from_many_unsorted_items )
+{
+    const int nrOfItems = 200000;
+
+    std::vector<Foo> items;
+    items.reserve(nrOfItems);
+    for (int i = 0; i < nrOfItems; ++i)
+    {
+        items.emplace_back((i * 7919) % nrOfItems);
+    }
+
+    SortedVectorMultiValue<Foo, int, FooValueExtractor, FooValueCompare> vector;
+    vector.insert(Foo(-1));
+    vector.rebuild(items.begin(), items.end());
+
+    BOOST_REQUIRE_EQUAL(static_cast<size_t>(nrOfItems), vector.size());
+
+    BOOST_REQUIRE(std::is_sorted(vector.begin(), vector.end(), FooValueCompare{}));
+    BOOST_REQUIRE_EQUAL(0, vector.begin()->getValue());
+    BOOST_REQUIRE_EQUAL(nrOfItems - 1, vector.rbegin()->getValue());
+}
@@ -113,3 +113,31 @@ BOOST_AUTO_TEST_CASE( SplitString_returns_early_when_output_gets_full )
     BOOST_REQUIRE_EQUAL("cd", output[1]);
     BOOST_REQUIRE_EQUAL("", output[2]);
 }
+
+BOOST_AUTO_TEST_CASE( CountASCIIPrefix_stops_at_the_first_non_ASCII_byte )
+{
+    BOOST_REQUIRE_EQUAL(0u, countASCIIPrefix(""));
+    BOOST_REQUIRE_EQUAL(3u, countASCIIPrefix("abc"));
+    BOOST_REQUIRE_EQUAL(20u, countASCIIPrefix("abcdefghijklmnopqrst"));
+    BOOST_REQUIRE_EQUAL(2u, countASCIIPrefix("ab\xC3\xA9"));
+    BOOST_REQUIRE_EQUAL(11u, countASCIIPrefix("abcdefghijk\xC3\xA9lmnopqrst"));
+
+    BOOST_REQUIRE(onlyASCII("abcdefghijklmnopqrst"));
+    BOOST_REQUIRE( ! onlyASCII("abcdefghijklmnopqrs\xFF"));
+}
+
+BOOST_AUTO_TEST_CASE( Strings_with_sort_keys_compare_using_primary_collation_strength )
+{
+    using String = JsonReadyStringWithSortKey<16>;
+
+    BOOST_REQUIRE(String("abc") == String("ABC"));
+    BOOST_REQUIRE(String("abc") == String("\xC3\xA1" "bc"));
+    BOOST_REQUIRE(String("abc") < String("abd"));
+    BOOST_REQUIRE(String("abc") < String("abcd"));
+    BOOST_REQUIRE(String("Zeta") > String("alpha"));
+
+    //sort keys that only differ after the inline prefix
+    BOOST_REQUIRE(String("abcdefghijklmn1") < String("ABCDEFGHIJKLMN2"));
+    BOOST_REQUIRE(String("abcdefghijklmn2") >= String("ABCDEFGHIJKLMN2"));
+    BOOST_REQUIRE(String("abcdefghijklmn2") <= String("ABCDEFGHIJKLMN2"));
+}
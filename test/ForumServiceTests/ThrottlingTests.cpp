@@ -0,0 +1,109 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "DefaultThrottling.h"
+#include "RandomGenerator.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Forum::Authorization;
+using namespace Forum::Entities;
+using namespace Forum::Helpers;
+
+BOOST_AUTO_TEST_CASE( Throttling_only_allows_a_limited_number_of_actions_per_period )
+{
+    DefaultThrottling throttling;
+    const IdType userId = generateUniqueId();
+    const IpAddress ip("127.0.0.1");
+
+    const auto maxAllowed = ThrottlingDefaultValues[static_cast<EnumIntType>(UserActionThrottling::NEW_CONTENT)].first;
+
+    for (size_t i = 0; i < maxAllowed; ++i)
+    {
+        BOOST_REQUIRE( ! throttling.check(UserActionThrottling::NEW_CONTENT, 10000, userId, ip));
+    }
+    BOOST_REQUIRE(throttling.check(UserActionThrottling::NEW_CONTENT, 10000, userId, ip));
+    BOOST_REQUIRE( ! throttling.check(UserActionThrottling::NEW_CONTENT, 10000, {}, ip));
+
+    auto statistics = throttling.statistics();
+    BOOST_REQUIRE_EQUAL(2u, statistics.entries);
+    BOOST_REQUIRE_EQUAL(0u, statistics.evictions);
+    BOOST_REQUIRE_EQUAL(1u, statistics.throttled);
+}
+
+BOOST_AUTO_TEST_CASE( Throttling_entries_are_evicted_after_being_idle_for_longer_than_the_longest_period )
+{
+    DefaultThrottling throttling;
+    const IpAddress ip("127.0.0.1");
+
+    Timestamp maxPeriod = 0;
+    for (auto& value : ThrottlingDefaultValues)
+    {
+        maxPeriod = std::max(maxPeriod, static_cast<Timestamp>(value.second));
+    }
+
+    constexpr size_t nrOfUsers = 100;
+    for (size_t i = 0; i < nrOfUsers; ++i)
+    {
+        throttling.check(UserActionThrottling::VOTE, 10000, generateUniqueId(), ip);
+    }
+    BOOST_REQUIRE_EQUAL(nrOfUsers, throttling.statistics().entries);
+
+    const auto later = 10000 + maxPeriod + DefaultThrottling::SweepInterval + 1;
+    for (size_t i = 0; i < nrOfUsers; ++i)
+    {
+        throttling.check(UserActionThrottling::VOTE, later, generateUniqueId(), ip);
+    }
+
+    auto statistics = throttling.statistics();
+    BOOST_REQUIRE_EQUAL(nrOfUsers, statistics.entries);
+    BOOST_REQUIRE_EQUAL(nrOfUsers, statistics.evictions);
+}
+
+BOOST_AUTO_TEST_CASE( Throttling_entries_are_evicted_by_sweeps_spread_over_multiple_checks )
+{
+    DefaultThrottling throttling;
+    const IpAddress ip("127.0.0.1");
+
+    Timestamp maxPeriod = 0;
+    for (auto& value : ThrottlingDefaultValues)
+    {
+        maxPeriod = std::max(maxPeriod, static_cast<Timestamp>(value.second));
+    }
+
+    constexpr size_t nrOfUsers = 10000;
+    for (size_t i = 0; i < nrOfUsers; ++i)
+    {
+        throttling.check(UserActionThrottling::VOTE, 10000, generateUniqueId(), ip);
+    }
+    BOOST_REQUIRE_EQUAL(nrOfUsers, throttling.statistics().entries);
+
+    const auto later = 10000 + maxPeriod + DefaultThrottling::SweepInterval + 1;
+    throttling.check(UserActionThrottling::VOTE, later, generateUniqueId(), ip);
+
+    BOOST_REQUIRE_LT(throttling.statistics().evictions, nrOfUsers);
+
+    //entries added in the meantime may rehash a shard, in which case the remaining ones are evicted by a later sweep
+    size_t nrOfChecks = 1;
+    while ((throttling.statistics().evictions < nrOfUsers) && (nrOfChecks < nrOfUsers))
+    {
+        throttling.check(UserActionThrottling::VOTE, later + nrOfChecks / 10, generateUniqueId(), ip);
+        nrOfChecks += 1;
+    }
+    BOOST_REQUIRE_EQUAL(nrOfUsers, throttling.statistics().evictions);
+}
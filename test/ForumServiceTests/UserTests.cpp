@@ -19,6 +19,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "CommandsCommon.h"
 #include "TestHelpers.h"
 
+#include <chrono>
+#include <thread>
 #include <vector>
 
 using namespace Forum::Configuration;
@@ -265,6 +267,30 @@ BOOST_AUTO_TEST_CASE( Creating_a_user_with_a_name_that_contains_invalid_characte
     assertStatusCodeEqual(StatusCode::INVALID_PARAMETERS, returnObject);
 }
 
+BOOST_AUTO_TEST_CASE( Creating_a_user_with_a_truncated_multi_byte_character_in_the_name_fails )
+{
+    auto handler = createCommandHandler();
+    auto returnObject = createUser(handler, "Foo\xC3");
+    assertStatusCodeEqual(StatusCode::INVALID_PARAMETERS, returnObject);
+}
+
+BOOST_AUTO_TEST_CASE( User_names_are_normalized_before_being_stored )
+{
+    auto handler = createCommandHandler();
+
+    //"Jose" followed by U+0301 COMBINING ACUTE ACCENT becomes "Jos" followed by U+00E9
+    auto returnObject = createUser(handler, "Jose\xCC\x81");
+    assertStatusCodeEqual(StatusCode::OK, returnObject);
+    BOOST_REQUIRE_EQUAL("Jos\xC3\xA9", returnObject.get<std::string>("name"));
+
+    //already normalized names are stored as they are
+    returnObject = createUser(handler, "Andr\xC3\xA9");
+    assertStatusCodeEqual(StatusCode::OK, returnObject);
+    BOOST_REQUIRE_EQUAL("Andr\xC3\xA9", returnObject.get<std::string>("name"));
+
+    assertStatusCodeEqual(StatusCode::ALREADY_EXISTS, createUser(handler, "Jos\xC3\xA9"));
+}
+
 BOOST_AUTO_TEST_CASE( A_user_that_was_created_can_be_retrieved_and_has_a_distinct_id )
 {
     auto handler = createCommandHandler();
@@ -582,6 +608,11 @@ BOOST_AUTO_TEST_CASE( Users_without_activity_have_last_seen_empty )
 
 BOOST_AUTO_TEST_CASE( User_last_seen_is_correctly_updated )
 {
+    ConfigChanger _([](auto& config)
+                    {
+                        config.user.lastSeenUpdateBatchMilliseconds = 0;
+                    });
+
     auto handler = createCommandHandler();
     std::vector<std::string> names = { "Abc", "Ghi", "Def" };
 
@@ -644,6 +675,126 @@ BOOST_AUTO_TEST_CASE( User_last_seen_is_correctly_updated )
     BOOST_REQUIRE_EQUAL("Abc", retrievedNames[2]);
 }
 
+BOOST_AUTO_TEST_CASE( User_last_seen_updates_of_read_requests_are_applied_in_batches )
+{
+    ConfigChanger _([](auto& config)
+                    {
+                        config.user.lastSeenUpdateBatchMilliseconds = 10;
+                    });
+
+    auto handler = createCommandHandler();
+    std::string userId;
+    {
+        TimestampChanger __(1000);
+        userId = createUserAndGetId(handler, "User");
+    }
+    {
+        TimestampChanger __(10000);
+        LoggedInUserChanger ___(userId);
+        (void)handlerToObj(handler, Forum::Commands::GET_USER_BY_NAME, { "User" });
+    }
+
+    Timestamp lastSeen = 0;
+    for (int i = 0; (i < 500) && (10000u != lastSeen); ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        lastSeen = handlerToObj(handler, Forum::Commands::GET_USER_BY_NAME, { "User" }).get<Timestamp>("user.lastSeen");
+    }
+    BOOST_REQUIRE_EQUAL(10000u, lastSeen);
+}
+
+BOOST_AUTO_TEST_CASE( User_last_seen_updates_of_read_requests_are_queued_again_after_the_precision_interval )
+{
+    ConfigChanger _([](auto& config)
+                    {
+                        config.user.lastSeenUpdateBatchMilliseconds = 10;
+                        config.user.lastSeenUpdatePrecision = 300;
+                    });
+
+    auto handler = createCommandHandler();
+    std::string userId;
+    {
+        TimestampChanger __(1000);
+        userId = createUserAndGetId(handler, "User");
+    }
+
+    const auto waitForLastSeen = [&handler](const Timestamp expected)
+    {
+        Timestamp lastSeen = 0;
+        for (int i = 0; (i < 500) && (expected != lastSeen); ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            lastSeen = handlerToObj(handler, Forum::Commands::GET_USER_BY_NAME, { "User" })
+                    .get<Timestamp>("user.lastSeen");
+        }
+        return lastSeen;
+    };
+
+    //requests made before the batch is applied are only queued once
+    for (Timestamp at : { 10000, 10100, 10200 })
+    {
+        TimestampChanger __(at);
+        LoggedInUserChanger ___(userId);
+        (void)handlerToObj(handler, Forum::Commands::GET_USER_BY_NAME, { "User" });
+    }
+    BOOST_REQUIRE_EQUAL(10000u, waitForLastSeen(10000));
+
+    {
+        TimestampChanger __(10400);
+        LoggedInUserChanger ___(userId);
+        (void)handlerToObj(handler, Forum::Commands::GET_USER_BY_NAME, { "User" });
+    }
+    BOOST_REQUIRE_EQUAL(10400u, waitForLastSeen(10400));
+}
+
+BOOST_AUTO_TEST_CASE( User_last_seen_updates_of_read_requests_wait_for_the_full_batch_interval )
+{
+    ConfigChanger _([](auto& config)
+                    {
+                        config.user.lastSeenUpdateBatchMilliseconds = 500;
+                        config.user.lastSeenUpdatePrecision = 300;
+                    });
+
+    auto handler = createCommandHandler();
+    std::string userId;
+    {
+        TimestampChanger __(1000);
+        userId = createUserAndGetId(handler, "User");
+    }
+
+    const auto getLastSeen = [&handler]()
+    {
+        return handlerToObj(handler, Forum::Commands::GET_USER_BY_NAME, { "User" }).get<Timestamp>("user.lastSeen");
+    };
+    const auto readUserAt = [&handler, &userId](const Timestamp at)
+    {
+        TimestampChanger __(at);
+        LoggedInUserChanger ___(userId);
+        (void)handlerToObj(handler, Forum::Commands::GET_USER_BY_NAME, { "User" });
+    };
+
+    readUserAt(10000);
+    Timestamp lastSeen = 0;
+    for (int i = 0; (i < 500) && (10000u != lastSeen); ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        lastSeen = getLastSeen();
+    }
+    BOOST_REQUIRE_EQUAL(10000u, lastSeen);
+
+    //a batch has just been applied, so the next update is queued until the interval elapses
+    readUserAt(10400);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    BOOST_REQUIRE_EQUAL(10000u, getLastSeen());
+
+    for (int i = 0; (i < 500) && (10400u != lastSeen); ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        lastSeen = getLastSeen();
+    }
+    BOOST_REQUIRE_EQUAL(10400u, lastSeen);
+}
+
 BOOST_AUTO_TEST_CASE( Retrieving_discussion_threads_of_invalid_user_returns_invalid_parameters )
 {
     auto handler = createCommandHandler();
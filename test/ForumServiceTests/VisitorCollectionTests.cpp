@@ -0,0 +1,98 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TestHelpers.h"
+#include "VisitorCollection.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Forum::Repository;
+using namespace Forum::Helpers;
+
+BOOST_AUTO_TEST_CASE( Visitors_are_counted_once_until_they_expire )
+{
+    VisitorCollection collection(300);
+    constexpr VisitorCollection::VisitorId nrOfVisitors = 1000;
+    {
+        TimestampChanger _(1000);
+        for (VisitorCollection::VisitorId i = 0; i < nrOfVisitors; ++i)
+        {
+            collection.add(i * 0x9E3779B97F4A7C15ull);
+            collection.add(i * 0x9E3779B97F4A7C15ull);
+        }
+        BOOST_REQUIRE_EQUAL(nrOfVisitors, collection.currentNumberOfVisitors());
+    }
+    {
+        TimestampChanger _(1200);
+        collection.add(0);
+        collection.cleanup();
+        BOOST_REQUIRE_EQUAL(nrOfVisitors, collection.currentNumberOfVisitors());
+    }
+    {
+        TimestampChanger _(1400);
+        collection.cleanup();
+        BOOST_REQUIRE_EQUAL(1u, collection.currentNumberOfVisitors());
+    }
+}
+
+BOOST_AUTO_TEST_CASE( Visitors_are_no_longer_counted_once_their_shard_is_full )
+{
+    VisitorCollection collection(300);
+    TimestampChanger _(1000);
+
+    //the upper bits of these ids are all zero, so they land on the same shard
+    const VisitorCollection::VisitorId nrOfVisitors = VisitorCollection::MaxVisitorsPerShard + 100;
+    for (VisitorCollection::VisitorId i = 0; i < nrOfVisitors; ++i)
+    {
+        collection.add(i);
+    }
+    BOOST_REQUIRE_EQUAL(VisitorCollection::MaxVisitorsPerShard, collection.currentNumberOfVisitors());
+
+    //visitors of other shards are still counted
+    collection.add(VisitorCollection::VisitorId{ 1 } << 32);
+    BOOST_REQUIRE_EQUAL(VisitorCollection::MaxVisitorsPerShard + 1, collection.currentNumberOfVisitors());
+}
+
+BOOST_AUTO_TEST_CASE( Expired_visitors_are_removed_over_multiple_additions )
+{
+    VisitorCollection collection(300);
+
+    //the upper bits of these ids are all zero, so they land on the same shard
+    constexpr VisitorCollection::VisitorId nrOfVisitors = 10000;
+    {
+        TimestampChanger _(1000);
+        for (VisitorCollection::VisitorId i = 0; i < nrOfVisitors; ++i)
+        {
+            collection.add(i);
+        }
+        BOOST_REQUIRE_EQUAL(nrOfVisitors, collection.currentNumberOfVisitors());
+    }
+    {
+        TimestampChanger _(2000);
+        const VisitorCollection::VisitorId newVisitor = nrOfVisitors;
+
+        collection.add(newVisitor);
+        BOOST_REQUIRE_GT(collection.currentNumberOfVisitors(), 1u);
+
+        for (VisitorCollection::VisitorId i = 0; (i < nrOfVisitors) && (collection.currentNumberOfVisitors() > 1); ++i)
+        {
+            collection.add(newVisitor);
+        }
+        BOOST_REQUIRE_EQUAL(1u, collection.currentNumberOfVisitors());
+    }
+}
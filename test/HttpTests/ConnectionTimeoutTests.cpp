@@ -0,0 +1,180 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ConnectionManagerWithTimeout.h"
+#include "FixedHttpConnectionManager.h"
+#include "Http2Session.h"
+#include "StreamSocketListener.h"
+#include "TimeoutManager.h"
+
+#include <chrono>
+#include <ctime>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Http;
+
+namespace
+{
+    constexpr uint8_t SettingsFrame = 0x4;
+    constexpr uint8_t PingFrame = 0x6;
+    constexpr uint8_t GoAwayFrame = 0x7;
+    constexpr uint8_t AckFlag = 0x1;
+
+    struct Frame
+    {
+        uint8_t type;
+        uint8_t flags;
+        std::string payload;
+    };
+
+    std::string frame(const uint8_t type, const uint8_t flags, const std::string& payload)
+    {
+        const auto length = payload.size();
+        return std::string{ static_cast<char>((length >> 16) & 0xFF), static_cast<char>((length >> 8) & 0xFF),
+                            static_cast<char>(length & 0xFF), static_cast<char>(type), static_cast<char>(flags),
+                            0, 0, 0, 0 } + payload;
+    }
+
+    bool read(boost::asio::local::stream_protocol::socket& socket, void* data, const size_t size)
+    {
+        //fail instead of waiting forever if nothing is received
+        auto& context = static_cast<boost::asio::io_context&>(socket.get_executor().context());
+        boost::system::error_code result = boost::asio::error::timed_out;
+        boost::asio::async_read(socket, boost::asio::buffer(data, size), [&result](auto ec, auto) { result = ec; });
+        context.restart();
+        context.run_for(std::chrono::seconds(10));
+        if (boost::asio::error::timed_out == result)
+        {
+            socket.cancel();
+            context.restart();
+            context.run();
+        }
+        return ! result;
+    }
+
+    bool readFrame(boost::asio::local::stream_protocol::socket& socket, Frame& result)
+    {
+        uint8_t header[9];
+        if ( ! read(socket, header, std::size(header))) return false;
+
+        const size_t length = (static_cast<size_t>(header[0]) << 16) | (static_cast<size_t>(header[1]) << 8)
+                            | header[2];
+        result.type = header[3];
+        result.flags = header[4];
+        result.payload.resize(length);
+        return (0 == length) || read(socket, result.payload.data(), length);
+    }
+
+    std::time_t now()
+    {
+        return std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    }
+}
+
+BOOST_AUTO_TEST_CASE( TimeoutManager_refreshes_elements_that_did_not_expire )
+{
+    std::vector<int> released;
+    TimeoutManager<int> manager([&released](auto value) { released.push_back(value); }, 10);
+
+    manager.addExpireIn(1, 10);
+    manager.addExpireIn(2, 10);
+    manager.refreshExpireIn(2, 100);
+
+    manager.checkTimeout(now() + 50);
+    BOOST_REQUIRE_EQUAL(1u, released.size());
+    BOOST_REQUIRE_EQUAL(1, released[0]);
+
+    //elements that already expired are not added again
+    manager.refreshExpireIn(1, 100);
+    manager.checkTimeout(now() + 200);
+    BOOST_REQUIRE_EQUAL(2u, released.size());
+    BOOST_REQUIRE_EQUAL(2, released[1]);
+}
+
+BOOST_AUTO_TEST_CASE( Http2_connections_are_kept_open_while_in_use_and_end_with_goaway_on_timeout )
+{
+    const auto path = "/tmp/forum-http-tests-" + std::to_string(::getpid()) + "-timeout.sock";
+    constexpr size_t TimeoutSeconds = 2;
+
+    boost::asio::io_context context;
+    auto router = std::make_unique<HttpRouter>();
+    auto connectionManager = std::make_shared<FixedHttpConnectionManager>(context, std::move(router), 4, 16, 16,
+                                                                          false);
+    auto connectionManagerWithTimeout = std::make_shared<ConnectionManagerWithTimeout>(context, connectionManager,
+                                                                                       TimeoutSeconds);
+    StreamSocketListener listener(context, path, connectionManagerWithTimeout);
+    listener.startListening();
+
+    struct ServerThread
+    {
+        ~ServerThread()
+        {
+            listener.stopListening();
+            connectionManager.stop();
+            context.stop();
+            thread.join();
+        }
+
+        boost::asio::io_context& context;
+        StreamSocketListener& listener;
+        IConnectionManager& connectionManager;
+        std::thread thread{ [this] { context.run(); } };
+    } serverThread{ context, listener, *connectionManagerWithTimeout };
+
+    boost::asio::io_context clientContext;
+    boost::asio::local::stream_protocol::socket client(clientContext);
+    client.connect(boost::asio::local::stream_protocol::endpoint(path));
+
+    const auto preface = std::string(Http2Session::ConnectionPreface) + frame(SettingsFrame, 0, {});
+    boost::asio::write(client, boost::asio::buffer(preface));
+
+    Frame received;
+    BOOST_REQUIRE(readFrame(client, received));
+    BOOST_REQUIRE_EQUAL(SettingsFrame, received.type);
+    BOOST_REQUIRE(readFrame(client, received));
+    BOOST_REQUIRE_EQUAL(SettingsFrame, received.type);
+
+    //stay active for longer than the timeout
+    const auto activeUntil = std::chrono::steady_clock::now() + std::chrono::seconds(2 * TimeoutSeconds);
+    while (std::chrono::steady_clock::now() < activeUntil)
+    {
+        const auto ping = frame(PingFrame, 0, std::string(8, 'p'));
+        boost::asio::write(client, boost::asio::buffer(ping));
+
+        BOOST_REQUIRE(readFrame(client, received));
+        BOOST_REQUIRE_EQUAL(PingFrame, received.type);
+        BOOST_REQUIRE_EQUAL(AckFlag, received.flags);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    }
+
+    //once idle, the connection is closed after sending GOAWAY with NO_ERROR
+    BOOST_REQUIRE(readFrame(client, received));
+    BOOST_REQUIRE_EQUAL(GoAwayFrame, received.type);
+    BOOST_REQUIRE_EQUAL(8u, received.payload.size());
+    BOOST_REQUIRE_EQUAL(std::string(4, '\0'), received.payload.substr(4));
+    BOOST_REQUIRE( ! readFrame(client, received));
+}
@@ -0,0 +1,157 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Hpack.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Http;
+
+using HeaderList = std::vector<std::pair<std::string, std::string>>;
+
+static std::string fromHex(const std::string& hex)
+{
+    std::string result;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2)
+    {
+        result.push_back(static_cast<char>(std::stoi(hex.substr(i, 2), nullptr, 16)));
+    }
+    return result;
+}
+
+static bool appendHeader(HttpStringView name, HttpStringView value, void* state)
+{
+    reinterpret_cast<HeaderList*>(state)->emplace_back(std::string(name), std::string(value));
+    return true;
+}
+
+static HeaderList decode(Hpack::Decoder& decoder, const std::string& block)
+{
+    HeaderList result;
+    BOOST_REQUIRE(decoder.decode(block.data(), block.size(), appendHeader, &result));
+    return result;
+}
+
+static void checkHeaders(const HeaderList& expected, const HeaderList& actual)
+{
+    BOOST_REQUIRE_EQUAL(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        BOOST_REQUIRE_EQUAL(expected[i].first, actual[i].first);
+        BOOST_REQUIRE_EQUAL(expected[i].second, actual[i].second);
+    }
+}
+
+//https://tools.ietf.org/html/rfc7541#appendix-C.3
+BOOST_AUTO_TEST_CASE( Hpack_decodes_requests_without_huffman_coding )
+{
+    Hpack::Decoder decoder;
+
+    checkHeaders({ { ":method", "GET" }, { ":scheme", "http" }, { ":path", "/" },
+                   { ":authority", "www.example.com" } },
+                 decode(decoder, fromHex("828684410f7777772e6578616d706c652e636f6d")));
+    BOOST_REQUIRE_EQUAL(57u, decoder.dynamicTableSize());
+
+    checkHeaders({ { ":method", "GET" }, { ":scheme", "http" }, { ":path", "/" },
+                   { ":authority", "www.example.com" }, { "cache-control", "no-cache" } },
+                 decode(decoder, fromHex("828684be58086e6f2d6361636865")));
+    BOOST_REQUIRE_EQUAL(110u, decoder.dynamicTableSize());
+
+    checkHeaders({ { ":method", "GET" }, { ":scheme", "https" }, { ":path", "/index.html" },
+                   { ":authority", "www.example.com" }, { "custom-key", "custom-value" } },
+                 decode(decoder, fromHex("828785bf400a637573746f6d2d6b65790c637573746f6d2d76616c7565")));
+    BOOST_REQUIRE_EQUAL(164u, decoder.dynamicTableSize());
+}
+
+//https://tools.ietf.org/html/rfc7541#appendix-C.4
+BOOST_AUTO_TEST_CASE( Hpack_decodes_requests_with_huffman_coding )
+{
+    Hpack::Decoder decoder;
+
+    checkHeaders({ { ":method", "GET" }, { ":scheme", "http" }, { ":path", "/" },
+                   { ":authority", "www.example.com" } },
+                 decode(decoder, fromHex("828684418cf1e3c2e5f23a6ba0ab90f4ff")));
+
+    checkHeaders({ { ":method", "GET" }, { ":scheme", "http" }, { ":path", "/" },
+                   { ":authority", "www.example.com" }, { "cache-control", "no-cache" } },
+                 decode(decoder, fromHex("828684be5886a8eb10649cbf")));
+
+    checkHeaders({ { ":method", "GET" }, { ":scheme", "https" }, { ":path", "/index.html" },
+                   { ":authority", "www.example.com" }, { "custom-key", "custom-value" } },
+                 decode(decoder, fromHex("828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf")));
+    BOOST_REQUIRE_EQUAL(164u, decoder.dynamicTableSize());
+}
+
+BOOST_AUTO_TEST_CASE( Hpack_rejects_invalid_input )
+{
+    HeaderList headers;
+    {
+        //index 0 is not used
+        Hpack::Decoder decoder;
+        const auto block = fromHex("80");
+        BOOST_REQUIRE( ! decoder.decode(block.data(), block.size(), appendHeader, &headers));
+    }
+    {
+        //index past the end of both tables
+        Hpack::Decoder decoder;
+        const auto block = fromHex("be");
+        BOOST_REQUIRE( ! decoder.decode(block.data(), block.size(), appendHeader, &headers));
+    }
+    {
+        //the length of the value is larger than what remains
+        Hpack::Decoder decoder;
+        const auto block = fromHex("4004616263");
+        BOOST_REQUIRE( ! decoder.decode(block.data(), block.size(), appendHeader, &headers));
+    }
+    {
+        //Huffman padding must consist of ones
+        std::string output;
+        const auto encoded = fromHex("1f00");
+        BOOST_REQUIRE( ! Hpack::decodeHuffman(encoded.data(), encoded.size(), output));
+    }
+}
+
+BOOST_AUTO_TEST_CASE( Hpack_encoded_headers_can_be_decoded )
+{
+    std::vector<char> block;
+    Hpack::encodeStatus(200, block);
+    Hpack::encodeStatus(431, block);
+    Hpack::encodeHeader("Content-Type", "application/json", block);
+    Hpack::encodeHeader("X-Custom-Header", std::string(300, 'x'), block);
+
+    Hpack::Decoder decoder;
+    checkHeaders({ { ":status", "200" }, { ":status", "431" }, { "content-type", "application/json" },
+                   { "x-custom-header", std::string(300, 'x') } },
+                 decode(decoder, std::string(block.begin(), block.end())));
+    BOOST_REQUIRE_EQUAL(0u, decoder.dynamicTableSize());
+}
+
+BOOST_AUTO_TEST_CASE( Hpack_encodes_long_header_names_entirely )
+{
+    const std::string name = "X-" + std::string(300, 'N');
+    std::vector<char> block;
+    Hpack::encodeHeader(name, "value", block);
+
+    Hpack::Decoder decoder;
+    checkHeaders({ { "x-" + std::string(300, 'n'), "value" } },
+                 decode(decoder, std::string(block.begin(), block.end())));
+}
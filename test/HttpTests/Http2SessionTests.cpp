@@ -0,0 +1,632 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Http2Session.h"
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Http;
+
+namespace
+{
+    enum FrameType : uint8_t
+    {
+        Data = 0x0,
+        Headers = 0x1,
+        ResetStream = 0x3,
+        Settings = 0x4,
+        Ping = 0x6,
+        GoAway = 0x7,
+        WindowUpdate = 0x8
+    };
+
+    constexpr uint8_t EndStream = 0x1;
+    constexpr uint8_t Ack = 0x1;
+    constexpr uint8_t EndHeaders = 0x4;
+
+    struct Frame
+    {
+        uint8_t type;
+        uint8_t flags;
+        uint32_t streamId;
+        std::string payload;
+    };
+
+    using HeaderList = std::vector<std::pair<std::string, std::string>>;
+
+    std::string uint32ToBytes(const uint32_t value)
+    {
+        return { static_cast<char>((value >> 24) & 0xFF), static_cast<char>((value >> 16) & 0xFF),
+                 static_cast<char>((value >> 8) & 0xFF), static_cast<char>(value & 0xFF) };
+    }
+
+    uint32_t bytesToUInt32(const std::string& value, const size_t offset = 0)
+    {
+        const auto bytes = reinterpret_cast<const uint8_t*>(value.data() + offset);
+        return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16)
+             | (static_cast<uint32_t>(bytes[2]) << 8) | bytes[3];
+    }
+
+    std::string frame(const uint8_t type, const uint8_t flags, const uint32_t streamId, const std::string& payload)
+    {
+        const auto length = payload.size();
+        std::string result{ static_cast<char>((length >> 16) & 0xFF), static_cast<char>((length >> 8) & 0xFF),
+                            static_cast<char>(length & 0xFF), static_cast<char>(type), static_cast<char>(flags) };
+        return result + uint32ToBytes(streamId) + payload;
+    }
+
+    std::string headersFrame(const uint32_t streamId, const uint8_t flags, const HeaderList& headers)
+    {
+        std::vector<char> block;
+        for (const auto& [name, value] : headers)
+        {
+            Hpack::encodeHeader(name, value, block);
+        }
+        return frame(FrameType::Headers, flags, streamId, std::string(block.begin(), block.end()));
+    }
+
+    std::string clientPreface()
+    {
+        return std::string(Http2Session::ConnectionPreface) + frame(FrameType::Settings, 0, 0, {});
+    }
+
+    bool appendHeader(HttpStringView name, HttpStringView value, void* state)
+    {
+        reinterpret_cast<HeaderList*>(state)->emplace_back(std::string(name), std::string(value));
+        return true;
+    }
+
+    struct Http2SessionFixture
+    {
+        explicit Http2SessionFixture(const size_t poolSize = 16, const size_t budgetSize = 1024 * 1024) :
+            pool(poolSize), budget(budgetSize),
+            session(pool, budget, processRequest, [](auto data, auto size, auto state)
+                    {
+                        reinterpret_cast<Http2SessionFixture*>(state)->output.append(data, size);
+                    }, this)
+        {}
+
+        static void processRequest(HttpRequest& request, HttpResponseBuilder& response, void* state)
+        {
+            auto& fixture = *reinterpret_cast<Http2SessionFixture*>(state);
+
+            std::string handled(request.path);
+            for (size_t i = 0; i < request.nrOfQueryPairs; ++i)
+            {
+                handled.append("|").append(request.queryPairs[i].first).append("=")
+                       .append(request.queryPairs[i].second);
+            }
+            for (size_t i = 0; i < request.nrOfCookies; ++i)
+            {
+                handled.append("|").append(request.cookies[i].first).append("=").append(request.cookies[i].second);
+            }
+            for (size_t i = 0; i < request.nrOfRequestContentBuffers; ++i)
+            {
+                handled.append("|").append(request.requestContentBuffers[i]);
+            }
+            fixture.handled.push_back(handled);
+
+            response.writeResponseCode(request.versionMajor, request.versionMinor, HttpStatusCode::OK);
+            response.writeHeader("Content-Type", "text/plain");
+            response.writeHeader("Connection", "keep-alive");
+            response.writeBodyAndContentLength(fixture.responseBody.empty() ? std::string(request.path)
+                                                                           : fixture.responseBody);
+        }
+
+        std::vector<Frame> takeFrames()
+        {
+            std::vector<Frame> result;
+            size_t offset = 0;
+            while (offset + 9 <= output.size())
+            {
+                const auto bytes = reinterpret_cast<const uint8_t*>(output.data() + offset);
+                const size_t length = (static_cast<size_t>(bytes[0]) << 16) | (static_cast<size_t>(bytes[1]) << 8)
+                                    | bytes[2];
+                BOOST_REQUIRE(offset + 9 + length <= output.size());
+
+                result.push_back({ bytes[3], bytes[4], bytesToUInt32(output, offset + 5) & 0x7FFFFFFF,
+                                   output.substr(offset + 9, length) });
+                offset += 9 + length;
+            }
+            BOOST_REQUIRE_EQUAL(offset, output.size());
+            output.clear();
+            return result;
+        }
+
+        HeaderList decodeHeaders(const Frame& headers)
+        {
+            HeaderList result;
+            BOOST_REQUIRE(decoder.decode(headers.payload.data(), headers.payload.size(), appendHeader, &result));
+            return result;
+        }
+
+        void startSession()
+        {
+            const auto preface = clientPreface();
+            BOOST_REQUIRE(session.process(preface.data(), preface.size()));
+
+            const auto frames = takeFrames();
+            BOOST_REQUIRE_EQUAL(2u, frames.size());
+            BOOST_REQUIRE_EQUAL(FrameType::Settings, frames[0].type);
+            BOOST_REQUIRE_EQUAL(0, frames[0].flags);
+            BOOST_REQUIRE_EQUAL(FrameType::Settings, frames[1].type);
+            BOOST_REQUIRE_EQUAL(Ack, frames[1].flags);
+        }
+
+        bool process(const std::string& input)
+        {
+            return session.process(input.data(), input.size());
+        }
+
+        Http2Session::ReadBufferPoolType pool;
+        ResponseOverflowBudget budget;
+        std::string output;
+        std::vector<std::string> handled;
+        std::string responseBody;
+        Hpack::Decoder decoder;
+        Http2Session session;
+    };
+
+    HeaderList getRequest(const std::string& path)
+    {
+        return { { ":method", "GET" }, { ":scheme", "http" }, { ":path", path }, { ":authority", "localhost" } };
+    }
+
+    HeaderList postRequest(const std::string& path)
+    {
+        auto result = getRequest(path);
+        result[0].second = "POST";
+        return result;
+    }
+
+    struct LargePoolHttp2SessionFixture : Http2SessionFixture
+    {
+        LargePoolHttp2SessionFixture() : Http2SessionFixture(4 * Http2Session::MaxLeasedBuffers)
+        {}
+    };
+
+    struct SmallBudgetHttp2SessionFixture : Http2SessionFixture
+    {
+        SmallBudgetHttp2SessionFixture() : Http2SessionFixture(16, 64 * 1024)
+        {}
+    };
+}
+
+BOOST_AUTO_TEST_CASE( Http2Session_detects_the_connection_preface )
+{
+    BOOST_REQUIRE(Http2Session::startsWithConnectionPreface("PRI ", 4));
+    BOOST_REQUIRE(Http2Session::startsWithConnectionPreface("PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n\0\0", 26));
+    BOOST_REQUIRE( ! Http2Session::startsWithConnectionPreface("PRI", 3));
+    BOOST_REQUIRE( ! Http2Session::startsWithConnectionPreface("GET / HTTP/1.1\r\n", 16));
+    BOOST_REQUIRE( ! Http2Session::startsWithConnectionPreface("PROPFIND / HTTP/1.1\r\n", 21));
+}
+
+BOOST_FIXTURE_TEST_CASE( Http2Session_rejects_an_invalid_preface, Http2SessionFixture )
+{
+    BOOST_REQUIRE( ! process("PRI * HTTP/1.1\r\n\r\n"));
+}
+
+BOOST_FIXTURE_TEST_CASE( Http2Session_converts_requests_and_responses, Http2SessionFixture )
+{
+    startSession();
+
+    auto headers = getRequest("/threads?sort=name");
+    headers.emplace_back("cookie", "first=1");
+    headers.emplace_back("cookie", "second=2");
+    BOOST_REQUIRE(process(headersFrame(1, EndStream | EndHeaders, headers)));
+
+    const std::vector<std::string> expectedHandled{ "threads|sort=name|first=1|second=2" };
+    BOOST_REQUIRE_EQUAL_COLLECTIONS(expectedHandled.begin(), expectedHandled.end(), handled.begin(), handled.end());
+
+    const auto frames = takeFrames();
+    BOOST_REQUIRE_EQUAL(2u, frames.size());
+    BOOST_REQUIRE_EQUAL(FrameType::Headers, frames[0].type);
+    BOOST_REQUIRE_EQUAL(EndHeaders, frames[0].flags);
+    BOOST_REQUIRE_EQUAL(1u, frames[0].streamId);
+
+    const HeaderList expectedHeaders{ { ":status", "200" }, { "content-type", "text/plain" },
+                                      { "content-length", "7" } };
+    const auto responseHeaders = decodeHeaders(frames[0]);
+    BOOST_REQUIRE(expectedHeaders == responseHeaders);
+
+    BOOST_REQUIRE_EQUAL(FrameType::Data, frames[1].type);
+    BOOST_REQUIRE_EQUAL(EndStream, frames[1].flags);
+    BOOST_REQUIRE_EQUAL(1u, frames[1].streamId);
+    BOOST_REQUIRE_EQUAL("threads", frames[1].payload);
+}
+
+BOOST_FIXTURE_TEST_CASE( Http2Session_answers_multiple_streams_in_order, Http2SessionFixture )
+{
+    startSession();
+
+    BOOST_REQUIRE(process(headersFrame(1, EndStream | EndHeaders, getRequest("/first"))
+                          + headersFrame(3, EndStream | EndHeaders, getRequest("/second"))));
+
+    const std::vector<std::string> expectedHandled{ "first", "second" };
+    BOOST_REQUIRE_EQUAL_COLLECTIONS(expectedHandled.begin(), expectedHandled.end(), handled.begin(), handled.end());
+
+    const auto frames = takeFrames();
+    BOOST_REQUIRE_EQUAL(4u, frames.size());
+    BOOST_REQUIRE_EQUAL(1u, frames[1].streamId);
+    BOOST_REQUIRE_EQUAL("first", frames[1].payload);
+    BOOST_REQUIRE_EQUAL(3u, frames[3].streamId);
+    BOOST_REQUIRE_EQUAL("second", frames[3].payload);
+}
+
+BOOST_FIXTURE_TEST_CASE( Http2Session_processes_frames_split_across_reads, Http2SessionFixture )
+{
+    startSession();
+
+    const auto input = headersFrame(1, EndStream | EndHeaders, getRequest("/split"));
+    for (const char c : input)
+    {
+        BOOST_REQUIRE(session.process(&c, 1));
+    }
+
+    const std::vector<std::string> expectedHandled{ "split" };
+    BOOST_REQUIRE_EQUAL_COLLECTIONS(expectedHandled.begin(), expectedHandled.end(), handled.begin(), handled.end());
+    BOOST_REQUIRE_EQUAL(2u, takeFrames().size());
+}
+
+BOOST_FIXTURE_TEST_CASE( Http2Session_passes_on_request_bodies, Http2SessionFixture )
+{
+    startSession();
+
+    auto headers = getRequest("/threads");
+    headers[0].second = "POST";
+    BOOST_REQUIRE(process(headersFrame(1, EndHeaders, headers)));
+    BOOST_REQUIRE(handled.empty());
+
+    BOOST_REQUIRE(process(frame(FrameType::Data, EndStream, 1, "abc")));
+
+    const std::vector<std::string> expectedHandled{ "threads|abc" };
+    BOOST_REQUIRE_EQUAL_COLLECTIONS(expectedHandled.begin(), expectedHandled.end(), handled.begin(), handled.end());
+
+    const auto frames = takeFrames();
+    BOOST_REQUIRE_EQUAL(3u, frames.size());
+    BOOST_REQUIRE_EQUAL(FrameType::Headers, frames[0].type);
+    BOOST_REQUIRE_EQUAL(FrameType::Data, frames[1].type);
+    //the connection window is replenished with what was received
+    BOOST_REQUIRE_EQUAL(FrameType::WindowUpdate, frames[2].type);
+    BOOST_REQUIRE_EQUAL(0u, frames[2].streamId);
+    BOOST_REQUIRE_EQUAL(3u, bytesToUInt32(frames[2].payload));
+}
+
+BOOST_FIXTURE_TEST_CASE( Http2Session_respects_flow_control_windows, Http2SessionFixture )
+{
+    startSession();
+
+    responseBody = std::string(70000, 'x');
+    BOOST_REQUIRE(process(headersFrame(1, EndStream | EndHeaders, getRequest("/large"))));
+
+    size_t received = 0;
+    for (const auto& item : takeFrames())
+    {
+        if (FrameType::Data == item.type)
+        {
+            BOOST_REQUIRE(item.payload.size() <= 16384u);
+            BOOST_REQUIRE_EQUAL(0, item.flags & EndStream);
+            received += item.payload.size();
+        }
+    }
+    //the default window of the connection and of the stream
+    BOOST_REQUIRE_EQUAL(65535u, received);
+
+    //both windows need to allow sending the rest
+    BOOST_REQUIRE(process(frame(FrameType::WindowUpdate, 0, 0, uint32ToBytes(10000))));
+    BOOST_REQUIRE(takeFrames().empty());
+
+    BOOST_REQUIRE(process(frame(FrameType::WindowUpdate, 0, 1, uint32ToBytes(10000))));
+    const auto frames = takeFrames();
+    BOOST_REQUIRE_EQUAL(1u, frames.size());
+    BOOST_REQUIRE_EQUAL(FrameType::Data, frames[0].type);
+    BOOST_REQUIRE_EQUAL(EndStream, frames[0].flags);
+    BOOST_REQUIRE_EQUAL(70000u - 65535u, frames[0].payload.size());
+}
+
+BOOST_FIXTURE_TEST_CASE( Http2Session_reserves_memory_for_responses_until_they_are_sent, Http2SessionFixture )
+{
+    startSession();
+
+    responseBody = std::string(70000, 'x');
+    BOOST_REQUIRE(process(headersFrame(1, EndStream | EndHeaders, getRequest("/large"))));
+    takeFrames();
+    //the rest of the response waits for the flow control windows
+    BOOST_REQUIRE_GT(budget.used(), 70000u);
+
+    BOOST_REQUIRE(process(frame(FrameType::WindowUpdate, 0, 0, uint32ToBytes(10000))
+                          + frame(FrameType::WindowUpdate, 0, 1, uint32ToBytes(10000))));
+    BOOST_REQUIRE_EQUAL(EndStream, takeFrames().at(0).flags);
+    BOOST_REQUIRE_EQUAL(0u, budget.used());
+}
+
+BOOST_FIXTURE_TEST_CASE( Http2Session_resets_streams_whose_responses_exceed_the_budget, SmallBudgetHttp2SessionFixture )
+{
+    startSession();
+
+    responseBody = std::string(70000, 'x');
+    BOOST_REQUIRE(process(headersFrame(1, EndStream | EndHeaders, getRequest("/large"))));
+    BOOST_REQUIRE_EQUAL(1u, handled.size());
+
+    auto frames = takeFrames();
+    BOOST_REQUIRE_EQUAL(1u, frames.size());
+    BOOST_REQUIRE_EQUAL(FrameType::ResetStream, frames[0].type);
+    BOOST_REQUIRE_EQUAL(1u, frames[0].streamId);
+    //INTERNAL_ERROR
+    BOOST_REQUIRE_EQUAL(2u, bytesToUInt32(frames[0].payload));
+    BOOST_REQUIRE_EQUAL(0u, budget.used());
+
+    //smaller responses are still sent
+    responseBody.clear();
+    BOOST_REQUIRE(process(headersFrame(3, EndStream | EndHeaders, getRequest("/small"))));
+    frames = takeFrames();
+    BOOST_REQUIRE_EQUAL(2u, frames.size());
+    BOOST_REQUIRE_EQUAL("small", frames[1].payload);
+    BOOST_REQUIRE_EQUAL(0u, budget.used());
+}
+
+BOOST_FIXTURE_TEST_CASE( Http2Session_answers_pings, Http2SessionFixture )
+{
+    startSession();
+
+    BOOST_REQUIRE(process(frame(FrameType::Ping, 0, 0, "12345678")));
+
+    const auto frames = takeFrames();
+    BOOST_REQUIRE_EQUAL(1u, frames.size());
+    BOOST_REQUIRE_EQUAL(FrameType::Ping, frames[0].type);
+    BOOST_REQUIRE_EQUAL(Ack, frames[0].flags);
+    BOOST_REQUIRE_EQUAL("12345678", frames[0].payload);
+}
+
+BOOST_FIXTURE_TEST_CASE( Http2Session_resets_streams_with_malformed_headers, Http2SessionFixture )
+{
+    startSession();
+
+    auto headers = getRequest("/threads");
+    headers.emplace_back("x-value", "a\r\nb");
+    BOOST_REQUIRE(process(headersFrame(1, EndStream | EndHeaders, headers)));
+    BOOST_REQUIRE(handled.empty());
+
+    const auto frames = takeFrames();
+    BOOST_REQUIRE_EQUAL(1u, frames.size());
+    BOOST_REQUIRE_EQUAL(FrameType::ResetStream, frames[0].type);
+    BOOST_REQUIRE_EQUAL(1u, frames[0].streamId);
+
+    //the connection remains usable
+    BOOST_REQUIRE(process(headersFrame(3, EndStream | EndHeaders, getRequest("/threads"))));
+    BOOST_REQUIRE_EQUAL(1u, handled.size());
+}
+
+namespace
+{
+    //literal header field with incremental indexing and a new name, for short names and values
+    std::string indexedLiteral(const std::string& name, const std::string& value)
+    {
+        assert((name.size() < 127) && (value.size() < 127));
+        return std::string{ 0x40, static_cast<char>(name.size()) } + name + static_cast<char>(value.size()) + value;
+    }
+
+    //the most recent entry in the dynamic table
+    constexpr char NewestDynamicTableEntry = static_cast<char>(0x80 | 62);
+}
+
+BOOST_FIXTURE_TEST_CASE( Http2Session_keeps_the_dynamic_table_in_sync_after_malformed_headers, Http2SessionFixture )
+{
+    startSession();
+
+    std::vector<char> block;
+    for (const auto& [name, value] : getRequest("/threads"))
+    {
+        Hpack::encodeHeader(name, value, block);
+    }
+    std::string first(block.begin(), block.end());
+    first += indexedLiteral("x-value", "a\nb") + indexedLiteral("x-next", "next");
+
+    BOOST_REQUIRE(process(frame(FrameType::Headers, EndStream | EndHeaders, 1, first)));
+    BOOST_REQUIRE(handled.empty());
+    BOOST_REQUIRE_EQUAL(FrameType::ResetStream, takeFrames().at(0).type);
+
+    //refers to the entry added after the malformed field
+    std::string second(block.begin(), block.end());
+    second += NewestDynamicTableEntry;
+    BOOST_REQUIRE(process(frame(FrameType::Headers, EndStream | EndHeaders, 3, second)));
+    BOOST_REQUIRE_EQUAL(1u, handled.size());
+}
+
+BOOST_FIXTURE_TEST_CASE( Http2Session_limits_the_size_of_decoded_header_lists, Http2SessionFixture )
+{
+    startSession();
+
+    std::vector<char> block;
+    for (const auto& [name, value] : getRequest("/threads"))
+    {
+        Hpack::encodeHeader(name, value, block);
+    }
+    std::string input(block.begin(), block.end());
+    //a few bytes that expand to far more than the advertised limit
+    input += indexedLiteral("x-large", std::string(100, 'x'));
+    input += std::string(100, NewestDynamicTableEntry);
+    BOOST_REQUIRE_LT(input.size(), 512u);
+
+    BOOST_REQUIRE( ! process(frame(FrameType::Headers, EndStream | EndHeaders, 1, input)));
+    BOOST_REQUIRE(handled.empty());
+
+    const auto frames = takeFrames();
+    BOOST_REQUIRE_EQUAL(1u, frames.size());
+    BOOST_REQUIRE_EQUAL(FrameType::GoAway, frames[0].type);
+    //ENHANCE_YOUR_CALM
+    BOOST_REQUIRE_EQUAL(0xBu, bytesToUInt32(frames[0].payload, 4));
+}
+
+BOOST_FIXTURE_TEST_CASE( Http2Session_closes_the_connection_on_protocol_errors, Http2SessionFixture )
+{
+    startSession();
+
+    //streams initiated by the client must use odd identifiers
+    BOOST_REQUIRE( ! process(headersFrame(2, EndStream | EndHeaders, getRequest("/threads"))));
+    BOOST_REQUIRE(handled.empty());
+
+    const auto frames = takeFrames();
+    BOOST_REQUIRE_EQUAL(1u, frames.size());
+    BOOST_REQUIRE_EQUAL(FrameType::GoAway, frames[0].type);
+    BOOST_REQUIRE_EQUAL(0u, frames[0].streamId);
+    //PROTOCOL_ERROR
+    BOOST_REQUIRE_EQUAL(1u, bytesToUInt32(frames[0].payload, 4));
+}
+
+BOOST_FIXTURE_TEST_CASE( Http2Session_resets_streams_with_header_blocks_that_do_not_end_them, Http2SessionFixture )
+{
+    startSession();
+
+    BOOST_REQUIRE(process(headersFrame(1, EndHeaders, postRequest("/threads"))));
+    //trailers need to end the stream
+    BOOST_REQUIRE(process(headersFrame(1, EndHeaders, { { "x-trailer", "value" } })));
+    BOOST_REQUIRE(handled.empty());
+
+    const auto frames = takeFrames();
+    BOOST_REQUIRE_EQUAL(1u, frames.size());
+    BOOST_REQUIRE_EQUAL(FrameType::ResetStream, frames[0].type);
+    BOOST_REQUIRE_EQUAL(1u, frames[0].streamId);
+    //PROTOCOL_ERROR
+    BOOST_REQUIRE_EQUAL(1u, bytesToUInt32(frames[0].payload));
+
+    //the connection remains usable
+    BOOST_REQUIRE(process(headersFrame(3, EndStream | EndHeaders, getRequest("/threads"))));
+    BOOST_REQUIRE_EQUAL(1u, handled.size());
+}
+
+BOOST_FIXTURE_TEST_CASE( Http2Session_resets_streams_with_header_blocks_after_their_end, Http2SessionFixture )
+{
+    startSession();
+
+    //the response waits for the flow control windows, so the stream is still open
+    responseBody = std::string(70000, 'x');
+    BOOST_REQUIRE(process(headersFrame(1, EndStream | EndHeaders, getRequest("/large"))));
+    takeFrames();
+
+    BOOST_REQUIRE(process(headersFrame(1, EndStream | EndHeaders, { { "x-trailer", "value" } })));
+    const auto frames = takeFrames();
+    BOOST_REQUIRE_EQUAL(1u, frames.size());
+    BOOST_REQUIRE_EQUAL(FrameType::ResetStream, frames[0].type);
+    BOOST_REQUIRE_EQUAL(1u, frames[0].streamId);
+    //STREAM_CLOSED
+    BOOST_REQUIRE_EQUAL(5u, bytesToUInt32(frames[0].payload));
+    BOOST_REQUIRE_EQUAL(0u, budget.used());
+}
+
+BOOST_FIXTURE_TEST_CASE( Http2Session_rejects_initial_window_sizes_that_overflow_stream_windows, Http2SessionFixture )
+{
+    startSession();
+
+    BOOST_REQUIRE(process(headersFrame(1, EndHeaders, postRequest("/threads"))));
+    //the stream window reaches the maximum
+    BOOST_REQUIRE(process(frame(FrameType::WindowUpdate, 0, 1, uint32ToBytes(0x7FFFFFFF - 65535))));
+    BOOST_REQUIRE(takeFrames().empty());
+
+    //SETTINGS_INITIAL_WINDOW_SIZE
+    const std::string setting = std::string{ 0, 4 } + uint32ToBytes(65536);
+    BOOST_REQUIRE( ! process(frame(FrameType::Settings, 0, 0, setting)));
+
+    const auto frames = takeFrames();
+    BOOST_REQUIRE_EQUAL(1u, frames.size());
+    BOOST_REQUIRE_EQUAL(FrameType::GoAway, frames[0].type);
+    //FLOW_CONTROL_ERROR
+    BOOST_REQUIRE_EQUAL(3u, bytesToUInt32(frames[0].payload, 4));
+}
+
+BOOST_FIXTURE_TEST_CASE( Http2Session_limits_the_pooled_buffers_leased_by_a_connection, LargePoolHttp2SessionFixture )
+{
+    startSession();
+
+    BOOST_REQUIRE(process(headersFrame(1, EndHeaders, postRequest("/first"))));
+    BOOST_REQUIRE(process(headersFrame(3, EndHeaders, postRequest("/second"))));
+
+    //each stream holds a buffer for its headers, the first one uses the rest of the allowance for its body
+    const auto bodyBuffers = Http2Session::MaxLeasedBuffers - 2;
+    const std::string chunk(16384, 'x');
+    size_t sent = 0;
+    while (sent < bodyBuffers * Buffer::ReadBufferSize)
+    {
+        const auto toSend = std::min(chunk.size(), bodyBuffers * Buffer::ReadBufferSize - sent);
+        BOOST_REQUIRE(process(frame(FrameType::Data, 0, 1, chunk.substr(0, toSend))));
+        sent += toSend;
+    }
+    takeFrames();
+
+    //neither a new stream nor more body data for another stream fit in the allowance
+    BOOST_REQUIRE(process(headersFrame(5, EndStream | EndHeaders, getRequest("/third"))));
+    BOOST_REQUIRE(process(frame(FrameType::Data, EndStream, 3, "abc")));
+    BOOST_REQUIRE(handled.empty());
+
+    std::vector<uint32_t> refusedStreams;
+    for (const auto& item : takeFrames())
+    {
+        if (FrameType::ResetStream == item.type)
+        {
+            //REFUSED_STREAM
+            BOOST_REQUIRE_EQUAL(7u, bytesToUInt32(item.payload));
+            refusedStreams.push_back(item.streamId);
+        }
+    }
+    const std::vector<uint32_t> expectedRefusedStreams{ 5, 3 };
+    BOOST_REQUIRE_EQUAL_COLLECTIONS(expectedRefusedStreams.begin(), expectedRefusedStreams.end(),
+                                    refusedStreams.begin(), refusedStreams.end());
+
+    //the first stream is still served and its buffers are returned afterwards
+    BOOST_REQUIRE(process(frame(FrameType::Data, EndStream, 1, {})));
+    BOOST_REQUIRE_EQUAL(1u, handled.size());
+    BOOST_REQUIRE_EQUAL(0u, handled[0].find("first|"));
+    takeFrames();
+
+    BOOST_REQUIRE(process(headersFrame(7, EndStream | EndHeaders, getRequest("/fourth"))));
+    BOOST_REQUIRE_EQUAL(2u, handled.size());
+    BOOST_REQUIRE_EQUAL("fourth", handled[1]);
+}
+
+BOOST_FIXTURE_TEST_CASE( Http2Session_finishes_started_streams_after_the_client_sends_goaway, Http2SessionFixture )
+{
+    startSession();
+
+    BOOST_REQUIRE(process(headersFrame(1, EndHeaders, postRequest("/threads"))));
+    BOOST_REQUIRE(process(frame(FrameType::GoAway, 0, 0, uint32ToBytes(0) + uint32ToBytes(0))));
+
+    //streams started after GOAWAY are refused
+    BOOST_REQUIRE(process(headersFrame(3, EndStream | EndHeaders, getRequest("/users"))));
+    auto frames = takeFrames();
+    BOOST_REQUIRE_EQUAL(1u, frames.size());
+    BOOST_REQUIRE_EQUAL(FrameType::ResetStream, frames[0].type);
+    BOOST_REQUIRE_EQUAL(3u, frames[0].streamId);
+
+    //the connection is closed once the pending response is sent
+    BOOST_REQUIRE( ! process(frame(FrameType::Data, EndStream, 1, "abc")));
+
+    const std::vector<std::string> expectedHandled{ "threads|abc" };
+    BOOST_REQUIRE_EQUAL_COLLECTIONS(expectedHandled.begin(), expectedHandled.end(), handled.begin(), handled.end());
+
+    frames = takeFrames();
+    BOOST_REQUIRE_EQUAL(2u, frames.size());
+    BOOST_REQUIRE_EQUAL(FrameType::Headers, frames[0].type);
+    BOOST_REQUIRE_EQUAL(FrameType::Data, frames[1].type);
+    BOOST_REQUIRE_EQUAL(EndStream, frames[1].flags);
+}
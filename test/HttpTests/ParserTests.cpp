@@ -18,6 +18,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "HttpParser.h"
 
+#include <algorithm>
 #include <cassert>
 #include <random>
 #include <string>
@@ -337,6 +338,33 @@ BOOST_AUTO_TEST_CASE( Http_Parser_parses_cookies )
     });
 }
 
+BOOST_AUTO_TEST_CASE( Http_Parser_ignores_cookies_and_query_parameters_over_the_limit )
+{
+    std::string path = "/app?";
+    std::string cookies;
+    for (size_t i = 0; i < 100; ++i)
+    {
+        path += "key" + std::to_string(i) + "=value" + std::to_string(i) + "&";
+        cookies += "name" + std::to_string(i) + "=value" + std::to_string(i) + "; ";
+    }
+    char headerBuffer[8192];
+    testParser("GET " + path + " HTTP/1.0\r\nCookie: " + cookies + "\r\n\r\n",
+            [](const Parser& parser, std::string_view /*requestBody*/)
+    {
+        BOOST_REQUIRE_EQUAL(Parser::ParseResult::FINISHED, parser);
+
+        const auto& request = parser.request();
+
+        BOOST_REQUIRE_EQUAL("app", request.path);
+        BOOST_REQUIRE_EQUAL(HttpRequest::MaxQueryPairs, request.nrOfQueryPairs);
+        BOOST_REQUIRE_EQUAL("key63", request.queryPairs[63].first);
+        BOOST_REQUIRE_EQUAL("value63", request.queryPairs[63].second);
+        BOOST_REQUIRE_EQUAL(HttpRequest::MaxCookies, request.nrOfCookies);
+        BOOST_REQUIRE_EQUAL("name31", request.cookies[31].first);
+        BOOST_REQUIRE_EQUAL("value31", request.cookies[31].second);
+    }, 1024, headerBuffer, std::size(headerBuffer));
+}
+
 BOOST_AUTO_TEST_CASE( Http_Parser_parses_request_body )
 {
     testParser("POST /app HTTP/1.0\r\nContent-Length:11\r\n\r\naa\r\nbb%20cc", 
@@ -407,3 +435,134 @@ BOOST_AUTO_TEST_CASE( Http_Parser_does_not_exceed_content_buffer )
         BOOST_REQUIRE_EQUAL("", requestBody);
     }, 10);
 }
+
+BOOST_AUTO_TEST_CASE( Http_Parser_leaves_bytes_of_pipelined_requests_unprocessed )
+{
+    char headerBuffer[1024];
+    std::string requestBody;
+
+    Parser parser(headerBuffer, std::size(headerBuffer), 1024, [](const char* buffer, size_t bufferSize, void* state)
+    {
+        reinterpret_cast<std::string*>(state)->append(buffer, bufferSize);
+        return true;
+    }, &requestBody);
+
+    std::string input = "POST /first HTTP/1.1\r\nContent-Length:5\r\n\r\nabcdeGET /second HTTP/1.1\r\n\r\nGET /thi";
+
+    parser.process(input.data(), input.size());
+
+    BOOST_REQUIRE_EQUAL(Parser::ParseResult::FINISHED, parser);
+    BOOST_REQUIRE_EQUAL("first", parser.request().path);
+    BOOST_REQUIRE_EQUAL("abcde", requestBody);
+
+    auto remaining = parser.unprocessedBytes();
+    BOOST_REQUIRE_EQUAL("GET /second HTTP/1.1\r\n\r\nGET /thi"s, input.substr(input.size() - remaining));
+
+    parser.reset();
+    parser.process(input.data() + input.size() - remaining, remaining);
+
+    BOOST_REQUIRE_EQUAL(Parser::ParseResult::FINISHED, parser);
+    BOOST_REQUIRE_EQUAL("second", parser.request().path);
+
+    remaining = parser.unprocessedBytes();
+    BOOST_REQUIRE_EQUAL("GET /thi"s, input.substr(input.size() - remaining));
+
+    parser.reset();
+    parser.process(input.data() + input.size() - remaining, remaining);
+
+    BOOST_REQUIRE_EQUAL(Parser::ParseResult::ONGOING, parser);
+    BOOST_REQUIRE_EQUAL(0u, parser.unprocessedBytes());
+}
+
+BOOST_AUTO_TEST_CASE( Http_Parser_rejects_too_large_bodies_before_reading_them )
+{
+    std::string requestBody;
+    char headerBuffer[1024];
+    Parser parser(headerBuffer, std::size(headerBuffer), 10, [](const char* buffer, size_t bufferSize, void* state)
+    {
+        reinterpret_cast<std::string*>(state)->append(buffer, bufferSize);
+        return true;
+    }, &requestBody);
+
+    std::string input = "POST /app HTTP/1.1\r\nContent-Length:11\r\n\r\n";
+    parser.process(input.data(), input.size());
+
+    BOOST_REQUIRE_EQUAL(Parser::ParseResult::INVALID_INPUT, parser);
+    BOOST_REQUIRE_EQUAL(HttpStatusCode::Payload_Too_Large, parser.errorCode());
+    BOOST_REQUIRE( ! parser.expectsBody());
+    BOOST_REQUIRE_EQUAL(0u, parser.remainingBodyBytes());
+    BOOST_REQUIRE_EQUAL("", requestBody);
+}
+
+BOOST_AUTO_TEST_CASE( Http_Parser_accounts_for_bodies_received_directly_into_storage )
+{
+    std::string requestBody;
+    char headerBuffer[1024];
+    Parser parser(headerBuffer, std::size(headerBuffer), 1024, [](const char* buffer, size_t bufferSize, void* state)
+    {
+        reinterpret_cast<std::string*>(state)->append(buffer, bufferSize);
+        return true;
+    }, &requestBody);
+
+    const std::string headers = "POST /app HTTP/1.1\r\nContent-Length:10\r\n\r\n";
+    std::string input = headers + "abc";
+    std::copy(input.begin(), input.end(), headerBuffer);
+
+    //parsed in place, as HttpConnection does
+    parser.process(headerBuffer, input.size());
+
+    BOOST_REQUIRE_EQUAL(Parser::ParseResult::ONGOING, parser);
+    BOOST_REQUIRE_EQUAL(headers.size(), parser.headerSize());
+    BOOST_REQUIRE(parser.expectsBody());
+    BOOST_REQUIRE_EQUAL(7u, parser.remainingBodyBytes());
+    BOOST_REQUIRE_EQUAL("abc", requestBody);
+
+    parser.processStoredBody(4);
+
+    BOOST_REQUIRE_EQUAL(Parser::ParseResult::ONGOING, parser);
+    BOOST_REQUIRE(parser.expectsBody());
+    BOOST_REQUIRE_EQUAL(3u, parser.remainingBodyBytes());
+
+    parser.processStoredBody(3);
+
+    BOOST_REQUIRE_EQUAL(Parser::ParseResult::FINISHED, parser);
+    BOOST_REQUIRE( ! parser.expectsBody());
+    BOOST_REQUIRE_EQUAL(0u, parser.remainingBodyBytes());
+    BOOST_REQUIRE_EQUAL("app", parser.request().path);
+    //bytes received directly into storage are not pushed again
+    BOOST_REQUIRE_EQUAL("abc", requestBody);
+}
+
+BOOST_AUTO_TEST_CASE( Http_Parser_parses_bodies_split_across_reads )
+{
+    std::string body(500, 'x');
+    for (size_t i = 0; i < body.size(); ++i)
+    {
+        body[i] = static_cast<char>('a' + (i % 26));
+    }
+    testParser("POST /app HTTP/1.1\r\nContent-Length:500\r\n\r\n" + body,
+        [&body](const Parser& parser, std::string_view requestBody)
+    {
+        BOOST_REQUIRE_EQUAL(Parser::ParseResult::FINISHED, parser);
+        BOOST_REQUIRE_EQUAL(0u, parser.remainingBodyBytes());
+        BOOST_REQUIRE_EQUAL(body, requestBody);
+    });
+}
+
+BOOST_AUTO_TEST_CASE( Http_Parser_rejects_bodies_larger_than_the_storage )
+{
+    char headerBuffer[1024];
+    Parser parser(headerBuffer, std::size(headerBuffer), 1024, [](const char* /*buffer*/, size_t /*bufferSize*/,
+                                                                  void* /*state*/)
+    {
+        //no more room
+        return false;
+    }, nullptr);
+
+    std::string input = "POST /app HTTP/1.1\r\nContent-Length:5\r\n\r\nabc";
+    parser.process(input.data(), input.size());
+
+    BOOST_REQUIRE_EQUAL(Parser::ParseResult::INVALID_INPUT, parser);
+    BOOST_REQUIRE_EQUAL(HttpStatusCode::Payload_Too_Large, parser.errorCode());
+    BOOST_REQUIRE( ! parser.expectsBody());
+}
@@ -0,0 +1,93 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReadWriteBufferArray.h"
+
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Http;
+
+template<size_t BufferSize, size_t MaxNrOfBuffers>
+static std::string toString(const ReadWriteBufferArray<BufferSize, MaxNrOfBuffers>& bufferArray)
+{
+    std::string result;
+    for (const auto buffer : bufferArray.constBufferWrapper())
+    {
+        result.append(boost::asio::buffer_cast<const char*>(buffer), boost::asio::buffer_size(buffer));
+    }
+    return result;
+}
+
+BOOST_AUTO_TEST_CASE( ReadWriteBufferArray_stores_data_received_directly_into_the_buffers )
+{
+    FixedSizeBufferPool<8> pool(2);
+    ReadWriteBufferArray<8, 2> bufferArray(pool);
+
+    auto buffer = bufferArray.prepare();
+    BOOST_REQUIRE_EQUAL(8u, buffer.size());
+    std::string("abcde").copy(static_cast<char*>(buffer.data()), 5);
+    bufferArray.commit(5);
+    BOOST_REQUIRE_EQUAL(5u, bufferArray.size());
+
+    //the rest of the same buffer is offered next
+    buffer = bufferArray.prepare();
+    BOOST_REQUIRE_EQUAL(3u, buffer.size());
+    std::string("fgh").copy(static_cast<char*>(buffer.data()), 3);
+    bufferArray.commit(3);
+
+    buffer = bufferArray.prepare();
+    BOOST_REQUIRE_EQUAL(8u, buffer.size());
+    std::string("ij").copy(static_cast<char*>(buffer.data()), 2);
+    bufferArray.commit(2);
+
+    BOOST_REQUIRE_EQUAL(10u, bufferArray.size());
+    BOOST_REQUIRE_EQUAL("abcdefghij", toString(bufferArray));
+    BOOST_REQUIRE( ! bufferArray.notEnoughRoom());
+}
+
+BOOST_AUTO_TEST_CASE( ReadWriteBufferArray_prepare_returns_an_empty_buffer_when_there_is_no_more_room )
+{
+    FixedSizeBufferPool<8> pool(2);
+    {
+        ReadWriteBufferArray<8, 1> bufferArray(pool);
+
+        BOOST_REQUIRE_EQUAL(8u, bufferArray.prepare().size());
+        bufferArray.commit(8);
+
+        //the maximum number of buffers is reached
+        BOOST_REQUIRE_EQUAL(0u, bufferArray.prepare().size());
+        BOOST_REQUIRE(bufferArray.notEnoughRoom());
+    }
+    {
+        auto leased = pool.leaseBuffer();
+        ReadWriteBufferArray<8, 2> bufferArray(pool);
+
+        BOOST_REQUIRE_EQUAL(8u, bufferArray.prepare().size());
+        bufferArray.commit(8);
+
+        //the pool is exhausted
+        BOOST_REQUIRE_EQUAL(0u, bufferArray.prepare().size());
+        BOOST_REQUIRE(bufferArray.notEnoughRoom());
+
+        bufferArray.reset();
+        BOOST_REQUIRE_EQUAL(0u, bufferArray.size());
+        BOOST_REQUIRE_EQUAL(8u, bufferArray.prepare().size());
+    }
+}
@@ -0,0 +1,230 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ResponseBuffer.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Http;
+
+static std::string toString(const ResponseBuffer& responseBuffer)
+{
+    std::vector<boost::asio::const_buffer> buffers;
+    responseBuffer.getBuffers(buffers);
+
+    std::string result;
+    for (const auto buffer : buffers)
+    {
+        result.append(boost::asio::buffer_cast<const char*>(buffer), boost::asio::buffer_size(buffer));
+    }
+    return result;
+}
+
+static std::string createInput(const size_t size)
+{
+    std::string result(size, ' ');
+    for (size_t i = 0; i < size; ++i)
+    {
+        result[i] = static_cast<char>('a' + (i % 26));
+    }
+    return result;
+}
+
+BOOST_AUTO_TEST_CASE( ResponseBuffer_keeps_responses_larger_than_the_pooled_buffers )
+{
+    ResponseBuffer::WriteBufferPoolType pool(2);
+    ResponseOverflowBudget budget(1024 * 1024);
+    ResponseBuffer responseBuffer(pool, budget);
+
+    const auto input = createInput(50000);
+    BOOST_REQUIRE(responseBuffer.write(input.data(), 1000));
+    BOOST_REQUIRE(responseBuffer.write(input.data() + 1000, input.size() - 1000));
+
+    BOOST_REQUIRE( ! responseBuffer.failed());
+    BOOST_REQUIRE_EQUAL(input.size(), responseBuffer.size());
+    BOOST_REQUIRE_EQUAL(input.size() - 2 * Buffer::WriteBufferSize, responseBuffer.overflowSize());
+    BOOST_REQUIRE_GE(budget.used(), responseBuffer.overflowSize());
+    BOOST_REQUIRE_EQUAL(input, toString(responseBuffer));
+
+    responseBuffer.reset();
+    BOOST_REQUIRE_EQUAL(0u, responseBuffer.size());
+    BOOST_REQUIRE_EQUAL(0u, budget.used());
+}
+
+BOOST_AUTO_TEST_CASE( ResponseBuffer_uses_the_overflow_when_the_pool_is_exhausted )
+{
+    ResponseBuffer::WriteBufferPoolType pool(1);
+    ResponseOverflowBudget budget(1024 * 1024);
+    auto leased = pool.leaseBuffer();
+    {
+        ResponseBuffer responseBuffer(pool, budget);
+
+        const auto input = createInput(100);
+        BOOST_REQUIRE(responseBuffer.write(input.data(), input.size()));
+        BOOST_REQUIRE_EQUAL(input.size(), responseBuffer.overflowSize());
+        BOOST_REQUIRE_EQUAL(input, toString(responseBuffer));
+    }
+    //the reserved memory is returned on destruction
+    BOOST_REQUIRE_EQUAL(0u, budget.used());
+}
+
+BOOST_AUTO_TEST_CASE( ResponseBuffer_refuses_responses_when_the_shared_budget_is_exhausted )
+{
+    ResponseBuffer::WriteBufferPoolType pool(0);
+    ResponseOverflowBudget budget(100 * 1024);
+    ResponseBuffer first(pool, budget);
+    ResponseBuffer second(pool, budget);
+
+    const auto input = createInput(80 * 1024);
+    BOOST_REQUIRE(first.write(input.data(), input.size()));
+
+    BOOST_REQUIRE( ! second.write(input.data(), input.size()));
+    BOOST_REQUIRE(second.failed());
+    BOOST_REQUIRE_EQUAL(HttpStatusCode::Service_Unavailable, second.errorCode());
+    //further writes are ignored until reset
+    BOOST_REQUIRE( ! second.write(input.data(), 1));
+
+    first.reset();
+    second.reset();
+    BOOST_REQUIRE(second.write(input.data(), input.size()));
+    BOOST_REQUIRE_EQUAL(input, toString(second));
+}
+
+BOOST_AUTO_TEST_CASE( ResponseBuffer_refuses_responses_larger_than_the_limit )
+{
+    ResponseBuffer::WriteBufferPoolType pool(1);
+    ResponseOverflowBudget budget(1024 * 1024);
+    ResponseBuffer responseBuffer(pool, budget, 1000);
+
+    const auto input = createInput(Buffer::WriteBufferSize + 1001);
+    BOOST_REQUIRE( ! responseBuffer.write(input.data(), input.size()));
+    BOOST_REQUIRE_EQUAL(HttpStatusCode::Internal_Server_Error, responseBuffer.errorCode());
+    BOOST_REQUIRE_EQUAL(0u, budget.used());
+}
+
+static void writeInPlace(ResponseBuffer& responseBuffer, const std::string& input)
+{
+    size_t written = 0;
+    while (written < input.size())
+    {
+        const auto buffer = responseBuffer.prepare();
+        const auto toWrite = std::min(input.size() - written, boost::asio::buffer_size(buffer));
+        BOOST_REQUIRE_GT(toWrite, 0u);
+        std::copy(input.data() + written, input.data() + written + toWrite, static_cast<char*>(buffer.data()));
+        responseBuffer.commit(toWrite);
+        written += toWrite;
+    }
+}
+
+BOOST_AUTO_TEST_CASE( ResponseBuffer_can_be_written_in_place_and_changed_afterwards )
+{
+    ResponseBuffer::WriteBufferPoolType pool(2);
+    ResponseOverflowBudget budget(1024 * 1024);
+    ResponseBuffer responseBuffer(pool, budget);
+
+    auto input = createInput(3 * Buffer::WriteBufferSize);
+    BOOST_REQUIRE(responseBuffer.write(input.data(), 100));
+    writeInPlace(responseBuffer, input.substr(100));
+
+    BOOST_REQUIRE_EQUAL(input.size(), responseBuffer.size());
+    BOOST_REQUIRE_EQUAL(Buffer::WriteBufferSize, responseBuffer.overflowSize());
+    BOOST_REQUIRE_EQUAL(input, toString(responseBuffer));
+
+    //the changed bytes span both pooled buffers and the overflow
+    const std::string changed(Buffer::WriteBufferSize + 200, '-');
+    const auto changedOffset = Buffer::WriteBufferSize - 100;
+    responseBuffer.overwrite(changedOffset, changed.data(), changed.size());
+    input.replace(changedOffset, changed.size(), changed);
+    BOOST_REQUIRE_EQUAL(input, toString(responseBuffer));
+
+    responseBuffer.truncate(2 * Buffer::WriteBufferSize + 10);
+    BOOST_REQUIRE_EQUAL(10u, responseBuffer.overflowSize());
+    BOOST_REQUIRE_EQUAL(input.substr(0, 2 * Buffer::WriteBufferSize + 10), toString(responseBuffer));
+
+    responseBuffer.truncate(10);
+    BOOST_REQUIRE_EQUAL(0u, responseBuffer.overflowSize());
+    BOOST_REQUIRE_EQUAL(input.substr(0, 10), toString(responseBuffer));
+    //the buffers that are no longer needed are returned to the pool
+    BOOST_REQUIRE(pool.leaseBuffer());
+
+    BOOST_REQUIRE(responseBuffer.write(input.data() + 10, 10));
+    BOOST_REQUIRE_EQUAL(input.substr(0, 20), toString(responseBuffer));
+}
+
+BOOST_AUTO_TEST_CASE( ResponseBuffer_does_not_prepare_more_than_the_limit )
+{
+    ResponseBuffer::WriteBufferPoolType pool(0);
+    ResponseOverflowBudget budget(1024 * 1024);
+    ResponseBuffer responseBuffer(pool, budget, 1000);
+
+    const auto buffer = responseBuffer.prepare();
+    BOOST_REQUIRE_EQUAL(1000u, boost::asio::buffer_size(buffer));
+    responseBuffer.commit(1000);
+
+    BOOST_REQUIRE_EQUAL(0u, boost::asio::buffer_size(responseBuffer.prepare()));
+    BOOST_REQUIRE_EQUAL(HttpStatusCode::Internal_Server_Error, responseBuffer.errorCode());
+}
+
+BOOST_AUTO_TEST_CASE( BudgetedResponseStorage_limits_the_size_of_responses_and_reserves_their_memory )
+{
+    ResponseOverflowBudget budget(1024 * 1024);
+    std::vector<char> output;
+    BudgetedResponseStorage storage(output, budget, 1000);
+
+    const auto input = createInput(1000);
+    BOOST_REQUIRE(storage.write(input.data(), 600));
+    BOOST_REQUIRE_EQUAL(1000u, budget.used());
+
+    const auto buffer = storage.prepare();
+    BOOST_REQUIRE_EQUAL(400u, boost::asio::buffer_size(buffer));
+    storage.commit(400);
+    BOOST_REQUIRE_EQUAL(1000u, output.size());
+
+    BOOST_REQUIRE( ! storage.write(input.data(), 1));
+    BOOST_REQUIRE(storage.failed());
+
+    storage.reset();
+    BOOST_REQUIRE_EQUAL(0u, budget.used());
+    BOOST_REQUIRE( ! storage.failed());
+}
+
+BOOST_AUTO_TEST_CASE( BudgetedResponseStorage_fails_once_the_shared_budget_is_used_up )
+{
+    ResponseOverflowBudget budget(20 * 1024);
+    std::vector<char> firstOutput, secondOutput;
+    BudgetedResponseStorage first(firstOutput, budget);
+    BudgetedResponseStorage second(secondOutput, budget);
+
+    const auto input = createInput(10 * 1024);
+    BOOST_REQUIRE(first.write(input.data(), input.size()));
+    BOOST_REQUIRE( ! second.write(input.data(), input.size()));
+    BOOST_REQUIRE(second.failed());
+
+    //the reservation of bytes handed over is kept until released explicitly
+    const auto reserved = first.takeReservation();
+    first.reset();
+    BOOST_REQUIRE_EQUAL(reserved, budget.used());
+    budget.release(reserved);
+
+    second.reset();
+    BOOST_REQUIRE(second.write(input.data(), input.size()));
+}
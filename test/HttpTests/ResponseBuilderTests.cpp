@@ -18,10 +18,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "HttpResponseBuilder.h"
 
+#include <algorithm>
 #include <string>
+#include <tuple>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
+#include <zlib.h>
+
 using namespace Http;
 using namespace std::literals::string_literals;
 
@@ -34,6 +39,15 @@ BOOST_AUTO_TEST_CASE( BuildSimpleResponseFromStatusCode_works )
                         HttpStringView(buffer, written));
 }
 
+BOOST_AUTO_TEST_CASE( BuildSimpleResponseFromStatusCode_writes_all_status_digits )
+{
+    char buffer[1024];
+    const auto written = buildSimpleResponseFromStatusCode(HttpStatusCode::Request_Header_Fields_Too_Large, 1, 1,
+                                                           buffer);
+
+    BOOST_REQUIRE_EQUAL("HTTP/1.1 431", HttpStringView(buffer, written).substr(0, 12));
+}
+
 BOOST_AUTO_TEST_CASE( WriteHttpDateGMT_works )
 {
     char buffer[1024];
@@ -100,3 +114,190 @@ BOOST_AUTO_TEST_CASE( HttpReponseBuilder_writes_body_with_content_length )
 
     BOOST_REQUIRE_EQUAL("HTTP/1.1 200 OK\r\nHeader1: Value1\r\nContent-Length: 17\r\n\r\nwhile(1);{\"a\": 1}", output);
 }
+
+BOOST_AUTO_TEST_CASE( EntityTagMatches_uses_weak_comparison )
+{
+    BOOST_REQUIRE(entityTagMatches("\"abc\"", "\"abc\""));
+    BOOST_REQUIRE(entityTagMatches("W/\"abc\"", "\"abc\""));
+    BOOST_REQUIRE(entityTagMatches("\"abc\"", "W/\"abc\""));
+    BOOST_REQUIRE( ! entityTagMatches("\"abcd\"", "\"abc\""));
+    BOOST_REQUIRE( ! entityTagMatches("", "\"abc\""));
+}
+
+BOOST_AUTO_TEST_CASE( EntityTagMatches_accepts_lists_and_wildcards )
+{
+    BOOST_REQUIRE(entityTagMatches("\"x\", W/\"abc\" ,\"y\"", "W/\"abc\""));
+    BOOST_REQUIRE(entityTagMatches("\"x\",\t\"abc\"", "\"abc\""));
+    BOOST_REQUIRE( ! entityTagMatches("\"x\", \"y\",", "\"abc\""));
+    BOOST_REQUIRE(entityTagMatches("*", "\"abc\""));
+}
+
+BOOST_AUTO_TEST_CASE( ChooseContentEncoding_prefers_gzip_and_respects_quality_values )
+{
+    BOOST_REQUIRE(ContentEncoding::Identity == chooseContentEncoding(""));
+    BOOST_REQUIRE(ContentEncoding::Identity == chooseContentEncoding("br, identity"));
+    BOOST_REQUIRE(ContentEncoding::Gzip == chooseContentEncoding("gzip, deflate, br"));
+    BOOST_REQUIRE(ContentEncoding::Gzip == chooseContentEncoding("GZIP"));
+    BOOST_REQUIRE(ContentEncoding::Deflate == chooseContentEncoding("deflate"));
+    BOOST_REQUIRE(ContentEncoding::Deflate == chooseContentEncoding("gzip;q=0.5, deflate"));
+    BOOST_REQUIRE(ContentEncoding::Deflate == chooseContentEncoding("gzip;q=0, deflate;q=0.1"));
+    BOOST_REQUIRE(ContentEncoding::Gzip == chooseContentEncoding("*"));
+    BOOST_REQUIRE(ContentEncoding::Deflate == chooseContentEncoding("gzip;q=0, *;q=0.2"));
+    BOOST_REQUIRE(ContentEncoding::Identity == chooseContentEncoding("gzip;q=0.000, deflate; q=0"));
+}
+
+static std::string inflateBody(const std::string& response, const int windowBits)
+{
+    const auto bodyStart = response.find("\r\n\r\n") + 4;
+
+    z_stream stream{};
+    BOOST_REQUIRE_EQUAL(Z_OK, inflateInit2(&stream, windowBits));
+
+    std::string output(1 << 16, '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(response.data() + bodyStart));
+    stream.avail_in = static_cast<uInt>(response.size() - bodyStart);
+    stream.next_out = reinterpret_cast<Bytef*>(output.data());
+    stream.avail_out = static_cast<uInt>(output.size());
+
+    BOOST_REQUIRE_EQUAL(Z_STREAM_END, inflate(&stream, Z_FINISH));
+    output.resize(stream.total_out);
+    inflateEnd(&stream);
+
+    return output;
+}
+
+BOOST_AUTO_TEST_CASE( HttpReponseBuilder_compresses_large_bodies )
+{
+    const std::string body = "{\"items\": [" + std::string(4000, '1') + "]}";
+
+    const auto encodings = { std::make_tuple(ContentEncoding::Gzip, "gzip", 15 + 16),
+                             std::make_tuple(ContentEncoding::Deflate, "deflate", 15) };
+    for (const auto& [encoding, encodingName, windowBits] : encodings)
+    {
+        std::string output;
+        HttpResponseBuilder response{ appendToString, &output };
+
+        BodyCompression compression;
+        compression.encoding = encoding;
+        compression.minimumSize = 1024;
+
+        response.writeResponseCode(1, 1, HttpStatusCode::OK);
+        response.writeBodyAndContentLength(body, "while(1);", compression);
+
+        BOOST_REQUIRE_NE(std::string::npos, output.find("\r\nVary: Accept-Encoding\r\n"));
+        BOOST_REQUIRE_NE(std::string::npos, output.find("\r\nContent-Encoding: "s + encodingName + "\r\n"));
+        BOOST_REQUIRE_LT(output.size(), body.size());
+        BOOST_REQUIRE_EQUAL("while(1);" + body, inflateBody(output, windowBits));
+    }
+}
+
+BOOST_AUTO_TEST_CASE( HttpReponseBuilder_does_not_compress_small_bodies )
+{
+    std::string output;
+    HttpResponseBuilder response{ appendToString, &output };
+
+    BodyCompression compression;
+    compression.encoding = ContentEncoding::Gzip;
+    compression.minimumSize = 1024;
+
+    response.writeResponseCode(1, 1, HttpStatusCode::OK);
+    response.writeBodyAndContentLength("{\"a\": 1}", "while(1);", compression);
+
+    BOOST_REQUIRE_EQUAL("HTTP/1.1 200 OK\r\nVary: Accept-Encoding\r\nContent-Length: 17\r\n\r\nwhile(1);{\"a\": 1}", 
+                        output);
+}
+
+static void appendToVector(const char* data, size_t size, void* state)
+{
+    auto& output = *reinterpret_cast<std::vector<char>*>(state);
+    output.insert(output.end(), data, data + size);
+}
+
+BOOST_AUTO_TEST_CASE( HttpReponseBuilder_fills_in_the_length_of_bodies_written_in_parts )
+{
+    std::vector<char> output;
+    VectorResponseStorage storage(output);
+    HttpResponseBuilder response{ appendToVector, &output, &storage };
+    BOOST_REQUIRE(response.canWriteBodyInParts());
+
+    response.writeResponseCode(1, 1, HttpStatusCode::OK);
+    response.writeHeader("Header1", "Value1");
+    response.startBodyInParts();
+    response.writeBodyPart("while(1);");
+
+    const std::string inPlace(40000, 'a');
+    size_t written = 0;
+    while (written < inPlace.size())
+    {
+        const auto buffer = response.prepareBodyPart();
+        const auto toWrite = std::min(inPlace.size() - written, boost::asio::buffer_size(buffer));
+        BOOST_REQUIRE_GT(toWrite, 0u);
+        std::copy(inPlace.data() + written, inPlace.data() + written + toWrite, static_cast<char*>(buffer.data()));
+        response.commitBodyPart(toWrite);
+        written += toWrite;
+    }
+    response.writeBodyPart("{}");
+    BOOST_REQUIRE(response.endBodyInParts());
+
+    const std::string expectedHeaders = "HTTP/1.1 200 OK\r\nHeader1: Value1\r\nContent-Length:      40011\r\n\r\n";
+    BOOST_REQUIRE_EQUAL(expectedHeaders + "while(1);" + inPlace + "{}", std::string(output.begin(), output.end()));
+}
+
+BOOST_AUTO_TEST_CASE( HttpReponseBuilder_compresses_bodies_written_in_parts )
+{
+    const std::string part = "{\"items\": [" + std::string(4000, '1') + "]}";
+
+    std::vector<char> output;
+    VectorResponseStorage storage(output);
+    HttpResponseBuilder response{ appendToVector, &output, &storage };
+
+    BodyCompression compression;
+    compression.encoding = ContentEncoding::Gzip;
+    compression.minimumSize = 1024;
+
+    response.writeResponseCode(1, 1, HttpStatusCode::OK);
+    response.startBodyInParts(compression, part.size());
+    //the body is compressed, it cannot be written in place
+    BOOST_REQUIRE_EQUAL(0u, boost::asio::buffer_size(response.prepareBodyPart()));
+    for (int i = 0; i < 10; ++i)
+    {
+        response.writeBodyPart(part);
+    }
+    BOOST_REQUIRE(response.endBodyInParts());
+
+    const std::string result(output.begin(), output.end());
+    const auto headersEnd = result.find("\r\n\r\n");
+    const auto contentLength = std::to_string(result.size() - headersEnd - 4);
+
+    BOOST_REQUIRE_NE(std::string::npos, result.find("\r\nVary: Accept-Encoding\r\n"));
+    BOOST_REQUIRE_NE(std::string::npos, result.find("\r\nContent-Encoding: gzip\r\n"));
+    BOOST_REQUIRE_NE(std::string::npos, result.find(" " + contentLength + "\r\n\r\n"));
+
+    std::string expected;
+    for (int i = 0; i < 10; ++i)
+    {
+        expected += part;
+    }
+    BOOST_REQUIRE_EQUAL(expected, inflateBody(result, 15 + 16));
+}
+
+BOOST_AUTO_TEST_CASE( HttpReponseBuilder_can_discard_a_response_for_writing_another_one )
+{
+    std::vector<char> output;
+    VectorResponseStorage storage(output);
+    HttpResponseBuilder response{ appendToVector, &output, &storage };
+
+    response.writeResponseCode(1, 1, HttpStatusCode::OK);
+    response.startBodyInParts();
+    response.writeBodyPart("{\"items\": [");
+    const auto buffer = response.prepareBodyPart();
+    BOOST_REQUIRE_GT(boost::asio::buffer_size(buffer), 0u);
+    response.commitBodyPart(0);
+    response.discardResponse();
+
+    response.writeResponseCode(1, 1, HttpStatusCode::Not_Found);
+    response.writeBodyAndContentLength("{}");
+
+    BOOST_REQUIRE_EQUAL("HTTP/1.1 404 Not Found\r\nContent-Length: 2\r\n\r\n{}",
+                        std::string(output.begin(), output.end()));
+}
@@ -0,0 +1,123 @@
+/*
+Fast Forum Backend
+Copyright (C) Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "HttpRouter.h"
+
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Http;
+
+namespace
+{
+    struct RoutedRequests
+    {
+        std::vector<std::string> handled;
+
+        void record(const std::string& name, const RequestState& requestState)
+        {
+            std::string value = name;
+            for (size_t i = 0; i < requestState.nrOfExtraPathParts; ++i)
+            {
+                value += "|" + std::string(requestState.extraPathParts[i]);
+            }
+            handled.push_back(value);
+        }
+        void first(RequestState& requestState) { record("first", requestState); }
+        void second(RequestState& requestState) { record("second", requestState); }
+        void third(RequestState& requestState) { record("third", requestState); }
+        void fallback(RequestState& requestState) { record("default", requestState); }
+    };
+
+    struct RouterFixture
+    {
+        RouterFixture()
+        {
+            router.addRoute("users", HttpVerb::GET, RouteHandler::fromMethod<&RoutedRequests::first>(routed));
+            router.addRoute("users/current", HttpVerb::GET, RouteHandler::fromMethod<&RoutedRequests::second>(routed));
+            router.addRoute("users", HttpVerb::POST, RouteHandler::fromMethod<&RoutedRequests::third>(routed));
+            router.freeze();
+        }
+
+        std::string forward(HttpVerb verb, HttpStringView path)
+        {
+            HttpRequest request;
+            request.verb = verb;
+            request.path = path;
+            HttpResponseBuilder response{ [](const char* data, size_t size, void* state)
+                                          {
+                                              static_cast<std::string*>(state)->append(data, size);
+                                          }, &responseText };
+            routed.handled.clear();
+            router.forward(request, response);
+            return routed.handled.empty() ? "" : routed.handled.front();
+        }
+
+        RoutedRequests routed;
+        HttpRouter router;
+        std::string responseText;
+    };
+}
+
+BOOST_FIXTURE_TEST_CASE( HttpRouter_matches_routes_case_insensitively, RouterFixture )
+{
+    BOOST_REQUIRE_EQUAL("first", forward(HttpVerb::GET, "users"));
+    BOOST_REQUIRE_EQUAL("first", forward(HttpVerb::GET, "USERS/"));
+    BOOST_REQUIRE_EQUAL("second", forward(HttpVerb::GET, "Users/Current"));
+}
+
+BOOST_FIXTURE_TEST_CASE( HttpRouter_separates_routes_by_verb, RouterFixture )
+{
+    BOOST_REQUIRE_EQUAL("first", forward(HttpVerb::GET, "users"));
+    BOOST_REQUIRE_EQUAL("third", forward(HttpVerb::POST, "users"));
+    BOOST_REQUIRE_EQUAL("", forward(HttpVerb::PUT, "users"));
+    BOOST_REQUIRE_NE(std::string::npos, responseText.find("404"));
+}
+
+BOOST_FIXTURE_TEST_CASE( HttpRouter_uses_the_longest_matching_route_and_extracts_the_remaining_path_parts,
+                         RouterFixture )
+{
+    BOOST_REQUIRE_EQUAL("second|abc", forward(HttpVerb::GET, "users/current/abc"));
+    BOOST_REQUIRE_EQUAL("first|other|abc", forward(HttpVerb::GET, "users/other/abc"));
+    BOOST_REQUIRE_EQUAL("first|Id|123", forward(HttpVerb::GET, "users/Id/123/"));
+    BOOST_REQUIRE_EQUAL("", forward(HttpVerb::GET, "user"));
+}
+
+BOOST_AUTO_TEST_CASE( HttpRouter_uses_the_default_route_if_no_other_route_matches )
+{
+    RoutedRequests routed;
+    HttpRouter router;
+    router.addRoute("users", HttpVerb::GET, RouteHandler::fromMethod<&RoutedRequests::first>(routed));
+    router.addRoute("users", HttpVerb::GET, RouteHandler::fromMethod<&RoutedRequests::second>(routed));
+    router.setDefaultRoute(RouteHandler::fromMethod<&RoutedRequests::fallback>(routed));
+    router.freeze();
+
+    HttpResponseBuilder response{ [](const char*, size_t, void*) {}, nullptr };
+    HttpRequest request;
+    request.verb = HttpVerb::GET;
+
+    request.path = "users/1";
+    router.forward(request, response);
+    request.path = "other/1";
+    router.forward(request, response);
+
+    const std::vector<std::string> expected{ "first|1", "default|other|1" };
+    BOOST_REQUIRE_EQUAL_COLLECTIONS(expected.begin(), expected.end(), routed.handled.begin(), routed.handled.end());
+}
@@ -0,0 +1,132 @@
+/*
+Fast Forum Backend
+Copyright (C) 2016-present Daniel Jurcau
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "StreamSocketListener.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Http;
+
+namespace
+{
+    struct CountingConnectionManager final : IConnectionManager
+    {
+        ConnectionIdentifier newConnection(IConnectionManager* /*manager*/, StreamSocket&& socket) override
+        {
+            //closed when going out of scope
+            StreamSocket accepted(std::move(socket));
+            ++acceptedConnections;
+            return nullptr;
+        }
+
+        void closeConnection(ConnectionIdentifier /*identifier*/) override {}
+        void disconnectConnection(ConnectionIdentifier /*identifier*/) override {}
+
+        std::atomic<int> acceptedConnections{ 0 };
+    };
+
+    std::string getSocketPath(const std::string& name)
+    {
+        return "/tmp/forum-http-tests-" + std::to_string(::getpid()) + "-" + name + ".sock";
+    }
+
+    bool isSocket(const std::string& path)
+    {
+        struct stat status{};
+        return (0 == ::lstat(path.c_str(), &status)) && S_ISSOCK(status.st_mode);
+    }
+
+    bool exists(const std::string& path)
+    {
+        struct stat status{};
+        return 0 == ::lstat(path.c_str(), &status);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( StreamSocketListener_accepts_connections_on_a_unix_socket )
+{
+    const auto path = getSocketPath("accept");
+    boost::asio::io_context context;
+    auto manager = std::make_shared<CountingConnectionManager>();
+    {
+        StreamSocketListener listener(context, path, manager);
+        listener.startListening();
+        BOOST_REQUIRE(isSocket(path));
+
+        boost::asio::local::stream_protocol::socket client(context);
+        client.connect(boost::asio::local::stream_protocol::endpoint(path));
+
+        for (int i = 0; (i < 100) && (0 == manager->acceptedConnections); ++i)
+        {
+            context.run_for(std::chrono::milliseconds(50));
+        }
+        BOOST_REQUIRE_EQUAL(1, manager->acceptedConnections);
+
+        listener.stopListening();
+    }
+    BOOST_REQUIRE( ! exists(path));
+}
+
+BOOST_AUTO_TEST_CASE( StreamSocketListener_replaces_a_stale_socket_file )
+{
+    const auto path = getSocketPath("stale");
+    boost::asio::io_context context;
+    {
+        //the socket file remains after the socket is closed
+        boost::asio::local::stream_protocol::acceptor previous(context,
+                                                               boost::asio::local::stream_protocol::endpoint(path));
+    }
+    BOOST_REQUIRE(isSocket(path));
+
+    StreamSocketListener listener(context, path, std::make_shared<CountingConnectionManager>());
+    listener.startListening();
+    BOOST_REQUIRE(isSocket(path));
+
+    listener.stopListening();
+    BOOST_REQUIRE( ! exists(path));
+}
+
+BOOST_AUTO_TEST_CASE( StreamSocketListener_does_not_replace_other_files )
+{
+    const auto path = getSocketPath("regular");
+    {
+        std::ofstream file(path);
+        file << "data";
+    }
+    boost::asio::io_context context;
+    {
+        StreamSocketListener listener(context, path, std::make_shared<CountingConnectionManager>());
+        BOOST_REQUIRE_THROW(listener.startListening(), boost::system::system_error);
+    }
+    std::string content;
+    {
+        std::ifstream file(path);
+        file >> content;
+    }
+    BOOST_REQUIRE_EQUAL("data", content);
+
+    ::unlink(path.c_str());
+}
@@ -19,14 +19,19 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "ConnectionManagerWithTimeout.h"
 #include "DefaultIOServiceProvider.h"
 #include "FixedHttpConnectionManager.h"
+#include "HttpParser.h"
 #include "HttpRouter.h"
-#include "TcpListener.h"
+#include "StreamSocketListener.h"
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <vector>
 
 #include <boost/noncopyable.hpp>
 
@@ -38,8 +43,8 @@ class Endpoints final : boost::noncopyable
 public:
     void registerRoutes(HttpRouter& router)
     {
-        router.addRoute("hello", HttpVerb::GET, [this](auto& state) { this->hello(state); });
-        router.addRoute("count", HttpVerb::GET, [this](auto& state) { this->count(state); });
+        router.addRoute("hello", HttpVerb::GET, RouteHandler::fromMethod<&Endpoints::hello>(*this));
+        router.addRoute("count", HttpVerb::GET, RouteHandler::fromMethod<&Endpoints::count>(*this));
     }
 
 private:
@@ -62,14 +67,148 @@ private:
     }
 };
 
+/**
+ * Measures only the time needed to find a route and extract the extra path parts, using a route table shaped like the
+ * one of the forum API
+ */
+static int benchmarkRouter()
+{
+    static const char* resources[] = { "users", "threads", "thread_messages", "tags", "categories", "attachments",
+                                       "privileges/thread", "privileges/tag", "privileges/category" };
+    static const char* actions[] = { "", "/id", "/name", "/search", "/multiple", "/latest", "/user", "/subscribed",
+                                     "/comments", "/rank", "/content", "/required/forum_wide", "/assign" };
+    const HttpVerb verbs[] = { HttpVerb::GET, HttpVerb::POST, HttpVerb::PUT, HttpVerb::DELETE };
+
+    std::vector<std::string> routes;
+    for (const auto resource : resources)
+    {
+        for (const auto action : actions)
+        {
+            routes.push_back(std::string(resource) + action);
+        }
+    }
+
+    uint64_t handlerCalls{};
+    const RouteHandler handler{ [](RequestState& requestState, void* state)
+                                {
+                                    *static_cast<uint64_t*>(state) += requestState.nrOfExtraPathParts;
+                                }, &handlerCalls };
+
+    HttpRouter router;
+    for (const auto& route : routes)
+    {
+        for (const auto verb : verbs)
+        {
+            router.addRoute(route, verb, handler);
+        }
+    }
+    router.freeze();
+
+    std::vector<std::string> paths;
+    for (const auto& route : routes)
+    {
+        paths.push_back(route + "/0b2f6c3a-60bc-4b60-a8a0-06d1b7e7e4b2/2");
+    }
+    paths.emplace_back("not/registered");
+
+    HttpResponseBuilder response{ [](const char*, size_t, void*) {}, nullptr };
+    HttpRequest request;
+    request.verb = HttpVerb::GET;
+
+    constexpr size_t iterations = 1000000;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        request.path = paths[i % paths.size()];
+        response.reset();
+        router.forward(request, response);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const auto elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+
+    std::cout << routes.size() * std::size(verbs) << " routes, " << iterations << " requests forwarded in "
+              << (elapsedNs / 1000000) << " ms (" << (static_cast<double>(elapsedNs) / iterations) << " ns/request, "
+              << handlerCalls << " extra path parts)\n";
+    return 0;
+}
+
+/**
+ * Measures the time needed to parse a request as sent by a browser, with about 1.5 KB of headers and cookies
+ */
+static int benchmarkParser()
+{
+    std::string request = "GET /threads/id/0b2f6c3a-60bc-4b60-a8a0-06d1b7e7e4b2?page=2&sort=created&order=ascending "
+                          "HTTP/1.1\r\n"
+                          "Host: dani.forum\r\n"
+                          "Connection: keep-alive\r\n"
+                          "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) "
+                          "Chrome/118.0.0.0 Safari/537.36\r\n"
+                          "Accept: application/json, text/plain, */*\r\n"
+                          "Accept-Encoding: gzip, deflate, br\r\n"
+                          "Accept-Language: en-US,en;q=0.9,ro;q=0.8,de;q=0.7\r\n"
+                          "Referer: https://dani.forum/threads/0b2f6c3a-60bc-4b60-a8a0-06d1b7e7e4b2\r\n"
+                          "Sec-Fetch-Dest: empty\r\n"
+                          "Sec-Fetch-Mode: cors\r\n"
+                          "Sec-Fetch-Site: same-origin\r\n"
+                          "X-Forwarded-For: 203.0.113.195\r\n"
+                          "Cookie: ";
+    for (int i = 0; i < 16; ++i)
+    {
+        request += "preference" + std::to_string(i) + "=value%20with%20some%20content%20" + std::to_string(i) + "; ";
+    }
+    request += "session=8f14e45fceea167a5a36dedd4bea2543ab8f3a9c2e1d0f7b6a5c4d3e2f1a0b9c\r\n\r\n";
+
+    std::vector<char> headerBuffer(Buffer::ReadBufferSize);
+    Parser parser{ headerBuffer.data(), headerBuffer.size(), 0,
+                   [](const char*, size_t, void*) { return true; }, nullptr };
+
+    constexpr size_t iterations = 1000000;
+    size_t cookiesFound{};
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        //values are decoded in place, so the request needs to be received again each time
+        std::copy(request.begin(), request.end(), headerBuffer.begin());
+        parser.reset();
+        parser.process(headerBuffer.data(), request.size());
+        if (parser != Parser::FINISHED)
+        {
+            std::cerr << "Could not parse the request\n";
+            return 1;
+        }
+        cookiesFound += parser.request().nrOfCookies;
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const auto elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+
+    std::cout << iterations << " requests of " << request.size() << " bytes parsed in " << (elapsedNs / 1000000)
+              << " ms (" << (static_cast<double>(elapsedNs) / iterations) << " ns/request, "
+              << cookiesFound << " cookies)\n";
+    return 0;
+}
+
 class Application final : boost::noncopyable
 {
 public:
-    int run(int /*argc*/, const char* /*argv*/[])
+    /**
+     * Listens on 127.0.0.1:8081 or, if a path is provided as the first argument, on a local socket at that path.
+     * Passing --router or --parser only measures the cost of routing or parsing requests, without any networking
+     */
+    int run(int argc, const char* argv[])
     {
+        if ((argc > 1) && (std::string_view(argv[1]) == "--router"))
+        {
+            return benchmarkRouter();
+        }
+        if ((argc > 1) && (std::string_view(argv[1]) == "--parser"))
+        {
+            return benchmarkParser();
+        }
         try
         {
-            initialize();
+            initialize((argc > 1) ? argv[1] : "");
         }
         catch (std::exception& ex)
         {
@@ -79,7 +218,7 @@ public:
 
         try
         {
-            tcpListener_->startListening();
+            listener_->startListening();
         }
         catch (std::exception& ex)
         {
@@ -90,13 +229,13 @@ public:
         ioServiceProvider_->start();
         ioServiceProvider_->waitForStop();
 
-        tcpListener_->stopListening();
+        listener_->stopListening();
 
         return 0;
     }
 
 private:
-    void initialize()
+    void initialize(std::string_view unixSocketPath)
     {
         ioServiceProvider_ = std::make_unique<DefaultIOServiceProvider>(std::thread::hardware_concurrency());
         auto& ioService = ioServiceProvider_->getIOService();
@@ -112,12 +251,20 @@ private:
         auto connectionManagerWithTimeout = std::make_shared<ConnectionManagerWithTimeout>(ioService,
             httpConnectionManager, 30);
 
-        tcpListener_ = std::make_unique<TcpListener>(ioService, "127.0.0.1", 8081, connectionManagerWithTimeout);
+        if (unixSocketPath.empty())
+        {
+            listener_ = std::make_unique<StreamSocketListener>(ioService, "127.0.0.1", 8081,
+                                                               connectionManagerWithTimeout);
+        }
+        else
+        {
+            listener_ = std::make_unique<StreamSocketListener>(ioService, unixSocketPath, connectionManagerWithTimeout);
+        }
     }
 
     std::unique_ptr<DefaultIOServiceProvider> ioServiceProvider_;
     std::unique_ptr<HttpRouter> httpRouter_;
-    std::unique_ptr<TcpListener> tcpListener_;
+    std::unique_ptr<StreamSocketListener> listener_;
     std::unique_ptr<Endpoints> endpoints_;
 };
 